@@ -178,6 +178,9 @@ int UnEscapeStr(BYTE *Text)
 	return (int)(dst - Text);
 }
 
+// MOobt@́AMf[^̐擪 c oCg
+#define OutBuffAt(c) (pvar->cv->OutBuff[(pvar->cv->OutPtr + (c)) & OutBuffMask(pvar->cv)])
+
 //
 //  o̓obt@ɕ
 //  ttpcmn/ttcmn.c:CommTextOut()x[X
@@ -186,57 +189,52 @@ void CommOut(char *str, int len) {
 	int outlen, c;
 	char *p;
 
-	if (len > OutBuffSize - pvar->cv->OutBuffCount)
-		outlen = OutBuffSize - pvar->cv->OutBuffCount;
+	if (len > pvar->cv->OutBuffMax - pvar->cv->OutBuffCount)
+		outlen = pvar->cv->OutBuffMax - pvar->cv->OutBuffCount;
 	else
 		outlen = len;
 
-	if (pvar->cv->OutPtr > 0) {
-		memmove(pvar->cv->OutBuff, &(pvar->cv->OutBuff[pvar->cv->OutPtr]), pvar->cv->OutBuffCount);
-		pvar->cv->OutPtr = 0;
-	}
-
 	c = pvar->cv->OutBuffCount;
 	for (p=str; outlen>0; p++, outlen--) {
 		switch (*p) {
 		  case 0x0d:
 			switch (pvar->cv->CRSend) {
 			  case IdCR:
-				pvar->cv->OutBuff[c++] = 0x0d;
-				if (c < OutBuffSize && pvar->cv->TelFlag && ! pvar->cv->TelBinSend) {
-					pvar->cv->OutBuff[c++] = 0;
+				OutBuffAt(c++) = 0x0d;
+				if (c < pvar->cv->OutBuffMax && pvar->cv->TelFlag && ! pvar->cv->TelBinSend) {
+					OutBuffAt(c++) = 0;
 				}
 				break;
 			  case IdLF:
-				pvar->cv->OutBuff[c++] = 0x0a;
+				OutBuffAt(c++) = 0x0a;
 				break;
 			  case IdCRLF:
-				pvar->cv->OutBuff[c++] = 0x0d;
-				if (c < OutBuffSize) {
-					pvar->cv->OutBuff[c++] = 0x0a;
+				OutBuffAt(c++) = 0x0d;
+				if (c < pvar->cv->OutBuffMax) {
+					OutBuffAt(c++) = 0x0a;
 				}
 				break;
 			}
-			if (c + outlen > OutBuffSize) {
+			if (c + outlen > pvar->cv->OutBuffMax) {
 				outlen--;
 			}
 			break;
 		  case 0xff:
 			if (pvar->cv->TelFlag) {
-				if (c < OutBuffSize - 1) {
-					pvar->cv->OutBuff[c++] = 0xff;
-					pvar->cv->OutBuff[c++] = 0xff;
+				if (c < pvar->cv->OutBuffMax - 1) {
+					OutBuffAt(c++) = 0xff;
+					OutBuffAt(c++) = 0xff;
 				}
 			}
 			else {
-				pvar->cv->OutBuff[c++] = 0xff;
+				OutBuffAt(c++) = 0xff;
 			}
-			if (c + outlen > OutBuffSize) {
+			if (c + outlen > pvar->cv->OutBuffMax) {
 				outlen--;
 			}
 			break;
 		  default:
-			pvar->cv->OutBuff[c++] = *p;
+			OutBuffAt(c++) = *p;
 		}
 	}
 
@@ -634,8 +632,8 @@ static TTXExports Exports = {
 
 BOOL __declspec(dllexport) PASCAL TTXBind(WORD Version, TTXExports *exports) {
 	int size = sizeof(Exports) - sizeof(exports->size);
-	/* do version checking if necessary */
-	/* if (Version!=TTVERSION) return FALSE; */
+	/* we write into cv->OutBuff, whose layout depends on the version */
+	if (Version!=TTVERSION) return FALSE;
 
 	if (size > exports->size) {
 		size = exports->size;
@@ -345,6 +345,7 @@
 #define HlpMacroCommandRotateright      92121
 #define HlpMacroCommandScprecv          92131
 #define HlpMacroCommandScpsend          92132
+#define HlpMacroCommandSearchbuff       92218
 #define HlpMacroCommandSend             92074
 #define HlpMacroCommandSendbreak        92075
 #define HlpMacroCommandSendbroadcast    92144
@@ -372,6 +373,8 @@
 #define HlpMacroCommandSetsync          92084
 #define HlpMacroCommandSettime          92085
 #define HlpMacroCommandSettitle         92086
+#define HlpMacroCommandSftprecv         92219
+#define HlpMacroCommandSftpsend         92220
 #define HlpMacroCommandShow             92087
 #define HlpMacroCommandShowtt           92088
 #define HlpMacroCommandSprintf          92117
@@ -72,8 +72,8 @@ Visual C++ 14.0 (Visual Studio 2015) 1900
 #include "i18n.h"
 
 #define MAXPATHLEN 256
-/* version 2.3 */
-#define TTVERSION (WORD)23
+/* version 2.4: TComVar.InBuff and OutBuff are pointers to ring buffers */
+#define TTVERSION (WORD)24
 
 #define DEBUG_PRINT(val) { \
 	FILE *fp; \
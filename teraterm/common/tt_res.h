@@ -25,6 +25,7 @@
 #define IDD_SETUP_DIR_DIALOG            123
 #define IDI_TTERM_3D                    124
 #define IDI_VT_3D                       125
+#define IDD_FINDBUFF_DIALOG             126
 #define IDR_TEKMENU                     1000
 #define IDC_EDIT_COMMENT                1000
 #define IDC_EDIT_FULLPATH               1001
@@ -234,6 +235,10 @@
 #define IDC_SAME_PROCESS_NEXTDROP_CHECK 2586
 #define IDC_DONTSHOW_CHECK              2587
 #define IDC_DAD_NOTE                    2588
+#define IDC_FINDBUFF_EDIT               2589
+#define IDC_FINDBUFF_REGEX              2590
+#define IDC_FINDBUFF_CASE               2591
+#define IDC_FINDBUFF_PREV               2592
 #define ID_ACC_SENDBREAK                50001
 #define ID_ACC_COPY                     50002
 #define ID_ACC_NEWCONNECTION            50003
@@ -283,6 +288,7 @@
 #define ID_EDIT_CANCELSELECT            50270
 #define ID_EDIT_SELECTSCREEN            50280
 #define ID_EDIT_SELECTALL               50290
+#define ID_EDIT_FINDBUFF                50295
 #define ID_SETUP_TERMINAL               50310
 #define ID_SETUP_WINDOW                 50320
 #define ID_SETUP_FONT                   50330
@@ -329,9 +335,9 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NO_MFC                     1
-#define _APS_NEXT_RESOURCE_VALUE        126
+#define _APS_NEXT_RESOURCE_VALUE        127
 #define _APS_NEXT_COMMAND_VALUE         52031
-#define _APS_NEXT_CONTROL_VALUE         2589
+#define _APS_NEXT_CONTROL_VALUE         2593
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
@@ -71,6 +71,13 @@ void PASCAL OpenHelp(UINT Command, DWORD Data, char *UILanguageFile);
 
 int PASCAL CommReadRawByte(PComVar cv, LPBYTE b);
 int PASCAL CommRead1Byte(PComVar cv, LPBYTE b);
+int PASCAL CommReadPrintableRun(PComVar cv, LPBYTE *run);
+int PASCAL CommReadUTF8Run(PComVar cv, LPBYTE *run);
+/* byte classes for CommReadDBCSRun() */
+#define DBCSSingle 1
+#define DBCSLead 2
+#define DBCSTrail 4
+int PASCAL CommReadDBCSRun(PComVar cv, LPBYTE *run, const BYTE *Class);
 void PASCAL CommInsert1Byte(PComVar cv, BYTE b);
 int PASCAL CommRawOut(PComVar cv, PCHAR B, int C);
 int PASCAL CommBinaryOut(PComVar cv, PCHAR B, int C);
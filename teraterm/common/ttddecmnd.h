@@ -88,6 +88,9 @@
 #define CmdLogAutoClose     'X'
 #define CmdGetModemStatus   'Y'
 #define CmdSetFlowCtrl      'Z'
+#define CmdSearchBuff       '['
+#define CmdSftpSend         ']'
+#define CmdSftpRcv          '^'
 
 #define LogOptBinary        1
 #define LogOptAppend        2
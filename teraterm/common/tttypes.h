@@ -683,6 +683,8 @@ struct tttset {
 	char LogTimestampFormat[48];
 	int TerminalInputSpeed;
 	int TerminalOutputSpeed;
+	int RecvBuffSize;
+	int CompressedBuffSize;
 };
 
 typedef struct tttset TTTSet, *PTTSet;
@@ -1004,13 +1006,28 @@ typedef TKeyMap *PKeyMap;
 #define APC  0x9F
 
 #define InBuffSize  1024
-#define OutBuffSize (1024*16)
+/* send ring buffer size (power of two); grows up to OutBuffSizeMax when a
+   write does not fit.  Talkers stop at OutBuffSize/2 pending bytes. */
+#define OutBuffSize    (1024*16)
+#define OutBuffSizeMax (1024*256)
 
+/* receive ring buffer size (power of two) */
+#define RecvBuffSizeMin     InBuffSize
+#define RecvBuffSizeMax     (1024*1024*16)
+#define RecvBuffSizeDefault (1024*64)
+
+/* compressed scroll buffer size (MB) */
+#define CompressedBuffSizeMax 2047
+
+/* TTX plug-ins get this structure as is (TTXInit). Bump TTVERSION in
+   teraterm.h whenever its layout changes. */
 typedef struct {
-	BYTE InBuff[InBuffSize];
+	LPBYTE InBuff;		/* receive ring buffer (InBuffMax bytes) */
 	int InBuffCount, InPtr;
-	BYTE OutBuff[OutBuffSize];
+	int InBuffMax;
+	LPBYTE OutBuff;		/* send ring buffer (OutBuffMax bytes) */
 	int OutBuffCount, OutPtr;
+	int OutBuffMax;
 
 	HWND HWin;
 	BOOL Ready;
@@ -1091,6 +1108,26 @@ typedef struct {
 } TComVar;
 typedef TComVar *PComVar;
 
+/* receive ring buffer: write position and wrap-free read/write lengths */
+#define InBuffMask(cv)      ((cv)->InBuffMax - 1)
+#define InBuffWritePtr(cv)  (((cv)->InPtr + (cv)->InBuffCount) & InBuffMask(cv))
+#define InBuffReadSpan(cv) \
+	(((cv)->InPtr + (cv)->InBuffCount > (cv)->InBuffMax) ? \
+	 (cv)->InBuffMax - (cv)->InPtr : (cv)->InBuffCount)
+#define InBuffWriteSpan(cv) \
+	((InBuffWritePtr(cv) >= (cv)->InPtr && (cv)->InBuffCount < (cv)->InBuffMax) ? \
+	 (cv)->InBuffMax - InBuffWritePtr(cv) : (cv)->InBuffMax - (cv)->InBuffCount)
+
+/* send ring buffer: same as above */
+#define OutBuffMask(cv)     ((cv)->OutBuffMax - 1)
+#define OutBuffWritePtr(cv) (((cv)->OutPtr + (cv)->OutBuffCount) & OutBuffMask(cv))
+#define OutBuffReadSpan(cv) \
+	(((cv)->OutPtr + (cv)->OutBuffCount > (cv)->OutBuffMax) ? \
+	 (cv)->OutBuffMax - (cv)->OutPtr : (cv)->OutBuffCount)
+#define OutBuffWriteSpan(cv) \
+	((OutBuffWritePtr(cv) >= (cv)->OutPtr && (cv)->OutBuffCount < (cv)->OutBuffMax) ? \
+	 (cv)->OutBuffMax - OutBuffWritePtr(cv) : (cv)->OutBuffMax - (cv)->OutBuffCount)
+
 #define ID_FILE          0
 #define ID_EDIT          1
 #define ID_SETUP         2
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * bufbench: microbenchmark of the scroll buffer operations in buffer.c.
+ *
+ *   bufbench [-c cols] [-l lines] [-b lines] [-n count]
+ *
+ * The screen is filled with colored text through the parser, then each
+ * operation below is called directly count times and timed:
+ *   scroll     BuffScroll() of the whole screen into the scroll buffer
+ *   region     BuffInsertLines()/BuffDeleteLines() below the first line
+ *   insert     BuffInsertSpace() at the start of every line
+ *   delete     BuffDeleteChars() at the start of every line
+ *   erase      BuffEraseCurToEnd() from the home position
+ *   redraw     BuffUpdateRect() of the whole window
+ * Only the public buffer.h functions are used, so the same source can be
+ * linked against other versions of buffer.c to compare cell layouts.
+ */
+#include "teraterm.h"
+#include "tttypes.h"
+#include "vtdisp.h"
+#include "buffer.h"
+
+#include <unistd.h>
+
+#include "hlcore.h"
+
+static THlConfig Config;
+static int Count = 20000;
+
+static void Usage(void)
+{
+	fprintf(stderr,
+	        "usage: bufbench [options]\n"
+	        "  -c cols     terminal width (80)\n"
+	        "  -l lines    terminal height (24)\n"
+	        "  -b lines    scroll buffer size (10000, -1: disabled)\n"
+	        "  -n count    repetitions of each operation (20000)\n");
+	exit(2);
+}
+
+static unsigned long long NowNsec(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long long)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+/* every line gets text in several colors so that the attributes vary */
+static void FillScreen(void)
+{
+	char line[64];
+	int y;
+
+	HlFeed("\033[H", 3);
+	for (y = 0; y < NumOfLines; y++) {
+		_snprintf_s(line, sizeof(line), _TRUNCATE,
+		            "\033[%dmscroll buffer \033[1;%dm%4d\033[0m cells ", 31 + y % 7, 32 + y % 6, y);
+		HlFeed(line, (int)strlen(line));
+		while (CursorX < NumOfColumns - 8) {
+			HlFeed("\033[7mabc\033[0mdefgh", 16);
+		}
+		if (y < NumOfLines - 1) {
+			HlFeed("\r\n", 2);
+		}
+	}
+	HlIdle();
+}
+
+static void Report(const char *Name, unsigned long long Nsec, int Ops, int Cells)
+{
+	printf("%-8s %10.1f ns/op %8.2f ns/line %7.3f ns/cell\n",
+	       Name, (double)Nsec / Ops, (double)Nsec / Ops / max(Cells / NumOfColumns, 1),
+	       (double)Nsec / Ops / Cells);
+}
+
+static void BenchScroll(void)
+{
+	unsigned long long t;
+	int i;
+
+	FillScreen();
+	MoveCursor(0, NumOfLines - 1);
+	t = NowNsec();
+	for (i = 0; i < Count; i++) {
+		BuffScroll(1, NumOfLines - 1);
+	}
+	Report("scroll", NowNsec() - t, Count, NumOfColumns * NumOfLines);
+}
+
+static void BenchRegion(void)
+{
+	unsigned long long t;
+	int i;
+
+	FillScreen();
+	t = NowNsec();
+	for (i = 0; i < Count; i++) {
+		MoveCursor(0, 1);
+		if (i & 1) {
+			BuffDeleteLines(1, NumOfLines - 1);
+		}
+		else {
+			BuffInsertLines(1, NumOfLines - 1);
+		}
+	}
+	Report("region", NowNsec() - t, Count, NumOfColumns * (NumOfLines - 1));
+}
+
+static void BenchChars(const char *Name, BOOL Insert)
+{
+	unsigned long long t;
+	int i, y;
+
+	FillScreen();
+	t = NowNsec();
+	for (i = 0; i < Count; i++) {
+		for (y = 0; y < NumOfLines; y++) {
+			MoveCursor(0, y);
+			if (Insert) {
+				BuffInsertSpace(1);
+			}
+			else {
+				BuffDeleteChars(1);
+			}
+		}
+	}
+	Report(Name, NowNsec() - t, Count, NumOfColumns * NumOfLines);
+}
+
+static void BenchErase(void)
+{
+	unsigned long long t;
+	int i;
+
+	FillScreen();
+	t = NowNsec();
+	for (i = 0; i < Count; i++) {
+		MoveCursor(0, 0);
+		BuffEraseCurToEnd();
+	}
+	Report("erase", NowNsec() - t, Count, NumOfColumns * NumOfLines);
+}
+
+static void BenchRedraw(void)
+{
+	unsigned long long t;
+	int i;
+
+	FillScreen();
+	t = NowNsec();
+	for (i = 0; i < Count; i++) {
+		HlRedraw();
+	}
+	Report("redraw", NowNsec() - t, Count, NumOfColumns * NumOfLines);
+}
+
+int main(int argc, char *argv[])
+{
+	int c;
+
+	while ((c = getopt(argc, argv, "c:l:b:n:")) != -1) {
+		switch (c) {
+		case 'c': Config.Columns = atoi(optarg); break;
+		case 'l': Config.Lines = atoi(optarg); break;
+		case 'b': Config.ScrollBuffSize = atoi(optarg); break;
+		case 'n': Count = max(atoi(optarg), 1); break;
+		default: Usage();
+		}
+	}
+	if (optind < argc) {
+		Usage();
+	}
+
+	HlInit(&Config);
+	printf("%dx%d, %d repetitions\n", NumOfColumns, NumOfLines, Count);
+	BenchScroll();
+	BenchRegion();
+	BenchChars("insert", TRUE);
+	BenchChars("delete", FALSE);
+	BenchErase();
+	BenchRedraw();
+	HlEnd();
+	return 0;
+}
@@ -0,0 +1,5 @@
+/* headless build: <mbstring.h> (Shift_JIS lead byte test only) */
+#pragma once
+
+#define _ismbblead(c) ((((c) & 0xff) >= 0x81 && ((c) & 0xff) <= 0x9f) || (((c) & 0xff) >= 0xe0 && ((c) & 0xff) <= 0xfc))
+#define _ismbbtrail(c) (((c) & 0xff) >= 0x40 && ((c) & 0xff) <= 0xfc && ((c) & 0xff) != 0x7f)
@@ -0,0 +1,183 @@
+/*
+ * Minimal Win32 declarations for building the terminal core on non-Windows
+ * hosts (headless build only). Only what vtterm.c / buffer.c and the headers
+ * they include need is declared here; the functions are implemented as
+ * no-ops in hlwin.c.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <wchar.h>
+
+#define PASCAL
+#define WINAPI
+#define CALLBACK
+#define APIENTRY
+#define __stdcall
+#define __cdecl
+#define _export
+#define FAR
+#define NEAR
+#define far
+#define near
+#define CONST const
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef unsigned int UINT;
+typedef int INT;
+typedef char CHAR;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef unsigned char UCHAR;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef int64_t __int64;
+typedef uint64_t UINT64;
+typedef wchar_t WCHAR;
+typedef char TCHAR;
+
+typedef char *PCHAR, *LPSTR, *LPTSTR;
+typedef const char *LPCSTR, *LPCTSTR;
+typedef WCHAR *LPWSTR;
+typedef const WCHAR *LPCWSTR;
+typedef BYTE *LPBYTE, *PBYTE;
+typedef WORD *LPWORD, *PWORD;
+typedef DWORD *LPDWORD, *PDWORD;
+typedef LONG *LPLONG, *PLONG;
+typedef BOOL *PBOOL, *LPBOOL;
+typedef int *LPINT, *PINT;
+typedef void *LPVOID, *PVOID;
+typedef const void *LPCVOID;
+
+typedef uintptr_t UINT_PTR, ULONG_PTR, DWORD_PTR, WPARAM;
+typedef intptr_t INT_PTR, LONG_PTR, LPARAM, LRESULT;
+typedef size_t SIZE_T;
+
+typedef void *HANDLE, *HGLOBAL, *HLOCAL, *HGDIOBJ, *HCURSOR, *HRGN, *HPALETTE;
+typedef struct HWND__ *HWND;
+typedef struct HDC__ *HDC;
+typedef struct HFONT__ *HFONT;
+typedef struct HMENU__ *HMENU;
+typedef struct HICON__ *HICON;
+typedef struct HINSTANCE__ *HINSTANCE;
+typedef HINSTANCE HMODULE;
+typedef struct HBITMAP__ *HBITMAP;
+typedef struct HBRUSH__ *HBRUSH;
+typedef struct HPEN__ *HPEN;
+typedef struct HKEY__ *HKEY;
+typedef DWORD COLORREF;
+typedef WORD ATOM;
+typedef DWORD LCID;
+typedef uintptr_t SOCKET;
+
+typedef struct { LONG left, top, right, bottom; } RECT, *PRECT, *LPRECT;
+typedef struct { LONG x, y; } POINT, *PPOINT, *LPPOINT;
+typedef struct { LONG cx, cy; } SIZE, *PSIZE, *LPSIZE;
+typedef struct {
+	LONG lfHeight, lfWidth, lfEscapement, lfOrientation, lfWeight;
+	BYTE lfItalic, lfUnderline, lfStrikeOut, lfCharSet;
+	BYTE lfOutPrecision, lfClipPrecision, lfQuality, lfPitchAndFamily;
+	CHAR lfFaceName[32];
+} LOGFONT, LOGFONTA, *PLOGFONT, *LPLOGFONT;
+typedef struct { DWORD dwLowDateTime, dwHighDateTime; } FILETIME;
+typedef struct { WORD wYear, wMonth, wDayOfWeek, wDay, wHour, wMinute, wSecond, wMilliseconds; } SYSTEMTIME;
+typedef struct { DWORD Internal, InternalHigh, Offset, OffsetHigh; HANDLE hEvent; } OVERLAPPED, *LPOVERLAPPED;
+typedef struct { UINT length, flags, showCmd; POINT ptMinPosition, ptMaxPosition; RECT rcNormalPosition; } WINDOWPLACEMENT;
+typedef struct { int dummy; } CRITICAL_SECTION, TEXTMETRIC, PAINTSTRUCT, NOTIFYICONDATA;
+typedef LRESULT (CALLBACK *WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef struct { HWND hwnd; UINT message; WPARAM wParam; LPARAM lParam; DWORD time; POINT pt; } MSG;
+typedef struct { DWORD nLength; LPVOID lpSecurityDescriptor; BOOL bInheritHandle; } SECURITY_ATTRIBUTES, *LPSECURITY_ATTRIBUTES;
+
+#define HIBYTE(w) ((BYTE)(((WORD)(w) >> 8) & 0xff))
+#define LOBYTE(w) ((BYTE)((WORD)(w) & 0xff))
+#define HIWORD(l) ((WORD)(((DWORD)(l) >> 16) & 0xffff))
+#define LOWORD(l) ((WORD)((DWORD)(l) & 0xffff))
+#define MAKELONG(a,b) ((LONG)(((WORD)(a)) | ((DWORD)((WORD)(b))) << 16))
+#define MAKEWORD(a,b) ((WORD)(((BYTE)(a)) | ((WORD)((BYTE)(b))) << 8))
+#define MAKEWPARAM(l,h) ((WPARAM)(DWORD)MAKELONG(l,h))
+#define MAKELPARAM(l,h) ((LPARAM)(DWORD)MAKELONG(l,h))
+#define RGB(r,g,b) ((COLORREF)(((BYTE)(r)|((WORD)((BYTE)(g))<<8))|(((DWORD)(BYTE)(b))<<16)))
+#define GetRValue(c) ((BYTE)(c))
+#define GetGValue(c) ((BYTE)(((WORD)(c)) >> 8))
+#define GetBValue(c) ((BYTE)((c) >> 16))
+#ifndef max
+#define max(a,b) (((a) > (b)) ? (a) : (b))
+#define min(a,b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#define MAXLONG 0x7fffffff
+#define INFINITE 0xFFFFFFFF
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define LF_FACESIZE 32
+#define WM_USER 0x0400
+#define WM_APP 0x8000
+#define CP_ACP 0
+#define CP_UTF8 65001
+#define GMEM_MOVEABLE 0x0002
+#define GMEM_ZEROINIT 0x0040
+#define GHND (GMEM_MOVEABLE | GMEM_ZEROINIT)
+#define LMEM_FIXED 0
+#define CF_TEXT 1
+#define CF_UNICODETEXT 13
+#define MB_OK 0
+#define MB_ICONEXCLAMATION 0x30
+#define SW_SHOWNORMAL 1
+
+/* MSVC CRT */
+#define _TRUNCATE ((size_t)-1)
+#define _stricmp strcasecmp
+#define _strnicmp strncasecmp
+#define _strdup strdup
+#define __isascii(c) (((c) & ~0x7f) == 0)
+typedef int errno_t;
+typedef void *_locale_t;
+errno_t strncpy_s(char *dst, size_t size, const char *src, size_t count);
+errno_t strncat_s(char *dst, size_t size, const char *src, size_t count);
+errno_t strcat_s(char *dst, size_t size, const char *src);
+errno_t strcpy_s(char *dst, size_t size, const char *src);
+int _snprintf_s(char *buf, size_t size, size_t count, const char *fmt, ...);
+int sprintf_s(char *buf, size_t size, const char *fmt, ...);
+#define _snprintf snprintf
+#define _snprintf_s_l(buf, size, count, fmt, loc, ...) _snprintf_s(buf, size, count, fmt, ##__VA_ARGS__)
+#define _create_locale(cat, name) ((_locale_t)NULL)
+#define _free_locale(loc) ((void)(loc))
+#define _vsnprintf vsnprintf
+
+/* Win32 API (no-ops in the headless build) */
+HGLOBAL GlobalAlloc(UINT Flags, SIZE_T Size);
+LPVOID GlobalLock(HGLOBAL h);
+BOOL GlobalUnlock(HGLOBAL h);
+HGLOBAL GlobalFree(HGLOBAL h);
+SIZE_T GlobalSize(HGLOBAL h);
+BOOL IsDBCSLeadByte(BYTE c);
+DWORD GetTickCount(void);
+BOOL InvalidateRect(HWND hWnd, const RECT *Rect, BOOL Erase);
+BOOL PostMessage(HWND hWnd, UINT Msg, WPARAM wp, LPARAM lp);
+LRESULT SendMessage(HWND hWnd, UINT Msg, WPARAM wp, LPARAM lp);
+void PostQuitMessage(int Code);
+BOOL MessageBeep(UINT Type);
+void OutputDebugString(LPCSTR Str);
+int MultiByteToWideChar(UINT CodePage, DWORD Flags, LPCSTR Src, int SrcLen, LPWSTR Dest, int DestLen);
+int WideCharToMultiByte(UINT CodePage, DWORD Flags, LPCWSTR Src, int SrcLen, LPSTR Dest, int DestLen, LPCSTR Def, LPBOOL Used);
+BOOL UpdateWindow(HWND hWnd);
+void Sleep(DWORD ms);
+BOOL OpenClipboard(HWND hWnd);
+BOOL EmptyClipboard(void);
+HANDLE SetClipboardData(UINT Format, HANDLE h);
+BOOL CloseClipboard(void);
+HINSTANCE ShellExecute(HWND hWnd, LPCSTR Op, LPCSTR File, LPCSTR Param, LPCSTR Dir, int Show);
@@ -0,0 +1,16 @@
+/* headless build: <winsock2.h> (types used in plugin headers only) */
+#pragma once
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+typedef struct { int dummy; } WSADATA, *LPWSADATA;
+typedef unsigned long u_long;
+typedef struct sockaddr SOCKADDR, *PSOCKADDR, *LPSOCKADDR;
+typedef struct addrinfo ADDRINFO, *PADDRINFO, *LPADDRINFO;
+typedef struct hostent HOSTENT, *PHOSTENT, *LPHOSTENT;
+#define INVALID_SOCKET ((SOCKET)-1)
+#define SOCKET_ERROR (-1)
@@ -0,0 +1,4 @@
+/* headless build: <ws2tcpip.h> */
+#pragma once
+
+#include <winsock2.h>
@@ -0,0 +1,1051 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Headless terminal core.
+ *
+ * vtterm.c (parser) and buffer.c (screen/scroll buffer) are linked
+ * unchanged.  This file provides the symbols they take from the rest of
+ * TERATERM.EXE / TTPCMN.DLL:
+ *   - vtdisp.c: display routines, forwarded to the render sink (hlsink.h)
+ *   - ttcmn.c: receive/send routines, reading from the buffer given to HlFeed()
+ *     (the run length scanners are the ones in ttpcmn/charrun.c)
+ *   - ttwinman.c, keyboard.c, ttime.c, clipboar.c, teraprn.cpp, telnet.c,
+ *     filesys.cpp, ttplug.c: state variables and no-op stubs
+ */
+#include "teraterm.h"
+#include "tttypes.h"
+#include "ttcommon.h"
+#include "ttlib.h"
+#include "vtdisp.h"
+#include "buffer.h"
+#include "vtterm.h"
+#include "ttwinman.h"
+#include "keyboard.h"
+#include "ttime.h"
+#include "clipboar.h"
+#include "teraprn.h"
+#include "telnet.h"
+#include "filesys.h"
+#include "ttplug.h"
+#include "charrun.h"
+
+#include "hlcore.h"
+
+static THlSink NullSink;
+static PHlSink Sink = &NullSink;
+
+/* ttwinman.c */
+HWND HVTWin;
+int TalkStatus = IdTalkKeyb;
+BOOL KeybEnabled = TRUE;
+TTTSet ts;
+TComVar cv;
+
+/* keyboard.c */
+BOOL AutoRepeatMode;
+BOOL AppliKeyMode, AppliCursorMode, AppliEscapeMode;
+BOOL Send8BitMode;
+BYTE DebugFlag = DEBUG_FLAG_NONE;
+
+/* vtdisp.c */
+int WinWidth, WinHeight;
+int FontHeight = 1, FontWidth = 1, ScreenWidth, ScreenHeight;
+BOOL AdjustSize, DontChangeSize;
+int CursorX, CursorY;
+int WinOrgX, WinOrgY, NewOrgX, NewOrgY;
+int NumOfLines, NumOfColumns;
+int PageStart, BuffEnd;
+TCharAttr DefCharAttr = {
+	AttrDefault,
+	AttrDefault,
+	AttrDefaultFG,
+	AttrDefaultBG
+};
+
+static TCharAttr CurCharAttr;
+static TCharAttr DCAttr;
+static BOOL DCReverse;
+static BOOL CaretEnabled = TRUE;
+static int CaretStatus;
+static int ScrollCount, dScroll, SRegionTop, SRegionBottom;
+static COLORREF ANSIColor[256];
+
+/* feed buffer (ttcmn.c) */
+#define PushBackMax 16
+static const BYTE *FeedPtr;
+static int FeedLen;
+static BYTE PushBack[PushBackMax];
+static int PushBackCount;
+
+/* HlScreenHash() */
+typedef struct {
+	char Code;
+	TCharAttr Attr;
+} THashCell;
+static THashCell *HashGrid;
+static int HashGridSize;
+
+/*
+ * vtdisp.c
+ */
+
+void InitColorTable()
+{
+	static const BYTE Base[16][3] = {
+		{  0,   0,   0}, {255,   0,   0}, {  0, 255,   0}, {255, 255,   0},
+		{  0,   0, 255}, {255,   0, 255}, {  0, 255, 255}, {255, 255, 255},
+		{128, 128, 128}, {128,   0,   0}, {  0, 128,   0}, {128, 128,   0},
+		{  0,   0, 128}, {128,   0, 128}, {  0, 128, 128}, {192, 192, 192}
+	};
+	static const BYTE Level[6] = {0, 95, 135, 175, 215, 255};
+	int i, g;
+
+	for (i = 0; i < 16; i++) {
+		ANSIColor[i] = RGB(Base[i][0], Base[i][1], Base[i][2]);
+	}
+	for (i = 16; i < 232; i++) {
+		ANSIColor[i] = RGB(Level[(i-16)/36], Level[(i-16)/6%6], Level[(i-16)%6]);
+	}
+	for (i = 232; i < 256; i++) {
+		g = (i-232)*10 + 8;
+		ANSIColor[i] = RGB(g, g, g);
+	}
+}
+
+void BGExchangeColor(void)
+{
+}
+
+void DispReset()
+{
+	CursorX = 0;
+	CursorY = 0;
+
+	ScrollCount = 0;
+	dScroll = 0;
+
+	if (IsCaretOn()) CaretOn();
+	DispEnableCaret(TRUE);
+}
+
+void DispConvWinToScreen(int Xw, int Yw, int *Xs, int *Ys, PBOOL Right)
+{
+	*Xs = Xw / FontWidth + WinOrgX;
+	*Ys = Yw / FontHeight + WinOrgY;
+	if (Right != NULL) {
+		*Right = FALSE;
+	}
+}
+
+void DispConvScreenToWin(int Xs, int Ys, int *Xw, int *Yw)
+{
+	if (Xw != NULL) {
+		*Xw = (Xs - WinOrgX) * FontWidth;
+	}
+	if (Yw != NULL) {
+		*Yw = (Ys - WinOrgY) * FontHeight;
+	}
+}
+
+void ChangeCaret()
+{
+}
+
+void UpdateCaretPosition(BOOL enforce)
+{
+}
+
+void CaretOn()
+{
+	if (! CaretEnabled) return;
+	if (Sink->Caret != NULL) {
+		Sink->Caret(Sink->data, CursorX - WinOrgX, CursorY - WinOrgY, TRUE);
+	}
+	CaretStatus = 0;
+}
+
+void CaretOff()
+{
+	if (CaretStatus == 0) {
+		if (Sink->Caret != NULL) {
+			Sink->Caret(Sink->data, CursorX - WinOrgX, CursorY - WinOrgY, FALSE);
+		}
+		CaretStatus++;
+	}
+}
+
+BOOL IsCaretOn()
+{
+	return (CaretStatus == 0);
+}
+
+void DispEnableCaret(BOOL On)
+{
+	if (! On) CaretOff();
+	CaretEnabled = On;
+}
+
+BOOL IsCaretEnabled()
+{
+	return CaretEnabled;
+}
+
+void DispSetCaretWidth(BOOL DW)
+{
+}
+
+void DispChangeWinSize(int Nx, int Ny)
+{
+	WinWidth = Nx;
+	WinHeight = Ny;
+	ScreenWidth = WinWidth * FontWidth;
+	ScreenHeight = WinHeight * FontHeight;
+
+	if (Sink->Resize != NULL) {
+		Sink->Resize(Sink->data, Nx, Ny);
+	}
+	InvalidateRect(HVTWin, NULL, FALSE);
+}
+
+void DispClearWin()
+{
+	InvalidateRect(HVTWin, NULL, FALSE);
+
+	ScrollCount = 0;
+	dScroll = 0;
+	if (WinHeight > NumOfLines) {
+		DispChangeWinSize(NumOfColumns, NumOfLines);
+	}
+	if (IsCaretOn()) CaretOn();
+}
+
+void DispChangeBackground()
+{
+	InvalidateRect(HVTWin, NULL, FALSE);
+}
+
+void DispChangeWin()
+{
+	InvalidateRect(HVTWin, NULL, FALSE);
+}
+
+void DispInitDC()
+{
+}
+
+void DispReleaseDC()
+{
+}
+
+void DispSetupDC(TCharAttr Attr, BOOL Reverse)
+{
+	DCAttr = Attr;
+	DCReverse = Reverse;
+}
+
+void DispStr(PCHAR Buff, int Count, int Y, int* X)
+{
+	if (Sink->DrawStr != NULL) {
+		Sink->DrawStr(Sink->data, *X / FontWidth, Y / FontHeight, Buff, Count, DCAttr, DCReverse);
+	}
+	*X = *X + Count * FontWidth;
+}
+
+void DispFlushStr()
+{
+}
+
+static void EraseRect(int Left, int Top, int Right, int Bottom)
+{
+	if (Sink->Erase != NULL && Left < Right && Top < Bottom) {
+		Sink->Erase(Sink->data, Left, Top, Right, Bottom);
+	}
+}
+
+void DispEraseCurToEnd(int YEnd)
+{
+	EraseRect(0, CursorY+1-WinOrgY, WinWidth, YEnd+1-WinOrgY);
+	EraseRect(CursorX-WinOrgX, CursorY-WinOrgY, WinWidth, CursorY+1-WinOrgY);
+}
+
+void DispEraseHomeToCur(int YHome)
+{
+	EraseRect(0, YHome-WinOrgY, WinWidth, CursorY-WinOrgY);
+	EraseRect(0, CursorY-WinOrgY, CursorX+1-WinOrgX, CursorY+1-WinOrgY);
+}
+
+void DispEraseCharsInLine(int XStart, int Count)
+{
+	EraseRect(XStart-WinOrgX, CursorY-WinOrgY, XStart+Count-WinOrgX, CursorY+1-WinOrgY);
+}
+
+BOOL DispDeleteLines(int Count, int YEnd)
+{
+	if (YEnd+1-WinOrgY > WinHeight) {
+		return FALSE;
+	}
+	if (Sink->Scroll != NULL) {
+		Sink->Scroll(Sink->data, CursorY-WinOrgY, YEnd-WinOrgY, Count);
+	}
+	return TRUE;
+}
+
+BOOL DispInsertLines(int Count, int YEnd)
+{
+	if (CursorY < WinOrgY) {
+		return FALSE;
+	}
+	if (Sink->Scroll != NULL) {
+		Sink->Scroll(Sink->data, CursorY-WinOrgY, YEnd-WinOrgY, -Count);
+	}
+	return TRUE;
+}
+
+BOOL IsLineVisible(int* X, int* Y)
+{
+	if ((dScroll != 0) &&
+	    (*Y>=SRegionTop) &&
+	    (*Y<=SRegionBottom)) {
+		*Y = *Y + dScroll;
+		if ((*Y<SRegionTop) || (*Y>SRegionBottom))
+			return FALSE;
+	}
+
+	if ((*Y<WinOrgY) ||
+	    (*Y>=WinOrgY+WinHeight))
+		return FALSE;
+
+	/* screen coordinate -> window coordinate */
+	*X = (*X-WinOrgX)*FontWidth;
+	*Y = (*Y-WinOrgY)*FontHeight;
+	return TRUE;
+}
+
+void DispScrollToCursor(int CurX, int CurY)
+{
+	if (CurX < NewOrgX)
+		NewOrgX = CurX;
+	else if (CurX >= NewOrgX+WinWidth)
+		NewOrgX = CurX + 1 - WinWidth;
+
+	if (CurY < NewOrgY)
+		NewOrgY = CurY;
+	else if (CurY >= NewOrgY+WinHeight)
+		NewOrgY = CurY + 1 - WinHeight;
+}
+
+void DispScrollNLines(int Top, int Bottom, int Direction)
+{
+	if ((dScroll*Direction <0) ||
+	    ((dScroll*Direction >0) &&
+	     ((SRegionTop!=Top) ||
+	      (SRegionBottom!=Bottom))))
+		DispUpdateScroll();
+	SRegionTop = Top;
+	SRegionBottom = Bottom;
+	dScroll = dScroll + Direction;
+	if (Direction>0)
+		DispCountScroll(Direction);
+	else
+		DispCountScroll(-Direction);
+}
+
+void DispCountScroll(int n)
+{
+	ScrollCount = ScrollCount + n;
+	if (ScrollCount>=ts.ScrollThreshold) DispUpdateScroll();
+}
+
+void DispUpdateScroll()
+{
+	ScrollCount = 0;
+
+	/* Update partial scroll */
+	if (dScroll != 0) {
+		if (Sink->Scroll != NULL) {
+			Sink->Scroll(Sink->data, SRegionTop-WinOrgY, SRegionBottom-WinOrgY, dScroll);
+		}
+		dScroll = 0;
+	}
+
+	/* Update normal scroll */
+	if (NewOrgX < 0) NewOrgX = 0;
+	if (NewOrgX>NumOfColumns-WinWidth)
+		NewOrgX = NumOfColumns-WinWidth;
+	if (NewOrgY < -PageStart) NewOrgY = -PageStart;
+	if (NewOrgY>BuffEnd-WinHeight-PageStart)
+		NewOrgY = BuffEnd-WinHeight-PageStart;
+
+	if ((NewOrgX==WinOrgX) &&
+	    (NewOrgY==WinOrgY)) return;
+
+	if (NewOrgX==WinOrgX && Sink->Scroll != NULL) {
+		/* the lines scrolled in are drawn by the sink through HlRedraw() */
+		Sink->Scroll(Sink->data, 0, WinHeight-1, NewOrgY-WinOrgY);
+	}
+	InvalidateRect(HVTWin, NULL, FALSE);
+
+	WinOrgX = NewOrgX;
+	WinOrgY = NewOrgY;
+
+	if (IsCaretOn()) CaretOn();
+}
+
+void DispScrollHomePos()
+{
+	NewOrgX = 0;
+	NewOrgY = 0;
+	DispUpdateScroll();
+}
+
+void DispVScroll(int Func, int Pos)
+{
+	switch (Func) {
+	case SCROLL_BOTTOM:
+		NewOrgY = BuffEnd-WinHeight-PageStart;
+		break;
+	case SCROLL_LINEDOWN: NewOrgY = WinOrgY + 1; break;
+	case SCROLL_LINEUP: NewOrgY = WinOrgY - 1; break;
+	case SCROLL_PAGEDOWN:
+		NewOrgY = WinOrgY + WinHeight - 1;
+		break;
+	case SCROLL_PAGEUP:
+		NewOrgY = WinOrgY - WinHeight + 1;
+		break;
+	case SCROLL_POS: NewOrgY = Pos-PageStart; break;
+	case SCROLL_TOP: NewOrgY = -PageStart; break;
+	}
+	DispUpdateScroll();
+}
+
+int TCharAttrCmp(TCharAttr a, TCharAttr b)
+{
+	if (a.Attr == b.Attr &&
+	    a.Attr2 == b.Attr2 &&
+	    a.Fore == b.Fore &&
+	    a.Back == b.Back) {
+		return 0;
+	}
+	else {
+		return 1;
+	}
+}
+
+void DispSetColor(unsigned int num, COLORREF color)
+{
+	switch (num) {
+	case CS_VT_NORMALFG:  ts.VTColor[0] = color; break;
+	case CS_VT_NORMALBG:  ts.VTColor[1] = color; break;
+	case CS_VT_BOLDFG:    ts.VTBoldColor[0] = color; break;
+	case CS_VT_BOLDBG:    ts.VTBoldColor[1] = color; break;
+	case CS_VT_BLINKFG:   ts.VTBlinkColor[0] = color; break;
+	case CS_VT_BLINKBG:   ts.VTBlinkColor[1] = color; break;
+	case CS_VT_REVERSEFG: ts.VTReverseColor[0] = color; break;
+	case CS_VT_REVERSEBG: ts.VTReverseColor[1] = color; break;
+	case CS_VT_URLFG:     ts.URLColor[0] = color; break;
+	case CS_VT_URLBG:     ts.URLColor[1] = color; break;
+	default:
+		if (num <= 255) {
+			ANSIColor[num] = color;
+		}
+		break;
+	}
+	InvalidateRect(HVTWin, NULL, FALSE);
+}
+
+void DispResetColor(unsigned int num)
+{
+	if (num == CS_ANSICOLOR_ALL || num == CS_ALL) {
+		InitColorTable();
+		InvalidateRect(HVTWin, NULL, FALSE);
+	}
+}
+
+COLORREF DispGetColor(unsigned int num)
+{
+	COLORREF color;
+
+	switch (num) {
+	case CS_VT_NORMALFG:  color = ts.VTColor[0]; break;
+	case CS_VT_NORMALBG:  color = ts.VTColor[1]; break;
+	case CS_VT_BOLDFG:    color = ts.VTBoldColor[0]; break;
+	case CS_VT_BOLDBG:    color = ts.VTBoldColor[1]; break;
+	case CS_VT_BLINKFG:   color = ts.VTBlinkColor[0]; break;
+	case CS_VT_BLINKBG:   color = ts.VTBlinkColor[1]; break;
+	case CS_VT_REVERSEFG: color = ts.VTReverseColor[0]; break;
+	case CS_VT_REVERSEBG: color = ts.VTReverseColor[1]; break;
+	case CS_VT_URLFG:     color = ts.URLColor[0]; break;
+	case CS_VT_URLBG:     color = ts.URLColor[1]; break;
+	default:
+		if (num <= 255) {
+			color = ANSIColor[num];
+		}
+		else {
+			color = ANSIColor[0];
+		}
+		break;
+	}
+
+	return color;
+}
+
+int DispFindClosestColor(int red, int green, int blue)
+{
+	int i, color, diff_r, diff_g, diff_b, diff, min;
+
+	min = 0xfffffff;
+	color = 0;
+
+	if (red < 0 || red > 255 || green < 0 || green > 255 || blue < 0 || blue > 255)
+		return -1;
+
+	for (i=0; i<256; i++) {
+		diff_r = red - GetRValue(ANSIColor[i]);
+		diff_g = green - GetGValue(ANSIColor[i]);
+		diff_b = blue - GetBValue(ANSIColor[i]);
+		diff = diff_r * diff_r + diff_g * diff_g + diff_b * diff_b;
+
+		if (diff < min) {
+			min = diff;
+			color = i;
+		}
+	}
+
+	if ((ts.ColorFlag & CF_FULLCOLOR) != 0 && color < 16 && (color & 7) != 0) {
+		color ^= 8;
+	}
+	return color;
+}
+
+void DispSetCurCharAttr(TCharAttr Attr)
+{
+	CurCharAttr = Attr;
+}
+
+/* window operations (CSI t) */
+void DispMoveWindow(int x, int y)
+{
+}
+
+void DispShowWindow(int mode)
+{
+	if (mode == WINDOW_REFRESH) {
+		InvalidateRect(HVTWin, NULL, FALSE);
+	}
+}
+
+void DispResizeWin(int w, int h)
+{
+}
+
+BOOL DispWindowIconified()
+{
+	return FALSE;
+}
+
+void DispGetWindowPos(int *x, int *y)
+{
+	*x = 0;
+	*y = 0;
+}
+
+void DispGetWindowSize(int *width, int *height)
+{
+	*width = ScreenWidth;
+	*height = ScreenHeight;
+}
+
+void DispGetRootWinSize(int *x, int *y)
+{
+	*x = TermWidthMax;
+	*y = TermHeightMax;
+}
+
+/*
+ * ttcmn.c
+ */
+
+int PASCAL CommRead1Byte(PComVar cv, LPBYTE b)
+{
+	if (PushBackCount > 0) {
+		*b = PushBack[--PushBackCount];
+		return 1;
+	}
+	if (FeedLen <= 0) {
+		return 0;
+	}
+	*b = *FeedPtr++;
+	FeedLen--;
+	return 1;
+}
+
+int PASCAL CommReadPrintableRun(PComVar cv, LPBYTE *run)
+{
+	int len;
+
+	if (PushBackCount > 0) {
+		return 0;
+	}
+	len = PrintableLength(FeedPtr, FeedLen);
+	if (len == 0) {
+		return 0;
+	}
+	*run = (LPBYTE)FeedPtr;
+	FeedPtr += len;
+	FeedLen -= len;
+	return len;
+}
+
+int PASCAL CommReadUTF8Run(PComVar cv, LPBYTE *run)
+{
+	int len;
+
+	if (PushBackCount > 0) {
+		return 0;
+	}
+	len = UTF8Length((const BYTE *)FeedPtr, FeedLen);
+	if (len == 0) {
+		return 0;
+	}
+	*run = (LPBYTE)FeedPtr;
+	FeedPtr += len;
+	FeedLen -= len;
+	return len;
+}
+
+int PASCAL CommReadDBCSRun(PComVar cv, LPBYTE *run, const BYTE *Class)
+{
+	int len;
+
+	if (PushBackCount > 0) {
+		return 0;
+	}
+	len = DBCSLength((const BYTE *)FeedPtr, FeedLen, Class);
+	if (len == 0) {
+		return 0;
+	}
+	*run = (LPBYTE)FeedPtr;
+	FeedPtr += len;
+	FeedLen -= len;
+	return len;
+}
+
+void PASCAL CommInsert1Byte(PComVar cv, BYTE b)
+{
+	if (PushBackCount < PushBackMax) {
+		PushBack[PushBackCount++] = b;
+	}
+}
+
+int PASCAL CommBinaryOut(PComVar cv, PCHAR B, int C)
+{
+	if (Sink->Send != NULL) {
+		Sink->Send(Sink->data, B, C);
+	}
+	return C;
+}
+
+int PASCAL CommTextOut(PComVar cv, PCHAR B, int C)
+{
+	return CommBinaryOut(cv, B, C);
+}
+
+int PASCAL CommTextEcho(PComVar cv, PCHAR B, int C)
+{
+	return C;
+}
+
+void PASCAL CommResetSerial(PTTSet ts, PComVar cv, BOOL ClearBuff)
+{
+}
+
+void PASCAL NotifyMessage(PComVar cv, PCHAR message, PCHAR title, DWORD flag)
+{
+}
+
+/*
+ * ttlib.c
+ */
+
+BYTE ConvHexChar(BYTE b)
+{
+	if ((b>='0') && (b<='9')) {
+		return (b - 0x30);
+	}
+	else if ((b>='A') && (b<='F')) {
+		return (b - 0x37);
+	}
+	else if ((b>='a') && (b<='f')) {
+		return (b - 0x57);
+	}
+	else {
+		return 0;
+	}
+}
+
+/* only used for OSC 52 clipboard writes, which ts.CtrlFlag leaves disabled */
+int b64decode(PCHAR dst, int dsize, PCHAR src)
+{
+	return -1;
+}
+
+void get_lang_msg(PCHAR key, PCHAR buf, int buf_len, PCHAR def, const char *iniFile)
+{
+	strncpy_s(buf, buf_len, def, _TRUNCATE);
+}
+
+/*
+ * ttwinman.c, keyboard.c, ttime.c, clipboar.c, teraprn.cpp, telnet.c,
+ * filesys.cpp, ttplug.c
+ */
+
+void ConvertToCP932(char *str, int len)
+{
+	/* the sink gets the title as received */
+}
+
+void ChangeTitle()
+{
+	if (Sink->Title != NULL) {
+		Sink->Title(Sink->data, (strlen(cv.TitleRemote) > 0) ? cv.TitleRemote : ts.Title);
+	}
+}
+
+BOOL ShiftKey()
+{
+	return FALSE;
+}
+
+BOOL ControlKey()
+{
+	return FALSE;
+}
+
+BOOL AltKey()
+{
+	return FALSE;
+}
+
+void ClearUserKey()
+{
+}
+
+void DefineUserKey(int NewKeyId, PCHAR NewKeyStr, int NewKeyLen)
+{
+}
+
+BOOL CanUseIME()
+{
+	return FALSE;
+}
+
+BOOL GetIMEOpenStatus(void)
+{
+	return FALSE;
+}
+
+void SetIMEOpenStatus(BOOL stat)
+{
+}
+
+PCHAR CBOpen(LONG MemSize)
+{
+	return NULL;
+}
+
+LPWSTR CBOpenW(LONG Count)
+{
+	return NULL;
+}
+
+void CBClose()
+{
+}
+
+void CBStartPasteB64(HWND HWin, PCHAR header, PCHAR footer)
+{
+}
+
+int VTPrintInit(int PrnFlag)
+{
+	return IdPrnCancel;
+}
+
+void PrnSetAttr(TCharAttr Attr)
+{
+}
+
+void PrnOutText(PCHAR Buff, int Count)
+{
+}
+
+void PrnNewLine()
+{
+}
+
+void VTPrintEnd()
+{
+}
+
+void OpenPrnFile()
+{
+}
+
+void ClosePrnFile()
+{
+}
+
+void WriteToPrnFile(BYTE b, BOOL Write)
+{
+}
+
+void TelChangeEcho()
+{
+}
+
+void TelInformWinSize(int nx, int ny)
+{
+}
+
+void Log1Byte(BYTE b)
+{
+}
+
+void BPStart(int mode)
+{
+}
+
+void ZMODEMStart(int mode)
+{
+}
+
+void PASCAL TTXSetWinSize(int rows, int cols)
+{
+}
+
+/* Win32 calls that act on the VT window */
+BOOL InvalidateRect(HWND hWnd, const RECT *Rect, BOOL Erase)
+{
+	if (Sink->Invalidate != NULL) {
+		Sink->Invalidate(Sink->data);
+	}
+	return TRUE;
+}
+
+BOOL UpdateWindow(HWND hWnd)
+{
+	return TRUE;
+}
+
+BOOL MessageBeep(UINT Type)
+{
+	if (Sink->Bell != NULL) {
+		Sink->Bell(Sink->data);
+	}
+	return TRUE;
+}
+
+void PostQuitMessage(int Code)
+{
+	fprintf(stderr, "headless: cannot allocate the screen buffer\n");
+	exit(1);
+}
+
+/*
+ * API
+ */
+
+void HlInit(PHlConfig Config)
+{
+	memset(&ts, 0, sizeof(ts));
+	memset(&cv, 0, sizeof(cv));
+
+	/* TERATERM.INI defaults for what vtterm.c / buffer.c look at */
+	ts.TerminalWidth = (Config->Columns > 0) ? Config->Columns : 80;
+	ts.TerminalHeight = (Config->Lines > 0) ? Config->Lines : 24;
+	ts.EnableScrollBuff = (Config->ScrollBuffSize >= 0);
+	ts.ScrollBuffSize = (Config->ScrollBuffSize > 0) ? Config->ScrollBuffSize : 10000;
+	ts.ScrollBuffMax = max(ts.ScrollBuffSize, 10000);
+	ts.CompressedBuffSize = min(Config->CompressedBuffSize, CompressedBuffSizeMax);
+	ts.Language = (Config->Language > 0) ? Config->Language : IdUtf8;
+	ts.KanjiCode = (Config->KanjiCode > 0) ? Config->KanjiCode : IdUTF8;
+	ts.KanjiCodeSend = ts.KanjiCode;
+	ts.KanjiIn = IdKanjiInB;
+	ts.KanjiOut = IdKanjiOutB;
+	ts.TerminalID = IdVT100;
+	ts.CRReceive = IdCR;
+	ts.CRSend = IdCR;
+	ts.Beep = IdBeepOn;
+	ts.BeepOverUsedCount = 5;
+	ts.BeepOverUsedTime = 2;
+	ts.ScrollThreshold = 12;
+	ts.MaxOSCBufferSize = 4096;
+	ts.TabStopFlag = TABF_ALL;
+	ts.AcceptTitleChangeRequest = IdTitleChangeRequestOverwrite;
+	ts.ColorFlag = CF_ANSICOLOR | CF_PCBOLD16 | CF_AIXTERM16 | CF_XTERM256 | CF_FULLCOLOR;
+	ts.TermFlag = TF_ACCEPT8BITCTRL;
+	ts.VTColor[0] = RGB(255, 255, 255);
+	ts.VTColor[1] = RGB(0, 0, 0);
+	strncpy_s(ts.Title, sizeof(ts.Title), "Tera Term", _TRUNCATE);
+	strncpy_s(ts.Locale, sizeof(ts.Locale), DEFAULT_LOCALE, _TRUNCATE);
+
+	cv.Open = TRUE;
+	cv.Ready = TRUE;
+	cv.PortType = IdTCPIP;
+	cv.Language = ts.Language;
+	cv.KanjiCodeEcho = ts.KanjiCode;
+	cv.KanjiCodeSend = ts.KanjiCodeSend;
+
+	InitColorTable();
+	FeedPtr = NULL;
+	FeedLen = 0;
+	PushBackCount = 0;
+
+	InitBuffer();
+	DispChangeWinSize(NumOfColumns, NumOfLines);
+	ResetTerminal();
+}
+
+void HlEnd(void)
+{
+	EndTerm();
+	FreeBuffer();
+	free(HashGrid);
+	HashGrid = NULL;
+	HashGridSize = 0;
+}
+
+void HlSetSink(PHlSink NewSink)
+{
+	Sink = (NewSink != NULL) ? NewSink : &NullSink;
+}
+
+void HlFeed(const char *Buff, int Count)
+{
+	FeedPtr = (const BYTE *)Buff;
+	FeedLen = Count;
+	while (FeedLen > 0 || PushBackCount > 0) {
+		VTParse();
+	}
+	FeedPtr = NULL;
+}
+
+void HlIdle(void)
+{
+	VTParse();
+}
+
+void HlRedraw(void)
+{
+	LockBuffer();
+	BuffUpdateRect(WinOrgX, WinOrgY, WinOrgX+WinWidth-1, WinOrgY+WinHeight-1);
+	UnlockBuffer();
+}
+
+void HlResize(int Nx, int Ny)
+{
+	ChangeTerminalSize(Nx, Ny);
+}
+
+static void HashDrawStr(void *data, int X, int Y, const char *Buff, int Count, TCharAttr Attr, BOOL Reverse)
+{
+	int i;
+
+	if (Y < 0 || Y >= WinHeight) {
+		return;
+	}
+	for (i = 0; i < Count && X + i < WinWidth; i++) {
+		if (X + i >= 0) {
+			HashGrid[Y * WinWidth + X + i].Code = Buff[i];
+			HashGrid[Y * WinWidth + X + i].Attr = Attr;
+		}
+	}
+}
+
+/*
+ * FNV-1a over the visible screen (characters and attributes as drawn) and
+ * the cursor position.  Used to compare replay results across builds.
+ */
+unsigned long long HlScreenHash(void)
+{
+	THlSink HashSink;
+	PHlSink SaveSink;
+	unsigned long long h = 14695981039346656037ULL;
+	int i, n;
+
+	n = WinWidth * WinHeight;
+	if (n > HashGridSize) {
+		free(HashGrid);
+		HashGrid = malloc(n * sizeof(THashCell));
+		if (HashGrid == NULL) {
+			HashGridSize = 0;
+			return 0;
+		}
+		HashGridSize = n;
+	}
+	for (i = 0; i < n; i++) {
+		HashGrid[i].Code = ' ';
+		HashGrid[i].Attr = DefCharAttr;
+	}
+
+	memset(&HashSink, 0, sizeof(HashSink));
+	HashSink.DrawStr = HashDrawStr;
+	SaveSink = Sink;
+	Sink = &HashSink;
+	HlRedraw();
+	Sink = SaveSink;
+
+	for (i = 0; i < n; i++) {
+		h = (h ^ (BYTE)HashGrid[i].Code) * 1099511628211ULL;
+		h = (h ^ HashGrid[i].Attr.Attr) * 1099511628211ULL;
+		h = (h ^ HashGrid[i].Attr.Attr2) * 1099511628211ULL;
+		h = (h ^ HashGrid[i].Attr.Fore) * 1099511628211ULL;
+		h = (h ^ HashGrid[i].Attr.Back) * 1099511628211ULL;
+	}
+	h = (h ^ (CursorX & 0xff)) * 1099511628211ULL;
+	h = (h ^ ((CursorX >> 8) & 0xff)) * 1099511628211ULL;
+	h = (h ^ (CursorY & 0xff)) * 1099511628211ULL;
+	h = (h ^ ((CursorY >> 8) & 0xff)) * 1099511628211ULL;
+	return h;
+}
+
+int HlGetLine(int Y, char *Buff, int BuffSize)
+{
+	int len;
+
+	LockBuffer();
+	len = BuffGetAnyLineData(PageStart + Y, Buff, BuffSize);
+	UnlockBuffer();
+	return len;
+}
+
+void HlGetRenderStats(PRenderStats Stats)
+{
+	BuffGetRenderStats(Stats);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Headless terminal core (parser + screen/scrollback model without a window) */
+#pragma once
+
+#include "hlsink.h"
+#include "buffer.h"
+
+/* HlInit() settings; zero fields take the TERATERM.INI defaults */
+typedef struct {
+	int Columns;		/* TerminalSize */
+	int Lines;
+	int ScrollBuffSize;	/* < 0: scroll buffer disabled */
+	int CompressedBuffSize;	/* CompressedBuffSize (MB) */
+	int Language;		/* IdEnglish, IdJapanese, IdRussian, IdKorean, IdUtf8 */
+	int KanjiCode;		/* IdSJIS, IdEUC, IdJIS, IdUTF8 */
+} THlConfig;
+typedef THlConfig *PHlConfig;
+
+void HlInit(PHlConfig Config);
+void HlEnd(void);
+void HlSetSink(PHlSink Sink);
+void HlFeed(const char *Buff, int Count);
+/* no more data for now; draws what HlFeed() left for the next frame */
+void HlIdle(void);
+void HlRedraw(void);
+void HlResize(int Nx, int Ny);
+unsigned long long HlScreenHash(void);
+int HlGetLine(int Y, char *Buff, int BuffSize);
+void HlGetRenderStats(PRenderStats Stats);
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Headless terminal core, render sink interface */
+#pragma once
+
+/*
+ * The headless core replaces vtdisp.c.  Everything vtterm.c and buffer.c
+ * would have drawn on the VT window is forwarded to a render sink instead.
+ * All coordinates are character cells relative to the top-left corner of
+ * the window (FontWidth == FontHeight == 1).  Any callback may be NULL.
+ */
+typedef struct {
+	void *data;
+
+	/* Count bytes of Buff drawn at (X, Y) with Attr (DBCS/UTF-8 as stored in the buffer) */
+	void (*DrawStr)(void *data, int X, int Y, const char *Buff, int Count, TCharAttr Attr, BOOL Reverse);
+	/* cells [Left, Right) x [Top, Bottom) are cleared to the background */
+	void (*Erase)(void *data, int Left, int Top, int Right, int Bottom);
+	/* lines Top..Bottom move up by Count lines (down if Count < 0) */
+	void (*Scroll)(void *data, int Top, int Bottom, int Count);
+	/* the whole window has to be redrawn; call HlRedraw() to get the contents */
+	void (*Invalidate)(void *data);
+	/* caret position and visibility */
+	void (*Caret)(void *data, int X, int Y, BOOL Visible);
+	/* terminal size changed (columns, lines) */
+	void (*Resize)(void *data, int Nx, int Ny);
+	/* window title changed */
+	void (*Title)(void *data, const char *Title);
+	void (*Bell)(void *data);
+	/* bytes the terminal sends back to the host (DA/DSR responses etc.) */
+	void (*Send)(void *data, const char *Buff, int Count);
+} THlSink;
+typedef THlSink *PHlSink;
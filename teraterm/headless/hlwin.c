@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Win32 API and MSVC CRT functions declared in compat/windows.h.
+ * Window related calls (InvalidateRect, MessageBeep, ...) are in hlcore.c.
+ */
+#include <windows.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define STRUNCATE 80
+
+/* GlobalAlloc(): the block size is kept in front of the block for GlobalSize() */
+typedef union {
+	SIZE_T Size;
+	double Align;
+} TGlobalHeader;
+
+HGLOBAL GlobalAlloc(UINT Flags, SIZE_T Size)
+{
+	TGlobalHeader *h;
+
+	if (Flags & GMEM_ZEROINIT) {
+		h = calloc(1, sizeof(TGlobalHeader) + Size);
+	}
+	else {
+		h = malloc(sizeof(TGlobalHeader) + Size);
+	}
+	if (h == NULL) {
+		return NULL;
+	}
+	h->Size = Size;
+	return h + 1;
+}
+
+LPVOID GlobalLock(HGLOBAL h)
+{
+	return h;
+}
+
+BOOL GlobalUnlock(HGLOBAL h)
+{
+	return TRUE;
+}
+
+HGLOBAL GlobalFree(HGLOBAL h)
+{
+	if (h != NULL) {
+		free((TGlobalHeader *)h - 1);
+	}
+	return NULL;
+}
+
+SIZE_T GlobalSize(HGLOBAL h)
+{
+	return (h != NULL) ? ((TGlobalHeader *)h - 1)->Size : 0;
+}
+
+/* code page 932 */
+BOOL IsDBCSLeadByte(BYTE c)
+{
+	return (c >= 0x81 && c <= 0x9f) || (c >= 0xe0 && c <= 0xfc);
+}
+
+DWORD GetTickCount(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (DWORD)(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+void Sleep(DWORD ms)
+{
+	usleep(ms * 1000);
+}
+
+BOOL PostMessage(HWND hWnd, UINT Msg, WPARAM wp, LPARAM lp)
+{
+	return TRUE;
+}
+
+LRESULT SendMessage(HWND hWnd, UINT Msg, WPARAM wp, LPARAM lp)
+{
+	return 0;
+}
+
+void OutputDebugString(LPCSTR Str)
+{
+	fputs(Str, stderr);
+}
+
+/* only used for clipboard text; copies bytes as they are */
+int MultiByteToWideChar(UINT CodePage, DWORD Flags, LPCSTR Src, int SrcLen, LPWSTR Dest, int DestLen)
+{
+	int i;
+
+	if (SrcLen < 0) {
+		SrcLen = strlen(Src) + 1;
+	}
+	if (DestLen == 0) {
+		return SrcLen;
+	}
+	for (i = 0; i < SrcLen && i < DestLen; i++) {
+		Dest[i] = (BYTE)Src[i];
+	}
+	return i;
+}
+
+int WideCharToMultiByte(UINT CodePage, DWORD Flags, LPCWSTR Src, int SrcLen, LPSTR Dest, int DestLen, LPCSTR Def, LPBOOL Used)
+{
+	int i;
+
+	if (SrcLen < 0) {
+		for (SrcLen = 0; Src[SrcLen] != 0; SrcLen++)
+			;
+		SrcLen++;
+	}
+	if (DestLen == 0) {
+		return SrcLen;
+	}
+	for (i = 0; i < SrcLen && i < DestLen; i++) {
+		Dest[i] = (char)Src[i];
+	}
+	return i;
+}
+
+BOOL OpenClipboard(HWND hWnd)
+{
+	return FALSE;
+}
+
+BOOL EmptyClipboard(void)
+{
+	return FALSE;
+}
+
+HANDLE SetClipboardData(UINT Format, HANDLE h)
+{
+	return NULL;
+}
+
+BOOL CloseClipboard(void)
+{
+	return TRUE;
+}
+
+HINSTANCE ShellExecute(HWND hWnd, LPCSTR Op, LPCSTR File, LPCSTR Param, LPCSTR Dir, int Show)
+{
+	return (HINSTANCE)(intptr_t)32;
+}
+
+errno_t strncpy_s(char *dst, size_t size, const char *src, size_t count)
+{
+	size_t len;
+
+	if (dst == NULL || size == 0) {
+		return EINVAL;
+	}
+	len = strlen(src);
+	if (count != _TRUNCATE && len > count) {
+		len = count;
+	}
+	if (len >= size) {
+		if (count != _TRUNCATE) {
+			dst[0] = 0;
+			return ERANGE;
+		}
+		memcpy(dst, src, size - 1);
+		dst[size - 1] = 0;
+		return STRUNCATE;
+	}
+	memcpy(dst, src, len);
+	dst[len] = 0;
+	return 0;
+}
+
+errno_t strncat_s(char *dst, size_t size, const char *src, size_t count)
+{
+	size_t len = strnlen(dst, size);
+
+	if (len >= size) {
+		return EINVAL;
+	}
+	return strncpy_s(dst + len, size - len, src, count);
+}
+
+errno_t strcat_s(char *dst, size_t size, const char *src)
+{
+	return strncat_s(dst, size, src, _TRUNCATE);
+}
+
+errno_t strcpy_s(char *dst, size_t size, const char *src)
+{
+	return strncpy_s(dst, size, src, _TRUNCATE);
+}
+
+int _snprintf_s(char *buf, size_t size, size_t count, const char *fmt, ...)
+{
+	va_list ap;
+	size_t limit;
+	int len;
+
+	if (buf == NULL || size == 0) {
+		return -1;
+	}
+	limit = (count == _TRUNCATE || count >= size) ? size : count + 1;
+	va_start(ap, fmt);
+	len = vsnprintf(buf, limit, fmt, ap);
+	va_end(ap);
+	if (len < 0 || (size_t)len >= limit) {
+		return -1;
+	}
+	return len;
+}
+
+int sprintf_s(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, size, fmt, ap);
+	va_end(ap);
+	return len;
+}
@@ -0,0 +1,553 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ttreplay: feed recorded terminal output to the headless core.
+ *
+ *   ttreplay [options] file...
+ *
+ * Each file (raw output, or ttyrec with -t) is replayed twice:
+ *   1. in fixed size chunks, timed as a whole (throughput in MB/s)
+ *   2. split at escape sequence boundaries, each piece timed on its own
+ *      (cost per sequence type)
+ * The screen hash after both runs must be the same; a difference means
+ * the result depends on where the input was split, and is reported as an
+ * error.  With -e the hash is also compared against an expected value,
+ * and with -m the throughput of the first pass against a lower limit.
+ */
+#include "teraterm.h"
+#include "tttypes.h"
+#include "buffer.h"
+
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "hlcore.h"
+
+#define ChunkSize 4096		/* bytes per HlFeed() call in pass 1 */
+#define ClassMax 256
+#define ClassNameMax 16
+
+typedef struct {
+	char Name[ClassNameMax];
+	unsigned long Count;
+	unsigned long long Bytes;
+	unsigned long long Nsec;
+} TSeqClass;
+
+static TSeqClass Classes[ClassMax];
+static int NumOfClasses;
+static double CallOverhead;	/* ns per HlFeed() call, see Calibrate() */
+
+static THlConfig Config;
+static BOOL TtyRec = FALSE;
+static BOOL Quiet = FALSE;
+static BOOL HashOnly = FALSE;
+static int Repeat = 1;
+static const char *Expected = NULL;
+static double MinMBps = 0;
+
+static void Fatal(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	fprintf(stderr, "ttreplay: ");
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	exit(2);
+}
+
+static void Usage(void)
+{
+	fprintf(stderr,
+	        "usage: ttreplay [options] file...\n"
+	        "  -c cols     terminal width (80)\n"
+	        "  -l lines    terminal height (24)\n"
+	        "  -b lines    scroll buffer size (10000, -1: disabled)\n"
+	        "  -z MB       compressed scroll buffer size (0)\n"
+	        "  -k code     kanji code: sjis, euc, jis, utf8 (utf8)\n"
+	        "  -L lang     language: english, japanese, russian, korean, utf8\n"
+	        "              (utf8, or japanese when -k is not utf8)\n"
+	        "  -t          input files are ttyrec recordings\n"
+	        "  -n count    replay each file count times (1)\n"
+	        "  -e hash     exit with 1 unless the final screen hash is hash\n"
+	        "  -m MB/s     exit with 1 if the throughput is below MB/s\n"
+	        "  -H          print only \"hash  file\" lines\n"
+	        "  -q          do not print the sequence type table\n"
+	        "  -           read from stdin\n");
+	exit(2);
+}
+
+static double Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static unsigned long long NowNsec(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long long)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+/*
+ * Input
+ */
+
+static char *ReadFile(const char *FName, int *Len)
+{
+	FILE *fp;
+	char *buf = NULL;
+	size_t size = 0, len = 0, n;
+
+	if (strcmp(FName, "-") == 0) {
+		fp = stdin;
+	}
+	else if ((fp = fopen(FName, "rb")) == NULL) {
+		Fatal("%s: %s", FName, strerror(errno));
+	}
+	do {
+		if (len == size) {
+			size = (size == 0) ? 65536 : size * 2;
+			if ((buf = realloc(buf, size)) == NULL) {
+				Fatal("%s: out of memory", FName);
+			}
+		}
+		n = fread(buf + len, 1, size - len, fp);
+		len += n;
+	} while (n > 0);
+	if (fp != stdin) {
+		fclose(fp);
+	}
+	if (len > INT_MAX) {
+		Fatal("%s: too large", FName);
+	}
+	*Len = (int)len;
+	return buf;
+}
+
+static DWORD GetLE32(const BYTE *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+/*
+ * ttyrec: each frame is a 12 byte header (sec, usec, len; little endian)
+ * followed by len bytes of output.  The frames are joined in place.
+ */
+static int StripTtyRec(const char *FName, char *Buff, int Len)
+{
+	int src = 0, dst = 0;
+	DWORD n;
+
+	while (src + 12 <= Len) {
+		n = GetLE32((BYTE *)&Buff[src + 8]);
+		src += 12;
+		if (n > (DWORD)(Len - src)) {
+			fprintf(stderr, "ttreplay: %s: truncated ttyrec frame\n", FName);
+			n = Len - src;
+		}
+		memmove(&Buff[dst], &Buff[src], n);
+		src += n;
+		dst += n;
+	}
+	return dst;
+}
+
+/*
+ * Sequence types
+ */
+
+static TSeqClass *GetClass(const char *Name)
+{
+	int i;
+
+	for (i = 0; i < NumOfClasses; i++) {
+		if (strcmp(Classes[i].Name, Name) == 0) {
+			return &Classes[i];
+		}
+	}
+	if (NumOfClasses == ClassMax) {
+		return GetClass("other");
+	}
+	strncpy_s(Classes[NumOfClasses].Name, ClassNameMax, Name, _TRUNCATE);
+	return &Classes[NumOfClasses++];
+}
+
+/* string sequences (OSC, DCS, ...) end with BEL (OSC only), ST or CAN/SUB */
+static int StringEnd(const BYTE *p, int len, int i, BOOL Osc)
+{
+	while (i < len) {
+		if (p[i] == 0x1b) {
+			return (i + 1 < len && p[i+1] == '\\') ? i + 2 : i;
+		}
+		if ((Osc && p[i] == 0x07) || p[i] == 0x18 || p[i] == 0x1a) {
+			return i + 1;
+		}
+		i++;
+	}
+	return i;
+}
+
+/*
+ * Length of the piece starting at p[0] and its type name.  Pieces are
+ * printable runs, single C0 controls, and complete escape sequences
+ * (8-bit C1 controls are left as text since they are valid UTF-8 / SJIS
+ * bytes).
+ */
+static int NextPiece(const BYTE *p, int len, char *Name)
+{
+	static const char *C0Names[32] = {
+		"NUL", "SOH", "STX", "ETX", "EOT", "ENQ", "ACK", "BEL",
+		"BS",  "HT",  "LF",  "VT",  "FF",  "CR",  "SO",  "SI",
+		"DLE", "DC1", "DC2", "DC3", "DC4", "NAK", "SYN", "ETB",
+		"CAN", "EM",  "SUB", "ESC", "FS",  "GS",  "RS",  "US"
+	};
+	int i, n;
+	BOOL mb;
+
+	if (p[0] != 0x1b && (p[0] < 0x20)) {
+		strncpy_s(Name, ClassNameMax, C0Names[p[0]], _TRUNCATE);
+		return 1;
+	}
+
+	if (p[0] != 0x1b) {
+		mb = FALSE;
+		for (i = 0; i < len && (p[i] >= 0x20); i++) {
+			if (p[i] >= 0x80) {
+				mb = TRUE;
+			}
+		}
+		strncpy_s(Name, ClassNameMax, mb ? "text (8bit)" : "text", _TRUNCATE);
+		return i;
+	}
+
+	if (len < 2) {
+		strncpy_s(Name, ClassNameMax, "ESC", _TRUNCATE);
+		return 1;
+	}
+
+	switch (p[1]) {
+	case '[':
+		/* CSI [private] params [intermediates] final */
+		i = 2;
+		n = 0;
+		Name[n++] = 'C'; Name[n++] = 'S'; Name[n++] = 'I'; Name[n++] = ' ';
+		if (i < len && p[i] >= '<' && p[i] <= '?') {
+			Name[n++] = p[i];
+		}
+		while (i < len && p[i] >= 0x30 && p[i] <= 0x3f) {
+			i++;
+		}
+		while (i < len && p[i] >= 0x20 && p[i] <= 0x2f) {
+			if (n < ClassNameMax - 2) {
+				Name[n++] = p[i];
+			}
+			i++;
+		}
+		if (i < len && p[i] >= 0x40 && p[i] <= 0x7e) {
+			Name[n++] = p[i];
+			i++;
+		}
+		Name[n] = 0;
+		return i;
+	case ']':
+		strncpy_s(Name, ClassNameMax, "OSC", _TRUNCATE);
+		return StringEnd(p, len, 2, TRUE);
+	case 'P':
+		strncpy_s(Name, ClassNameMax, "DCS", _TRUNCATE);
+		return StringEnd(p, len, 2, FALSE);
+	case 'X':
+	case '^':
+	case '_':
+		strncpy_s(Name, ClassNameMax, "SOS/PM/APC", _TRUNCATE);
+		return StringEnd(p, len, 2, FALSE);
+	}
+
+	/* ESC [intermediates] final */
+	i = 1;
+	n = 0;
+	Name[n++] = 'E'; Name[n++] = 'S'; Name[n++] = 'C'; Name[n++] = ' ';
+	while (i < len && p[i] >= 0x20 && p[i] <= 0x2f) {
+		if (n < ClassNameMax - 2) {
+			Name[n++] = p[i];
+		}
+		i++;
+	}
+	if (i < len && p[i] >= 0x30 && p[i] <= 0x7e) {
+		Name[n++] = p[i];
+		i++;
+	}
+	Name[n] = 0;
+	return i;
+}
+
+/*
+ * Replay
+ */
+
+/*
+ * pass 1: fixed size chunks
+ *   Each chunk stands for one receive batch, and the input goes idle only at
+ *   the end, so Render tells how much of the parsed text was actually drawn.
+ */
+static unsigned long long ReplayChunks(const char *Buff, int Len, double *Sec, PRenderStats Render)
+{
+	TRenderStats Start;
+	unsigned long long h;
+	double t;
+	int r, i, n;
+
+	HlInit(&Config);
+	HlGetRenderStats(&Start);
+	t = Now();
+	for (r = 0; r < Repeat; r++) {
+		for (i = 0; i < Len; i += n) {
+			n = min(ChunkSize, Len - i);
+			HlFeed(&Buff[i], n);
+		}
+	}
+	HlIdle();
+	*Sec = Now() - t;
+	HlGetRenderStats(Render);
+	Render->Frames -= Start.Frames;
+	Render->CellsParsed -= Start.CellsParsed;
+	Render->CellsPainted -= Start.CellsPainted;
+	Render->TextRuns -= Start.TextRuns;
+	h = HlScreenHash();
+	HlEnd();
+	return h;
+}
+
+/*
+ * Every HlFeed() call costs the VTParse() prologue/epilogue (caret, buffer
+ * lock, scroll update) plus the timer itself, whatever it is fed.  Measure
+ * that with a byte that does nothing (NUL) and take it off each piece so
+ * short sequences are not buried under the per-call cost.
+ */
+static void Calibrate(void)
+{
+	unsigned long long t, sum = 0;
+	int i;
+
+	HlInit(&Config);
+	for (i = 0; i < 20000; i++) {
+		t = NowNsec();
+		HlFeed("", 1);
+		if (i >= 10000) {	/* the first half warms up */
+			sum += NowNsec() - t;
+		}
+	}
+	CallOverhead = (double)sum / 10000;
+	HlEnd();
+}
+
+/* pass 2: one piece at a time */
+static unsigned long long ReplayPieces(const char *Buff, int Len)
+{
+	char Name[ClassNameMax];
+	TSeqClass *c;
+	unsigned long long h, t;
+	int r, i, n;
+
+	HlInit(&Config);
+	for (r = 0; r < Repeat; r++) {
+		for (i = 0; i < Len; i += n) {
+			n = NextPiece((const BYTE *)&Buff[i], Len - i, Name);
+			c = GetClass(Name);
+			t = NowNsec();
+			HlFeed(&Buff[i], n);
+			c->Nsec += NowNsec() - t;
+			c->Bytes += n;
+			c->Count++;
+		}
+	}
+	h = HlScreenHash();
+	HlEnd();
+	return h;
+}
+
+static double NetNsec(const TSeqClass *c)
+{
+	double ns = c->Nsec - CallOverhead * c->Count;
+
+	return (ns > 0) ? ns : 0;
+}
+
+static int CompareClass(const void *a, const void *b)
+{
+	double x = NetNsec(a), y = NetNsec(b);
+
+	if (x != y) {
+		return (x < y) ? 1 : -1;
+	}
+	return strcmp(((const TSeqClass *)a)->Name, ((const TSeqClass *)b)->Name);
+}
+
+static void PrintClasses(void)
+{
+	double total = 0;
+	int i;
+
+	for (i = 0; i < NumOfClasses; i++) {
+		total += NetNsec(&Classes[i]);
+	}
+	if (total == 0) {
+		return;
+	}
+	qsort(Classes, NumOfClasses, sizeof(TSeqClass), CompareClass);
+
+	printf("  %-16s %10s %12s %9s %8s %6s  (%.0f ns/call subtracted)\n",
+	       "type", "count", "bytes", "ns/piece", "ns/byte", "time", CallOverhead);
+	for (i = 0; i < NumOfClasses; i++) {
+		printf("  %-16s %10lu %12llu %9.1f %8.2f %5.1f%%\n",
+		       Classes[i].Name, Classes[i].Count, Classes[i].Bytes,
+		       NetNsec(&Classes[i]) / Classes[i].Count,
+		       NetNsec(&Classes[i]) / Classes[i].Bytes,
+		       100.0 * NetNsec(&Classes[i]) / total);
+	}
+}
+
+static int Replay(const char *FName)
+{
+	char *Buff;
+	int Len;
+	unsigned long long h1, h2;
+	double sec, mbps;
+	char hash[17];
+	TRenderStats Render;
+
+	Buff = ReadFile(FName, &Len);
+	if (TtyRec) {
+		Len = StripTtyRec(FName, Buff, Len);
+	}
+
+	memset(Classes, 0, sizeof(Classes));
+	NumOfClasses = 0;
+	h1 = ReplayChunks(Buff, Len, &sec, &Render);
+	h2 = HashOnly ? h1 : ReplayPieces(Buff, Len);
+	free(Buff);
+
+	_snprintf_s(hash, sizeof(hash), _TRUNCATE, "%016llx", h1);
+	mbps = (sec > 0) ? (double)Len * Repeat / sec / 1e6 : 0.0;
+	if (HashOnly) {
+		printf("%s  %s\n", hash, FName);
+	}
+	else {
+		printf("%s: %d bytes x %d, %.3f s, %.2f MB/s, screen hash %s\n",
+		       FName, Len, Repeat, sec, mbps, hash);
+		printf("  %lu frames, %lu cells parsed, %lu cells painted (%.1f%%) in %lu text runs\n",
+		       (unsigned long)Render.Frames, (unsigned long)Render.CellsParsed,
+		       (unsigned long)Render.CellsPainted,
+		       (Render.CellsParsed > 0) ? 100.0 * Render.CellsPainted / Render.CellsParsed : 0.0,
+		       (unsigned long)Render.TextRuns);
+		if (! Quiet) {
+			PrintClasses();
+		}
+	}
+
+	if (h1 != h2) {
+		fprintf(stderr, "ttreplay: %s: screen hash depends on input splitting (%016llx / %016llx)\n",
+		        FName, h1, h2);
+		return 1;
+	}
+	if (Expected != NULL && _stricmp(Expected, hash) != 0) {
+		fprintf(stderr, "ttreplay: %s: screen hash %s, expected %s\n", FName, hash, Expected);
+		return 1;
+	}
+	if (MinMBps > 0 && mbps < MinMBps) {
+		fprintf(stderr, "ttreplay: %s: %.2f MB/s, expected at least %.2f MB/s\n", FName, mbps, MinMBps);
+		return 1;
+	}
+	return 0;
+}
+
+static int ParseKanjiCode(const char *s)
+{
+	if (_stricmp(s, "sjis") == 0) return IdSJIS;
+	if (_stricmp(s, "euc") == 0) return IdEUC;
+	if (_stricmp(s, "jis") == 0) return IdJIS;
+	if (_stricmp(s, "utf8") == 0 || _stricmp(s, "utf-8") == 0) return IdUTF8;
+	Fatal("unknown kanji code: %s", s);
+	return 0;
+}
+
+static int ParseLanguage(const char *s)
+{
+	if (_stricmp(s, "english") == 0) return IdEnglish;
+	if (_stricmp(s, "japanese") == 0) return IdJapanese;
+	if (_stricmp(s, "russian") == 0) return IdRussian;
+	if (_stricmp(s, "korean") == 0) return IdKorean;
+	if (_stricmp(s, "utf8") == 0 || _stricmp(s, "utf-8") == 0) return IdUtf8;
+	Fatal("unknown language: %s", s);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int c, ret = 0;
+
+	while ((c = getopt(argc, argv, "c:l:b:z:k:L:tn:e:m:Hq")) != -1) {
+		switch (c) {
+		case 'c': Config.Columns = atoi(optarg); break;
+		case 'l': Config.Lines = atoi(optarg); break;
+		case 'b': Config.ScrollBuffSize = atoi(optarg); break;
+		case 'z': Config.CompressedBuffSize = atoi(optarg); break;
+		case 'k': Config.KanjiCode = ParseKanjiCode(optarg); break;
+		case 'L': Config.Language = ParseLanguage(optarg); break;
+		case 't': TtyRec = TRUE; break;
+		case 'n': Repeat = max(atoi(optarg), 1); break;
+		case 'e': Expected = optarg; break;
+		case 'm': MinMBps = atof(optarg); break;
+		case 'H': HashOnly = TRUE; break;
+		case 'q': Quiet = TRUE; break;
+		default: Usage();
+		}
+	}
+	if (optind >= argc) {
+		Usage();
+	}
+	if (Config.Language == 0 && Config.KanjiCode != 0 && Config.KanjiCode != IdUTF8) {
+		Config.Language = IdJapanese;
+	}
+
+	if (! HashOnly) {
+		Calibrate();
+	}
+	for (; optind < argc; optind++) {
+		ret |= Replay(argv[optind]);
+	}
+	return ret;
+}
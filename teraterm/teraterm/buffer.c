@@ -33,6 +33,10 @@
 #include "tttypes.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <assert.h>
+#include <zlib.h>
 
 #include "ttwinman.h"
 #include "teraprn.h"
@@ -43,6 +47,11 @@
 
 #include "buffer.h"
 
+// Oniguruma: Regular expression library
+#define ONIG_EXTERN extern
+#include "oniguruma.h"
+#undef ONIG_EXTERN
+
 // URLi΍莁pb` 2005/4/2j
 #define URL_EMPHASIS 1
 
@@ -64,26 +73,63 @@ static WORD TabStops[256];
 static int NTabStops;
 
 static WORD BuffLock = 0;
-static HANDLE HCodeBuff = 0;
-static HANDLE HAttrBuff = 0;
-static HANDLE HAttrBuff2 = 0;
-static HANDLE HAttrBuffFG = 0;
-static HANDLE HAttrBuffBG = 0;
-
-static PCHAR CodeBuff;  /* Character code buffer */
-static PCHAR AttrBuff;  /* Attribute buffer */
-static PCHAR AttrBuff2; /* Color attr buffer */
-static PCHAR AttrBuffFG; /* Foreground color attr buffer */
-static PCHAR AttrBuffBG; /* Background color attr buffer */
-static PCHAR CodeLine;
-static PCHAR AttrLine;
-static PCHAR AttrLine2;
-static PCHAR AttrLineFG;
-static PCHAR AttrLineBG;
+/*
+ * XN[obt@ 1 Z
+ *   ]͕R[hƑ 5 ̕ʁX̃obt@ɎĂA
+ *   XN[}/폜̂т 5 񂸂 memmove/memset ̂
+ *   1 Z 5 oCg̍\̂ɂ܂Ƃ߂ 1 ōςނ悤ɂB
+ *   XN[̑͏oCgŌ܂̂ŁAZɋlߕ͓ȂB
+ */
+typedef struct {
+	char Code;
+	BYTE Attr;
+	BYTE Attr2;
+	BYTE Fore;
+	BYTE Back;
+} TCell;
+typedef TCell *PCell;
+
+static HANDLE HCellBuff = 0;
+
+static PCell CellBuff;  /* Character code & attribute buffer */
+/*
+ * M Unicode ̕ʒu
+ *   Rs[pɁACellBuff Ɠт UniBuff Ɏ (0: Code 狁߂)B
+ *   قƂǂ̍s͕ʒuȂ̂ŁALineUni[s]  0 ̍s UniBuff 
+ *   ɂׂ 0 Ƃ݂ȂBs̏ LineUni  0 ɂ邾ōςށB
+ *   UniBuff ͍ŏɕʒuƂɊmۂB
+ */
+static LPDWORD UniBuff = NULL;
+static LPBYTE LineUni = NULL;  // CellBuff ̍sƂ UniBuff L
+static DWORD PutUni = 0;  // BuffPutChar()/BuffPutKanji() ŏޕ̕ʒu
+static PCell CellLine;
 static LONG LinePtr;
 static LONG BufferSize;
 static int NumOfLinesInBuff;
 static int BuffStartAbs, BuffEndAbs;
+/*
+ * s̕ёւ\
+ *   Oobt@̍sʒu (BuffStartAbs ȂǂƓP)  CellBuff 
+ *   s̑ΉBXN[͈͓̃XN[s̑}E폜
+ *   Zړɂ̕\]čsB
+ */
+static int *LineMap;   // Oobt@̍sʒu  CellBuff ̍s
+static int *LineSlot;  // CellBuff ̍s  Oobt@̍sʒu
+static LPBYTE LineURLDirty;  // CellBuff ̍sƂ URL tKv邩
+/*
+ * `҂͈̔
+ *   M͂̏ł͕`悹Aʂ̍s (CursorY ƓW) Ƃ
+ *   Z͈̔ DamageLeft[y] ` DamageRight[y]-1 L^ĂA
+ *   BuffFlushDamage() ł܂Ƃ߂ĕ`悷BDamageLeft >= DamageRight ̍s͕`ς݁B
+ *   `҂̍s DamageTop ` DamageBottom ̊ԂɂB
+ *   s̓eXN[s̑}E폜ňڂƂ͔͈͂ꏏɈڂB
+ */
+static LPWORD DamageLeft, DamageRight;
+static int DamageTop, DamageBottom;
+static TRenderStats RenderStats;
+static DWORD FrameParsed, FramePainted;  // `撆̃t[ŏE`悵Z
+static DWORD TextRuns;  // DispStr() ɓn̐
+static DWORD LastFrameTick;
 static POINT SelectStart, SelectEnd, SelectEndOld;
 static BOOL BoxSelect;
 static POINT DblClkStart, DblClkEnd;
@@ -94,47 +140,854 @@ static BOOL SeveralPageSelect;  // add (2005.5.15 yutaka)
 
 static TCharAttr CurCharAttr;
 
+/*
+ * kXN[obt@
+ *   Oobt@ (CellBuff) 炠ӂꂽÂs ColdBlockLines s
+ *   ubNɂ܂Ƃ߁Azlib ňkĕێB
+ *   sԍ 0 ` ColdLines-1 kAColdLines ` BuffEnd-1 Oobt@B
+ *
+ *   kꂽs̓XN[IŎQƂꂽƂɃubNPʂœWJA
+ *   CellBuff  BufferSize ȍ~ɂ\p̈ɒuB\p̈
+ *   2 ubNAubNԍ̋ŎĝŁAאڂ
+ *   2 ubNɂ܂͈ ( 1 Ȃ) ͓ɎQƂłB
+ */
+#define ColdBlockLines 1024
+#define ColdLinesMax 100000000
+#define ColdRawSize(w) ((LONG)sizeof(TCell) * ColdBlockLines * (w))
+#define ColdUniSize(w) ((LONG)sizeof(DWORD) * ColdBlockLines * (w))
+#define ColdPlanes 5  // kƂɃZ𕪂ʂ̐
+#define ColdUniPlanes 3  // ʒuubNőʂ̐
+
+typedef struct {
+	PCell Raw;    // kÕf[^ (̃ubN̂)
+	LPDWORD RawUni;  // Raw ̕ʒu (ʒusȂ NULL)
+	BOOL Uni;     // Data ɕʒu̖ʂ邩
+	LPBYTE Data;  // k̃f[^
+	uLong Size;   // Data ̃TCY
+	int Lines;
+	int Width;
+} TColdBlock;
+typedef TColdBlock *PColdBlock;
+
+static BOOL ColdView = FALSE;  // CellBuff ɕ\p̈悪邩
+static PColdBlock ColdBlocks = NULL;
+static int NumOfColdBlocks = 0;
+static int ColdBlocksAlloc = 0;
+static int ColdLines = 0;
+static LONG ColdMemory = 0;
+static int ColdSlotBlock[2] = {-1, -1};
+static int ColdSlotLines[2];
+static TCell ColdLastCell;  // kXN[obt@̍ŏIs̍s
+
+static LONG GetColdLinePtr(int Line);
+static int GetColdSlotLine(LONG Ptr);
+static void FreeCellBuffer();
+static void MarkURLDirty(LONG Ptr);
+static BOOL MarkURL(LONG Ptr, int *XStart, int *XEnd);
+static void SearchReset();
+static void SearchRollback(int Line);
+static void SearchDropLines(int Count);
+static void SearchAddLine(int Line, PCell Src);
+
 HANDLE SaveBuff = NULL;
 int SaveBuffX;
 int SaveBuffY;
 
 LONG GetLinePtr(int Line)
 {
-	LONG Ptr;
+	int Slot;
 
-	Ptr = (LONG)(BuffStartAbs + Line) * (LONG)(NumOfColumns);
-	while (Ptr>=BufferSize) {
-		Ptr = Ptr - BufferSize;
+	assert(Line >= 0);
+	if (Line < ColdLines) {
+		return GetColdLinePtr(Line);
 	}
-	return Ptr;
+	Slot = BuffStartAbs + Line - ColdLines;
+	while (Slot>=NumOfLinesInBuff) {
+		Slot = Slot - NumOfLinesInBuff;
+	}
+	return (LONG)LineMap[Slot] * NumOfColumns;
 }
 
 LONG NextLinePtr(LONG Ptr)
 {
-	Ptr = Ptr + (LONG)NumOfColumns;
-	if (Ptr >= BufferSize) {
-		Ptr = Ptr - BufferSize;
+	int Row, Slot;
+
+	if (Ptr >= BufferSize) { // kXN[obt@̕\p̈
+		return GetLinePtr(GetColdSlotLine(Ptr) + 1) + (Ptr - BufferSize) % NumOfColumns;
 	}
-	return Ptr;
+	Row = Ptr / NumOfColumns;
+	Slot = LineSlot[Row] + 1;
+	if (Slot >= NumOfLinesInBuff) {
+		Slot = 0;
+	}
+	return (LONG)LineMap[Slot] * NumOfColumns + (Ptr - (LONG)Row * NumOfColumns);
 }
 
 LONG PrevLinePtr(LONG Ptr)
 {
-	Ptr = Ptr - (LONG)NumOfColumns;
-	if (Ptr < 0) {
-		Ptr = Ptr + BufferSize;
+	int Row, Slot;
+
+	if (Ptr >= BufferSize) { // kXN[obt@̕\p̈
+		return GetLinePtr(GetColdSlotLine(Ptr) - 1) + (Ptr - BufferSize) % NumOfColumns;
+	}
+	Row = Ptr / NumOfColumns;
+	Slot = LineSlot[Row];
+	if (ColdLines > 0 && Slot == BuffStartAbs) {
+		// Oobt@̐擪s̑O͈kXN[obt@̍ŏIs
+		return GetLinePtr(ColdLines - 1) + (Ptr - (LONG)Row * NumOfColumns);
+	}
+	Slot--;
+	if (Slot < 0) {
+		Slot = NumOfLinesInBuff - 1;
+	}
+	return (LONG)LineMap[Slot] * NumOfColumns + (Ptr - (LONG)Row * NumOfColumns);
+}
+
+// Rows s Cells Z UniBuff mۂ
+//   sƂ LineUni ͖ɒuA0 ɂĂ
+static LPDWORD NewUniBuff(LONG Cells, int Rows)
+{
+	LPDWORD p;
+
+	if ((p = (LPDWORD)malloc(sizeof(DWORD) * Cells + Rows)) != NULL) {
+		memset(&p[Cells], 0, Rows);
+	}
+	return p;
+}
+
+// ʒuO UniBuff mۂ
+static BOOL AllocUni()
+{
+	LONG Cells;
+	int Rows;
+
+	if (UniBuff != NULL) {
+		return TRUE;
+	}
+	Rows = NumOfLinesInBuff + (ColdView ? 2 * ColdBlockLines : 0);
+	Cells = (LONG)Rows * NumOfColumns;
+	if ((UniBuff = NewUniBuff(Cells, Rows)) == NULL) {
+		return FALSE;
+	}
+	LineUni = (LPBYTE)&UniBuff[Cells];
+	return TRUE;
+}
+
+// CellBuff  Row sڂ UniBuff gn߂
+static void UseLineUni(int Row)
+{
+	if (! LineUni[Row]) {
+		memset(&UniBuff[(LONG)Row * NumOfColumns], 0, sizeof(DWORD) * NumOfColumns);
+		LineUni[Row] = 1;
+	}
+}
+
+// CellBuff  Ptr ܂ލsʒu
+static BOOL LineHasUni(LONG Ptr)
+{
+	return LineUni != NULL && LineUni[Ptr / NumOfColumns];
+}
+
+// CellBuff  Ptr  Count Z̕ʒu 0 ɂ (s܂ł悢)
+//   ̂тɌĂ΂̂ŁAʒuȂ͊֐Ă΂ɍς܂
+#define ClearUni(Ptr, Count) (LineUni != NULL ? ClearLineUni(Ptr, Count) : (void)0)
+
+static void ClearLineUni(LONG Ptr, LONG Count)
+{
+	LONG End, RowStart, RowEnd;
+	int Row;
+
+	if (Count <= 0) {
+		return;
+	}
+	End = Ptr + Count;
+	for (Row = Ptr / NumOfColumns; (LONG)Row * NumOfColumns < End; Row++) {
+		if (! LineUni[Row]) {
+			continue;
+		}
+		RowStart = (LONG)Row * NumOfColumns;
+		RowEnd = RowStart + NumOfColumns;
+		if (Ptr <= RowStart && End >= RowEnd) {
+			LineUni[Row] = 0;
+		}
+		else {
+			RowStart = max(RowStart, Ptr);
+			RowEnd = min(RowEnd, End);
+			memset(&UniBuff[RowStart], 0, sizeof(DWORD) * (RowEnd - RowStart));
+		}
+	}
+}
+
+// CellBuff ̃Z c ̕ʒu
+static DWORD GetCellUni(PCell c)
+{
+	LONG Ptr = (LONG)(c - CellBuff);
+
+	return LineHasUni(Ptr) ? UniBuff[Ptr] : 0;
+}
+
+// CellBuff ̃Z c ɕʒu u 
+//   u  0 ł̂ŁACode Ȃ SetCellCode() ̑ɂȂ
+static void SetCellUni(PCell c, DWORD u)
+{
+	LONG Ptr = (LONG)(c - CellBuff);
+
+	if (! LineHasUni(Ptr)) {
+		if (u == 0 || ! AllocUni()) {
+			return;
+		}
+		UseLineUni(Ptr / NumOfColumns);
+	}
+	UniBuff[Ptr] = u;
+}
+
+// CellBuff ̃Z c ̕ς
+//   Code ςACode 狁߂Ȃʒu͏Ă
+#define SetCellCode(c, ch) ((c).Code = (ch), ClearUni((LONG)(&(c) - CellBuff), 1))
+
+// Src  Count Z̕ʒu CellBuff  Ptr ɏ (Src  NULL Ȃ 0 ɂ)
+static void PutLineUni(LONG Ptr, LPDWORD Src, int Count)
+{
+	int i;
+
+	if (Src != NULL) {
+		for (i=0; i<Count && Src[i]==0; i++) {
+		}
+		if (i < Count && AllocUni()) {
+			UseLineUni(Ptr / NumOfColumns);
+			memcpy(&UniBuff[Ptr], Src, sizeof(DWORD)*Count);
+			return;
+		}
+	}
+	ClearUni(Ptr, Count);
+}
+
+// CellBuff  Ptr  Count Z̕ʒu Dest Ɏo
+static void GetLineUni(LONG Ptr, LPDWORD Dest, int Count)
+{
+	if (LineHasUni(Ptr)) {
+		memcpy(Dest, &UniBuff[Ptr], sizeof(DWORD)*Count);
+	}
+	else {
+		memset(Dest, 0, sizeof(DWORD)*Count);
+	}
+}
+
+// CellBuff  SrcPtr  Count Z DestPtr Ɉڂ
+//   dȂĂ悢ACount Z͂ꂼ 1 sɎ܂Ă邱
+static void MoveCells(LONG DestPtr, LONG SrcPtr, int Count)
+{
+	memmove(&CellBuff[DestPtr], &CellBuff[SrcPtr], sizeof(TCell)*Count);
+	if (! LineHasUni(SrcPtr)) {
+		ClearUni(DestPtr, Count);
+		return;
+	}
+	UseLineUni(DestPtr / NumOfColumns);
+	memmove(&UniBuff[DestPtr], &UniBuff[SrcPtr], sizeof(DWORD)*Count);
+}
+
+// Dest  Count Zw肵ƑŖ߂
+//   CellBuff ̒ȂAĂяo ClearUni() s
+static void FillCells(PCell Dest, int Count, char Code, BYTE Attr, BYTE Attr2, BYTE Fore, BYTE Back)
+{
+	TCell c;
+	int i;
+
+	c.Code = Code;
+	c.Attr = Attr;
+	c.Attr2 = Attr2;
+	c.Fore = Fore;
+	c.Back = Back;
+	for (i=0; i<Count; i++) {
+		Dest[i] = c;
+	}
+}
+
+/*
+ * p̋󔒍s
+ *   EraseCells() ݂͌̔wiF̋ 1 sĂA memcpy B
+ *   Z 1 葬BBlankWidth ͍ĂZ̐ŁA
+ *   wiFʂ̕ς蒼B
+ */
+static TCell BlankLine[BuffXMax];
+static int BlankWidth = 0;
+
+// CellBuff  Dest  Count Z݂̔wiF̋󔒂Ŗ߂
+static void EraseCells(PCell Dest, int Count)
+{
+	BYTE Attr2 = (BYTE)(CurCharAttr.Attr2 & Attr2ColorMask);
+	int n;
+
+	ClearUni((LONG)(Dest - CellBuff), Count);
+	if (BlankWidth != NumOfColumns || BlankLine[0].Attr2 != Attr2 ||
+	    BlankLine[0].Fore != CurCharAttr.Fore || BlankLine[0].Back != CurCharAttr.Back) {
+		BlankWidth = min(NumOfColumns, BuffXMax);
+		FillCells(BlankLine, BlankWidth, 0x20, AttrDefault, Attr2, CurCharAttr.Fore, CurCharAttr.Back);
+	}
+	while (Count > 0) {
+		n = min(Count, BlankWidth);
+		memcpy(Dest, BlankLine, sizeof(TCell)*n);
+		Dest += n;
+		Count -= n;
+	}
+}
+
+// Line sڂ Count s݂̔wiF̋󔒂Ŗ߂
+//   NextLinePtr() ͏ZĝŁAsԍ GetLinePtr() ŋ߂
+static void EraseLines(int Line, int Count)
+{
+	int i;
+
+	for (i=0; i<Count; i++) {
+		EraseCells(&CellBuff[GetLinePtr(Line+i)], NumOfColumns);
+	}
+}
+
+// Oobt@̍sʒu Slot  Count s̕тtɂ
+static void ReverseLines(int Slot, int Count)
+{
+	int i, j, t;
+
+	i = Slot;
+	j = Slot + Count - 1;
+	if (j >= NumOfLinesInBuff) {
+		j = j - NumOfLinesInBuff;
+	}
+	for (; Count > 1; Count -= 2) {
+		t = LineMap[i];
+		LineMap[i] = LineMap[j];
+		LineMap[j] = t;
+		LineSlot[LineMap[i]] = i;
+		LineSlot[LineMap[j]] = j;
+		if (++i >= NumOfLinesInBuff) {
+			i = 0;
+		}
+		if (--j < 0) {
+			j = NumOfLinesInBuff - 1;
+		}
+	}
+}
+
+// Line sڂ Count s n sɉ] (n < 0 Ȃ牺)
+//   ͈͂͂ݏos͔Α̒[ɉ̂ŁAĂяoŏ
+static void RotateLines(int Line, int Count, int n)
+{
+	int Slot, Head;
+
+	if (Count <= 1) {
+		return;
+	}
+	n = n % Count;
+	if (n < 0) {
+		n = n + Count;
+	}
+	if (n == 0) {
+		return;
+	}
+	Slot = BuffStartAbs + Line - ColdLines;
+	while (Slot >= NumOfLinesInBuff) {
+		Slot = Slot - NumOfLinesInBuff;
+	}
+	Head = Slot + n;
+	if (Head >= NumOfLinesInBuff) {
+		Head = Head - NumOfLinesInBuff;
+	}
+	ReverseLines(Slot, n);
+	ReverseLines(Head, Count - n);
+	ReverseLines(Slot, Count);
+
+	// J[\sڂȂ̂Ŏ蒼
+	LinePtr = GetLinePtr(PageStart+CursorY);
+	CellLine = &CellBuff[LinePtr];
+}
+
+// ʂ Y sڂ XStart  Count Z`҂ɂ
+static void DamageAdd(int Y, int XStart, int Count)
+{
+	if (Y < 0 || Y >= NumOfLines || Count <= 0) {
+		return;
+	}
+	if (DamageLeft[Y] >= DamageRight[Y]) {
+		DamageLeft[Y] = XStart;
+		DamageRight[Y] = XStart + Count;
+	}
+	else {
+		DamageLeft[Y] = min(DamageLeft[Y], XStart);
+		DamageRight[Y] = max(DamageRight[Y], XStart + Count);
+	}
+	DamageTop = min(DamageTop, Y);
+	DamageBottom = max(DamageBottom, Y);
+}
+
+// ʂ XStart, YStart  XEnd, YEnd ܂ (XEnd, YEnd ܂) `҂ɂ
+static void DamageRect(int XStart, int YStart, int XEnd, int YEnd)
+{
+	int y;
+
+	for (y = max(YStart, 0) ; y <= YEnd && y < NumOfLines ; y++) {
+		DamageAdd(y, max(XStart, 0), min(XEnd, NumOfColumns-1) - max(XStart, 0) + 1);
+	}
+}
+
+// ʂ Top s Bottom s̓e n s (n < 0 Ȃ牺) ڂ̂ŁA
+// `҂͈̔͂ꏏɈڂ
+//   ͈͂̊Oɏos͉ʏł͈͂̊OɉôŎ̂ĂB
+//   XN[obt@֏os܂Ă (XN[obt@
+//   \) ꍇ́AEBhEŜĕ`悳B
+static void DamageScroll(int Top, int Bottom, int n)
+{
+	int y, d, Step, Last, Moved;
+
+	if (Top < 0) {
+		Top = 0;
+	}
+	if (Bottom >= NumOfLines) {
+		Bottom = NumOfLines-1;
+	}
+	if (n == 0 || DamageTop > Bottom || DamageBottom < Top) {
+		return;
+	}
+
+	// ֈڂƂ͏̍sAֈڂƂ͉̍s珈
+	if (n > 0) {
+		y = max(Top, DamageTop);
+		Last = min(Bottom, DamageBottom);
+		Step = 1;
+	}
+	else {
+		y = min(Bottom, DamageBottom);
+		Last = max(Top, DamageTop);
+		Step = -1;
+	}
+	Moved = 0;
+	for (; y != Last + Step ; y += Step) {
+		if (DamageLeft[y] >= DamageRight[y]) {
+			continue;
+		}
+		d = y - n;
+		if (d >= Top && d <= Bottom) {
+			DamageLeft[d] = DamageLeft[y];
+			DamageRight[d] = DamageRight[y];
+			Moved++;
+		}
+		else if (Top == 0 && d < 0 && d >= NewOrgY) {
+			InvalidateRect(HVTWin, NULL, FALSE);
+		}
+		DamageLeft[y] = DamageRight[y] = 0;
+	}
+
+	if (Moved == 0 && DamageTop >= Top && DamageBottom <= Bottom) {
+		DamageTop = NumOfLines;
+		DamageBottom = -1;
+	}
+	else {
+		DamageTop = max(0, min(DamageTop, max(Top, DamageTop - n)));
+		DamageBottom = min(NumOfLines-1, max(DamageBottom, min(Bottom, DamageBottom - n)));
+	}
+}
+
+// Src  Count Z̕R[h Dest ɃRs[
+static void CopyCellCodes(PCHAR Dest, PCell Src, int Count)
+{
+	int i;
+
+	for (i=0; i<Count; i++) {
+		Dest[i] = Src[i].Code;
+	}
+}
+
+// DispStr() ɓn߁AR[hÄɎo
+//   Ԃľ͎Ăяo܂ŗL
+static PCHAR GetCellCodes(PCell Src, int Count)
+{
+	static char CodeStr[BuffXMax+1];
+
+	if (Count > BuffXMax) {
+		Count = BuffXMax;
+	}
+	CopyCellCodes(CodeStr, Src, Count);
+	CodeStr[Count] = 0;
+	return CodeStr;
+}
+
+// Src ( SrcWidth)  1 s Dest ( DestWidth) ɃRs[
+//   Dest ̕Lꍇ͋󔒂Ŗ߁AE[Ő؂ꂽSp͏
+//   DestUni, SrcUni ͂ꂼ̍s̕ʒu
+//   (DestUni  NULL Ȃ畄ʒu̓Rs[ȂBSrcUni  NULL Ȃ 0 Ƃ)
+static void CopyLineCells(PCell Dest, LPDWORD DestUni, int DestWidth, PCell Src, LPDWORD SrcUni, int SrcWidth)
+{
+	int w;
+
+	w = (SrcWidth < DestWidth) ? SrcWidth : DestWidth;
+	memcpy(Dest, Src, sizeof(TCell)*w);
+	if (DestUni != NULL) {
+		if (SrcUni != NULL) {
+			memcpy(DestUni, SrcUni, sizeof(DWORD)*w);
+			memset(&DestUni[w], 0, sizeof(DWORD)*(DestWidth-w));
+		}
+		else {
+			memset(DestUni, 0, sizeof(DWORD)*DestWidth);
+		}
+	}
+	if (w < DestWidth) {
+		FillCells(&Dest[w], DestWidth-w, 0x20, AttrDefault, AttrDefault, AttrDefaultFG, AttrDefaultBG);
+	}
+	else if (w > 0 && (Dest[w-1].Attr & AttrKanji)) {
+		Dest[w-1].Code = ' ';
+		Dest[w-1].Attr ^= AttrKanji;
+		if (DestUni != NULL) {
+			DestUni[w-1] = 0;
+		}
+	}
+}
+
+// ɐVubNǉ
+static BOOL ColdNewBlock()
+{
+	PColdBlock p;
+	int n;
+
+	if (NumOfColdBlocks >= ColdBlocksAlloc) {
+		n = (ColdBlocksAlloc > 0) ? ColdBlocksAlloc * 2 : 64;
+		p = (PColdBlock)realloc(ColdBlocks, sizeof(TColdBlock) * n);
+		if (p == NULL) {
+			return FALSE;
+		}
+		ColdBlocks = p;
+		ColdBlocksAlloc = n;
+	}
+	p = &ColdBlocks[NumOfColdBlocks];
+	p->Raw = (PCell)malloc(ColdRawSize(NumOfColumns));
+	if (p->Raw == NULL) {
+		return FALSE;
+	}
+	p->RawUni = NULL;
+	p->Uni = FALSE;
+	p->Data = NULL;
+	p->Size = 0;
+	p->Lines = 0;
+	p->Width = NumOfColumns;
+	ColdMemory += ColdRawSize(NumOfColumns);
+	NumOfColdBlocks++;
+	return TRUE;
+}
+
+// ܂ubNk
+//   Ẑ܂܂葮Ƃɂ܂Ƃ߂悭kނ̂ŁA
+//   Code, Attr, Attr2, Fore, Back (ƕʒu 3 oCg) ̏ɕבւĂ爳kB
+//   sꍇ͈kÕf[^̂܂܎B
+static void ColdCompressBlock(PColdBlock p)
+{
+	LONG n, i;
+	int NumOfPlanes;
+	LPBYTE Planes, Data;
+	uLong Size;
+
+	n = (LONG)p->Lines * p->Width;
+	NumOfPlanes = ColdPlanes + (p->RawUni != NULL ? ColdUniPlanes : 0);
+	if ((Planes = (LPBYTE)malloc(n * NumOfPlanes)) == NULL) {
+		return;
+	}
+	for (i=0; i<n; i++) {
+		Planes[i] = p->Raw[i].Code;
+		Planes[n+i] = p->Raw[i].Attr;
+		Planes[n*2+i] = p->Raw[i].Attr2;
+		Planes[n*3+i] = p->Raw[i].Fore;
+		Planes[n*4+i] = p->Raw[i].Back;
+	}
+	if (p->RawUni != NULL) {
+		for (i=0; i<n; i++) {
+			Planes[n*5+i] = (BYTE)p->RawUni[i];
+			Planes[n*6+i] = (BYTE)(p->RawUni[i] >> 8);
+			Planes[n*7+i] = (BYTE)(p->RawUni[i] >> 16);
+		}
+	}
+
+	Size = compressBound(n * NumOfPlanes);
+	Data = (LPBYTE)malloc(Size);
+	if (Data != NULL && compress2(Data, &Size, Planes, n * NumOfPlanes, Z_BEST_SPEED) == Z_OK) {
+		p->Data = (LPBYTE)realloc(Data, Size);
+		if (p->Data == NULL) {
+			p->Data = Data;
+		}
+		p->Size = Size;
+		free(p->Raw);
+		p->Raw = NULL;
+		ColdMemory += (LONG)Size - ColdRawSize(p->Width);
+		if (p->RawUni != NULL) {
+			free(p->RawUni);
+			p->RawUni = NULL;
+			p->Uni = TRUE;
+			ColdMemory -= ColdUniSize(p->Width);
+		}
+	}
+	else {
+		free(Data);
+	}
+	free(Planes);
+}
+
+// ubN b \p̈ Slot ɓWJ
+static void ColdLoadBlock(int b, int Slot)
+{
+	PColdBlock p;
+	PCell Dest, c;
+	LPBYTE Planes;
+	LONG n, i, DestPtr;
+	uLongf Size;
+	int x, y, NumOfPlanes;
+	BOOL Uni;
+
+	if (ColdBlocks == NULL || ColdLines == 0 || b < 0 || b >= NumOfColdBlocks) {
+		return;
+	}
+	p = &ColdBlocks[b];
+	DestPtr = BufferSize + (LONG)Slot * ColdBlockLines * NumOfColumns;
+	Dest = &CellBuff[DestPtr];
+	n = (LONG)p->Lines * p->Width;
+
+	// ʒuubNȂAWJ̍s UniBuff g
+	ClearUni(DestPtr, (LONG)ColdBlockLines * NumOfColumns);
+	Uni = (p->RawUni != NULL || p->Uni) && AllocUni();
+	if (Uni) {
+		for (y=0; y<p->Lines; y++) {
+			UseLineUni(DestPtr / NumOfColumns + y);
+		}
+	}
+
+	if (p->Raw != NULL) {
+		for (y=0; y<p->Lines; y++) {
+			CopyLineCells(&Dest[(LONG)y*NumOfColumns], Uni ? &UniBuff[DestPtr+(LONG)y*NumOfColumns] : NULL, NumOfColumns,
+			              &p->Raw[(LONG)y*p->Width], p->RawUni ? &p->RawUni[(LONG)y*p->Width] : NULL, p->Width);
+		}
+	}
+	else {
+		FillCells(Dest, p->Lines * NumOfColumns, 0x20, AttrDefault, AttrDefault, AttrDefaultFG, AttrDefaultBG);
+		NumOfPlanes = ColdPlanes + (p->Uni ? ColdUniPlanes : 0);
+		if ((Planes = (LPBYTE)malloc(n * NumOfPlanes)) != NULL) {
+			Size = n * NumOfPlanes;
+			if (uncompress(Planes, &Size, p->Data, p->Size) == Z_OK && Size == (uLongf)(n * NumOfPlanes)) {
+				for (y=0; y<p->Lines; y++) {
+					for (x=0; x<p->Width && x<NumOfColumns; x++) {
+						i = (LONG)y * p->Width + x;
+						c = &Dest[(LONG)y * NumOfColumns + x];
+						c->Code = Planes[i];
+						c->Attr = Planes[n+i];
+						c->Attr2 = Planes[n*2+i];
+						c->Fore = Planes[n*3+i];
+						c->Back = Planes[n*4+i];
+						if (Uni && p->Uni) {
+							UniBuff[DestPtr + (LONG)y * NumOfColumns + x] =
+								(DWORD)Planes[n*5+i] | ((DWORD)Planes[n*6+i] << 8) | ((DWORD)Planes[n*7+i] << 16);
+						}
+					}
+					if (p->Width > NumOfColumns && (c->Attr & AttrKanji)) {
+						SetCellCode(*c, ' ');
+						c->Attr ^= AttrKanji;
+					}
+				}
+			}
+			free(Planes);
+		}
+	}
+
+	ColdSlotBlock[Slot] = b;
+	ColdSlotLines[Slot] = p->Lines;
+}
+
+static LONG GetColdLinePtr(int Line)
+{
+	int b, Slot;
+
+	// kXN[obt@ () ȂAOobt@̐擪sԂ
+	if (ColdBlocks == NULL || ColdLines == 0) {
+		return (LONG)LineMap[BuffStartAbs] * NumOfColumns;
+	}
+	if (Line < 0) {
+		Line = 0;
+	}
+	else if (Line >= ColdLines) {
+		Line = ColdLines - 1;
+	}
+	b = Line / ColdBlockLines;
+	Slot = b & 1;
+	if (ColdSlotBlock[Slot] != b || ColdSlotLines[Slot] != ColdBlocks[b].Lines) {
+		ColdLoadBlock(b, Slot);
+	}
+	return BufferSize + ((LONG)Slot * ColdBlockLines + Line % ColdBlockLines) * NumOfColumns;
+}
+
+// \p̈̈ʒusԍ߂
+static int GetColdSlotLine(LONG Ptr)
+{
+	LONG SlotSize;
+
+	Ptr = Ptr - BufferSize;
+	SlotSize = (LONG)ColdBlockLines * NumOfColumns;
+	return ColdSlotBlock[Ptr / SlotSize] * ColdBlockLines + (int)((Ptr % SlotSize) / NumOfColumns);
+}
+
+static void ColdInvalidateSlots()
+{
+	ColdSlotBlock[0] = ColdSlotBlock[1] = -1;
+}
+
+// Oobt@̐擪 (ԌÂs)  Count skXN[obt@Ɉڂ
+//   Ԃl͈ڂs
+static int ColdStoreLines(int Count)
+{
+	PColdBlock p;
+	LONG Ptr;
+	int i, XStart, XEnd;
+	LPDWORD SrcUni;
+
+	for (i=0; i<Count; i++) {
+		if (NumOfColdBlocks == 0 || ColdBlocks[NumOfColdBlocks-1].Lines >= ColdBlockLines) {
+			if (! ColdNewBlock()) {
+				break;
+			}
+		}
+		p = &ColdBlocks[NumOfColdBlocks-1];
+		Ptr = (LONG)LineMap[BuffStartAbs] * NumOfColumns;
+		// x`悳ꂸɈڂŝŁA URL m肳
+		MarkURL(Ptr, &XStart, &XEnd);
+		SearchAddLine(ColdLines, &CellBuff[Ptr]);
+		SrcUni = LineHasUni(Ptr) ? &UniBuff[Ptr] : NULL;
+		if (SrcUni != NULL && p->RawUni == NULL) {
+			// ubNōŏɕʒusƂɊmۂ
+			p->RawUni = (LPDWORD)calloc((LONG)ColdBlockLines * p->Width, sizeof(DWORD));
+			if (p->RawUni != NULL) {
+				ColdMemory += ColdUniSize(p->Width);
+			}
+		}
+		CopyLineCells(&p->Raw[(LONG)p->Lines * p->Width],
+		              p->RawUni ? &p->RawUni[(LONG)p->Lines * p->Width] : NULL, p->Width,
+		              &CellBuff[Ptr], SrcUni, NumOfColumns);
+		ColdLastCell = CellBuff[Ptr + NumOfColumns - 1];
+		p->Lines++;
+		ColdLines++;
+		BuffStartAbs++;
+		if (BuffStartAbs >= NumOfLinesInBuff) {
+			BuffStartAbs = 0;
+		}
+		if (p->Lines == ColdBlockLines) {
+			ColdCompressBlock(p);
+		}
+	}
+	return i;
+}
+
+static void ColdFreeBlock(PColdBlock p)
+{
+	if (p->Raw != NULL) {
+		free(p->Raw);
+		ColdMemory -= ColdRawSize(p->Width);
+	}
+	if (p->RawUni != NULL) {
+		free(p->RawUni);
+		ColdMemory -= ColdUniSize(p->Width);
+	}
+	if (p->Data != NULL) {
+		free(p->Data);
+		ColdMemory -= (LONG)p->Size;
+	}
+}
+
+// 𒴂ÂubN̂Ă
+//   ̂Ăs BuffEnd  PageStart 炷
+static void ColdTrim()
+{
+	LONG Max;
+	int n, Dropped;
+
+	Max = (LONG)ts.CompressedBuffSize * 1024 * 1024;
+	n = 0;
+	Dropped = 0;
+	while (NumOfColdBlocks - n > 1 && (ColdMemory > Max || ColdLines > ColdLinesMax)) {
+		ColdFreeBlock(&ColdBlocks[n]);
+		ColdLines -= ColdBlocks[n].Lines;
+		BuffEnd -= ColdBlocks[n].Lines;
+		PageStart -= ColdBlocks[n].Lines;
+		Dropped += ColdBlocks[n].Lines;
+		n++;
+	}
+	if (n > 0) {
+		NumOfColdBlocks -= n;
+		memmove(&ColdBlocks[0], &ColdBlocks[n], sizeof(TColdBlock) * NumOfColdBlocks);
+		ColdInvalidateSlots();
+		SearchDropLines(Dropped);
+	}
+}
+
+// kXN[obt@ɂ
+//   BuffEnd ̒͌Ăяoōs
+static void ColdFree()
+{
+	int i;
+
+	for (i=0; i<NumOfColdBlocks; i++) {
+		ColdFreeBlock(&ColdBlocks[i]);
+	}
+	free(ColdBlocks);
+	ColdBlocks = NULL;
+	NumOfColdBlocks = 0;
+	ColdBlocksAlloc = 0;
+	ColdLines = 0;
+	ColdMemory = 0;
+	ColdInvalidateSlots();
+}
+
+// kÕubNVɍ킹
+//   kς݂̃ubN͓WJɍ킹
+static void ColdChangeWidth(int Nx)
+{
+	PColdBlock p;
+	PCell Raw;
+	LPDWORD RawUni;
+	int i, y;
+
+	for (i=0; i<NumOfColdBlocks; i++) {
+		p = &ColdBlocks[i];
+		if (p->Raw == NULL || p->Width == Nx) {
+			continue;
+		}
+		if ((Raw = (PCell)malloc(ColdRawSize(Nx))) == NULL) {
+			continue;
+		}
+		RawUni = NULL;
+		if (p->RawUni != NULL && (RawUni = (LPDWORD)malloc(ColdUniSize(Nx))) == NULL) {
+			free(Raw);
+			continue;
+		}
+		for (y=0; y<p->Lines; y++) {
+			CopyLineCells(&Raw[(LONG)y*Nx], RawUni ? &RawUni[(LONG)y*Nx] : NULL, Nx,
+			              &p->Raw[(LONG)y*p->Width], p->RawUni ? &p->RawUni[(LONG)y*p->Width] : NULL, p->Width);
+		}
+		free(p->Raw);
+		ColdMemory += ColdRawSize(Nx) - ColdRawSize(p->Width);
+		p->Raw = Raw;
+		if (RawUni != NULL) {
+			free(p->RawUni);
+			ColdMemory += ColdUniSize(Nx) - ColdUniSize(p->Width);
+			p->RawUni = RawUni;
+		}
+		p->Width = Nx;
 	}
-	return Ptr;
 }
 
 BOOL ChangeBuffer(int Nx, int Ny)
 {
-	HANDLE HCodeNew, HAttrNew, HAttr2New, HAttrFGNew, HAttrBGNew;
+	HANDLE HCellNew;
 	LONG NewSize;
 	int NxCopy, NyCopy, i;
-	PCHAR CodeDest, AttrDest, AttrDest2, AttrDestFG, AttrDestBG;
-	LONG SrcPtr, DestPtr;
+	PCell CellDest;
+	LONG SrcPtr, DestPtr, ViewSize;
 	WORD LockOld;
+	BOOL NewColdView;
+	int *NewMap;
+	int BuffEndOld;
+	LPDWORD UniDest;
+	LPBYTE LineUniDest;
 
 	if (Nx > BuffXMax) {
 		Nx = BuffXMax;
@@ -152,34 +1005,25 @@ BOOL ChangeBuffer(int Nx, int Ny)
 
 	NewSize = (LONG)Nx * (LONG)Ny;
 
-	HCodeNew = NULL;
-	HAttrNew = NULL;
-	HAttr2New = NULL;
-	HAttrFGNew = NULL;
-	HAttrBGNew = NULL;
+	// kXN[obt@gꍇ́AWJsüɕt
+	NewColdView = (ts.EnableScrollBuff>0 && ts.CompressedBuffSize>0);
+	ViewSize = NewColdView ? 2 * ColdBlockLines * (LONG)Nx : 0;
 
-	if ((HCodeNew=GlobalAlloc(GMEM_MOVEABLE, NewSize)) == NULL || (CodeDest=GlobalLock(HCodeNew)) == NULL) {
-		goto allocate_error;
-	}
-	if ((HAttrNew=GlobalAlloc(GMEM_MOVEABLE, NewSize)) == NULL || (AttrDest=GlobalLock(HAttrNew)) == NULL) {
-		goto allocate_error;
-	}
-	if ((HAttr2New=GlobalAlloc(GMEM_MOVEABLE, NewSize)) == NULL || (AttrDest2=GlobalLock(HAttr2New)) == NULL) {
-		goto allocate_error;
+	if ((NewMap=malloc((sizeof(int) * 2 + sizeof(WORD) * 2 + 1) * Ny)) == NULL) {
+		return FALSE;
 	}
-	if ((HAttrFGNew=GlobalAlloc(GMEM_MOVEABLE, NewSize)) == NULL || (AttrDestFG=GlobalLock(HAttrFGNew)) == NULL) {
-		goto allocate_error;
+	if ((HCellNew=GlobalAlloc(GMEM_MOVEABLE, (NewSize + ViewSize) * sizeof(TCell))) == NULL) {
+		free(NewMap);
+		return FALSE;
 	}
-	if ((HAttrBGNew=GlobalAlloc(GMEM_MOVEABLE, NewSize)) == NULL || (AttrDestBG=GlobalLock(HAttrBGNew)) == NULL) {
-		goto allocate_error;
+	if ((CellDest=GlobalLock(HCellNew)) == NULL) {
+		GlobalFree(HCellNew);
+		free(NewMap);
+		return FALSE;
 	}
 
-	memset(&CodeDest[0], 0x20, NewSize);
-	memset(&AttrDest[0], AttrDefault, NewSize);
-	memset(&AttrDest2[0], AttrDefault, NewSize);
-	memset(&AttrDestFG[0], AttrDefaultFG, NewSize);
-	memset(&AttrDestBG[0], AttrDefaultBG, NewSize);
-	if ( HCodeBuff!=0 ) {
+	FillCells(&CellDest[0], NewSize, 0x20, AttrDefault, AttrDefault, AttrDefaultFG, AttrDefaultBG);
+	if ( HCellBuff!=0 ) {
 		if ( NumOfColumns > Nx ) {
 			NxCopy = Nx;
 		}
@@ -187,40 +1031,69 @@ BOOL ChangeBuffer(int Nx, int Ny)
 			NxCopy = NumOfColumns;
 		}
 
-		if ( BuffEnd > Ny ) {
+		LockOld = BuffLock;
+		LockBuffer();
+		BuffEndOld = BuffEnd;
+		if (NewColdView && BuffEnd - ColdLines > Ny) {
+			// VOobt@ɓ肫Ȃs͈kXN[obt@Ɉڂ
+			ColdStoreLines(BuffEnd - ColdLines - Ny);
+		}
+
+		if ( BuffEnd - ColdLines > Ny ) {
 			NyCopy = Ny;
 		}
 		else {
-			NyCopy = BuffEnd;
+			NyCopy = BuffEnd - ColdLines;
 		}
-		LockOld = BuffLock;
-		LockBuffer();
 		SrcPtr = GetLinePtr(BuffEnd-NyCopy);
 		DestPtr = 0;
-		for (i = 1 ; i <= NyCopy ; i++) {
-			memcpy(&CodeDest[DestPtr],&CodeBuff[SrcPtr],NxCopy);
-			memcpy(&AttrDest[DestPtr],&AttrBuff[SrcPtr],NxCopy);
-			memcpy(&AttrDest2[DestPtr],&AttrBuff2[SrcPtr],NxCopy);
-			memcpy(&AttrDestFG[DestPtr],&AttrBuffFG[SrcPtr],NxCopy);
-			memcpy(&AttrDestBG[DestPtr],&AttrBuffBG[SrcPtr],NxCopy);
-			if (AttrDest[DestPtr+NxCopy-1] & AttrKanji) {
-				CodeDest[DestPtr+NxCopy-1] = ' ';
-				AttrDest[DestPtr+NxCopy-1] ^= AttrKanji;
+		UniDest = NULL;
+		LineUniDest = NULL;
+		for (i = 0 ; i < NyCopy ; i++) {
+			memcpy(&CellDest[DestPtr], &CellBuff[SrcPtr], sizeof(TCell)*NxCopy);
+			// ʒus΁AVobt@ɂ UniBuff 
+			if (LineHasUni(SrcPtr) && UniDest == NULL &&
+			    (UniDest = NewUniBuff(NewSize + ViewSize, Ny + ViewSize / Nx)) != NULL) {
+				LineUniDest = (LPBYTE)&UniDest[NewSize + ViewSize];
+			}
+			if (LineHasUni(SrcPtr) && UniDest != NULL) {
+				memcpy(&UniDest[DestPtr], &UniBuff[SrcPtr], sizeof(DWORD)*NxCopy);
+				memset(&UniDest[DestPtr+NxCopy], 0, sizeof(DWORD)*(Nx-NxCopy));
+				LineUniDest[i] = 1;
+			}
+			if (CellDest[DestPtr+NxCopy-1].Attr & AttrKanji) {
+				CellDest[DestPtr+NxCopy-1].Code = ' ';
+				CellDest[DestPtr+NxCopy-1].Attr ^= AttrKanji;
+				if (LineUniDest != NULL && LineUniDest[i]) {
+					UniDest[DestPtr+NxCopy-1] = 0;
+				}
 			}
 			SrcPtr = NextLinePtr(SrcPtr);
 			DestPtr = DestPtr + (LONG)Nx;
 		}
-		FreeBuffer();
+		FreeCellBuffer();
+		UniBuff = UniDest;
+		LineUni = LineUniDest;
 	}
 	else {
 		LockOld = 0;
 		NyCopy = NumOfLines;
 		Selected = FALSE;
+		BuffEndOld = 0;
+	}
+
+	if (! NewColdView) {
+		ColdFree();
 	}
+	else if (Nx != NumOfColumns) {
+		ColdChangeWidth(Nx);
+	}
+	ColdView = NewColdView;
+	ColdInvalidateSlots();
 
 	if (Selected) {
-		SelectStart.y = SelectStart.y - BuffEnd + NyCopy;
-		SelectEnd.y = SelectEnd.y - BuffEnd + NyCopy;
+		SelectStart.y = SelectStart.y - BuffEnd + ColdLines + NyCopy;
+		SelectEnd.y = SelectEnd.y - BuffEnd + ColdLines + NyCopy;
 		if (SelectStart.y < 0) {
 			SelectStart.y = 0;
 			SelectStart.x = 0;
@@ -235,61 +1108,54 @@ BOOL ChangeBuffer(int Nx, int Ny)
 		            (SelectEnd.x > SelectStart.x));
 	}
 
-	HCodeBuff = HCodeNew;
-	HAttrBuff = HAttrNew;
-	HAttrBuff2 = HAttr2New;
-	HAttrBuffFG = HAttrFGNew;
-	HAttrBuffBG = HAttrBGNew;
+	HCellBuff = HCellNew;
 	BufferSize = NewSize;
 	NumOfLinesInBuff = Ny;
+	LineMap = NewMap;
+	LineSlot = NewMap + Ny;
+	DamageLeft = (LPWORD)(NewMap + 2 * Ny);
+	DamageRight = DamageLeft + Ny;
+	LineURLDirty = (LPBYTE)(DamageRight + Ny);
+	for (i = 0 ; i < Ny ; i++) {
+		LineMap[i] = i;
+		LineSlot[i] = i;
+	}
+	memset(LineURLDirty, 1, Ny);
+	memset(DamageLeft, 0, sizeof(WORD) * 2 * Ny);
+	DamageTop = Ny;
+	DamageBottom = -1;
 	BuffStartAbs = 0;
-	BuffEnd = NyCopy;
+	BuffEnd = ColdLines + NyCopy;
 
-	if (BuffEnd==NumOfLinesInBuff) {
+	if (NyCopy==NumOfLinesInBuff) {
 		BuffEndAbs = 0;
 	}
 	else {
-		BuffEndAbs = BuffEnd;
+		BuffEndAbs = NyCopy;
 	}
 
 	PageStart = BuffEnd - NumOfLines;
 
+	// ĉ͖̍sȂ̂ŁA͐擪̂Ă点΂悢
+	if (Nx != NumOfColumns) {
+		SearchReset();
+	}
+	else {
+		SearchDropLines(BuffEndOld - BuffEnd);
+		SearchRollback(PageStart);
+	}
+
 	LinePtr = 0;
 	if (LockOld>0) {
-		CodeBuff = (PCHAR)GlobalLock(HCodeBuff);
-		AttrBuff = (PCHAR)GlobalLock(HAttrBuff);
-		AttrBuff2 = (PCHAR)GlobalLock(HAttrBuff2);
-		AttrBuffFG = (PCHAR)GlobalLock(HAttrBuffFG);
-		AttrBuffBG = (PCHAR)GlobalLock(HAttrBuffBG);
-		CodeLine = CodeBuff;
-		AttrLine = AttrBuff;
-		AttrLine2 = AttrBuff2;
-		AttrLineFG = AttrBuffFG;
-		AttrLineBG = AttrBuffBG;
+		CellBuff = (PCell)GlobalLock(HCellBuff);
+		CellLine = CellBuff;
 	}
 	else {
-		GlobalUnlock(HCodeNew);
-		GlobalUnlock(HAttrNew);
-		GlobalUnlock(HAttr2New);
-		GlobalUnlock(HAttrFGNew);
-		GlobalUnlock(HAttrBGNew);
+		GlobalUnlock(HCellNew);
 	}
 	BuffLock = LockOld;
 
 	return TRUE;
-
-allocate_error:
-	if (CodeDest)   GlobalUnlock(HCodeNew);
-	if (AttrDest)   GlobalUnlock(HAttrNew);
-	if (AttrDest2)  GlobalUnlock(HAttr2New);
-	if (AttrDestFG) GlobalUnlock(HAttrFGNew);
-	if (AttrDestBG) GlobalUnlock(HAttrBGNew);
-	if (HCodeNew)   GlobalFree(HCodeNew);
-	if (HAttrNew)   GlobalFree(HAttrNew);
-	if (HAttr2New)  GlobalFree(HAttr2New);
-	if (HAttrFGNew) GlobalFree(HAttrFGNew);
-	if (HAttrBGNew) GlobalFree(HAttrBGNew);
-	return FALSE;
 }
 
 void InitBuffer()
@@ -335,11 +1201,7 @@ void InitBuffer()
 void NewLine(int Line)
 {
 	LinePtr = GetLinePtr(Line);
-	CodeLine = &CodeBuff[LinePtr];
-	AttrLine = &AttrBuff[LinePtr];
-	AttrLine2 = &AttrBuff2[LinePtr];
-	AttrLineFG = &AttrBuffFG[LinePtr];
-	AttrLineBG = &AttrBuffBG[LinePtr];
+	CellLine = &CellBuff[LinePtr];
 }
 
 void LockBuffer()
@@ -348,11 +1210,7 @@ void LockBuffer()
 	if (BuffLock>1) {
 		return;
 	}
-	CodeBuff = (PCHAR)GlobalLock(HCodeBuff);
-	AttrBuff = (PCHAR)GlobalLock(HAttrBuff);
-	AttrBuff2 = (PCHAR)GlobalLock(HAttrBuff2);
-	AttrBuffFG = (PCHAR)GlobalLock(HAttrBuffFG);
-	AttrBuffBG = (PCHAR)GlobalLock(HAttrBuffBG);
+	CellBuff = (PCell)GlobalLock(HCellBuff);
 	NewLine(PageStart+CursorY);
 }
 
@@ -365,47 +1223,35 @@ void UnlockBuffer()
 	if (BuffLock>0) {
 		return;
 	}
-	if (HCodeBuff!=NULL) {
-		GlobalUnlock(HCodeBuff);
-	}
-	if (HAttrBuff!=NULL) {
-		GlobalUnlock(HAttrBuff);
-	}
-	if (HAttrBuff2!=NULL) {
-		GlobalUnlock(HAttrBuff2);
-	}
-	if (HAttrBuffFG!=NULL) {
-		GlobalUnlock(HAttrBuffFG);
-	}
-	if (HAttrBuffBG!=NULL) {
-		GlobalUnlock(HAttrBuffBG);
+	if (HCellBuff!=NULL) {
+		GlobalUnlock(HCellBuff);
 	}
 }
 
-void FreeBuffer()
+static void FreeCellBuffer()
 {
 	BuffLock = 1;
 	UnlockBuffer();
-	if (HCodeBuff!=NULL) {
-		GlobalFree(HCodeBuff);
-		HCodeBuff = NULL;
-	}
-	if (HAttrBuff!=NULL) {
-		GlobalFree(HAttrBuff);
-		HAttrBuff = NULL;
-	}
-	if (HAttrBuff2!=NULL) {
-		GlobalFree(HAttrBuff2);
-		HAttrBuff2 = NULL;
-	}
-	if (HAttrBuffFG!=NULL) {
-		GlobalFree(HAttrBuffFG);
-		HAttrBuffFG = NULL;
-	}
-	if (HAttrBuffBG!=NULL) {
-		GlobalFree(HAttrBuffBG);
-		HAttrBuffBG = NULL;
-	}
+	if (HCellBuff!=NULL) {
+		GlobalFree(HCellBuff);
+		HCellBuff = NULL;
+	}
+	free(LineMap);
+	LineMap = NULL;
+	LineSlot = NULL;
+	DamageLeft = NULL;
+	DamageRight = NULL;
+	LineURLDirty = NULL;
+	free(UniBuff);
+	UniBuff = NULL;
+	LineUni = NULL;
+}
+
+void FreeBuffer()
+{
+	FreeCellBuffer();
+	ColdFree();
+	SearchReset();
 }
 
 void BuffAllSelect()
@@ -482,54 +1328,48 @@ void BuffReset()
 
 void BuffScroll(int Count, int Bottom)
 {
-	int i, n;
-	LONG SrcPtr, DestPtr;
+	int n;
 	int BuffEndOld;
 
 	if (Count>NumOfLinesInBuff) {
 		Count = NumOfLinesInBuff;
 	}
+	if (Bottom<NumOfLines-1 && Count > NumOfLinesInBuff-(NumOfLines-1-Bottom)) {
+		// XN[͈͂艺̍s̈ړ悪Oobt@Ɏ܂悤ɂ
+		Count = NumOfLinesInBuff-(NumOfLines-1-Bottom);
+	}
 
-	DestPtr = GetLinePtr(PageStart+NumOfLines-1+Count);
-	n = Count;
-	if (Bottom<NumOfLines-1) {
-		SrcPtr = GetLinePtr(PageStart+NumOfLines-1);
-		for (i=NumOfLines-1; i>=Bottom+1; i--) {
-			memcpy(&(CodeBuff[DestPtr]),&(CodeBuff[SrcPtr]),NumOfColumns);
-			memcpy(&(AttrBuff[DestPtr]),&(AttrBuff[SrcPtr]),NumOfColumns);
-			memcpy(&(AttrBuff2[DestPtr]),&(AttrBuff2[SrcPtr]),NumOfColumns);
-			memcpy(&(AttrBuffFG[DestPtr]),&(AttrBuffFG[SrcPtr]),NumOfColumns);
-			memcpy(&(AttrBuffBG[DestPtr]),&(AttrBuffBG[SrcPtr]),NumOfColumns);
-			memset(&(CodeBuff[SrcPtr]),0x20,NumOfColumns);
-			memset(&(AttrBuff[SrcPtr]),AttrDefault,NumOfColumns);
-			memset(&(AttrBuff2[SrcPtr]),CurCharAttr.Attr2 & Attr2ColorMask, NumOfColumns);
-			memset(&(AttrBuffFG[SrcPtr]),CurCharAttr.Fore,NumOfColumns);
-			memset(&(AttrBuffBG[SrcPtr]),CurCharAttr.Back,NumOfColumns);
-			SrcPtr = PrevLinePtr(SrcPtr);
-			DestPtr = PrevLinePtr(DestPtr);
-			n--;
+	BuffEndOld = BuffEnd;
+	if (ColdView) {
+		// Oobt@炠ӂskXN[obt@Ɉڂ
+		n = BuffEnd - ColdLines + Count - NumOfLinesInBuff;
+		if (n > 0) {
+			ColdStoreLines(n);
+			ColdTrim();
 		}
 	}
-	for (i = 1 ; i <= n ; i++) {
-		memset(&CodeBuff[DestPtr],0x20,NumOfColumns);
-		memset(&AttrBuff[DestPtr],AttrDefault,NumOfColumns);
-		memset(&AttrBuff2[DestPtr],CurCharAttr.Attr2 & Attr2ColorMask, NumOfColumns);
-		memset(&AttrBuffFG[DestPtr],CurCharAttr.Fore,NumOfColumns);
-		memset(&AttrBuffBG[DestPtr],CurCharAttr.Back,NumOfColumns);
-		DestPtr = PrevLinePtr(DestPtr);
+
+	if (Bottom<NumOfLines-1) {
+		// XN[͈͂艺̍s Count sA󂢂sVsɂ
+		RotateLines(PageStart+Bottom+1, NumOfLines-1-Bottom+Count, -Count);
+		EraseLines(PageStart+Bottom+1, Count);
+	}
+	else {
+		EraseLines(PageStart+NumOfLines, Count);
 	}
 
 	BuffEndAbs = BuffEndAbs + Count;
 	if (BuffEndAbs >= NumOfLinesInBuff) {
 		BuffEndAbs = BuffEndAbs - NumOfLinesInBuff;
 	}
-	BuffEndOld = BuffEnd;
 	BuffEnd = BuffEnd + Count;
-	if (BuffEnd >= NumOfLinesInBuff) {
-		BuffEnd = NumOfLinesInBuff;
+	if (BuffEnd - ColdLines >= NumOfLinesInBuff) {
+		SearchDropLines(BuffEnd - ColdLines - NumOfLinesInBuff);
+		BuffEnd = ColdLines + NumOfLinesInBuff;
 		BuffStartAbs = BuffEndAbs;
 	}
 	PageStart = BuffEnd-NumOfLines;
+	DamageScroll(0, Bottom, Count);
 
 	if (Selected) {
 		SelectStart.y = SelectStart.y - Count + BuffEnd - BuffEndOld;
@@ -553,21 +1393,13 @@ void BuffScroll(int Count, int Bottom)
 void NextLine()
 {
 	LinePtr = NextLinePtr(LinePtr);
-	CodeLine = &CodeBuff[LinePtr];
-	AttrLine = &AttrBuff[LinePtr];
-	AttrLine2 = &AttrBuff2[LinePtr];
-	AttrLineFG = &AttrBuffFG[LinePtr];
-	AttrLineBG = &AttrBuffBG[LinePtr];
+	CellLine = &CellBuff[LinePtr];
 }
 
 void PrevLine()
 {
 	LinePtr = PrevLinePtr(LinePtr);
-	CodeLine = &CodeBuff[LinePtr];
-	AttrLine = &AttrBuff[LinePtr];
-	AttrLine2 = &AttrBuff2[LinePtr];
-	AttrLineFG = &AttrBuffFG[LinePtr];
-	AttrLineBG = &AttrBuffBG[LinePtr];
+	CellLine = &CellBuff[LinePtr];
 }
 
 void EraseKanji(int LR)
@@ -576,19 +1408,20 @@ void EraseKanji(int LR)
 //   LR: left(0)/right(1) flag
 
 	if ((CursorX-LR>=0) &&
-	    ((AttrLine[CursorX-LR] & AttrKanji) != 0)) {
-		CodeLine[CursorX-LR] = 0x20;
-		AttrLine[CursorX-LR] = CurCharAttr.Attr;
-		AttrLine2[CursorX-LR] = CurCharAttr.Attr2;
-		AttrLineFG[CursorX-LR] = CurCharAttr.Fore;
-		AttrLineBG[CursorX-LR] = CurCharAttr.Back;
+	    ((CellLine[CursorX-LR].Attr & AttrKanji) != 0)) {
+		SetCellCode(CellLine[CursorX-LR], 0x20);
+		CellLine[CursorX-LR].Attr = CurCharAttr.Attr;
+		CellLine[CursorX-LR].Attr2 = CurCharAttr.Attr2;
+		CellLine[CursorX-LR].Fore = CurCharAttr.Fore;
+		CellLine[CursorX-LR].Back = CurCharAttr.Back;
 		if (CursorX-LR+1 < NumOfColumns) {
-			CodeLine[CursorX-LR+1] = 0x20;
-			AttrLine[CursorX-LR+1] = CurCharAttr.Attr;
-			AttrLine2[CursorX-LR+1] = CurCharAttr.Attr2;
-			AttrLineFG[CursorX-LR+1] = CurCharAttr.Fore;
-			AttrLineBG[CursorX-LR+1] = CurCharAttr.Back;
+			SetCellCode(CellLine[CursorX-LR+1], 0x20);
+			CellLine[CursorX-LR+1].Attr = CurCharAttr.Attr;
+			CellLine[CursorX-LR+1].Attr2 = CurCharAttr.Attr2;
+			CellLine[CursorX-LR+1].Fore = CurCharAttr.Fore;
+			CellLine[CursorX-LR+1].Back = CurCharAttr.Back;
 		}
+		DamageAdd(CursorY, CursorX-LR, 2);
 	}
 }
 
@@ -602,20 +1435,20 @@ void EraseKanjiOnLRMargin(LONG ptr, int count)
 
 	for (i=0; i<count; i++) {
 		pos = ptr + CursorLeftM-1;
-		if (CursorLeftM>0 && (AttrBuff[pos] & AttrKanji)) {
-			CodeBuff[pos] = 0x20;
-			AttrBuff[pos] &= ~AttrKanji;
+		if (CursorLeftM>0 && (CellBuff[pos].Attr & AttrKanji)) {
+			SetCellCode(CellBuff[pos], 0x20);
+			CellBuff[pos].Attr &= ~AttrKanji;
 			pos++;
-			CodeBuff[pos] = 0x20;
-			AttrBuff[pos] &= ~AttrKanji;
+			SetCellCode(CellBuff[pos], 0x20);
+			CellBuff[pos].Attr &= ~AttrKanji;
 		}
 		pos = ptr + CursorRightM;
-		if (CursorRightM < NumOfColumns-1 && (AttrBuff[pos] & AttrKanji)) {
-			CodeBuff[pos] = 0x20;
-			AttrBuff[pos] &= ~AttrKanji;
+		if (CursorRightM < NumOfColumns-1 && (CellBuff[pos].Attr & AttrKanji)) {
+			SetCellCode(CellBuff[pos], 0x20);
+			CellBuff[pos].Attr &= ~AttrKanji;
 			pos++;
-			CodeBuff[pos] = 0x20;
-			AttrBuff[pos] &= ~AttrKanji;
+			SetCellCode(CellBuff[pos], 0x20);
+			CellBuff[pos].Attr &= ~AttrKanji;
 		}
 		ptr = NextLinePtr(ptr);
 	}
@@ -636,9 +1469,9 @@ void BuffInsertSpace(int Count)
 	if (ts.Language==IdJapanese || ts.Language==IdKorean || ts.Language==IdUtf8)
 		EraseKanji(1); /* if cursor is on right half of a kanji, erase the kanji */
 
-	if (CursorRightM < NumOfColumns-1 && (AttrLine[CursorRightM] & AttrKanji)) {
-		CodeLine[CursorRightM+1] = 0x20;
-		AttrLine[CursorRightM+1] &= ~AttrKanji;
+	if (CursorRightM < NumOfColumns-1 && (CellLine[CursorRightM].Attr & AttrKanji)) {
+		SetCellCode(CellLine[CursorRightM+1], 0x20);
+		CellLine[CursorRightM+1].Attr &= ~AttrKanji;
 		extr = 1;
 	}
 
@@ -648,24 +1481,17 @@ void BuffInsertSpace(int Count)
 	MoveLen = CursorRightM + 1 - CursorX - Count;
 
 	if (MoveLen > 0) {
-		memmove(&(CodeLine[CursorX+Count]), &(CodeLine[CursorX]), MoveLen);
-		memmove(&(AttrLine[CursorX+Count]), &(AttrLine[CursorX]), MoveLen);
-		memmove(&(AttrLine2[CursorX+Count]), &(AttrLine2[CursorX]), MoveLen);
-		memmove(&(AttrLineFG[CursorX+Count]), &(AttrLineFG[CursorX]), MoveLen);
-		memmove(&(AttrLineBG[CursorX+Count]), &(AttrLineBG[CursorX]), MoveLen);
-	}
-	memset(&(CodeLine[CursorX]), 0x20, Count);
-	memset(&(AttrLine[CursorX]), AttrDefault, Count);
-	memset(&(AttrLine2[CursorX]), CurCharAttr.Attr2 & Attr2ColorMask, Count);
-	memset(&(AttrLineFG[CursorX]), CurCharAttr.Fore, Count);
-	memset(&(AttrLineBG[CursorX]), CurCharAttr.Back, Count);
+		MoveCells(LinePtr+CursorX+Count, LinePtr+CursorX, MoveLen);
+		MarkURLDirty(LinePtr);
+	}
+	EraseCells(&CellLine[CursorX], Count);
 	/* last char in current line is kanji first? */
-	if ((AttrLine[CursorRightM] & AttrKanji) != 0) {
+	if ((CellLine[CursorRightM].Attr & AttrKanji) != 0) {
 		/* then delete it */
-		CodeLine[CursorRightM] = 0x20;
-		AttrLine[CursorRightM] &= ~AttrKanji;
+		SetCellCode(CellLine[CursorRightM], 0x20);
+		CellLine[CursorRightM].Attr &= ~AttrKanji;
 	}
-	BuffUpdateRect(CursorX, CursorY, CursorRightM+extr, CursorY);
+	DamageRect(CursorX, CursorY, CursorRightM+extr, CursorY);
 }
 
 void BuffEraseCurToEnd()
@@ -680,19 +1506,14 @@ void BuffEraseCurToEnd()
 		EraseKanji(1); /* if cursor is on right half of a kanji, erase the kanji */
 	}
 	offset = CursorX;
-	TmpPtr = GetLinePtr(PageStart+CursorY);
 	YEnd = NumOfLines-1;
 	if (StatusLine && !isCursorOnStatusLine) {
 		YEnd--;
 	}
 	for (i = CursorY ; i <= YEnd ; i++) {
-		memset(&(CodeBuff[TmpPtr+offset]),0x20,NumOfColumns-offset);
-		memset(&(AttrBuff[TmpPtr+offset]),AttrDefault,NumOfColumns-offset);
-		memset(&(AttrBuff2[TmpPtr+offset]),CurCharAttr.Attr2 & Attr2ColorMask, NumOfColumns-offset);
-		memset(&(AttrBuffFG[TmpPtr+offset]),CurCharAttr.Fore,NumOfColumns-offset);
-		memset(&(AttrBuffBG[TmpPtr+offset]),CurCharAttr.Back,NumOfColumns-offset);
+		TmpPtr = GetLinePtr(PageStart+i);
+		EraseCells(&CellBuff[TmpPtr+offset], NumOfColumns-offset);
 		offset = 0;
-		TmpPtr = NextLinePtr(TmpPtr);
 	}
 	/* update window */
 	DispEraseCurToEnd(YEnd);
@@ -716,17 +1537,12 @@ void BuffEraseHomeToCur()
 	else {
 		YHome = 0;
 	}
-	TmpPtr = GetLinePtr(PageStart+YHome);
 	for (i = YHome ; i <= CursorY ; i++) {
 		if (i==CursorY) {
 			offset = CursorX+1;
 		}
-		memset(&(CodeBuff[TmpPtr]),0x20,offset);
-		memset(&(AttrBuff[TmpPtr]),AttrDefault,offset);
-		memset(&(AttrBuff2[TmpPtr]),CurCharAttr.Attr2 & Attr2ColorMask, offset);
-		memset(&(AttrBuffFG[TmpPtr]),CurCharAttr.Fore,offset);
-		memset(&(AttrBuffBG[TmpPtr]),CurCharAttr.Back,offset);
-		TmpPtr = NextLinePtr(TmpPtr);
+		TmpPtr = GetLinePtr(PageStart+i);
+		EraseCells(&CellBuff[TmpPtr], offset);
 	}
 
 	/* update window */
@@ -751,29 +1567,32 @@ void BuffInsertLines(int Count, int YEnd)
 	if (extl || extr)
 		EraseKanjiOnLRMargin(GetLinePtr(PageStart+CursorY), YEnd-CursorY+1);
 
-	SrcPtr = GetLinePtr(PageStart+YEnd-Count) + CursorLeftM;
-	DestPtr = GetLinePtr(PageStart+YEnd) + CursorLeftM;
-	linelen = CursorRightM - CursorLeftM + 1;
-	for (i= YEnd-Count ; i>=CursorY ; i--) {
-		memcpy(&(CodeBuff[DestPtr]), &(CodeBuff[SrcPtr]), linelen);
-		memcpy(&(AttrBuff[DestPtr]), &(AttrBuff[SrcPtr]), linelen);
-		memcpy(&(AttrBuff2[DestPtr]), &(AttrBuff2[SrcPtr]), linelen);
-		memcpy(&(AttrBuffFG[DestPtr]), &(AttrBuffFG[SrcPtr]), linelen);
-		memcpy(&(AttrBuffBG[DestPtr]), &(AttrBuffBG[SrcPtr]), linelen);
-		SrcPtr = PrevLinePtr(SrcPtr);
-		DestPtr = PrevLinePtr(DestPtr);
-	}
-	for (i = 1 ; i <= Count ; i++) {
-		memset(&(CodeBuff[DestPtr]), 0x20, linelen);
-		memset(&(AttrBuff[DestPtr]), AttrDefault, linelen);
-		memset(&(AttrBuff2[DestPtr]), CurCharAttr.Attr2 & Attr2ColorMask, linelen);
-		memset(&(AttrBuffFG[DestPtr]), CurCharAttr.Fore, linelen);
-		memset(&(AttrBuffBG[DestPtr]), CurCharAttr.Back, linelen);
-		DestPtr = PrevLinePtr(DestPtr);
+	if (!extl && !extr) {
+		RotateLines(PageStart+CursorY, YEnd-CursorY+1, -Count);
+		DamageScroll(CursorY, YEnd, -Count);
+		EraseLines(PageStart+CursorY, Count);
+	}
+	else {
+		DestPtr = GetLinePtr(PageStart+YEnd) + CursorLeftM;
+		linelen = CursorRightM - CursorLeftM + 1;
+		// ̈Ŝ}ꍇ͈ړsȂ (ړ͗̈̏ɂȂ)
+		if (YEnd-Count >= CursorY) {
+			SrcPtr = GetLinePtr(PageStart+YEnd-Count) + CursorLeftM;
+			for (i= YEnd-Count ; i>=CursorY ; i--) {
+				MoveCells(DestPtr, SrcPtr, linelen);
+				MarkURLDirty(DestPtr);
+				SrcPtr = PrevLinePtr(SrcPtr);
+				DestPtr = PrevLinePtr(DestPtr);
+			}
+		}
+		for (i = 1 ; i <= Count ; i++) {
+			EraseCells(&CellBuff[DestPtr], linelen);
+			DestPtr = PrevLinePtr(DestPtr);
+		}
 	}
 
 	if (CursorLeftM > 0 || CursorRightM < NumOfColumns-1 || !DispInsertLines(Count, YEnd)) {
-		BuffUpdateRect(CursorLeftM-extl, CursorY, CursorRightM+extr, YEnd);
+		DamageRect(CursorLeftM-extl, CursorY, CursorRightM+extr, YEnd);
 	}
 }
 
@@ -784,7 +1603,7 @@ void BuffEraseCharsInLine(int XStart, int Count)
 {
 	BOOL LineContinued=FALSE;
 
-	if (ts.EnableContinuedLineCopy && XStart == 0 && (AttrLine[0] & AttrLineContinued)) {
+	if (ts.EnableContinuedLineCopy && XStart == 0 && (CellLine[0].Attr & AttrLineContinued)) {
 		LineContinued = TRUE;
 	}
 
@@ -793,11 +1612,7 @@ void BuffEraseCharsInLine(int XStart, int Count)
 	}
 
 	NewLine(PageStart+CursorY);
-	memset(&(CodeLine[XStart]),0x20,Count);
-	memset(&(AttrLine[XStart]),AttrDefault,Count);
-	memset(&(AttrLine2[XStart]),CurCharAttr.Attr2 & Attr2ColorMask, Count);
-	memset(&(AttrLineFG[XStart]),CurCharAttr.Fore,Count);
-	memset(&(AttrLineBG[XStart]),CurCharAttr.Back,Count);
+	EraseCells(&CellLine[XStart], Count);
 
 	if (ts.EnableContinuedLineCopy) {
 		if (LineContinued) {
@@ -805,7 +1620,7 @@ void BuffEraseCharsInLine(int XStart, int Count)
 		}
 
 		if (XStart + Count >= NumOfColumns) {
-			AttrBuff[NextLinePtr(LinePtr)] &= ~AttrLineContinued;
+			CellBuff[NextLinePtr(LinePtr)].Attr &= ~AttrLineContinued;
 		}
 	}
 
@@ -830,29 +1645,32 @@ void BuffDeleteLines(int Count, int YEnd)
 	if (extl || extr)
 		EraseKanjiOnLRMargin(GetLinePtr(PageStart+CursorY), YEnd-CursorY+1);
 
-	SrcPtr = GetLinePtr(PageStart+CursorY+Count) + (LONG)CursorLeftM;
-	DestPtr = GetLinePtr(PageStart+CursorY) + (LONG)CursorLeftM;
-	linelen = CursorRightM - CursorLeftM + 1;
-	for (i=CursorY ; i<= YEnd-Count ; i++) {
-		memcpy(&(CodeBuff[DestPtr]), &(CodeBuff[SrcPtr]), linelen);
-		memcpy(&(AttrBuff[DestPtr]), &(AttrBuff[SrcPtr]), linelen);
-		memcpy(&(AttrBuff2[DestPtr]), &(AttrBuff2[SrcPtr]), linelen);
-		memcpy(&(AttrBuffFG[DestPtr]), &(AttrBuffFG[SrcPtr]), linelen);
-		memcpy(&(AttrBuffBG[DestPtr]), &(AttrBuffBG[SrcPtr]), linelen);
-		SrcPtr = NextLinePtr(SrcPtr);
-		DestPtr = NextLinePtr(DestPtr);
-	}
-	for (i = YEnd+1-Count ; i<=YEnd ; i++) {
-		memset(&(CodeBuff[DestPtr]), 0x20, linelen);
-		memset(&(AttrBuff[DestPtr]), AttrDefault, linelen);
-		memset(&(AttrBuff2[DestPtr]), CurCharAttr.Attr2 & Attr2ColorMask,  linelen);
-		memset(&(AttrBuffFG[DestPtr]), CurCharAttr.Fore, linelen);
-		memset(&(AttrBuffBG[DestPtr]), CurCharAttr.Back, linelen);
-		DestPtr = NextLinePtr(DestPtr);
+	if (!extl && !extr) {
+		RotateLines(PageStart+CursorY, YEnd-CursorY+1, Count);
+		DamageScroll(CursorY, YEnd, Count);
+		EraseLines(PageStart+YEnd+1-Count, Count);
+	}
+	else {
+		DestPtr = GetLinePtr(PageStart+CursorY) + (LONG)CursorLeftM;
+		linelen = CursorRightM - CursorLeftM + 1;
+		// ̈Ŝ폜ꍇ͈ړsȂ (ړ͗̈̉ɂȂ)
+		if (CursorY <= YEnd-Count) {
+			SrcPtr = GetLinePtr(PageStart+CursorY+Count) + (LONG)CursorLeftM;
+			for (i=CursorY ; i<= YEnd-Count ; i++) {
+				MoveCells(DestPtr, SrcPtr, linelen);
+				MarkURLDirty(DestPtr);
+				SrcPtr = NextLinePtr(SrcPtr);
+				DestPtr = NextLinePtr(DestPtr);
+			}
+		}
+		for (i = YEnd+1-Count ; i<=YEnd ; i++) {
+			EraseCells(&CellBuff[DestPtr], linelen);
+			DestPtr = NextLinePtr(DestPtr);
+		}
 	}
 
 	if (CursorLeftM > 0 || CursorRightM < NumOfColumns-1 || ! DispDeleteLines(Count,YEnd)) {
-		BuffUpdateRect(CursorLeftM-extl, CursorY, CursorRightM+extr, YEnd);
+		DamageRect(CursorLeftM-extl, CursorY, CursorRightM+extr, YEnd);
 	}
 }
 
@@ -873,11 +1691,11 @@ void BuffDeleteChars(int Count)
 		EraseKanji(1); /* if cursor on right half... */
 	}
 
-	if (CursorRightM < NumOfColumns-1 && (AttrLine[CursorRightM] & AttrKanji)) {
-		CodeLine[CursorRightM] = 0x20;
-		AttrLine[CursorRightM] &= ~AttrKanji;
-		CodeLine[CursorRightM+1] = 0x20;
-		AttrLine[CursorRightM+1] &= ~AttrKanji;
+	if (CursorRightM < NumOfColumns-1 && (CellLine[CursorRightM].Attr & AttrKanji)) {
+		SetCellCode(CellLine[CursorRightM], 0x20);
+		CellLine[CursorRightM].Attr &= ~AttrKanji;
+		SetCellCode(CellLine[CursorRightM+1], 0x20);
+		CellLine[CursorRightM+1].Attr &= ~AttrKanji;
 		extr = 1;
 	}
 
@@ -887,19 +1705,12 @@ void BuffDeleteChars(int Count)
 	MoveLen = CursorRightM + 1 - CursorX - Count;
 
 	if (MoveLen > 0) {
-		memmove(&(CodeLine[CursorX]), &(CodeLine[CursorX+Count]), MoveLen);
-		memmove(&(AttrLine[CursorX]), &(AttrLine[CursorX+Count]), MoveLen);
-		memmove(&(AttrLine2[CursorX]), &(AttrLine2[CursorX+Count]), MoveLen);
-		memmove(&(AttrLineFG[CursorX]), &(AttrLineFG[CursorX+Count]), MoveLen);
-		memmove(&(AttrLineBG[CursorX]), &(AttrLineBG[CursorX+Count]), MoveLen);
+		MoveCells(LinePtr+CursorX, LinePtr+CursorX+Count, MoveLen);
+		MarkURLDirty(LinePtr);
 	}
-	memset(&(CodeLine[CursorX + MoveLen]), 0x20, Count);
-	memset(&(AttrLine[CursorX + MoveLen]), AttrDefault, Count);
-	memset(&(AttrLine2[CursorX + MoveLen]), CurCharAttr.Attr2 & Attr2ColorMask, Count);
-	memset(&(AttrLineFG[CursorX + MoveLen]), CurCharAttr.Fore, Count);
-	memset(&(AttrLineBG[CursorX + MoveLen]), CurCharAttr.Back, Count);
+	EraseCells(&CellLine[CursorX + MoveLen], Count);
 
-	BuffUpdateRect(CursorX, CursorY, CursorRightM+extr, CursorY);
+	DamageRect(CursorX, CursorY, CursorRightM+extr, CursorY);
 }
 
 void BuffEraseChars(int Count)
@@ -916,11 +1727,7 @@ void BuffEraseChars(int Count)
 	if (Count > NumOfColumns-CursorX) {
 		Count = NumOfColumns-CursorX;
 	}
-	memset(&(CodeLine[CursorX]),0x20,Count);
-	memset(&(AttrLine[CursorX]),AttrDefault,Count);
-	memset(&(AttrLine2[CursorX]),CurCharAttr.Attr2 & Attr2ColorMask, Count);
-	memset(&(AttrLineFG[CursorX]),CurCharAttr.Fore,Count);
-	memset(&(AttrLineBG[CursorX]),CurCharAttr.Back,Count);
+	EraseCells(&CellLine[CursorX], Count);
 
 	/* update window */
 	DispEraseCharsInLine(CursorX,Count);
@@ -934,14 +1741,11 @@ void BuffFillWithE()
 
 	TmpPtr = GetLinePtr(PageStart);
 	for (i = 0 ; i <= NumOfLines-1-StatusLine ; i++) {
-		memset(&(CodeBuff[TmpPtr]),'E',NumOfColumns);
-		memset(&(AttrBuff[TmpPtr]),AttrDefault,NumOfColumns);
-		memset(&(AttrBuff2[TmpPtr]),AttrDefault,NumOfColumns);
-		memset(&(AttrBuffFG[TmpPtr]),AttrDefaultFG,NumOfColumns);
-		memset(&(AttrBuffBG[TmpPtr]),AttrDefaultBG,NumOfColumns);
+		FillCells(&CellBuff[TmpPtr], NumOfColumns, 'E', AttrDefault, AttrDefault, AttrDefaultFG, AttrDefaultBG);
+		ClearUni(TmpPtr, NumOfColumns);
 		TmpPtr = NextLinePtr(TmpPtr);
 	}
-	BuffUpdateRect(WinOrgX,WinOrgY,WinOrgX+WinWidth-1,WinOrgY+WinHeight-1);
+	DamageRect(WinOrgX,WinOrgY,WinOrgX+WinWidth-1,WinOrgY+WinHeight-1);
 }
 
 void BuffDrawLine(TCharAttr Attr, int Direction, int C)
@@ -973,12 +1777,9 @@ void BuffDrawLine(TCharAttr Attr, int Direction, int C)
 				C = NumOfColumns-CursorX;
 			}
 			Ptr = GetLinePtr(PageStart+Y);
-			memset(&(CodeBuff[Ptr+CursorX]),'q',C);
-			memset(&(AttrBuff[Ptr+CursorX]),Attr.Attr,C);
-			memset(&(AttrBuff2[Ptr+CursorX]),Attr.Attr2,C);
-			memset(&(AttrBuffFG[Ptr+CursorX]),Attr.Fore,C);
-			memset(&(AttrBuffBG[Ptr+CursorX]),Attr.Back,C);
-			BuffUpdateRect(CursorX,Y,CursorX+C-1,Y);
+			FillCells(&CellBuff[Ptr+CursorX], C, 'q', Attr.Attr, Attr.Attr2, Attr.Fore, Attr.Back);
+			ClearUni(Ptr+CursorX, C);
+			DamageRect(CursorX,Y,CursorX+C-1,Y);
 			break;
 		case 5:
 		case 6:
@@ -1001,14 +1802,14 @@ void BuffDrawLine(TCharAttr Attr, int Direction, int C)
 				C = NumOfLines-StatusLine-CursorY;
 			}
 			for (i=1; i<=C; i++) {
-				CodeBuff[Ptr+X] = 'x';
-				AttrBuff[Ptr+X] = Attr.Attr;
-				AttrBuff2[Ptr+X] = Attr.Attr2;
-				AttrBuffFG[Ptr+X] = Attr.Fore;
-				AttrBuffBG[Ptr+X] = Attr.Back;
+				SetCellCode(CellBuff[Ptr+X], 'x');
+				CellBuff[Ptr+X].Attr = Attr.Attr;
+				CellBuff[Ptr+X].Attr2 = Attr.Attr2;
+				CellBuff[Ptr+X].Fore = Attr.Fore;
+				CellBuff[Ptr+X].Back = Attr.Back;
 				Ptr = NextLinePtr(Ptr);
 			}
-			BuffUpdateRect(X,CursorY,X,CursorY+C-1);
+			DamageRect(X,CursorY,X,CursorY+C-1);
 			break;
 	}
 }
@@ -1035,29 +1836,25 @@ void BuffEraseBox
 	Ptr = GetLinePtr(PageStart+YStart);
 	for (i=YStart; i<=YEnd; i++) {
 		if ((XStart>0) &&
-		    ((AttrBuff[Ptr+XStart-1] & AttrKanji) != 0)) {
-			CodeBuff[Ptr+XStart-1] = 0x20;
-			AttrBuff[Ptr+XStart-1] = CurCharAttr.Attr;
-			AttrBuff2[Ptr+XStart-1] = CurCharAttr.Attr2;
-			AttrBuffFG[Ptr+XStart-1] = CurCharAttr.Fore;
-			AttrBuffBG[Ptr+XStart-1] = CurCharAttr.Back;
+		    ((CellBuff[Ptr+XStart-1].Attr & AttrKanji) != 0)) {
+			SetCellCode(CellBuff[Ptr+XStart-1], 0x20);
+			CellBuff[Ptr+XStart-1].Attr = CurCharAttr.Attr;
+			CellBuff[Ptr+XStart-1].Attr2 = CurCharAttr.Attr2;
+			CellBuff[Ptr+XStart-1].Fore = CurCharAttr.Fore;
+			CellBuff[Ptr+XStart-1].Back = CurCharAttr.Back;
 		}
 		if ((XStart+C<NumOfColumns) &&
-		    ((AttrBuff[Ptr+XStart+C-1] & AttrKanji) != 0)) {
-			CodeBuff[Ptr+XStart+C] = 0x20;
-			AttrBuff[Ptr+XStart+C] = CurCharAttr.Attr;
-			AttrBuff2[Ptr+XStart+C] = CurCharAttr.Attr2;
-			AttrBuffFG[Ptr+XStart+C] = CurCharAttr.Fore;
-			AttrBuffBG[Ptr+XStart+C] = CurCharAttr.Back;
-		}
-		memset(&(CodeBuff[Ptr+XStart]),0x20,C);
-		memset(&(AttrBuff[Ptr+XStart]),AttrDefault,C);
-		memset(&(AttrBuff2[Ptr+XStart]),CurCharAttr.Attr2 & Attr2ColorMask, C);
-		memset(&(AttrBuffFG[Ptr+XStart]),CurCharAttr.Fore,C);
-		memset(&(AttrBuffBG[Ptr+XStart]),CurCharAttr.Back,C);
+		    ((CellBuff[Ptr+XStart+C-1].Attr & AttrKanji) != 0)) {
+			SetCellCode(CellBuff[Ptr+XStart+C], 0x20);
+			CellBuff[Ptr+XStart+C].Attr = CurCharAttr.Attr;
+			CellBuff[Ptr+XStart+C].Attr2 = CurCharAttr.Attr2;
+			CellBuff[Ptr+XStart+C].Fore = CurCharAttr.Fore;
+			CellBuff[Ptr+XStart+C].Back = CurCharAttr.Back;
+		}
+		EraseCells(&CellBuff[Ptr+XStart], C);
 		Ptr = NextLinePtr(Ptr);
 	}
-	BuffUpdateRect(XStart,YStart,XEnd,YEnd);
+	DamageRect(XStart,YStart,XEnd,YEnd);
 }
 
 void BuffFillBox(char ch, int XStart, int YStart, int XEnd, int YEnd)
@@ -1081,22 +1878,19 @@ void BuffFillBox(char ch, int XStart, int YStart, int XEnd, int YEnd)
 	Ptr = GetLinePtr(PageStart+YStart);
 	for (i=YStart; i<=YEnd; i++) {
 		if ((XStart>0) &&
-		    ((AttrBuff[Ptr+XStart-1] & AttrKanji) != 0)) {
-			CodeBuff[Ptr+XStart-1] = 0x20;
-			AttrBuff[Ptr+XStart-1] ^= AttrKanji;
+		    ((CellBuff[Ptr+XStart-1].Attr & AttrKanji) != 0)) {
+			SetCellCode(CellBuff[Ptr+XStart-1], 0x20);
+			CellBuff[Ptr+XStart-1].Attr ^= AttrKanji;
 		}
 		if ((XStart+Cols<NumOfColumns) &&
-		    ((AttrBuff[Ptr+XStart+Cols-1] & AttrKanji) != 0)) {
-			CodeBuff[Ptr+XStart+Cols] = 0x20;
-		}
-		memset(&(CodeBuff[Ptr+XStart]), ch, Cols);
-		memset(&(AttrBuff[Ptr+XStart]), CurCharAttr.Attr, Cols);
-		memset(&(AttrBuff2[Ptr+XStart]), CurCharAttr.Attr2, Cols);
-		memset(&(AttrBuffFG[Ptr+XStart]), CurCharAttr.Fore, Cols);
-		memset(&(AttrBuffBG[Ptr+XStart]), CurCharAttr.Back, Cols);
+		    ((CellBuff[Ptr+XStart+Cols-1].Attr & AttrKanji) != 0)) {
+			SetCellCode(CellBuff[Ptr+XStart+Cols], 0x20);
+		}
+		FillCells(&CellBuff[Ptr+XStart], Cols, ch, CurCharAttr.Attr, CurCharAttr.Attr2, CurCharAttr.Fore, CurCharAttr.Back);
+		ClearUni(Ptr+XStart, Cols);
 		Ptr = NextLinePtr(Ptr);
 	}
-	BuffUpdateRect(XStart, YStart, XEnd, YEnd);
+	DamageRect(XStart, YStart, XEnd, YEnd);
 }
 
 //
@@ -1122,7 +1916,7 @@ void BuffCopyBox(
 		SrcXEnd = NumOfColumns-1;
 	}
 	if (SrcYEnd > NumOfLines-1-StatusLine) {
-		SrcYEnd = NumOfColumns-1;
+		SrcYEnd = NumOfLines-1-StatusLine;
 	}
 	if (SrcXStart > SrcXEnd ||
 	    SrcYStart > SrcYEnd ||
@@ -1136,50 +1930,35 @@ void BuffCopyBox(
 		C = NumOfColumns - DstX;
 	}
 	L = SrcYEnd - SrcYStart + 1;
-	if (DstY + C > NumOfColumns) {
-		C = NumOfColumns - DstX;
+	if (DstY + L > NumOfLines-StatusLine) {
+		L = NumOfLines-StatusLine - DstY;
 	}
 
-	if (SrcXStart > DstX) {
-		SPtr = GetLinePtr(PageStart+SrcYStart);
-		DPtr = GetLinePtr(PageStart+DstY);
-		for (i=0; i<L; i++) {
-			memcpy(&(CodeBuff[DPtr+DstX]), &(CodeBuff[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuff[DPtr+DstX]), &(AttrBuff[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuff2[DPtr+DstX]), &(AttrBuff2[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuffFG[DPtr+DstX]), &(AttrBuffFG[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuffBG[DPtr+DstX]), &(AttrBuffBG[SPtr+SrcXStart]), C);
-			SPtr = NextLinePtr(SPtr);
-			DPtr = NextLinePtr(DPtr);
-		}
+	if (SrcYStart == DstY && SrcXStart == DstX) {
+		return;
 	}
-	else if (SrcXStart < DstX) {
-		SPtr = GetLinePtr(PageStart+SrcYEnd);
+	/* dȂ`󂳂Ȃ悤AֈڂƂ͉̍sʂ */
+	if (DstY > SrcYStart) {
+		SPtr = GetLinePtr(PageStart+SrcYStart+L-1);
 		DPtr = GetLinePtr(PageStart+DstY+L-1);
 		for (i=L; i>0; i--) {
-			memcpy(&(CodeBuff[DPtr+DstX]), &(CodeBuff[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuff[DPtr+DstX]), &(AttrBuff[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuff2[DPtr+DstX]), &(AttrBuff2[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuffFG[DPtr+DstX]), &(AttrBuffFG[SPtr+SrcXStart]), C);
-			memcpy(&(AttrBuffBG[DPtr+DstX]), &(AttrBuffBG[SPtr+SrcXStart]), C);
+			MoveCells(DPtr+DstX, SPtr+SrcXStart, C);
+			MarkURLDirty(DPtr);
 			SPtr = PrevLinePtr(SPtr);
 			DPtr = PrevLinePtr(DPtr);
 		}
 	}
-	else if (SrcYStart != DstY) {
+	else {
 		SPtr = GetLinePtr(PageStart+SrcYStart);
 		DPtr = GetLinePtr(PageStart+DstY);
 		for (i=0; i<L; i++) {
-			memmove(&(CodeBuff[DPtr+DstX]), &(CodeBuff[SPtr+SrcXStart]), C);
-			memmove(&(AttrBuff[DPtr+DstX]), &(AttrBuff[SPtr+SrcXStart]), C);
-			memmove(&(AttrBuff2[DPtr+DstX]), &(AttrBuff2[SPtr+SrcXStart]), C);
-			memmove(&(AttrBuffFG[DPtr+DstX]), &(AttrBuffFG[SPtr+SrcXStart]), C);
-			memmove(&(AttrBuffBG[DPtr+DstX]), &(AttrBuffBG[SPtr+SrcXStart]), C);
+			MoveCells(DPtr+DstX, SPtr+SrcXStart, C);
+			MarkURLDirty(DPtr);
 			SPtr = NextLinePtr(SPtr);
 			DPtr = NextLinePtr(DPtr);
 		}
 	}
-	BuffUpdateRect(DstX,DstY,DstX+C-1,DstY+L-1);
+	DamageRect(DstX,DstY,DstX+C-1,DstY+L-1);
 }
 
 void BuffChangeAttrBox(int XStart, int YStart, int XEnd, int YEnd, PCharAttr attr, PCharAttr mask)
@@ -1202,23 +1981,23 @@ void BuffChangeAttrBox(int XStart, int YStart, int XEnd, int YEnd, PCharAttr att
 	if (mask) { // DECCARA
 		for (i=YStart; i<=YEnd; i++) {
 			j = Ptr+XStart-1;
-			if (XStart>0 && (AttrBuff[j] & AttrKanji)) {
-				AttrBuff[j] = AttrBuff[j] & ~mask->Attr | attr->Attr;
-				AttrBuff2[j] = AttrBuff2[j] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[j] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[j] = attr->Back; }
+			if (XStart>0 && (CellBuff[j].Attr & AttrKanji)) {
+				CellBuff[j].Attr = CellBuff[j].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[j].Attr2 = CellBuff[j].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[j].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[j].Back = attr->Back; }
 			}
 			while (++j < Ptr+XStart+C) {
-				AttrBuff[j] = AttrBuff[j] & ~mask->Attr | attr->Attr;
-				AttrBuff2[j] = AttrBuff2[j] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[j] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[j] = attr->Back; }
+				CellBuff[j].Attr = CellBuff[j].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[j].Attr2 = CellBuff[j].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[j].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[j].Back = attr->Back; }
 			}
-			if (XStart+C<NumOfColumns && (AttrBuff[j-1] & AttrKanji)) {
-				AttrBuff[j] = AttrBuff[j] & ~mask->Attr | attr->Attr;
-				AttrBuff2[j] = AttrBuff2[j] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[j] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[j] = attr->Back; }
+			if (XStart+C<NumOfColumns && (CellBuff[j-1].Attr & AttrKanji)) {
+				CellBuff[j].Attr = CellBuff[j].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[j].Attr2 = CellBuff[j].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[j].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[j].Back = attr->Back; }
 			}
 			Ptr = NextLinePtr(Ptr);
 		}
@@ -1226,19 +2005,19 @@ void BuffChangeAttrBox(int XStart, int YStart, int XEnd, int YEnd, PCharAttr att
 	else { // DECRARA
 		for (i=YStart; i<=YEnd; i++) {
 			j = Ptr+XStart-1;
-			if (XStart>0 && (AttrBuff[j] & AttrKanji)) {
-				AttrBuff[j] ^= attr->Attr;
+			if (XStart>0 && (CellBuff[j].Attr & AttrKanji)) {
+				CellBuff[j].Attr ^= attr->Attr;
 			}
 			while (++j < Ptr+XStart+C) {
-				AttrBuff[j] ^= attr->Attr;
+				CellBuff[j].Attr ^= attr->Attr;
 			}
-			if (XStart+C<NumOfColumns && (AttrBuff[j-1] & AttrKanji)) {
-				AttrBuff[j] ^= attr->Attr;
+			if (XStart+C<NumOfColumns && (CellBuff[j-1].Attr & AttrKanji)) {
+				CellBuff[j].Attr ^= attr->Attr;
 			}
 			Ptr = NextLinePtr(Ptr);
 		}
 	}
-	BuffUpdateRect(XStart, YStart, XEnd, YEnd);
+	DamageRect(XStart, YStart, XEnd, YEnd);
 }
 
 void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr attr, PCharAttr mask)
@@ -1263,40 +2042,40 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 			i = Ptr + XStart - 1;
 			endp = Ptr + XEnd + 1;
 
-			if (XStart > 0 && (AttrBuff[i] & AttrKanji)) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+			if (XStart > 0 && (CellBuff[i].Attr & AttrKanji)) {
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 			}
 			while (++i < endp) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 			}
-			if (XEnd < NumOfColumns-1 && (AttrBuff[i-1] & AttrKanji)) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+			if (XEnd < NumOfColumns-1 && (CellBuff[i-1].Attr & AttrKanji)) {
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 			}
 		}
 		else {
 			i = Ptr + XStart - 1;
 			endp = Ptr + NumOfColumns;
 
-			if (XStart > 0 && (AttrBuff[i] & AttrKanji)) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+			if (XStart > 0 && (CellBuff[i].Attr & AttrKanji)) {
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 			}
 			while (++i < endp) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 			}
 
 			for (j=0; j < YEnd-YStart-1; j++) {
@@ -1305,10 +2084,10 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 				endp = Ptr + NumOfColumns;
 
 				while (i < endp) {
-					AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-					AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-					if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-					if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+					CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+					CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+					if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+					if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 					i++;
 				}
 			}
@@ -1318,17 +2097,17 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 			endp = Ptr + XEnd + 1;
 
 			while (i < endp) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 				i++;
 			}
-			if (XEnd < NumOfColumns-1 && (AttrBuff[i-1] & AttrKanji)) {
-				AttrBuff[i] = AttrBuff[i] & ~mask->Attr | attr->Attr;
-				AttrBuff2[i] = AttrBuff2[i] & ~mask->Attr2 | attr->Attr2;
-				if (mask->Attr2 & Attr2Fore) { AttrBuffFG[i] = attr->Fore; }
-				if (mask->Attr2 & Attr2Back) { AttrBuffBG[i] = attr->Back; }
+			if (XEnd < NumOfColumns-1 && (CellBuff[i-1].Attr & AttrKanji)) {
+				CellBuff[i].Attr = CellBuff[i].Attr & ~mask->Attr | attr->Attr;
+				CellBuff[i].Attr2 = CellBuff[i].Attr2 & ~mask->Attr2 | attr->Attr2;
+				if (mask->Attr2 & Attr2Fore) { CellBuff[i].Fore = attr->Fore; }
+				if (mask->Attr2 & Attr2Back) { CellBuff[i].Back = attr->Back; }
 			}
 		}
 	}
@@ -1337,25 +2116,25 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 			i = Ptr + XStart - 1;
 			endp = Ptr + XEnd + 1;
 
-			if (XStart > 0 && (AttrBuff[i] & AttrKanji)) {
-				AttrBuff[i] ^= attr->Attr;
+			if (XStart > 0 && (CellBuff[i].Attr & AttrKanji)) {
+				CellBuff[i].Attr ^= attr->Attr;
 			}
 			while (++i < endp) {
-				AttrBuff[i] ^= attr->Attr;
+				CellBuff[i].Attr ^= attr->Attr;
 			}
-			if (XEnd < NumOfColumns-1 && (AttrBuff[i-1] & AttrKanji)) {
-				AttrBuff[i] ^= attr->Attr;
+			if (XEnd < NumOfColumns-1 && (CellBuff[i-1].Attr & AttrKanji)) {
+				CellBuff[i].Attr ^= attr->Attr;
 			}
 		}
 		else {
 			i = Ptr + XStart - 1;
 			endp = Ptr + NumOfColumns;
 
-			if (XStart > 0 && (AttrBuff[i] & AttrKanji)) {
-				AttrBuff[i] ^= attr->Attr;
+			if (XStart > 0 && (CellBuff[i].Attr & AttrKanji)) {
+				CellBuff[i].Attr ^= attr->Attr;
 			}
 			while (++i < endp) {
-				AttrBuff[i] ^= attr->Attr;
+				CellBuff[i].Attr ^= attr->Attr;
 			}
 
 			for (j=0; j < YEnd-YStart-1; j++) {
@@ -1364,7 +2143,7 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 				endp = Ptr + NumOfColumns;
 
 				while (i < endp) {
-					AttrBuff[i] ^= attr->Attr;
+					CellBuff[i].Attr ^= attr->Attr;
 					i++;
 				}
 			}
@@ -1374,16 +2153,16 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 			endp = Ptr + XEnd + 1;
 
 			while (i < endp) {
-				AttrBuff[i] ^= attr->Attr;
+				CellBuff[i].Attr ^= attr->Attr;
 				i++;
 			}
-			if (XEnd < NumOfColumns-1 && (AttrBuff[i-1] & AttrKanji)) {
-				AttrBuff[i] ^= attr->Attr;
+			if (XEnd < NumOfColumns-1 && (CellBuff[i-1].Attr & AttrKanji)) {
+				CellBuff[i].Attr ^= attr->Attr;
 			}
 			Ptr = NextLinePtr(Ptr);
 		}
 	}
-	BuffUpdateRect(0, YStart, NumOfColumns-1, YEnd);
+	DamageRect(0, YStart, NumOfColumns-1, YEnd);
 }
 
 int LeftHalfOfDBCS(LONG Line, int CharPtr)
@@ -1394,7 +2173,7 @@ int LeftHalfOfDBCS(LONG Line, int CharPtr)
 //   return: points to the left half of the DBCS
 {
 	if ((CharPtr>0) &&
-		((AttrBuff[Line+CharPtr-1] & AttrKanji) != 0)) {
+		((CellBuff[Line+CharPtr-1].Attr & AttrKanji) != 0)) {
 		CharPtr--;
 	}
 	return CharPtr;
@@ -1419,7 +2198,7 @@ int MoveCharPtr(LONG Line, int *x, int dx)
 	i = 0;
 	while (dx!=0) {
 		if (dx>0) { // move right
-			if ((AttrBuff[Line+*x] & AttrKanji) != 0) {
+			if ((CellBuff[Line+*x].Attr & AttrKanji) != 0) {
 				if (*x<NumOfColumns-2) {
 					i++;
 					*x = *x + 2;
@@ -1443,15 +2222,57 @@ int MoveCharPtr(LONG Line, int *x, int dx)
 	return i;
 }
 
+// Z c ̕ UTF-16  Dest ɏAԂ
+//   b: Nbv{[hɏoCg (^uɒu󔒂 c->Code ƈقȂ)
+//   M̕ʒucĂ΂gAȂ DBCS ϊ
+static int CellToWide(PCell c, BYTE b, LPWSTR Dest)
+{
+	DWORD u;
+	char mb[2];
+	int n;
+
+	if (b != (BYTE)c->Code) {
+		Dest[0] = b;
+		return 1;
+	}
+	u = GetCellUni(c);
+	if (u == UniContinued) {
+		return 0;
+	}
+	if (u >= 0x10000) {
+		u -= 0x10000;
+		Dest[0] = (WCHAR)(0xd800 | (u >> 10));
+		Dest[1] = (WCHAR)(0xdc00 | (u & 0x3ff));
+		return 2;
+	}
+	if (u != 0) {
+		Dest[0] = (WCHAR)u;
+		return 1;
+	}
+	if (b < 0x80) {
+		Dest[0] = b;
+		return 1;
+	}
+	mb[0] = c->Code;
+	n = 1;
+	if (c->Attr & AttrKanji) {
+		mb[1] = c[1].Code;
+		n = 2;
+	}
+	return MultiByteToWideChar(CP_ACP, 0, mb, n, Dest, 2);
+}
+
 void BuffCBCopy(BOOL Table)
 // copy selected text to clipboard
 {
 	LONG MemSize;
 	PCHAR CBPtr;
-	LONG TmpPtr;
+	LPWSTR CBWPtr;
+	LONG TmpPtr, kw;
 	int i, j, k, IStart, IEnd;
-	BOOL Sp, FirstChar;
+	BOOL Sp, FirstChar, Trail;
 	BYTE b;
+	PCell c;
 	BOOL LineContinued, PrevLineContinued;
 
 	LineContinued = FALSE;
@@ -1477,6 +2298,8 @@ void BuffCBCopy(BOOL Table)
 	if (CBPtr==NULL) {
 		return;
 	}
+	// TQ[gyA̕܂߂ 1 Z 2 ܂
+	CBWPtr = CBOpenW(MemSize * 2);
 
 // --- copy selected text to CB memory
 	LockBuffer();
@@ -1484,6 +2307,7 @@ void BuffCBCopy(BOOL Table)
 	CBPtr[0] = 0;
 	TmpPtr = GetLinePtr(SelectStart.y);
 	k = 0;
+	kw = 0;
 	for (j = SelectStart.y ; j<=SelectEnd.y ; j++) {
 		if (BoxSelect) {
 			IStart = SelectStart.x;
@@ -1515,30 +2339,32 @@ void BuffCBCopy(BOOL Table)
 		LineContinued = FALSE;
 		if (ts.EnableContinuedLineCopy && j!=SelectEnd.y && !BoxSelect) {
 			LONG NextTmpPtr = NextLinePtr(TmpPtr);
-			if ((AttrBuff[NextTmpPtr] & AttrLineContinued) != 0) {
+			if ((CellBuff[NextTmpPtr].Attr & AttrLineContinued) != 0) {
 				LineContinued = TRUE;
 			}
 			if (IEnd == NumOfColumns-1 &&
-				(AttrBuff[TmpPtr + IEnd] & AttrLineContinued) != 0) {
+				(CellBuff[TmpPtr + IEnd].Attr & AttrLineContinued) != 0) {
 				MoveCharPtr(TmpPtr,&IEnd,-1);
 			}
 		}
 		if (!LineContinued)
-			while ((IEnd>0) && (CodeBuff[TmpPtr+IEnd]==0x20)) {
+			while ((IEnd>0) && (CellBuff[TmpPtr+IEnd].Code==0x20)) {
 				MoveCharPtr(TmpPtr,&IEnd,-1);
 			}
-		if ((IEnd==0) && (CodeBuff[TmpPtr]==0x20)) {
+		if ((IEnd==0) && (CellBuff[TmpPtr].Code==0x20)) {
 			IEnd = -1;
 		}
-		else if ((AttrBuff[TmpPtr+IEnd] & AttrKanji) != 0) { /* DBCS first byte? */
+		else if (IEnd >= 0 && (CellBuff[TmpPtr+IEnd].Attr & AttrKanji) != 0) { /* DBCS first byte? */
 			IEnd++;
 		}
 
 		Sp = FALSE;
 		FirstChar = TRUE;
+		Trail = FALSE;
 		i = IStart;
 		while (i <= IEnd) {
-			b = CodeBuff[TmpPtr+i];
+			c = &CellBuff[TmpPtr+i];
+			b = c->Code;
 			i++;
 			if (! Sp) {
 				if ((Table) && (b<=0x20)) {
@@ -1549,6 +2375,9 @@ void BuffCBCopy(BOOL Table)
 					FirstChar = FALSE;
 					CBPtr[k] = b;
 					k++;
+					if (CBWPtr != NULL && ! Trail) {
+						kw += CellToWide(c, b, &CBWPtr[kw]);
+					}
 				}
 			}
 			else {
@@ -1557,8 +2386,12 @@ void BuffCBCopy(BOOL Table)
 					FirstChar = FALSE;
 					CBPtr[k] = b;
 					k++;
+					if (CBWPtr != NULL && ! Trail) {
+						kw += CellToWide(c, b, &CBWPtr[kw]);
+					}
 				}
 			}
+			Trail = ! Trail && (c->Attr & AttrKanji) != 0;
 		}
 
 		if (!LineContinued)
@@ -1567,19 +2400,26 @@ void BuffCBCopy(BOOL Table)
 				k++;
 				CBPtr[k] = 0x0a;
 				k++;
+				if (CBWPtr != NULL) {
+					CBWPtr[kw++] = 0x0d;
+					CBWPtr[kw++] = 0x0a;
+				}
 			}
 
 		TmpPtr = NextLinePtr(TmpPtr);
 	}
 	CBPtr[k] = 0;
+	if (CBWPtr != NULL) {
+		CBWPtr[kw] = 0;
+	}
 	LineContinued = FALSE;
 	if (ts.EnableContinuedLineCopy && j!=SelectEnd.y && !BoxSelect && j<BuffEnd-1) {
 		LONG NextTmpPtr = NextLinePtr(TmpPtr);
-		if ((AttrBuff[NextTmpPtr] & AttrLineContinued) != 0) {
+		if ((CellBuff[NextTmpPtr].Attr & AttrLineContinued) != 0) {
 			LineContinued = TRUE;
 		}
 		if (IEnd == NumOfColumns-1 &&
-			(AttrBuff[TmpPtr + IEnd] & AttrLineContinued) != 0) {
+			(CellBuff[TmpPtr + IEnd].Attr & AttrLineContinued) != 0) {
 			MoveCharPtr(TmpPtr,&IEnd,-1);
 		}
 	}
@@ -1658,27 +2498,27 @@ void BuffPrint(BOOL ScrollRegion)
 		}
 
 		while ((IEnd>=IStart) &&
-		       (CodeBuff[TmpPtr+IEnd]==0x20) &&
-		       (AttrBuff[TmpPtr+IEnd]==AttrDefault) &&
-		       (AttrBuff2[TmpPtr+IEnd]==AttrDefault)) {
+		       (CellBuff[TmpPtr+IEnd].Code==0x20) &&
+		       (CellBuff[TmpPtr+IEnd].Attr==AttrDefault) &&
+		       (CellBuff[TmpPtr+IEnd].Attr2==AttrDefault)) {
 			IEnd--;
 		}
 
 		i = IStart;
 		while (i <= IEnd) {
-			CurAttr.Attr = AttrBuff[TmpPtr+i] & ~ AttrKanji;
-			CurAttr.Attr2 = AttrBuff2[TmpPtr+i];
-			CurAttr.Fore = AttrBuffFG[TmpPtr+i];
-			CurAttr.Back = AttrBuffBG[TmpPtr+i];
+			CurAttr.Attr = CellBuff[TmpPtr+i].Attr & ~ AttrKanji;
+			CurAttr.Attr2 = CellBuff[TmpPtr+i].Attr2;
+			CurAttr.Fore = CellBuff[TmpPtr+i].Fore;
+			CurAttr.Back = CellBuff[TmpPtr+i].Back;
 
 			count = 1;
 			while ((i+count <= IEnd) &&
-			       (CurAttr.Attr == (AttrBuff[TmpPtr+i+count] & ~ AttrKanji)) &&
-			       (CurAttr.Attr2 == AttrBuff2[TmpPtr+i+count]) &&
-			       (CurAttr.Fore == AttrBuffFG[TmpPtr+i+count]) &&
-			       (CurAttr.Back == AttrBuffBG[TmpPtr+i+count]) ||
+			       (CurAttr.Attr == (CellBuff[TmpPtr+i+count].Attr & ~ AttrKanji)) &&
+			       (CurAttr.Attr2 == CellBuff[TmpPtr+i+count].Attr2) &&
+			       (CurAttr.Fore == CellBuff[TmpPtr+i+count].Fore) &&
+			       (CurAttr.Back == CellBuff[TmpPtr+i+count].Back) ||
 			       (i+count<NumOfColumns) &&
-			       ((AttrBuff[TmpPtr+i+count-1] & AttrKanji) != 0)) {
+			       ((CellBuff[TmpPtr+i+count-1].Attr & AttrKanji) != 0)) {
 				count++;
 			}
 
@@ -1686,7 +2526,7 @@ void BuffPrint(BOOL ScrollRegion)
 				PrnSetAttr(CurAttr);
 				TempAttr = CurAttr;
 			}
-			PrnOutText(&(CodeBuff[TmpPtr+i]),count);
+			PrnOutText(GetCellCodes(&CellBuff[TmpPtr+i],count),count);
 			i = i+count;
 		}
 		PrnNewLine();
@@ -1706,11 +2546,11 @@ void BuffDumpCurrentLine(BYTE TERM)
 	int i, j;
 
 	i = NumOfColumns;
-	while ((i>0) && (CodeLine[i-1]==0x20)) {
+	while ((i>0) && (CellLine[i-1].Code==0x20)) {
 		i--;
 	}
 	for (j=0; j<i; j++) {
-		WriteToPrnFile(CodeLine[j],FALSE);
+		WriteToPrnFile(CellLine[j].Code,FALSE);
 	}
 	WriteToPrnFile(0,TRUE);
 	if ((TERM>=LF) && (TERM<=FF)) {
@@ -1721,101 +2561,206 @@ void BuffDumpCurrentLine(BYTE TERM)
 
 
 /* begin - ishizaki */
-static void markURL(int x)
+/*
+ * URL ̌o
+ *   񂾂Ƃ͍sɈt邾ɂĂA`}EX
+ *   ̍sQƂƂɂ܂Ƃ߂ URL tB
+ *   XL[̌o͑SẴXL[𓯎ɏƍI[g}gōsB
+ */
+#ifdef URL_EMPHASIS
+// RFC3986(Uniform Resource Identifier (URI): Generic Syntax)ɏ
+// by sakura editor 1.5.2.1: etc_uty.cpp
+static const char	url_char[] = {
+  /* +0  +1  +2  +3  +4  +5  +6  +7  +8  +9  +A  +B  +C  +D  +E  +F */
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,	/* +00: */
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,	/* +10: */
+      0, -1,  0, -1, -1, -1, -1,  0,  0,  0,  0, -1, -1, -1, -1, -1,	/* +20: " !"#$%&'()*+,-./" */
+     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1,  0, -1,	/* +30: "0123456789:;<=>?" */
+     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,	/* +40: "@ABCDEFGHIJKLMNO" */
+     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1,  0,  0, -1,	/* +50: "PQRSTUVWXYZ[\]^_" */
+      0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,	/* +60: "`abcdefghijklmno" */
+     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  0,  0, -1,  0,	/* +70: "pqrstuvwxyz{|}~ " */
+    /* 0    : not url char
+     * -1   : url char
+     * other: url head char --> url_table array number + 1
+     */
+};
+static const char *url_prefix[] = {
+	"https://",
+	"http://",
+	"sftp://",
+	"tftp://",
+	"news://",
+	"ftp://",
+	"mms://",
+	NULL
+};
+
+#define URLStatesMax 64
+
+static BYTE URLNext[URLStatesMax][128];  // ԑJڃe[u
+static BYTE URLMatchLen[URLStatesMax];   // ̏ԂňvXL[̒
+static BOOL URLAutomatonReady = FALSE;
+
+// url_prefix  Aho-Corasick ̃I[g}g
+static void URLBuildAutomaton()
+{
+	BYTE Fail[URLStatesMax], Queue[URLStatesMax];
+	int States, Head, Tail, i, c, s, r;
+	const char *p;
+
+	memset(URLNext, 0, sizeof(URLNext));
+	memset(URLMatchLen, 0, sizeof(URLMatchLen));
+
+	States = 1;
+	for (i=0; url_prefix[i]!=NULL; i++) {
+		s = 0;
+		for (p = url_prefix[i]; *p; p++) {
+			c = (BYTE)*p;
+			if (URLNext[s][c] == 0) {
+				URLNext[s][c] = States++;
+			}
+			s = URLNext[s][c];
+		}
+		URLMatchLen[s] = (BYTE)strlen(url_prefix[i]);
+	}
+
+	Head = Tail = 0;
+	for (c=0; c<128; c++) {
+		s = URLNext[0][c];
+		if (s != 0) {
+			Fail[s] = 0;
+			Queue[Tail++] = s;
+		}
+	}
+	while (Head < Tail) {
+		r = Queue[Head++];
+		for (c=0; c<128; c++) {
+			s = URLNext[r][c];
+			if (s != 0) {
+				Fail[s] = URLNext[Fail[r]][c];
+				if (URLMatchLen[s] == 0) {
+					URLMatchLen[s] = URLMatchLen[Fail[s]];
+				}
+				Queue[Tail++] = s;
+			}
+			else {
+				URLNext[r][c] = URLNext[Fail[r]][c];
+			}
+		}
+	}
+
+	URLAutomatonReady = TRUE;
+}
+#endif
+
+// Ptr ܂ލs URL tKv邱ƂL^
+static void MarkURLDirty(LONG Ptr)
+{
+	if (Ptr < BufferSize) {
+		LineURLDirty[Ptr / NumOfColumns] = 1;
+	}
+}
+
+// Ptr Ŏn܂s URL KvȂt
+//   ς͈͂ XStart, XEnd ɕԂBωȂ FALSE ԂB
+static BOOL MarkURL(LONG Ptr, int *XStart, int *XEnd)
 {
 #ifdef URL_EMPHASIS
-	LONG PrevCharPtr;
-	CHAR PrevCharAttr, PrevCharCode;
-
-	// RFC3986(Uniform Resource Identifier (URI): Generic Syntax)ɏ
-	// by sakura editor 1.5.2.1: etc_uty.cpp
-	static const char	url_char[] = {
-	  /* +0  +1  +2  +3  +4  +5  +6  +7  +8  +9  +A  +B  +C  +D  +E  +F */
-	      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,	/* +00: */
-	      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,	/* +10: */
-	      0, -1,  0, -1, -1, -1, -1,  0,  0,  0,  0, -1, -1, -1, -1, -1,	/* +20: " !"#$%&'()*+,-./" */
-	     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1,  0, -1,	/* +30: "0123456789:;<=>?" */
-	     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,	/* +40: "@ABCDEFGHIJKLMNO" */
-	     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0, -1,  0,  0, -1,	/* +50: "PQRSTUVWXYZ[\]^_" */
-	      0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,	/* +60: "`abcdefghijklmno" */
-	     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  0,  0, -1,  0,	/* +70: "pqrstuvwxyz{|}~ " */
-	    /* 0    : not url char
-	     * -1   : url char
-	     * other: url head char --> url_table array number + 1
-	     */
-	};
-	static char *prefix[] = {
-		"https://",
-		"http://",
-		"sftp://",
-		"tftp://",
-		"news://",
-		"ftp://",
-		"mms://",
-		NULL
-	};
-	unsigned char ch = CodeLine[x];
+	static char NewURL[BuffXMax];
+	PCell Line, PrevChar;
+	int x, i, s, len, Row, First, Last;
+	BYTE ch;
+
+	if (Ptr >= BufferSize) { // kXN[obt@̍s͈ڂƂɏς
+		return FALSE;
+	}
+	Row = Ptr / NumOfColumns;
+	if (! LineURLDirty[Row]) {
+		return FALSE;
+	}
+	LineURLDirty[Row] = 0;
 
 	if (ts.EnableClickableUrl == FALSE &&
 		(ts.ColorFlag & CF_URLCOLOR) == 0)
-		return;
+		return FALSE;
+
+	if (! URLAutomatonReady) {
+		URLBuildAutomaton();
+	}
+
+	Line = &CellBuff[Ptr];
+	s = 0;
+	for (x=0; x<NumOfColumns; x++) {
+		ch = (BYTE)Line[x].Code;
+		NewURL[x] = 0;
 
-	// O̍sAĂ邩B
-	if (x == 0) {
-		PrevCharPtr = PrevLinePtr(LinePtr) + NumOfColumns-1;
-		PrevCharCode = CodeBuff[PrevCharPtr];
-		PrevCharAttr = AttrBuff[PrevCharPtr];
-		if ((PrevCharAttr & AttrURL) && !(AttrLine[0]&(AttrKanji|AttrSpecial)) && !(ch & 0x80) && url_char[ch]) {
-			if ((AttrLine[0] & AttrLineContinued) || (ts.JoinSplitURL &&
-			    (PrevCharCode == ts.JoinSplitURLIgnoreEOLChar || ts.JoinSplitURLIgnoreEOLChar == '\0' ))) {
-				AttrLine[0] |= AttrURL;
+		if (x == 0) {
+			// O̍sAĂ邩B
+			if (ColdLines > 0 && LineSlot[Row] == BuffStartAbs) {
+				// O̍s͈kς݂Ȃ̂ŁAWJɊoĂsg
+				PrevChar = &ColdLastCell;
+			}
+			else {
+				PrevChar = &CellBuff[PrevLinePtr(Ptr) + NumOfColumns-1];
+			}
+			if ((PrevChar->Attr & AttrURL) && !(Line[0].Attr&(AttrKanji|AttrSpecial)) && !(ch & 0x80) && url_char[ch]) {
+				if ((Line[0].Attr & AttrLineContinued) || (ts.JoinSplitURL &&
+				    (PrevChar->Code == ts.JoinSplitURLIgnoreEOLChar || ts.JoinSplitURLIgnoreEOLChar == '\0' ))) {
+					NewURL[0] = 1;
+				}
 			}
 		}
-		return;
-	}
+		else if (NewURL[x-1] &&
+		         !(Line[x].Attr & (AttrKanji|AttrSpecial)) &&
+		         ((!(ch & 0x80) && url_char[ch]) || (x == NumOfColumns - 1 && ch == ts.JoinSplitURLIgnoreEOLChar))) {
+			NewURL[x] = 1;
+		}
 
-	if ((x-1>=0) && (AttrLine[x-1] & AttrURL) &&
-	  !(AttrLine[x] & (AttrKanji|AttrSpecial)) &&
-	  ((!(ch & 0x80) && url_char[ch]) || (x == NumOfColumns - 1 && ch == ts.JoinSplitURLIgnoreEOLChar))) {
-		AttrLine[x] |= AttrURL;
-		return;
+		s = (ch & 0x80) ? 0 : URLNext[s][ch];
+		len = URLMatchLen[s];
+		if (len > 0 && ! NewURL[x]) {
+			for (i = 0; i < len; i++) {
+				NewURL[x-i] = 1;
+			}
+		}
 	}
 
-	if ((x-2>=0) && !strncmp(&CodeLine[x-2], "://", 3)) {
-		int i, len = -1;
-		RECT rc;
-		int CaretX, CaretY;
-		char **p = prefix;
-
-		while (*p) {
-			len = strlen(*p) - 1;
-			if ((x-len>=0) && !strncmp(&CodeLine[x-len], *p, len)) {
-				for (i = 0; i <= len; i++) {
-					AttrLine[x-i] |= AttrURL;
-				}
-				break;
+	First = NumOfColumns;
+	Last = -1;
+	for (x=0; x<NumOfColumns; x++) {
+		if (((Line[x].Attr & AttrURL) != 0) != NewURL[x]) {
+			Line[x].Attr ^= AttrURL;
+			if (First > x) {
+				First = x;
 			}
-			p++;
-		}
-
-		/* nCp[N̐FύX́Ałɉʂ֏o͌ɁAobt@k URL 
-		 * tƂWbNł邽߁AF`悳ȂꍇB
-		 * XAnCp[N𔭌^C~OŁA̍sɍĕ`woƂŁA
-		 * A^CȐF`B
-		 * (2009.8.26 yutaka)
-		 */
-		CaretX = (0-WinOrgX)*FontWidth;
-		CaretY = (CursorY-WinOrgY)*FontHeight;
-		rc.left = CaretX;
-		rc.top = CaretY;
-		rc.right = CaretX + NumOfColumns * FontWidth;
-		rc.bottom = CaretY + FontHeight;
-		InvalidateRect(HVTWin, &rc, FALSE);
+			Last = x;
+		}
+	}
+	if (Last < 0) {
+		return FALSE;
 	}
+	if (Last == NumOfColumns - 1) {
+		// sς̂Ŏ̍s̘Aג
+		MarkURLDirty(NextLinePtr(Ptr));
+	}
+	*XStart = First;
+	*XEnd = Last;
+	return TRUE;
+#else
+	return FALSE;
 #endif
 }
 /* end - ishizaki */
 
+void BuffSetUnicode(DWORD Code)
+// Set the code point stored with the characters put by BuffPutChar()/BuffPutKanji()
+//   Code: Unicode code point, UniContinued for the right half of a
+//         character drawn as two cells, or 0 to derive it from the DBCS code
+{
+	PutUni = Code;
+}
+
 void BuffPutChar(BYTE b, TCharAttr Attr, BOOL Insert)
 // Put a character in the buffer at the current position
 //   b: character
@@ -1825,7 +2770,7 @@ void BuffPutChar(BYTE b, TCharAttr Attr, BOOL Insert)
 	int XStart, LineEnd, MoveLen;
 	int extr = 0;
 
-	if (ts.EnableContinuedLineCopy && CursorX == 0 && (AttrLine[0] & AttrLineContinued)) {
+	if (ts.EnableContinuedLineCopy && CursorX == 0 && (CellLine[0].Attr & AttrLineContinued)) {
 		Attr.Attr |= AttrLineContinued;
 	}
 
@@ -1842,40 +2787,34 @@ void BuffPutChar(BYTE b, TCharAttr Attr, BOOL Insert)
 		else
 			LineEnd = CursorRightM;
 
-		if (LineEnd < NumOfColumns - 1 && (AttrLine[LineEnd] & AttrKanji)) {
-			CodeLine[LineEnd] = 0x20;
-			AttrLine[LineEnd] &= ~AttrKanji;
-			CodeLine[LineEnd+1] = 0x20;
-			AttrLine[LineEnd+1] &= ~AttrKanji;
+		if (LineEnd < NumOfColumns - 1 && (CellLine[LineEnd].Attr & AttrKanji)) {
+			SetCellCode(CellLine[LineEnd], 0x20);
+			CellLine[LineEnd].Attr &= ~AttrKanji;
+			SetCellCode(CellLine[LineEnd+1], 0x20);
+			CellLine[LineEnd+1].Attr &= ~AttrKanji;
 			extr = 1;
 		}
 
 		MoveLen = LineEnd - CursorX;
 		if (MoveLen > 0) {
-			memmove(&CodeLine[CursorX+1], &CodeLine[CursorX], MoveLen);
-			memmove(&AttrLine[CursorX+1], &AttrLine[CursorX], MoveLen);
-			memmove(&AttrLine2[CursorX+1], &AttrLine2[CursorX], MoveLen);
-			memmove(&AttrLineFG[CursorX+1], &AttrLineFG[CursorX], MoveLen);
-			memmove(&AttrLineBG[CursorX+1], &AttrLineBG[CursorX], MoveLen);
-		}
-		CodeLine[CursorX] = b;
-		AttrLine[CursorX] = Attr.Attr;
-		AttrLine2[CursorX] = Attr.Attr2;
-		AttrLineFG[CursorX] = Attr.Fore;
-		AttrLineBG[CursorX] = Attr.Back;
+			MoveCells(LinePtr+CursorX+1, LinePtr+CursorX, MoveLen);
+		}
+		CellLine[CursorX].Code = b;
+		SetCellUni(&CellLine[CursorX], PutUni);
+		CellLine[CursorX].Attr = Attr.Attr;
+		CellLine[CursorX].Attr2 = Attr.Attr2;
+		CellLine[CursorX].Fore = Attr.Fore;
+		CellLine[CursorX].Back = Attr.Back;
 		/* last char in current line is kanji first? */
-		if ((AttrLine[LineEnd] & AttrKanji) != 0) {
+		if ((CellLine[LineEnd].Attr & AttrKanji) != 0) {
 			/* then delete it */
-			CodeLine[LineEnd] = 0x20;
-			AttrLine[LineEnd] = CurCharAttr.Attr;
-			AttrLine2[LineEnd] = CurCharAttr.Attr2;
-			AttrLineFG[LineEnd] = CurCharAttr.Fore;
-			AttrLineBG[LineEnd] = CurCharAttr.Back;
+			SetCellCode(CellLine[LineEnd], 0x20);
+			CellLine[LineEnd].Attr = CurCharAttr.Attr;
+			CellLine[LineEnd].Attr2 = CurCharAttr.Attr2;
+			CellLine[LineEnd].Fore = CurCharAttr.Fore;
+			CellLine[LineEnd].Back = CurCharAttr.Back;
 		}
-		/* begin - ishizaki */
-		markURL(CursorX+1);
-		markURL(CursorX);
-		/* end - ishizaki */
+		MarkURLDirty(LinePtr);
 
 		if (StrChangeCount==0) {
 			XStart = CursorX;
@@ -1884,17 +2823,16 @@ void BuffPutChar(BYTE b, TCharAttr Attr, BOOL Insert)
 			XStart = StrChangeStart;
 		}
 		StrChangeCount = 0;
-		BuffUpdateRect(XStart, CursorY, LineEnd+extr, CursorY);
+		DamageRect(XStart, CursorY, LineEnd+extr, CursorY);
 	}
 	else {
-		CodeLine[CursorX] = b;
-		AttrLine[CursorX] = Attr.Attr;
-		AttrLine2[CursorX] = Attr.Attr2;
-		AttrLineFG[CursorX] = Attr.Fore;
-		AttrLineBG[CursorX] = Attr.Back;
-		/* begin - ishizaki */
-		markURL(CursorX);
-		/* end - ishizaki */
+		CellLine[CursorX].Code = b;
+		SetCellUni(&CellLine[CursorX], PutUni);
+		CellLine[CursorX].Attr = Attr.Attr;
+		CellLine[CursorX].Attr2 = Attr.Attr2;
+		CellLine[CursorX].Fore = Attr.Fore;
+		CellLine[CursorX].Back = Attr.Back;
+		MarkURLDirty(LinePtr);
 
 		if (StrChangeCount==0) {
 			StrChangeStart = CursorX;
@@ -1903,6 +2841,117 @@ void BuffPutChar(BYTE b, TCharAttr Attr, BOOL Insert)
 	}
 }
 
+void BuffPutString(PCHAR s, int len, TCharAttr Attr)
+// Put single-byte characters in the buffer at the current position
+// (overwrite mode) and leave the cursor on the last character.
+// The caller must make sure that the string fits in the current line.
+//   s: characters
+//   len: length of s
+//   Attr: attributes
+{
+	int XEnd, i;
+	BOOL Continued;
+
+	if (len <= 0) {
+		return;
+	}
+	XEnd = CursorX + len - 1;
+
+	Continued = ts.EnableContinuedLineCopy && CursorX == 0 && (CellLine[0].Attr & AttrLineContinued);
+
+	if (ts.Language==IdJapanese || ts.Language==IdKorean || ts.Language==IdUtf8) {
+		EraseKanji(1); /* if cursor is on right half of a kanji, erase the kanji */
+		/* if the last char overwrites left half of a kanji, erase its right half */
+		if ((CellLine[XEnd].Attr & AttrKanji) != 0 && XEnd+1 < NumOfColumns) {
+			SetCellCode(CellLine[XEnd+1], 0x20);
+			CellLine[XEnd+1].Attr = CurCharAttr.Attr;
+			CellLine[XEnd+1].Attr2 = CurCharAttr.Attr2;
+			CellLine[XEnd+1].Fore = CurCharAttr.Fore;
+			CellLine[XEnd+1].Back = CurCharAttr.Back;
+			DamageAdd(CursorY, XEnd+1, 1);
+		}
+	}
+
+	ClearUni(LinePtr+CursorX, len);
+	for (i=0; i<len; i++) {
+		CellLine[CursorX+i].Code = s[i];
+		CellLine[CursorX+i].Attr = Attr.Attr;
+		CellLine[CursorX+i].Attr2 = Attr.Attr2;
+		CellLine[CursorX+i].Fore = Attr.Fore;
+		CellLine[CursorX+i].Back = Attr.Back;
+	}
+	if (Continued) {
+		CellLine[0].Attr |= AttrLineContinued;
+	}
+
+	MarkURLDirty(LinePtr);
+
+	if (StrChangeCount==0) {
+		StrChangeStart = CursorX;
+	}
+	StrChangeCount = StrChangeCount + len;
+
+	CursorX = XEnd;
+	/* ŉsłXN[ */
+	if (ts.AutoScrollOnlyInBottomLine == 0 || WinOrgY == 0) {
+		DispScrollToCursor(CursorX, CursorY);
+	}
+}
+
+void BuffPutKanjiString(LPWORD w, int count, TCharAttr Attr)
+// Put DBCS characters in the buffer at the current position
+// (overwrite mode) and leave the cursor on the last character.
+// The caller must make sure that the characters fit in the current line.
+//   w: characters
+//   count: number of characters in w
+//   Attr: attributes
+{
+	int XEnd, X, i;
+	BOOL Continued;
+
+	if (count <= 0) {
+		return;
+	}
+	XEnd = CursorX + count * 2 - 1;
+
+	Continued = ts.EnableContinuedLineCopy && CursorX == 0 && (CellLine[0].Attr & AttrLineContinued);
+
+	EraseKanji(1); /* if cursor is on right half of a kanji, erase the kanji */
+
+	ClearUni(LinePtr+CursorX, count * 2);
+	X = CursorX;
+	for (i=0; i<count; i++) {
+		CellLine[X].Code = HIBYTE(w[i]);
+		CellLine[X].Attr = Attr.Attr | AttrKanji; /* DBCS first byte */
+		CellLine[X].Attr2 = Attr.Attr2;
+		CellLine[X].Fore = Attr.Fore;
+		CellLine[X].Back = Attr.Back;
+		CellLine[X+1].Code = LOBYTE(w[i]);
+		CellLine[X+1].Attr = Attr.Attr;
+		CellLine[X+1].Attr2 = Attr.Attr2;
+		CellLine[X+1].Fore = Attr.Fore;
+		CellLine[X+1].Back = Attr.Back;
+		X += 2;
+	}
+	if (Continued) {
+		CellLine[0].Attr |= AttrLineContinued;
+		CellLine[1].Attr |= AttrLineContinued;
+	}
+
+	MarkURLDirty(LinePtr);
+
+	if (StrChangeCount==0) {
+		StrChangeStart = CursorX;
+	}
+	StrChangeCount = StrChangeCount + count * 2;
+
+	CursorX = XEnd - 1;
+	/* ŉsłXN[ */
+	if (ts.AutoScrollOnlyInBottomLine == 0 || WinOrgY == 0) {
+		DispScrollToCursor(CursorX, CursorY);
+	}
+}
+
 void BuffPutKanji(WORD w, TCharAttr Attr, BOOL Insert)
 // Put a kanji character in the buffer at the current position
 //   b: character
@@ -1912,7 +2961,7 @@ void BuffPutKanji(WORD w, TCharAttr Attr, BOOL Insert)
 	int XStart, LineEnd, MoveLen;
 	int extr = 0;
 
-	if (ts.EnableContinuedLineCopy && CursorX == 0 && (AttrLine[0] & AttrLineContinued)) {
+	if (ts.EnableContinuedLineCopy && CursorX == 0 && (CellLine[0].Attr & AttrLineContinued)) {
 		Attr.Attr |= AttrLineContinued;
 	}
 
@@ -1924,48 +2973,42 @@ void BuffPutKanji(WORD w, TCharAttr Attr, BOOL Insert)
 		else
 			LineEnd = CursorRightM;
 
-		if (LineEnd < NumOfColumns - 1 && (AttrLine[LineEnd] & AttrKanji)) {
-			CodeLine[LineEnd] = 0x20;
-			AttrLine[LineEnd] &= ~AttrKanji;
-			CodeLine[LineEnd+1] = 0x20;
-			AttrLine[LineEnd+1] &= ~AttrKanji;
+		if (LineEnd < NumOfColumns - 1 && (CellLine[LineEnd].Attr & AttrKanji)) {
+			SetCellCode(CellLine[LineEnd], 0x20);
+			CellLine[LineEnd].Attr &= ~AttrKanji;
+			SetCellCode(CellLine[LineEnd+1], 0x20);
+			CellLine[LineEnd+1].Attr &= ~AttrKanji;
 			extr = 1;
 		}
 
 		MoveLen = LineEnd - CursorX - 1;
 		if (MoveLen > 0) {
-			memmove(&CodeLine[CursorX+2], &CodeLine[CursorX], MoveLen);
-			memmove(&AttrLine[CursorX+2], &AttrLine[CursorX], MoveLen);
-			memmove(&AttrLine2[CursorX+2], &AttrLine2[CursorX], MoveLen);
-			memmove(&AttrLineFG[CursorX+2], &AttrLineFG[CursorX], MoveLen);
-			memmove(&AttrLineBG[CursorX+2], &AttrLineBG[CursorX], MoveLen);
-		}
-
-		CodeLine[CursorX] = HIBYTE(w);
-		AttrLine[CursorX] = Attr.Attr | AttrKanji; /* DBCS first byte */
-		AttrLine2[CursorX] = Attr.Attr2;
-		AttrLineFG[CursorX] = Attr.Fore;
-		AttrLineBG[CursorX] = Attr.Back;
+			MoveCells(LinePtr+CursorX+2, LinePtr+CursorX, MoveLen);
+		}
+
+		CellLine[CursorX].Code = HIBYTE(w);
+		SetCellUni(&CellLine[CursorX], PutUni);
+		CellLine[CursorX].Attr = Attr.Attr | AttrKanji; /* DBCS first byte */
+		CellLine[CursorX].Attr2 = Attr.Attr2;
+		CellLine[CursorX].Fore = Attr.Fore;
+		CellLine[CursorX].Back = Attr.Back;
 		if (CursorX < LineEnd) {
-			CodeLine[CursorX+1] = LOBYTE(w);
-			AttrLine[CursorX+1] = Attr.Attr;
-			AttrLine2[CursorX+1] = Attr.Attr2;
-			AttrLineFG[CursorX+1] = Attr.Fore;
-			AttrLineBG[CursorX+1] = Attr.Back;
+			SetCellCode(CellLine[CursorX+1], LOBYTE(w));
+			CellLine[CursorX+1].Attr = Attr.Attr;
+			CellLine[CursorX+1].Attr2 = Attr.Attr2;
+			CellLine[CursorX+1].Fore = Attr.Fore;
+			CellLine[CursorX+1].Back = Attr.Back;
 		}
-		/* begin - ishizaki */
-		markURL(CursorX);
-		markURL(CursorX+1);
-		/* end - ishizaki */
+		MarkURLDirty(LinePtr);
 
 		/* last char in current line is kanji first? */
-		if ((AttrLine[LineEnd] & AttrKanji) != 0) {
+		if ((CellLine[LineEnd].Attr & AttrKanji) != 0) {
 			/* then delete it */
-			CodeLine[LineEnd] = 0x20;
-			AttrLine[LineEnd] = CurCharAttr.Attr;
-			AttrLine2[LineEnd] = CurCharAttr.Attr2;
-			AttrLineFG[LineEnd] = CurCharAttr.Fore;
-			AttrLineBG[LineEnd] = CurCharAttr.Back;
+			SetCellCode(CellLine[LineEnd], 0x20);
+			CellLine[LineEnd].Attr = CurCharAttr.Attr;
+			CellLine[LineEnd].Attr2 = CurCharAttr.Attr2;
+			CellLine[LineEnd].Fore = CurCharAttr.Fore;
+			CellLine[LineEnd].Back = CurCharAttr.Back;
 		}
 
 		if (StrChangeCount==0) {
@@ -1975,25 +3018,23 @@ void BuffPutKanji(WORD w, TCharAttr Attr, BOOL Insert)
 			XStart = StrChangeStart;
 		}
 		StrChangeCount = 0;
-		BuffUpdateRect(XStart, CursorY, LineEnd+extr, CursorY);
+		DamageRect(XStart, CursorY, LineEnd+extr, CursorY);
 	}
 	else {
-		CodeLine[CursorX] = HIBYTE(w);
-		AttrLine[CursorX] = Attr.Attr | AttrKanji; /* DBCS first byte */
-		AttrLine2[CursorX] = Attr.Attr2;
-		AttrLineFG[CursorX] = Attr.Fore;
-		AttrLineBG[CursorX] = Attr.Back;
+		CellLine[CursorX].Code = HIBYTE(w);
+		SetCellUni(&CellLine[CursorX], PutUni);
+		CellLine[CursorX].Attr = Attr.Attr | AttrKanji; /* DBCS first byte */
+		CellLine[CursorX].Attr2 = Attr.Attr2;
+		CellLine[CursorX].Fore = Attr.Fore;
+		CellLine[CursorX].Back = Attr.Back;
 		if (CursorX < NumOfColumns-1) {
-			CodeLine[CursorX+1] = LOBYTE(w);
-			AttrLine[CursorX+1] = Attr.Attr;
-			AttrLine2[CursorX+1] = Attr.Attr2;
-			AttrLineFG[CursorX+1] = Attr.Fore;
-			AttrLineBG[CursorX+1] = Attr.Back;
+			SetCellCode(CellLine[CursorX+1], LOBYTE(w));
+			CellLine[CursorX+1].Attr = Attr.Attr;
+			CellLine[CursorX+1].Attr2 = Attr.Attr2;
+			CellLine[CursorX+1].Fore = Attr.Fore;
+			CellLine[CursorX+1].Back = Attr.Back;
 		}
-		/* begin - ishizaki */
-		markURL(CursorX);
-		markURL(CursorX+1);
-		/* end - ishizaki */
+		MarkURLDirty(LinePtr);
 
 		if (StrChangeCount==0) {
 			StrChangeStart = CursorX;
@@ -2033,7 +3074,7 @@ void BuffUpdateRect
 //   YEnd: y position
 {
 	int i, j, count;
-	int IStart, IEnd;
+	int IStart, IEnd, UStart, UEnd;
 	int X, Y;
 	LONG TmpPtr;
 	TCharAttr CurAttr, TempAttr;
@@ -2078,6 +3119,8 @@ void BuffUpdateRect
 	Y = (YStart-WinOrgY)*FontHeight;
 	TmpPtr = GetLinePtr(PageStart+YStart);
 	for (j = YStart+PageStart ; j <= YEnd+PageStart ; j++) {
+		MarkURL(TmpPtr, &UStart, &UEnd);
+
 		IStart = XStart;
 		IEnd = XEnd;
 
@@ -2087,20 +3130,20 @@ void BuffUpdateRect
 
 		i = IStart;
 		do {
-			CurAttr.Attr = AttrBuff[TmpPtr+i] & ~ AttrKanji;
-			CurAttr.Attr2 = AttrBuff2[TmpPtr+i];
-			CurAttr.Fore = AttrBuffFG[TmpPtr+i];
-			CurAttr.Back = AttrBuffBG[TmpPtr+i];
+			CurAttr.Attr = CellBuff[TmpPtr+i].Attr & ~ AttrKanji;
+			CurAttr.Attr2 = CellBuff[TmpPtr+i].Attr2;
+			CurAttr.Fore = CellBuff[TmpPtr+i].Fore;
+			CurAttr.Back = CellBuff[TmpPtr+i].Back;
 			CurSel = CheckSelect(i,j);
 			count = 1;
 			while ( (i+count <= IEnd) &&
-			        (CurAttr.Attr == (AttrBuff[TmpPtr+i+count] & ~ AttrKanji)) &&
-			        (CurAttr.Attr2==AttrBuff2[TmpPtr+i+count]) &&
-			        (CurAttr.Fore==AttrBuffFG[TmpPtr+i+count]) &&
-			        (CurAttr.Back==AttrBuffBG[TmpPtr+i+count]) &&
+			        (CurAttr.Attr == (CellBuff[TmpPtr+i+count].Attr & ~ AttrKanji)) &&
+			        (CurAttr.Attr2==CellBuff[TmpPtr+i+count].Attr2) &&
+			        (CurAttr.Fore==CellBuff[TmpPtr+i+count].Fore) &&
+			        (CurAttr.Back==CellBuff[TmpPtr+i+count].Back) &&
 			        (CurSel==CheckSelect(i+count,j)) ||
 			        (i+count<NumOfColumns) &&
-			        ((AttrBuff[TmpPtr+i+count-1] & AttrKanji) != 0) ) {
+			        ((CellBuff[TmpPtr+i+count-1].Attr & AttrKanji) != 0) ) {
 				count++;
 			}
 
@@ -2109,71 +3152,106 @@ void BuffUpdateRect
 				TempAttr = CurAttr;
 				TempSel = CurSel;
 			}
-			DispStr(&CodeBuff[TmpPtr+i],count,Y, &X);
+			DispStr(GetCellCodes(&CellBuff[TmpPtr+i],count),count,Y, &X);
+			TextRuns++;
 			i = i+count;
 		}
 		while (i<=IEnd);
 		Y = Y + FontHeight;
 		TmpPtr = NextLinePtr(TmpPtr);
 	}
+	DispFlushStr();
 	if (Caret) {
 		CaretOn();
 	}
 }
 
 void UpdateStr()
-// Display not-yet-displayed string
+// Add not-yet-displayed string to the damaged region
+//   the string is drawn by BuffFlushDamage()
 {
-	int X, Y;
-	TCharAttr TempAttr;
-	int pos, len;
-
 	if (StrChangeCount==0) {
 		return;
 	}
-	X = StrChangeStart;
-	Y = CursorY;
-	if (! IsLineVisible(&X, &Y)) {
-		StrChangeCount = 0;
-		return;
-	}
+	DamageAdd(CursorY, StrChangeStart, StrChangeCount);
+	FrameParsed += StrChangeCount;
+	StrChangeCount = 0;
+}
 
-	TempAttr.Attr = AttrLine[StrChangeStart];
-	TempAttr.Attr2 = AttrLine2[StrChangeStart];
-	TempAttr.Fore = AttrLineFG[StrChangeStart];
-	TempAttr.Back = AttrLineBG[StrChangeStart];
-
-	/* ꂩ`悷镶̎n܂肪uURL\vꍇA
-	 * YFōs܂ŃyCgȂ悤ɂB
-	 * (2009.10.24 yutaka)
-	 */
-	if (TempAttr.Attr & AttrURL) {
-		/* Jnʒuǂ܂ł AttrURL JEg */
-		len = 0;
-		for (pos = 0 ; pos < StrChangeCount ; pos++) {
-			if (TempAttr.Attr != AttrLine[StrChangeStart + pos])
-				break;
-			len++;
+void BuffFlushDamage()
+// Display the damaged region
+{
+	int y, XStart, XEnd, UStart, UEnd;
+	int Top, Bottom, Count;
+	DWORD Runs;
+
+	UpdateStr();
+	DispUpdateScroll();
+	Runs = TextRuns;
+
+	Top = DamageTop;
+	Bottom = min(DamageBottom, NumOfLines-1);
+	DamageTop = NumOfLines;
+	DamageBottom = -1;
+
+	for (y = Top ; y <= Bottom ; y++) {
+		if (DamageLeft[y] >= DamageRight[y]) {
+			continue;
 		}
-		DispSetupDC(TempAttr, FALSE);
-		DispStr(&CodeLine[StrChangeStart], len, Y, &X);
+		XStart = DamageLeft[y];
+		XEnd = DamageRight[y] - 1;
+		DamageLeft[y] = DamageRight[y] = 0;
 
-		/* c̕񂪂΁Aӂɕ`sB*/
-		if (len < StrChangeCount) {
-			TempAttr.Attr = AttrLine[StrChangeStart + pos];
-			TempAttr.Attr2 = AttrLine2[StrChangeStart + pos];
-			TempAttr.Fore = AttrLineFG[StrChangeStart + pos];
-			TempAttr.Back = AttrLineBG[StrChangeStart + pos];
+		/* URL ͍sPʂŕt̂ŁA͈͂̊Oς邱ƂB
+		 * ς͈͂ꏏɕ`悷B */
+		if (MarkURL(GetLinePtr(PageStart+y), &UStart, &UEnd)) {
+			XStart = min(XStart, UStart);
+			XEnd = max(XEnd, UEnd);
+		}
 
-			DispSetupDC(TempAttr, FALSE);
-			DispStr(&CodeLine[StrChangeStart + pos], (StrChangeCount - len), Y, &X);
+		if (y >= WinOrgY && y < WinOrgY+WinHeight) {
+			Count = min(XEnd, WinOrgX+WinWidth-1) - max(XStart, WinOrgX) + 1;
+			if (Count > 0) {
+				FramePainted += Count;
+			}
 		}
-	} else {
-		DispSetupDC(TempAttr, FALSE);
-		DispStr(&CodeLine[StrChangeStart],StrChangeCount,Y, &X);
+		BuffUpdateRect(XStart, y, XEnd, y);
 	}
 
-	StrChangeCount = 0;
+	RenderStats.Frames++;
+	RenderStats.CellsParsed += FrameParsed;
+	RenderStats.CellsPainted += FramePainted;
+	RenderStats.TextRuns += TextRuns - Runs;
+	RenderStats.LastParsed = FrameParsed;
+	RenderStats.LastPainted = FramePainted;
+	RenderStats.LastTextRuns = TextRuns - Runs;
+	FrameParsed = 0;
+	FramePainted = 0;
+	LastFrameTick = GetTickCount();
+}
+
+void BuffRenderFrame(BOOL Idle)
+// Display the damaged region at most once per RenderFrameInterval
+//   Idle: no more received data. the region is displayed now.
+{
+	UpdateStr();
+	if (DamageTop > DamageBottom) {
+		return;
+	}
+	if (Idle || GetTickCount() - LastFrameTick >= RenderFrameInterval) {
+		BuffFlushDamage();
+	}
+}
+
+BOOL BuffRenderPending()
+// Is there any not-yet-displayed string?
+{
+	return (StrChangeCount > 0 || DamageTop <= DamageBottom);
+}
+
+void BuffGetRenderStats(PRenderStats Stats)
+{
+	*Stats = RenderStats;
 }
 
 #if 0
@@ -2192,12 +3270,12 @@ void UpdateStrUnicode(void)
     return;
   }
 
-  TempAttr.Attr = AttrLine[StrChangeStart];
-  TempAttr.Attr2 = AttrLine2[StrChangeStart];
-  TempAttr.Fore = AttrLineFG[StrChangeStart];
-  TempAttr.Back = AttrLineBG[StrChangeStart];
+  TempAttr.Attr = CellLine[StrChangeStart].Attr;
+  TempAttr.Attr2 = CellLine[StrChangeStart].Attr2;
+  TempAttr.Fore = CellLine[StrChangeStart].Fore;
+  TempAttr.Back = CellLine[StrChangeStart].Back;
   DispSetupDC(TempAttr, FALSE);
-  DispStr(&CodeLine[StrChangeStart],StrChangeCount,Y, &X);
+  DispStr(GetCellCodes(&CellLine[StrChangeStart],StrChangeCount),StrChangeCount,Y, &X);
   StrChangeCount = 0;
 }
 #endif
@@ -2236,7 +3314,7 @@ void BuffSetCaretWidth()
 	BOOL DW;
 
 	/* check whether cursor on a DBCS character */
-	DW = (((BYTE)(AttrLine[CursorX]) & AttrKanji) != 0);
+	DW = (((BYTE)(CellLine[CursorX].Attr) & AttrKanji) != 0);
 	DispSetCaretWidth(DW);
 }
 
@@ -2256,25 +3334,25 @@ void ScrollUp1Line()
 		if (extl || extr)
 			EraseKanjiOnLRMargin(GetLinePtr(PageStart+CursorTop), CursorBottom-CursorTop+1);
 
-		linelen = CursorRightM - CursorLeftM + 1;
-		DestPtr = GetLinePtr(PageStart+CursorBottom) + CursorLeftM;
-		for (i = CursorBottom-1 ; i >= CursorTop ; i--) {
-			SrcPtr = PrevLinePtr(DestPtr);
-			memcpy(&(CodeBuff[DestPtr]), &(CodeBuff[SrcPtr]), linelen);
-			memcpy(&(AttrBuff[DestPtr]), &(AttrBuff[SrcPtr]), linelen);
-			memcpy(&(AttrBuff2[DestPtr]), &(AttrBuff2[SrcPtr]), linelen);
-			memcpy(&(AttrBuffFG[DestPtr]), &(AttrBuffFG[SrcPtr]), linelen);
-			memcpy(&(AttrBuffBG[DestPtr]), &(AttrBuffBG[SrcPtr]), linelen);
-			DestPtr = SrcPtr;
-		}
-		memset(&(CodeBuff[SrcPtr]), 0x20, linelen);
-		memset(&(AttrBuff[SrcPtr]), AttrDefault, linelen);
-		memset(&(AttrBuff2[SrcPtr]), CurCharAttr.Attr2 & Attr2ColorMask, linelen);
-		memset(&(AttrBuffFG[SrcPtr]), CurCharAttr.Fore, linelen);
-		memset(&(AttrBuffBG[SrcPtr]), CurCharAttr.Back, linelen);
+		if (!extl && !extr) {
+			RotateLines(PageStart+CursorTop, CursorBottom-CursorTop+1, -1);
+			DamageScroll(CursorTop, CursorBottom, -1);
+			EraseLines(PageStart+CursorTop, 1);
+		}
+		else {
+			linelen = CursorRightM - CursorLeftM + 1;
+			DestPtr = GetLinePtr(PageStart+CursorBottom) + CursorLeftM;
+			for (i = CursorBottom-1 ; i >= CursorTop ; i--) {
+				SrcPtr = PrevLinePtr(DestPtr);
+				MoveCells(DestPtr, SrcPtr, linelen);
+				MarkURLDirty(DestPtr);
+				DestPtr = SrcPtr;
+			}
+			EraseCells(&CellBuff[DestPtr], linelen);
+		}
 
 		if (CursorLeftM > 0 || CursorRightM < NumOfColumns-1)
-			BuffUpdateRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
+			DamageRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
 		else
 			DispScrollNLines(CursorTop, CursorBottom, -1);
 	}
@@ -2326,33 +3404,33 @@ void BuffScrollNLines(int n)
 		if (extl || extr)
 			EraseKanjiOnLRMargin(GetLinePtr(PageStart+CursorTop), CursorBottom-CursorTop+1);
 
-		linelen = CursorRightM - CursorLeftM + 1;
-		DestPtr = GetLinePtr(PageStart+CursorTop) + (LONG)CursorLeftM;
-		if (n<CursorBottom-CursorTop+1) {
-			SrcPtr = GetLinePtr(PageStart+CursorTop+n) + (LONG)CursorLeftM;
-			for (i = CursorTop+n ; i<=CursorBottom ; i++) {
-				memmove(&(CodeBuff[DestPtr]), &(CodeBuff[SrcPtr]), linelen);
-				memmove(&(AttrBuff[DestPtr]), &(AttrBuff[SrcPtr]), linelen);
-				memmove(&(AttrBuff2[DestPtr]), &(AttrBuff2[SrcPtr]), linelen);
-				memmove(&(AttrBuffFG[DestPtr]), &(AttrBuffFG[SrcPtr]), linelen);
-				memmove(&(AttrBuffBG[DestPtr]), &(AttrBuffBG[SrcPtr]), linelen);
-				SrcPtr = NextLinePtr(SrcPtr);
-				DestPtr = NextLinePtr(DestPtr);
-			}
-		}
-		else {
+		if (n > CursorBottom-CursorTop+1) {
 			n = CursorBottom-CursorTop+1;
 		}
-		for (i = CursorBottom+1-n ; i<=CursorBottom; i++) {
-			memset(&(CodeBuff[DestPtr]), 0x20, linelen);
-			memset(&(AttrBuff[DestPtr]), AttrDefault, linelen);
-			memset(&(AttrBuff2[DestPtr]), CurCharAttr.Attr2 & Attr2ColorMask, linelen);
-			memset(&(AttrBuffFG[DestPtr]), CurCharAttr.Fore, linelen);
-			memset(&(AttrBuffBG[DestPtr]), CurCharAttr.Back, linelen);
-			DestPtr = NextLinePtr(DestPtr);
+		if (!extl && !extr) {
+			RotateLines(PageStart+CursorTop, CursorBottom-CursorTop+1, n);
+			DamageScroll(CursorTop, CursorBottom, n);
+			EraseLines(PageStart+CursorBottom+1-n, n);
+		}
+		else {
+			linelen = CursorRightM - CursorLeftM + 1;
+			DestPtr = GetLinePtr(PageStart+CursorTop) + (LONG)CursorLeftM;
+			if (n<CursorBottom-CursorTop+1) {
+				SrcPtr = GetLinePtr(PageStart+CursorTop+n) + (LONG)CursorLeftM;
+				for (i = CursorTop+n ; i<=CursorBottom ; i++) {
+					MoveCells(DestPtr, SrcPtr, linelen);
+					MarkURLDirty(DestPtr);
+					SrcPtr = NextLinePtr(SrcPtr);
+					DestPtr = NextLinePtr(DestPtr);
+				}
+			}
+			for (i = CursorBottom+1-n ; i<=CursorBottom; i++) {
+				EraseCells(&CellBuff[DestPtr], linelen);
+				DestPtr = NextLinePtr(DestPtr);
+			}
 		}
 		if (CursorLeftM > 0 || CursorRightM < NumOfColumns-1)
-			BuffUpdateRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
+			DamageRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
 		else
 			DispScrollNLines(CursorTop, CursorBottom, n);
 	}
@@ -2387,34 +3465,34 @@ void BuffRegionScrollUpNLines(int n) {
 		if (extl || extr)
 			EraseKanjiOnLRMargin(GetLinePtr(PageStart+CursorTop), CursorBottom-CursorTop+1);
 
-		DestPtr = GetLinePtr(PageStart+CursorTop) + CursorLeftM;
-		linelen = CursorRightM - CursorLeftM + 1;
-		if (n < CursorBottom - CursorTop + 1) {
-			SrcPtr = GetLinePtr(PageStart+CursorTop+n) + CursorLeftM;
-			for (i = CursorTop+n ; i<=CursorBottom ; i++) {
-				memmove(&(CodeBuff[DestPtr]), &(CodeBuff[SrcPtr]), linelen);
-				memmove(&(AttrBuff[DestPtr]), &(AttrBuff[SrcPtr]), linelen);
-				memmove(&(AttrBuff2[DestPtr]), &(AttrBuff2[SrcPtr]), linelen);
-				memmove(&(AttrBuffFG[DestPtr]), &(AttrBuffFG[SrcPtr]), linelen);
-				memmove(&(AttrBuffBG[DestPtr]), &(AttrBuffBG[SrcPtr]), linelen);
-				SrcPtr = NextLinePtr(SrcPtr);
-				DestPtr = NextLinePtr(DestPtr);
-			}
-		}
-		else {
+		if (n > CursorBottom - CursorTop + 1) {
 			n = CursorBottom - CursorTop + 1;
 		}
-		for (i = CursorBottom+1-n ; i<=CursorBottom; i++) {
-			memset(&(CodeBuff[DestPtr]), 0x20, linelen);
-			memset(&(AttrBuff[DestPtr]), AttrDefault, linelen);
-			memset(&(AttrBuff2[DestPtr]), CurCharAttr.Attr2 & Attr2ColorMask, linelen);
-			memset(&(AttrBuffFG[DestPtr]), CurCharAttr.Fore, linelen);
-			memset(&(AttrBuffBG[DestPtr]), CurCharAttr.Back, linelen);
-			DestPtr = NextLinePtr(DestPtr);
+		if (!extl && !extr) {
+			RotateLines(PageStart+CursorTop, CursorBottom-CursorTop+1, n);
+			DamageScroll(CursorTop, CursorBottom, n);
+			EraseLines(PageStart+CursorBottom+1-n, n);
+		}
+		else {
+			DestPtr = GetLinePtr(PageStart+CursorTop) + CursorLeftM;
+			linelen = CursorRightM - CursorLeftM + 1;
+			if (n < CursorBottom - CursorTop + 1) {
+				SrcPtr = GetLinePtr(PageStart+CursorTop+n) + CursorLeftM;
+				for (i = CursorTop+n ; i<=CursorBottom ; i++) {
+					MoveCells(DestPtr, SrcPtr, linelen);
+					MarkURLDirty(DestPtr);
+					SrcPtr = NextLinePtr(SrcPtr);
+					DestPtr = NextLinePtr(DestPtr);
+				}
+			}
+			for (i = CursorBottom+1-n ; i<=CursorBottom; i++) {
+				EraseCells(&CellBuff[DestPtr], linelen);
+				DestPtr = NextLinePtr(DestPtr);
+			}
 		}
 
 		if (CursorLeftM > 0 || CursorRightM < NumOfColumns-1) {
-			BuffUpdateRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
+			DamageRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
 		}
 		else {
 			DispScrollNLines(CursorTop, CursorBottom, n);
@@ -2439,34 +3517,34 @@ void BuffRegionScrollDownNLines(int n) {
 	if (extl || extr)
 		EraseKanjiOnLRMargin(GetLinePtr(PageStart+CursorTop), CursorBottom-CursorTop+1);
 
-	DestPtr = GetLinePtr(PageStart+CursorBottom) + CursorLeftM;
-	linelen = CursorRightM - CursorLeftM + 1;
-	if (n < CursorBottom - CursorTop + 1) {
-		SrcPtr = GetLinePtr(PageStart+CursorBottom-n) + CursorLeftM;
-		for (i=CursorBottom-n ; i>=CursorTop ; i--) {
-			memmove(&(CodeBuff[DestPtr]), &(CodeBuff[SrcPtr]), linelen);
-			memmove(&(AttrBuff[DestPtr]), &(AttrBuff[SrcPtr]), linelen);
-			memmove(&(AttrBuff2[DestPtr]), &(AttrBuff2[SrcPtr]), linelen);
-			memmove(&(AttrBuffFG[DestPtr]), &(AttrBuffFG[SrcPtr]), linelen);
-			memmove(&(AttrBuffBG[DestPtr]), &(AttrBuffBG[SrcPtr]), linelen);
-			SrcPtr = PrevLinePtr(SrcPtr);
-			DestPtr = PrevLinePtr(DestPtr);
-		}
-	}
-	else {
+	if (n > CursorBottom - CursorTop + 1) {
 		n = CursorBottom - CursorTop + 1;
 	}
-	for (i = CursorTop+n-1; i>=CursorTop; i--) {
-		memset(&(CodeBuff[DestPtr]), 0x20, linelen);
-		memset(&(AttrBuff[DestPtr]), AttrDefault, linelen);
-		memset(&(AttrBuff2[DestPtr]), CurCharAttr.Attr2 & Attr2ColorMask, linelen);
-		memset(&(AttrBuffFG[DestPtr]), CurCharAttr.Fore, linelen);
-		memset(&(AttrBuffBG[DestPtr]), CurCharAttr.Back, linelen);
-		DestPtr = PrevLinePtr(DestPtr);
+	if (!extl && !extr) {
+		RotateLines(PageStart+CursorTop, CursorBottom-CursorTop+1, -n);
+		DamageScroll(CursorTop, CursorBottom, -n);
+		EraseLines(PageStart+CursorTop, n);
+	}
+	else {
+		DestPtr = GetLinePtr(PageStart+CursorBottom) + CursorLeftM;
+		linelen = CursorRightM - CursorLeftM + 1;
+		if (n < CursorBottom - CursorTop + 1) {
+			SrcPtr = GetLinePtr(PageStart+CursorBottom-n) + CursorLeftM;
+			for (i=CursorBottom-n ; i>=CursorTop ; i--) {
+				MoveCells(DestPtr, SrcPtr, linelen);
+				MarkURLDirty(DestPtr);
+				SrcPtr = PrevLinePtr(SrcPtr);
+				DestPtr = PrevLinePtr(DestPtr);
+			}
+		}
+		for (i = CursorTop+n-1; i>=CursorTop; i--) {
+			EraseCells(&CellBuff[DestPtr], linelen);
+			DestPtr = PrevLinePtr(DestPtr);
+		}
 	}
 
 	if (CursorLeftM > 0 || CursorRightM < NumOfColumns-1) {
-		BuffUpdateRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
+		DamageRect(CursorLeftM-extl, CursorTop, CursorRightM+extr, CursorBottom);
 	}
 	else {
 		DispScrollNLines(CursorTop, CursorBottom, -n);
@@ -2507,10 +3585,10 @@ void CursorUpWithScroll()
 //   check if a character is the word delimiter
 BOOL IsDelimiter(LONG Line, int CharPtr)
 {
-	if ((AttrBuff[Line+CharPtr] & AttrKanji) !=0) {
+	if ((CellBuff[Line+CharPtr].Attr & AttrKanji) !=0) {
 		return (ts.DelimDBCS!=0);
 	}
-	return (strchr(ts.DelimList,CodeBuff[Line+CharPtr])!=NULL);
+	return (strchr(ts.DelimList,CellBuff[Line+CharPtr].Code)!=NULL);
 }
 
 void GetMinMax(int i1, int i2, int i3,
@@ -2533,37 +3611,58 @@ void GetMinMax(int i1, int i2, int i3,
 }
 
 /* start - ishizaki */
-static void invokeBrowser(LONG ptr)
+static void invokeBrowser(int Line, int X)
 {
 #ifdef URL_EMPHASIS
-	LONG i, start, end;
+	LONG Ptr, PrevPtr;
+	int XStart, XEnd;
 	char url[1024], param[1024];
 	char *uptr, ch;
 
-	start = ptr;
-	while (AttrBuff[start] & AttrURL) {
-		start--;
-	}
-	start++;
-
-	end = ptr;
-	while (AttrBuff[end] & AttrURL) {
-		end++;
+	// s܂ URL ̐擪T
+	//   Oobt@ŗׂ荇s CellBuff łׂ荇Ƃ͌Ȃ̂ŁA
+	//   sPʂłǂ
+	Ptr = GetLinePtr(Line);
+	while (1) {
+		if (X > 0) {
+			if (! (CellBuff[Ptr+X-1].Attr & AttrURL)) {
+				break;
+			}
+			X--;
+		}
+		else {
+			if (Line == 0) {
+				break;
+			}
+			PrevPtr = PrevLinePtr(Ptr);
+			MarkURL(PrevPtr, &XStart, &XEnd);
+			if (! (CellBuff[PrevPtr+NumOfColumns-1].Attr & AttrURL)) {
+				break;
+			}
+			Line--;
+			Ptr = PrevPtr;
+			X = NumOfColumns - 1;
+		}
 	}
-	end--;
 
-	if (start + (LONG)sizeof(url) -1 <= end) {
-		end = start + sizeof(url) - 2;
-	}
 	uptr = url;
-	for (i = 0; i < end - start + 1; i++) {
-		ch = CodeBuff[start + i];
-		if ((start + i) % NumOfColumns == NumOfColumns - 1
-			&& ch == ts.JoinSplitURLIgnoreEOLChar) {
+	while (uptr < url + sizeof(url) - 1 && (CellBuff[Ptr+X].Attr & AttrURL)) {
+		ch = CellBuff[Ptr+X].Code;
+		if (X == NumOfColumns - 1 && ch == ts.JoinSplitURLIgnoreEOLChar) {
 			// ssp}[Np̏̕ꍇ̓XLbv
 		} else {
 			*uptr++ = ch;
 		}
+		X++;
+		if (X >= NumOfColumns) {
+			Line++;
+			if (Line >= BuffEnd) {
+				break;
+			}
+			Ptr = NextLinePtr(Ptr);
+			MarkURL(Ptr, &XStart, &XEnd);
+			X = 0;
+		}
 	}
 	*uptr = '\0';
 
@@ -2668,7 +3767,7 @@ void ChangeSelectRegion()
 
 BOOL BuffUrlDblClk(int Xw, int Yw)
 {
-	int X, Y;
+	int X, Y, XStart, XEnd;
 	LONG TmpPtr;
 	BOOL url_invoked = FALSE;
 
@@ -2691,14 +3790,15 @@ BOOL BuffUrlDblClk(int Xw, int Yw)
 	if ((Y>=0) && (Y<BuffEnd)) {
 		LockBuffer();
 		TmpPtr = GetLinePtr(Y);
+		MarkURL(TmpPtr, &XStart, &XEnd);
 		/* start - ishizaki */
-		if (AttrBuff[TmpPtr+X] & AttrURL) {
+		if (CellBuff[TmpPtr+X].Attr & AttrURL) {
 			BoxSelect = FALSE;
 			SelectEnd = SelectStart;
 			ChangeSelectRegion();
 
 			url_invoked = TRUE;
-			invokeBrowser(TmpPtr+X);
+			invokeBrowser(Y, X);
 
 			SelectStart.x = 0;
 			SelectStart.y = 0;
@@ -2748,16 +3848,16 @@ void BuffDblClk(int Xw, int Yw)
 		YStart = YEnd = Y;
 
 		if (IsDelimiter(TmpPtr,IStart)) {
-			b = CodeBuff[TmpPtr+IStart];
-			DBCS = (AttrBuff[TmpPtr+IStart] & AttrKanji) != 0;
-			while ((b==CodeBuff[TmpPtr+IStart]) ||
+			b = CellBuff[TmpPtr+IStart].Code;
+			DBCS = (CellBuff[TmpPtr+IStart].Attr & AttrKanji) != 0;
+			while ((b==CellBuff[TmpPtr+IStart].Code) ||
 			       DBCS &&
-			       ((AttrBuff[TmpPtr+IStart] & AttrKanji)!=0)) {
+			       ((CellBuff[TmpPtr+IStart].Attr & AttrKanji)!=0)) {
 				MoveCharPtr(TmpPtr,&IStart,-1); // move left
 				if (ts.EnableContinuedLineCopy) {
 					if (IStart<=0) {
 						// [̏ꍇ
-						if (YStart>0 && AttrBuff[TmpPtr] & AttrLineContinued) {
+						if (YStart>0 && CellBuff[TmpPtr].Attr & AttrLineContinued) {
 							// O̍sɈړ
 							YStart--;
 							TmpPtr = GetLinePtr(YStart);
@@ -2775,8 +3875,8 @@ void BuffDblClk(int Xw, int Yw)
 					}
 				}
 			}
-			if ((b!=CodeBuff[TmpPtr+IStart]) &&
-			    ! (DBCS && ((AttrBuff[TmpPtr+IStart] & AttrKanji)!=0))) {
+			if ((b!=CellBuff[TmpPtr+IStart].Code) &&
+			    ! (DBCS && ((CellBuff[TmpPtr+IStart].Attr & AttrKanji)!=0))) {
 				// ŏIʒu Delimiter łȂꍇɂ͂ЂƂEɂ炷
 				if (ts.EnableContinuedLineCopy && IStart == NumOfColumns-1) {
 					// E[̏ꍇɂ͎̍sֈړ
@@ -2792,15 +3892,15 @@ void BuffDblClk(int Xw, int Yw)
 			// sړĂ邩Ȃ̂ŁANbNs蒼
 			TmpPtr = GetLinePtr(YEnd);
 			i = 1;
-			while (((b==CodeBuff[TmpPtr+IEnd]) ||
+			while (((b==CellBuff[TmpPtr+IEnd].Code) ||
 			        DBCS &&
-			        ((AttrBuff[TmpPtr+IEnd] & AttrKanji)!=0))) {
+			        ((CellBuff[TmpPtr+IEnd].Attr & AttrKanji)!=0))) {
 				i = MoveCharPtr(TmpPtr,&IEnd,1); // move right
 				if (ts.EnableContinuedLineCopy) {
 					if (i==0) {
 						// E[̏ꍇ
 						if (YEnd<BuffEnd &&
-						    AttrBuff[TmpPtr+IEnd+1+DBCS] & AttrLineContinued) {
+						    CellBuff[TmpPtr+IEnd+1+DBCS].Attr & AttrLineContinued) {
 							// ̍sɈړ
 							YEnd++;
 							TmpPtr = GetLinePtr(YEnd);
@@ -2825,7 +3925,7 @@ void BuffDblClk(int Xw, int Yw)
 				if (ts.EnableContinuedLineCopy) {
 					if (IStart<=0) {
 						// [̏ꍇ
-						if (YStart>0 && AttrBuff[TmpPtr] & AttrLineContinued) {
+						if (YStart>0 && CellBuff[TmpPtr].Attr & AttrLineContinued) {
 							// O̍sɈړ
 							YStart--;
 							TmpPtr = GetLinePtr(YStart);
@@ -2864,7 +3964,7 @@ void BuffDblClk(int Xw, int Yw)
 				if (ts.EnableContinuedLineCopy) {
 					if (i==0) {
 						// E[̏ꍇ
-						if (YEnd<BuffEnd && AttrBuff[TmpPtr+IEnd+1] & AttrLineContinued) {
+						if (YEnd<BuffEnd && CellBuff[TmpPtr+IEnd+1].Attr & AttrLineContinued) {
 							// ̍sɈړ
 							YEnd++;
 							TmpPtr = GetLinePtr(YEnd);
@@ -3015,8 +4115,8 @@ void BuffStartSelect(int Xw, int Yw, BOOL Box)
 	TmpPtr = GetLinePtr(SelectStart.y);
 	// check if the cursor is on the right half of a character
 	if ((SelectStart.x>0) &&
-	    ((AttrBuff[TmpPtr+SelectStart.x-1] & AttrKanji) != 0) ||
-	    ((AttrBuff[TmpPtr+SelectStart.x] & AttrKanji) == 0) &&
+	    ((CellBuff[TmpPtr+SelectStart.x-1].Attr & AttrKanji) != 0) ||
+	    ((CellBuff[TmpPtr+SelectStart.x].Attr & AttrKanji) == 0) &&
 	     Right) {
 		SelectStart.x++;
 	}
@@ -3057,9 +4157,9 @@ void BuffChangeSelect(int Xw, int Yw, int NClick)
 	LockBuffer();
 	// check if the cursor is on the right half of a character
 	if ((X>0) &&
-	    ((AttrBuff[TmpPtr+X-1] & AttrKanji) != 0) ||
+	    ((CellBuff[TmpPtr+X-1].Attr & AttrKanji) != 0) ||
 	    (X<NumOfColumns) &&
-	    ((AttrBuff[TmpPtr+X] & AttrKanji) == 0) &&
+	    ((CellBuff[TmpPtr+X].Attr & AttrKanji) == 0) &&
 	    Right) {
 		X++;
 	}
@@ -3070,8 +4170,8 @@ void BuffChangeSelect(int Xw, int Yw, int NClick)
 
 #if 0
 	/* start - ishizaki */
-	if (ts.EnableClickableUrl && (NClick == 2) && (AttrBuff[TmpPtr+X] & AttrURL)) {
-		invokeBrowser(TmpPtr+X);
+	if (ts.EnableClickableUrl && (NClick == 2) && (CellBuff[TmpPtr+X].Attr & AttrURL)) {
+		invokeBrowser(Y, X);
 
 		SelectStart.x = 0;
 		SelectStart.y = 0;
@@ -3106,12 +4206,12 @@ void BuffChangeSelect(int Xw, int Yw, int NClick)
 
 			i = 1;
 			if (IsDelimiter(TmpPtr,X)) {
-				b = CodeBuff[TmpPtr+X];
-				DBCS = (AttrBuff[TmpPtr+X] & AttrKanji) != 0;
+				b = CellBuff[TmpPtr+X].Code;
+				DBCS = (CellBuff[TmpPtr+X].Attr & AttrKanji) != 0;
 				while ((i!=0) &&
-				       ((b==CodeBuff[TmpPtr+SelectEnd.x]) ||
+				       ((b==CellBuff[TmpPtr+SelectEnd.x].Code) ||
 				        DBCS &&
-				        ((AttrBuff[TmpPtr+SelectEnd.x] & AttrKanji)!=0))) {
+				        ((CellBuff[TmpPtr+SelectEnd.x].Attr & AttrKanji)!=0))) {
 					i = MoveCharPtr(TmpPtr,(int *)&SelectEnd.x,1); // move right
 				}
 			}
@@ -3134,17 +4234,17 @@ void BuffChangeSelect(int Xw, int Yw, int NClick)
 				SelectEnd.y = Y;
 			}
 			if (IsDelimiter(TmpPtr,SelectEnd.x)) {
-				b = CodeBuff[TmpPtr+SelectEnd.x];
-				DBCS = (AttrBuff[TmpPtr+SelectEnd.x] & AttrKanji) != 0;
+				b = CellBuff[TmpPtr+SelectEnd.x].Code;
+				DBCS = (CellBuff[TmpPtr+SelectEnd.x].Attr & AttrKanji) != 0;
 				while ((SelectEnd.x>0) &&
-				       ((b==CodeBuff[TmpPtr+SelectEnd.x]) ||
+				       ((b==CellBuff[TmpPtr+SelectEnd.x].Code) ||
 				       DBCS &&
-				       ((AttrBuff[TmpPtr+SelectEnd.x] & AttrKanji)!=0))) {
+				       ((CellBuff[TmpPtr+SelectEnd.x].Attr & AttrKanji)!=0))) {
 					MoveCharPtr(TmpPtr,(int *)&SelectEnd.x,-1); // move left
 				}
-				if ((b!=CodeBuff[TmpPtr+SelectEnd.x]) &&
+				if ((b!=CellBuff[TmpPtr+SelectEnd.x].Code) &&
 				    ! (DBCS &&
-				    ((AttrBuff[TmpPtr+SelectEnd.x] & AttrKanji)!=0))) {
+				    ((CellBuff[TmpPtr+SelectEnd.x].Attr & AttrKanji)!=0))) {
 					MoveCharPtr(TmpPtr,(int *)&SelectEnd.x,1);
 				}
 			}
@@ -3312,9 +4412,9 @@ void BuffChangeTerminalSize(int Nx, int Ny)
 		if ((ts.TermFlag & TF_CLEARONRESIZE) == 0 && Ny != NumOfLines) {
 			if (Ny > NumOfLines) {
 				CursorY += Ny - NumOfLines;
-				if (Ny > BuffEnd) {
-					CursorY -= Ny - BuffEnd;
-					BuffEnd = Ny;
+				if (Ny > BuffEnd - ColdLines) {
+					CursorY -= Ny - (BuffEnd - ColdLines);
+					BuffEnd = ColdLines + Ny;
 				}
 			}
 			else {
@@ -3334,6 +4434,7 @@ void BuffChangeTerminalSize(int Nx, int Ny)
 		ts.TerminalHeight = Ny-StatusLine;
 
 		PageStart = BuffEnd - NumOfLines;
+		SearchRollback(PageStart);
 	}
 
 	if (ts.TermFlag & TF_CLEARONRESIZE) {
@@ -3455,6 +4556,8 @@ void ChangeWin()
 void ClearBuffer()
 {
 	/* Reset buffer */
+	ColdFree();
+	SearchReset();
 	PageStart = 0;
 	BuffStartAbs = 0;
 	BuffEnd = NumOfLines;
@@ -3472,11 +4575,7 @@ void ClearBuffer()
 	Selected = FALSE;
 
 	NewLine(0);
-	memset(&CodeBuff[0],0x20,BufferSize);
-	memset(&AttrBuff[0],AttrDefault,BufferSize);
-	memset(&AttrBuff2[0],CurCharAttr.Attr2 & Attr2ColorMask, BufferSize);
-	memset(&AttrBuffFG[0],CurCharAttr.Fore,BufferSize);
-	memset(&AttrBuffBG[0],CurCharAttr.Back,BufferSize);
+	EraseCells(&CellBuff[0], BufferSize);
 
 	/* Home position */
 	CursorX = 0;
@@ -3682,9 +4781,9 @@ void BuffLineContinued(BOOL mode)
 {
 	if (ts.EnableContinuedLineCopy) {
 		if (mode) {
-			AttrLine[0] |= AttrLineContinued;
+			CellLine[0].Attr |= AttrLineContinued;
 		} else {
-			AttrLine[0] &= ~AttrLineContinued;
+			CellLine[0].Attr &= ~AttrLineContinued;
 		}
 	}
 }
@@ -3694,22 +4793,20 @@ void BuffSetCurCharAttr(TCharAttr Attr) {
 	DispSetCurCharAttr(Attr);
 }
 
+// SaveBuff ɂ͉ʂ̕ʒu (DWORD)AZ̏ɒu
 void BuffSaveScreen()
 {
-	PCHAR CodeDest, AttrDest, AttrDest2, AttrDestFG, AttrDestBG;
+	PCell CellDest;
+	LPDWORD UniDest;
 	LONG ScrSize;
 	LONG SrcPtr, DestPtr;
 	int i;
 
 	if (SaveBuff == NULL) {
 		ScrSize = NumOfColumns * NumOfLines;
-		if ((SaveBuff=GlobalAlloc(GMEM_MOVEABLE, ScrSize * 5)) != NULL) {
-			if ((CodeDest=GlobalLock(SaveBuff)) != NULL) {
-				AttrDest = CodeDest + ScrSize;
-				AttrDest2 = AttrDest + ScrSize;
-				AttrDestFG = AttrDest2 + ScrSize;
-				AttrDestBG = AttrDestFG + ScrSize;
-
+		if ((SaveBuff=GlobalAlloc(GMEM_MOVEABLE, ScrSize * (sizeof(DWORD) + sizeof(TCell)))) != NULL) {
+			if ((UniDest=GlobalLock(SaveBuff)) != NULL) {
+				CellDest = (PCell)&UniDest[ScrSize];
 				SaveBuffX = NumOfColumns;
 				SaveBuffY = NumOfLines;
 
@@ -3717,11 +4814,8 @@ void BuffSaveScreen()
 				DestPtr = 0;
 
 				for (i=0; i<NumOfLines; i++) {
-					memcpy(&CodeDest[DestPtr], &CodeBuff[SrcPtr], NumOfColumns);
-					memcpy(&AttrDest[DestPtr], &AttrBuff[SrcPtr], NumOfColumns);
-					memcpy(&AttrDest2[DestPtr], &AttrBuff2[SrcPtr], NumOfColumns);
-					memcpy(&AttrDestFG[DestPtr], &AttrBuffFG[SrcPtr], NumOfColumns);
-					memcpy(&AttrDestBG[DestPtr], &AttrBuffBG[SrcPtr], NumOfColumns);
+					memcpy(&CellDest[DestPtr], &CellBuff[SrcPtr], sizeof(TCell)*NumOfColumns);
+					GetLineUni(SrcPtr, &UniDest[DestPtr], NumOfColumns);
 					SrcPtr = NextLinePtr(SrcPtr);
 					DestPtr += NumOfColumns;
 				}
@@ -3737,20 +4831,14 @@ void BuffSaveScreen()
 
 void BuffRestoreScreen()
 {
-	PCHAR CodeSrc, AttrSrc, AttrSrc2, AttrSrcFG, AttrSrcBG;
-	LONG ScrSize;
+	PCell CellSrc;
+	LPDWORD UniSrc;
 	LONG SrcPtr, DestPtr;
 	int i, CopyX, CopyY;
 
 	if (SaveBuff != NULL) {
-		if ((CodeSrc=GlobalLock(SaveBuff)) != NULL) {
-			ScrSize = SaveBuffX * SaveBuffY;
-
-			AttrSrc = CodeSrc + ScrSize;
-			AttrSrc2 = AttrSrc + ScrSize;
-			AttrSrcFG = AttrSrc2 + ScrSize;
-			AttrSrcBG = AttrSrcFG + ScrSize;
-
+		if ((UniSrc=GlobalLock(SaveBuff)) != NULL) {
+			CellSrc = (PCell)&UniSrc[(LONG)SaveBuffX * SaveBuffY];
 			CopyX = (SaveBuffX > NumOfColumns) ? NumOfColumns : SaveBuffX;
 			CopyY = (SaveBuffY > NumOfLines) ? NumOfLines : SaveBuffY;
 
@@ -3758,19 +4846,17 @@ void BuffRestoreScreen()
 			DestPtr = GetLinePtr(PageStart);
 
 			for (i=0; i<CopyY; i++) {
-				memcpy(&CodeBuff[DestPtr], &CodeSrc[SrcPtr], CopyX);
-				memcpy(&AttrBuff[DestPtr], &AttrSrc[SrcPtr], CopyX);
-				memcpy(&AttrBuff2[DestPtr], &AttrSrc2[SrcPtr], CopyX);
-				memcpy(&AttrBuffFG[DestPtr], &AttrSrcFG[SrcPtr], CopyX);
-				memcpy(&AttrBuffBG[DestPtr], &AttrSrcBG[SrcPtr], CopyX);
-				if (AttrBuff[DestPtr+CopyX-1] & AttrKanji) {
-					CodeBuff[DestPtr+CopyX-1] = ' ';
-					AttrBuff[DestPtr+CopyX-1] ^= AttrKanji;
+				memcpy(&CellBuff[DestPtr], &CellSrc[SrcPtr], sizeof(TCell)*CopyX);
+				PutLineUni(DestPtr, &UniSrc[SrcPtr], CopyX);
+				MarkURLDirty(DestPtr);
+				if (CellBuff[DestPtr+CopyX-1].Attr & AttrKanji) {
+					SetCellCode(CellBuff[DestPtr+CopyX-1], ' ');
+					CellBuff[DestPtr+CopyX-1].Attr ^= AttrKanji;
 				}
 				SrcPtr += SaveBuffX;
 				DestPtr = NextLinePtr(DestPtr);
 			}
-			BuffUpdateRect(WinOrgX,WinOrgY,WinOrgX+WinWidth-1,WinOrgY+WinHeight-1);
+			DamageRect(WinOrgX,WinOrgY,WinOrgX+WinWidth-1,WinOrgY+WinHeight-1);
 		}
 
 		GlobalFree(SaveBuff);
@@ -3795,7 +4881,7 @@ void BuffSelectedEraseCurToEnd()
 
 	NewLine(PageStart+CursorY);
 	if (ts.Language==IdJapanese || ts.Language==IdKorean || ts.Language==IdUtf8) {
-		if (!(AttrLine2[CursorX] & Attr2Protect)) {
+		if (!(CellLine[CursorX].Attr2 & Attr2Protect)) {
 			EraseKanji(1); /* if cursor is on right half of a kanji, erase the kanji */
 		}
 	}
@@ -3807,16 +4893,16 @@ void BuffSelectedEraseCurToEnd()
 	}
 	for (i = CursorY ; i <= YEnd ; i++) {
 		for (j = TmpPtr + offset; j < TmpPtr + NumOfColumns - offset; j++) {
-			if (!(AttrBuff2[j] & Attr2Protect)) {
-				CodeBuff[j] = 0x20;
-				AttrBuff[j] &= AttrSgrMask;
+			if (!(CellBuff[j].Attr2 & Attr2Protect)) {
+				SetCellCode(CellBuff[j], 0x20);
+				CellBuff[j].Attr &= AttrSgrMask;
 			}
 		}
 		offset = 0;
 		TmpPtr = NextLinePtr(TmpPtr);
 	}
 	/* update window */
-	BuffUpdateRect(0, CursorY, NumOfColumns, YEnd);
+	DamageRect(0, CursorY, NumOfColumns, YEnd);
 }
 
 void BuffSelectedEraseHomeToCur()
@@ -3828,7 +4914,7 @@ void BuffSelectedEraseHomeToCur()
 
 	NewLine(PageStart+CursorY);
 	if (ts.Language==IdJapanese || ts.Language==IdKorean || ts.Language==IdUtf8) {
-		if (!(AttrLine2[CursorX] & Attr2Protect)) {
+		if (!(CellLine[CursorX].Attr2 & Attr2Protect)) {
 			EraseKanji(0); /* if cursor is on left half of a kanji, erase the kanji */
 		}
 	}
@@ -3845,16 +4931,16 @@ void BuffSelectedEraseHomeToCur()
 			offset = CursorX+1;
 		}
 		for (j = TmpPtr; j < TmpPtr + offset; j++) {
-			if (!(AttrBuff2[j] & Attr2Protect)) {
-				CodeBuff[j] = 0x20;
-				AttrBuff[j] &= AttrSgrMask;
+			if (!(CellBuff[j].Attr2 & Attr2Protect)) {
+				SetCellCode(CellBuff[j], 0x20);
+				CellBuff[j].Attr &= AttrSgrMask;
 			}
 		}
 		TmpPtr = NextLinePtr(TmpPtr);
 	}
 
 	/* update window */
-	BuffUpdateRect(0, YHome, NumOfColumns, CursorY);
+	DamageRect(0, YHome, NumOfColumns, CursorY);
 }
 
 void BuffSelectedEraseScreen() {
@@ -3884,26 +4970,26 @@ void BuffSelectiveEraseBox
 	Ptr = GetLinePtr(PageStart+YStart);
 	for (i=YStart; i<=YEnd; i++) {
 		if ((XStart>0) &&
-		    ((AttrBuff[Ptr+XStart-1] & AttrKanji) != 0) &&
-		    ((AttrBuff2[Ptr+XStart-1] & Attr2Protect) == 0)) {
-			CodeBuff[Ptr+XStart-1] = 0x20;
-			AttrBuff[Ptr+XStart-1] &= AttrSgrMask;
+		    ((CellBuff[Ptr+XStart-1].Attr & AttrKanji) != 0) &&
+		    ((CellBuff[Ptr+XStart-1].Attr2 & Attr2Protect) == 0)) {
+			SetCellCode(CellBuff[Ptr+XStart-1], 0x20);
+			CellBuff[Ptr+XStart-1].Attr &= AttrSgrMask;
 		}
 		if ((XStart+C<NumOfColumns) &&
-		    ((AttrBuff[Ptr+XStart+C-1] & AttrKanji) != 0) &&
-		    ((AttrBuff2[Ptr+XStart+C-1] & Attr2Protect) == 0)) {
-			CodeBuff[Ptr+XStart+C] = 0x20;
-			AttrBuff[Ptr+XStart+C] &= AttrSgrMask;
+		    ((CellBuff[Ptr+XStart+C-1].Attr & AttrKanji) != 0) &&
+		    ((CellBuff[Ptr+XStart+C-1].Attr2 & Attr2Protect) == 0)) {
+			SetCellCode(CellBuff[Ptr+XStart+C], 0x20);
+			CellBuff[Ptr+XStart+C].Attr &= AttrSgrMask;
 		}
 		for (j=Ptr+XStart; j<Ptr+XStart+C; j++) {
-			if (!(AttrBuff2[j] & Attr2Protect)) {
-				CodeBuff[j] = 0x20;
-				AttrBuff[j] &= AttrSgrMask;
+			if (!(CellBuff[j].Attr2 & Attr2Protect)) {
+				SetCellCode(CellBuff[j], 0x20);
+				CellBuff[j].Attr &= AttrSgrMask;
 			}
 		}
 		Ptr = NextLinePtr(Ptr);
 	}
-	BuffUpdateRect(XStart,YStart,XEnd,YEnd);
+	DamageRect(XStart,YStart,XEnd,YEnd);
 }
 
 void BuffSelectedEraseCharsInLine(int XStart, int Count)
@@ -3914,21 +5000,21 @@ void BuffSelectedEraseCharsInLine(int XStart, int Count)
 	int i;
 	BOOL LineContinued=FALSE;
 
-	if (ts.EnableContinuedLineCopy && XStart == 0 && (AttrLine[0] & AttrLineContinued)) {
+	if (ts.EnableContinuedLineCopy && XStart == 0 && (CellLine[0].Attr & AttrLineContinued)) {
 		LineContinued = TRUE;
 	}
 
 	if (ts.Language==IdJapanese || ts.Language==IdKorean || ts.Language==IdUtf8) {
-		if (!(AttrLine2[CursorX] & Attr2Protect)) {
+		if (!(CellLine[CursorX].Attr2 & Attr2Protect)) {
 			EraseKanji(1); /* if cursor is on right half of a kanji, erase the kanji */
 		}
 	}
 
 	NewLine(PageStart+CursorY);
 	for (i=XStart; i < XStart + Count; i++) {
-		if (!(AttrLine2[i] & Attr2Protect)) {
-			CodeLine[i] = 0x20;
-			AttrLine[i] &= AttrSgrMask;
+		if (!(CellLine[i].Attr2 & Attr2Protect)) {
+			SetCellCode(CellLine[i], 0x20);
+			CellLine[i].Attr &= AttrSgrMask;
 		}
 	}
 
@@ -3938,11 +5024,11 @@ void BuffSelectedEraseCharsInLine(int XStart, int Count)
 		}
 
 		if (XStart + Count >= NumOfColumns) {
-			AttrBuff[NextLinePtr(LinePtr)] &= ~AttrLineContinued;
+			CellBuff[NextLinePtr(LinePtr)].Attr &= ~AttrLineContinued;
 		}
 	}
 
-	BuffUpdateRect(XStart, CursorY, XStart+Count, CursorY);
+	DamageRect(XStart, CursorY, XStart+Count, CursorY);
 }
 
 void BuffScrollLeft(int count)
@@ -3957,39 +5043,32 @@ void BuffScrollLeft(int count)
 	for (i = CursorTop; i <= CursorBottom; i++) {
 		Ptr = LPtr + CursorLeftM;
 
-		if (AttrBuff[LPtr+CursorRightM] & AttrKanji) {
-			CodeBuff[LPtr+CursorRightM] = 0x20;
-			AttrBuff[LPtr+CursorRightM] &= ~AttrKanji;
+		if (CellBuff[LPtr+CursorRightM].Attr & AttrKanji) {
+			SetCellCode(CellBuff[LPtr+CursorRightM], 0x20);
+			CellBuff[LPtr+CursorRightM].Attr &= ~AttrKanji;
 			if (CursorRightM < NumOfColumns-1) {
-				CodeBuff[LPtr+CursorRightM+1] = 0x20;
+				SetCellCode(CellBuff[LPtr+CursorRightM+1], 0x20);
 			}
 		}
 
-		if (AttrBuff[Ptr+count-1] & AttrKanji) {
-			CodeBuff[Ptr+count] = 0x20;
+		if (CellBuff[Ptr+count-1].Attr & AttrKanji) {
+			SetCellCode(CellBuff[Ptr+count], 0x20);
 		}
 
-		if (CursorLeftM > 0 && AttrBuff[Ptr-1] & AttrKanji) {
-			CodeBuff[Ptr-1] = 0x20;
-			AttrBuff[Ptr-1] &= ~AttrKanji;
+		if (CursorLeftM > 0 && CellBuff[Ptr-1].Attr & AttrKanji) {
+			SetCellCode(CellBuff[Ptr-1], 0x20);
+			CellBuff[Ptr-1].Attr &= ~AttrKanji;
 		}
 
-		memmove(&(CodeBuff[Ptr]),   &(CodeBuff[Ptr+count]),   MoveLen);
-		memmove(&(AttrBuff[Ptr]),   &(AttrBuff[Ptr+count]),   MoveLen);
-		memmove(&(AttrBuff2[Ptr]),  &(AttrBuff2[Ptr+count]),  MoveLen);
-		memmove(&(AttrBuffFG[Ptr]), &(AttrBuffFG[Ptr+count]), MoveLen);
-		memmove(&(AttrBuffBG[Ptr]), &(AttrBuffBG[Ptr+count]), MoveLen);
+		MoveCells(Ptr, Ptr+count, MoveLen);
+		MarkURLDirty(Ptr);
 
-		memset(&(CodeBuff[Ptr+MoveLen]),   0x20,             count);
-		memset(&(AttrBuff[Ptr+MoveLen]),   AttrDefault,      count);
-		memset(&(AttrBuff2[Ptr+MoveLen]),  CurCharAttr.Attr2 & Attr2ColorMask, count);
-		memset(&(AttrBuffFG[Ptr+MoveLen]), CurCharAttr.Fore, count);
-		memset(&(AttrBuffBG[Ptr+MoveLen]), CurCharAttr.Back, count);
+		EraseCells(&CellBuff[Ptr+MoveLen], count);
 
 		LPtr = NextLinePtr(LPtr);
 	}
 
-	BuffUpdateRect(CursorLeftM-(CursorLeftM>0), CursorTop, CursorRightM+(CursorRightM<NumOfColumns-1), CursorBottom);
+	DamageRect(CursorLeftM-(CursorLeftM>0), CursorTop, CursorRightM+(CursorRightM<NumOfColumns-1), CursorBottom);
 }
 
 void BuffScrollRight(int count)
@@ -4004,37 +5083,30 @@ void BuffScrollRight(int count)
 	for (i = CursorTop; i <= CursorBottom; i++) {
 		Ptr = LPtr + CursorLeftM;
 
-		if (CursorRightM < NumOfColumns-1 && AttrBuff[LPtr+CursorRightM] & AttrKanji) {
-			CodeBuff[LPtr+CursorRightM+1] = 0x20;
+		if (CursorRightM < NumOfColumns-1 && CellBuff[LPtr+CursorRightM].Attr & AttrKanji) {
+			SetCellCode(CellBuff[LPtr+CursorRightM+1], 0x20);
 		}
 
-		if (CursorLeftM > 0 && AttrBuff[Ptr-1] & AttrKanji) {
-			CodeBuff[Ptr-1] = 0x20;
-			AttrBuff[Ptr-1] &= ~AttrKanji;
-			CodeBuff[Ptr] = 0x20;
+		if (CursorLeftM > 0 && CellBuff[Ptr-1].Attr & AttrKanji) {
+			SetCellCode(CellBuff[Ptr-1], 0x20);
+			CellBuff[Ptr-1].Attr &= ~AttrKanji;
+			SetCellCode(CellBuff[Ptr], 0x20);
 		}
 
-		memmove(&(CodeBuff[Ptr+count]),   &(CodeBuff[Ptr]),   MoveLen);
-		memmove(&(AttrBuff[Ptr+count]),   &(AttrBuff[Ptr]),   MoveLen);
-		memmove(&(AttrBuff2[Ptr+count]),  &(AttrBuff2[Ptr]),  MoveLen);
-		memmove(&(AttrBuffFG[Ptr+count]), &(AttrBuffFG[Ptr]), MoveLen);
-		memmove(&(AttrBuffBG[Ptr+count]), &(AttrBuffBG[Ptr]), MoveLen);
+		MoveCells(Ptr+count, Ptr, MoveLen);
+		MarkURLDirty(Ptr);
 
-		memset(&(CodeBuff[Ptr]),   0x20,             count);
-		memset(&(AttrBuff[Ptr]),   AttrDefault,      count);
-		memset(&(AttrBuff2[Ptr]),  CurCharAttr.Attr2 & Attr2ColorMask, count);
-		memset(&(AttrBuffFG[Ptr]), CurCharAttr.Fore, count);
-		memset(&(AttrBuffBG[Ptr]), CurCharAttr.Back, count);
+		EraseCells(&CellBuff[Ptr], count);
 
-		if (AttrBuff[LPtr+CursorRightM] & AttrKanji) {
-			CodeBuff[LPtr+CursorRightM] = 0x20;
-			AttrBuff[LPtr+CursorRightM] &= ~AttrKanji;
+		if (CellBuff[LPtr+CursorRightM].Attr & AttrKanji) {
+			SetCellCode(CellBuff[LPtr+CursorRightM], 0x20);
+			CellBuff[LPtr+CursorRightM].Attr &= ~AttrKanji;
 		}
 
 		LPtr = NextLinePtr(LPtr);
 	}
 
-	BuffUpdateRect(CursorLeftM-(CursorLeftM>0), CursorTop, CursorRightM+(CursorRightM<NumOfColumns-1), CursorBottom);
+	DamageRect(CursorLeftM-(CursorLeftM>0), CursorTop, CursorRightM+(CursorRightM<NumOfColumns-1), CursorBottom);
 }
 
 // ݍs܂邲ƃobt@Ɋi[BԂl݂͌̃J[\ʒu(X)B
@@ -4044,7 +5116,7 @@ int BuffGetCurrentLineData(char *buf, int bufsize)
 
 	Ptr = GetLinePtr(PageStart + CursorY);
 	memset(buf, 0, bufsize);
-	memcpy(buf, &CodeBuff[Ptr], min(NumOfColumns, bufsize - 1));
+	CopyCellCodes(buf, &CellBuff[Ptr], min(NumOfColumns, bufsize - 1));
 	return (CursorX);
 }
 
@@ -4060,7 +5132,7 @@ int BuffGetAnyLineData(int offset_y, char *buf, int bufsize)
 	Ptr = GetLinePtr(offset_y);
 	memset(buf, 0, bufsize);
 	copysize = min(NumOfColumns, bufsize - 1);
-	memcpy(buf, &CodeBuff[Ptr], copysize);
+	CopyCellCodes(buf, &CellBuff[Ptr], copysize);
 
 	return (copysize);
 }
@@ -4068,7 +5140,7 @@ int BuffGetAnyLineData(int offset_y, char *buf, int bufsize)
 
 BOOL BuffCheckMouseOnURL(int Xw, int Yw)
 {
-	int X, Y;
+	int X, Y, XStart, XEnd;
 	LONG TmpPtr;
 	BOOL Result, Right;
 
@@ -4086,8 +5158,9 @@ BOOL BuffCheckMouseOnURL(int Xw, int Yw)
 
 	TmpPtr = GetLinePtr(Y);
 	LockBuffer();
+	MarkURL(TmpPtr, &XStart, &XEnd);
 
-	if (AttrBuff[TmpPtr+X] & AttrURL)
+	if (CellBuff[TmpPtr+X].Attr & AttrURL)
 		Result = TRUE;
 	else
 		Result = FALSE;
@@ -4096,3 +5169,534 @@ BOOL BuffCheckMouseOnURL(int Xw, int Yw)
 
 	return Result;
 }
+
+/*
+ * XN[obt@̌
+ *
+ *   SearchBlockLines sƂɁA܂܂镶 3 g (trigram) ̃nbV
+ *   rbg}bvɋL^ĂA trigram  1 ł܂܂Ȃ
+ *   ubN͍sɓǂݔ΂B
+ *   ɍڂ̂̓XN[AEgs (PageStart O) ŁA
+ *   kXN[obt@Ɉڂs͂̏ŁAȊO͌ɒǉB
+ *   ÂŝĂꂽƂ͍sԍ炵AsvɂȂubNB
+ */
+#define SearchBlockLines 1024
+#define SearchBitsSize 8192  // 1 ubÑrbg}bṽoCg (2^16 rbg)
+#define SearchHashMax 64     // Ɏg trigram ̍ő吔
+
+static LPBYTE *SearchBits = NULL;
+static int NumOfSearchBlocks = 0;
+static int SearchBlocksAlloc = 0;
+static int SearchTop = 0;      // SearchBits[0] ̐擪ɂsԍ (̂Ƃ)
+static int SearchIndexed = 0;  // ̍sO͍ɓo^ς
+
+#define SearchFold(c) (((c) >= 'A' && (c) <= 'Z') ? (c) + 0x20 : (c))
+
+static WORD SearchTrigram(BYTE a, BYTE b, BYTE c)
+{
+	DWORD h;
+
+	h = ((DWORD)SearchFold(a) << 16) | ((DWORD)SearchFold(b) << 8) | SearchFold(c);
+	h *= 2654435761UL;
+	return (WORD)(h >> 16);
+}
+
+// ׂĎ̂Ă
+static void SearchReset()
+{
+	int i;
+
+	for (i=0; i<NumOfSearchBlocks; i++) {
+		free(SearchBits[i]);
+	}
+	free(SearchBits);
+	SearchBits = NULL;
+	NumOfSearchBlocks = 0;
+	SearchBlocksAlloc = 0;
+	SearchTop = 0;
+	SearchIndexed = 0;
+}
+
+// Line sڈȍ~̍̂Ă (s̓eꍇ)
+static void SearchRollback(int Line)
+{
+	int b;
+
+	if (SearchIndexed <= Line) {
+		return;
+	}
+	b = (Line - SearchTop) / SearchBlockLines;
+	if (b < 0) {
+		b = 0;
+	}
+	while (NumOfSearchBlocks > b) {
+		NumOfSearchBlocks--;
+		free(SearchBits[NumOfSearchBlocks]);
+	}
+	SearchIndexed = SearchTop + b * SearchBlockLines;
+	if (SearchIndexed < 0) {
+		SearchIndexed = 0;
+	}
+}
+
+// 擪 Count ŝĂꂽ̂ŁAsԍ炷
+static void SearchDropLines(int Count)
+{
+	int n;
+
+	if (Count <= 0 || NumOfSearchBlocks == 0) {
+		return;
+	}
+	SearchTop -= Count;
+	SearchIndexed -= Count;
+	if (SearchIndexed <= 0) {
+		SearchReset();
+		return;
+	}
+	n = 0;
+	while (SearchTop + (n + 1) * SearchBlockLines <= 0) {
+		free(SearchBits[n]);
+		n++;
+	}
+	if (n > 0) {
+		NumOfSearchBlocks -= n;
+		memmove(&SearchBits[0], &SearchBits[n], sizeof(LPBYTE) * NumOfSearchBlocks);
+		SearchTop += n * SearchBlockLines;
+	}
+}
+
+// Line s (e Src) ɉ
+//   ͐擪珇ɍ̂ŁAɓo^ׂsȊO͖
+static void SearchAddLine(int Line, PCell Src)
+{
+	LPBYTE Bits, *NewBits;
+	int b, x;
+	WORD h;
+
+	if (Line != SearchIndexed) {
+		return;
+	}
+	b = (Line - SearchTop) / SearchBlockLines;
+	if (b >= NumOfSearchBlocks) {
+		if (NumOfSearchBlocks >= SearchBlocksAlloc) {
+			NewBits = realloc(SearchBits, sizeof(LPBYTE) * (SearchBlocksAlloc + 16));
+			if (NewBits == NULL) {
+				return;
+			}
+			SearchBits = NewBits;
+			SearchBlocksAlloc += 16;
+		}
+		if ((SearchBits[NumOfSearchBlocks] = calloc(1, SearchBitsSize)) == NULL) {
+			return;
+		}
+		NumOfSearchBlocks++;
+	}
+	Bits = SearchBits[b];
+
+	for (x=0; x+2<NumOfColumns; x++) {
+		if (Src[x].Code == ' ' && Src[x+1].Code == ' ' && Src[x+2].Code == ' ') {
+			continue;
+		}
+		h = SearchTrigram(Src[x].Code, Src[x+1].Code, Src[x+2].Code);
+		Bits[h >> 3] |= 1 << (h & 7);
+	}
+	SearchIndexed++;
+}
+
+// XN[AEgŝAo^̂̂ɉ
+static void SearchUpdateIndex()
+{
+	LONG Ptr;
+	int Line;
+
+	SearchRollback(PageStart);
+	if (SearchIndexed >= PageStart) {
+		return;
+	}
+	Ptr = GetLinePtr(SearchIndexed);
+	for (Line = SearchIndexed; Line < PageStart; Line++) {
+		SearchAddLine(Line, &CellBuff[Ptr]);
+		if (SearchIndexed == Line) {
+			break;  // s
+		}
+		Ptr = NextLinePtr(Ptr);
+	}
+}
+
+// Str[0..Len)  trigram  Hash ɉ
+static int SearchAddTrigrams(PCHAR Str, int Len, WORD *Hash, int Count)
+{
+	int i;
+
+	for (i=0; i+2<Len && Count<SearchHashMax; i++) {
+		if (Str[i] == ' ' && Str[i+1] == ' ' && Str[i+2] == ' ') {
+			continue;
+		}
+		Hash[Count++] = SearchTrigram(Str[i], Str[i+1], Str[i+2]);
+	}
+	return Count;
+}
+
+static BOOL SearchIsLead(BYTE c)
+{
+	return ts.Language == IdJapanese && IsDBCSLeadByte(c);
+}
+
+// K\Ƀ}b`镶񂪕K܂ޕoA trigram  Hash ɓ
+//   ʂ̒ENXEʎwqŏȗł镶͎gȂB
+//   I (|) Ƃ͉oȂB
+static int SearchRegexTrigrams(PCHAR Re, BOOL IgnoreCase, WORD *Hash)
+{
+	char Run[256];
+	int Len = 0, Last = 0, Depth = 0, Count = 0, i = 0, Class;
+	BYTE c;
+
+	if (strchr(Re, '|') != NULL) {
+		return 0;
+	}
+	if (strstr(Re, "(?") != NULL) {
+		// (?i) ŃIvVς邩Ȃ
+		IgnoreCase = TRUE;
+	}
+
+#define FLUSH() (Count = SearchAddTrigrams(Run, Len, Hash, Count), Len = Last = 0)
+
+	while (Re[i] != 0) {
+		c = (BYTE)Re[i];
+		if (SearchIsLead(c) && Re[i+1] != 0) {
+			if (Depth > 0 || IgnoreCase || Len + 2 >= sizeof(Run)) {
+				FLUSH();
+			}
+			else {
+				Run[Len++] = Re[i];
+				Run[Len++] = Re[i+1];
+				Last = 2;
+			}
+			i += 2;
+			continue;
+		}
+		i++;
+		switch (c) {
+		case '\\':
+			c = (BYTE)Re[i];
+			if (c == 0) {
+				break;
+			}
+			i++;
+			if (isalnum(c) || c >= 0x80) {
+				// \d, \x41, \p{...} : p {...} ǂݔ΂
+				FLUSH();
+				while (isalnum((BYTE)Re[i])) {
+					i++;
+				}
+				if (Re[i] == '{') {
+					while (Re[i] != 0 && Re[i] != '}') {
+						i++;
+					}
+					if (Re[i] != 0) {
+						i++;
+					}
+				}
+			}
+			else if (Depth > 0 || Len + 1 >= sizeof(Run)) {
+				FLUSH();
+			}
+			else {
+				Run[Len++] = c;
+				Last = 1;
+			}
+			break;
+		case '[':
+			FLUSH();
+			Class = 1;
+			if (Re[i] == '^') {
+				i++;
+			}
+			if (Re[i] == ']') {
+				i++;
+			}
+			while (Re[i] != 0 && Class > 0) {
+				if (Re[i] == '\\' && Re[i+1] != 0) {
+					i++;
+				}
+				else if (Re[i] == '[') {
+					Class++;
+				}
+				else if (Re[i] == ']') {
+					Class--;
+				}
+				i++;
+			}
+			break;
+		case '(':
+			FLUSH();
+			Depth++;
+			break;
+		case ')':
+			FLUSH();
+			Depth--;
+			break;
+		case '?':
+		case '*':
+		case '{':
+			// O 1 ͖Ă悢
+			Len -= Last;
+			FLUSH();
+			if (c == '{') {
+				while (Re[i] != 0 && Re[i] != '}') {
+					i++;
+				}
+				if (Re[i] != 0) {
+					i++;
+				}
+			}
+			break;
+		case '+':
+		case '.':
+		case '^':
+		case '$':
+			FLUSH();
+			break;
+		default:
+			if (Depth > 0 || (IgnoreCase && c >= 0x80) || Len + 1 >= sizeof(Run)) {
+				FLUSH();
+			}
+			else {
+				Run[Len++] = c;
+				Last = 1;
+			}
+			break;
+		}
+	}
+	FLUSH();
+
+#undef FLUSH
+
+	return Count;
+}
+
+// ubN b  Hash  trigram ׂĊ܂މ\邩
+static BOOL SearchBlockMayMatch(int b, WORD *Hash, int Count)
+{
+	LPBYTE Bits;
+	int i;
+
+	Bits = SearchBits[b];
+	for (i=0; i<Count; i++) {
+		if ((Bits[Hash[i] >> 3] & (1 << (Hash[i] & 7))) == 0) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+// 1 s̒
+//   Oł From ڈȍ~ōŏ́Ał From ڂOōŌ̈vT
+static BOOL SearchLine(LONG Ptr, PCHAR Str, int StrLen, regex_t *Reg, OnigRegion *Region,
+                       int Flags, int From, int *HitX, int *HitLen)
+{
+	PCHAR Text;
+	int Len, x, i, r, Dir;
+	BYTE a, b;
+
+	Text = GetCellCodes(&CellBuff[Ptr], NumOfColumns);
+	Len = NumOfColumns;
+	while (Len > 0 && Text[Len-1] == ' ') {
+		Len--;
+	}
+
+	if (Reg != NULL) {
+		if (Flags & BuffSearchBackward) {
+			if (From <= 0) {
+				return FALSE;
+			}
+			if (From > Len) {
+				From = Len + 1;
+			}
+			r = onig_search(Reg, (UChar *)Text, (UChar *)Text + Len,
+			                (UChar *)Text + From - 1, (UChar *)Text, Region, ONIG_OPTION_NONE);
+		}
+		else {
+			if (From > Len) {
+				return FALSE;
+			}
+			r = onig_search(Reg, (UChar *)Text, (UChar *)Text + Len,
+			                (UChar *)Text + From, (UChar *)Text + Len, Region, ONIG_OPTION_NONE);
+		}
+		if (r < 0) {
+			return FALSE;
+		}
+		*HitX = Region->beg[0];
+		*HitLen = Region->end[0] - Region->beg[0];
+		return TRUE;
+	}
+
+	if (Flags & BuffSearchBackward) {
+		x = min(From - 1, Len - StrLen);
+		Dir = -1;
+	}
+	else {
+		x = From;
+		Dir = 1;
+	}
+	for ( ; x >= 0 && x + StrLen <= Len; x += Dir) {
+		for (i=0; i<StrLen; i++) {
+			a = Text[x+i];
+			b = Str[i];
+			if (Flags & BuffSearchIgnoreCase) {
+				a = SearchFold(a);
+				b = SearchFold(b);
+			}
+			if (a != b) {
+				break;
+			}
+		}
+		// 2 oCg 2 oCgڂn܂v͖
+		if (i == StrLen && (x == 0 || (CellBuff[Ptr+x-1].Attr & AttrKanji) == 0)) {
+			*HitX = x;
+			*HitLen = StrLen;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// XN[obt@
+//   Flags: BuffSearchRegex, BuffSearchIgnoreCase, BuffSearchBackward
+//   Start O (ł Start O) ōŏɌv͈̔͂
+//   Start, End (End ͈v̒) ɕԂBs܂v͒TȂB
+//   Start obt@͈̔͊OȂA擪 (ł͖) TB
+BOOL BuffSearch(PCHAR Str, int Flags, POINT *Start, POINT *End)
+{
+	WORD Hash[SearchHashMax];
+	int Count, StrLen, Y, X, b, HitX, HitLen;
+	regex_t *Reg = NULL;
+	OnigRegion *Region = NULL;
+	OnigErrorInfo einfo;
+	OnigEncoding Enc;
+	BOOL Found = FALSE;
+
+	StrLen = strlen(Str);
+	if (StrLen == 0) {
+		return FALSE;
+	}
+
+	if (Flags & BuffSearchRegex) {
+		Enc = (ts.Language == IdJapanese) ? ONIG_ENCODING_SJIS : ONIG_ENCODING_ASCII;
+		if (onig_new(&Reg, (UChar *)Str, (UChar *)Str + StrLen,
+		             (Flags & BuffSearchIgnoreCase) ? ONIG_OPTION_IGNORECASE : ONIG_OPTION_NONE,
+		             Enc, ONIG_SYNTAX_DEFAULT, &einfo) != ONIG_NORMAL) {
+			return FALSE;
+		}
+		Region = onig_region_new();
+		Count = SearchRegexTrigrams(Str, (Flags & BuffSearchIgnoreCase) != 0, Hash);
+	}
+	else {
+		Count = SearchAddTrigrams(Str, StrLen, Hash, 0);
+	}
+
+	LockBuffer();
+	SearchUpdateIndex();
+
+	Y = Start->y;
+	X = Start->x;
+	if (X > NumOfColumns) {
+		X = NumOfColumns;
+	}
+	if (Flags & BuffSearchBackward) {
+		if (Y >= BuffEnd) {
+			Y = BuffEnd - 1;
+			X = NumOfColumns;
+		}
+	}
+	else if (Y < 0) {
+		Y = 0;
+		X = 0;
+	}
+
+	while (Y >= 0 && Y < BuffEnd) {
+		if (Count > 0 && Y < SearchIndexed) {
+			b = (Y - SearchTop) / SearchBlockLines;
+			if (! SearchBlockMayMatch(b, Hash, Count)) {
+				// ̃ubNɂ͖
+				if (Flags & BuffSearchBackward) {
+					Y = SearchTop + b * SearchBlockLines - 1;
+					X = NumOfColumns;
+				}
+				else {
+					// ̃ubNɂ͖o^̍s܂܂
+					Y = min(SearchTop + (b + 1) * SearchBlockLines, SearchIndexed);
+					X = 0;
+				}
+				continue;
+			}
+		}
+		if (SearchLine(GetLinePtr(Y), Str, StrLen, Reg, Region, Flags, X, &HitX, &HitLen)) {
+			Start->x = HitX;
+			Start->y = Y;
+			End->x = HitX + HitLen;
+			End->y = Y;
+			Found = TRUE;
+			break;
+		}
+		if (Flags & BuffSearchBackward) {
+			Y--;
+			X = NumOfColumns;
+		}
+		else {
+			Y++;
+			X = 0;
+		}
+	}
+
+	UnlockBuffer();
+
+	if (Reg != NULL) {
+		onig_region_free(Region, 1);
+		onig_free(Reg);
+	}
+	return Found;
+}
+
+// I͈ (Ε\̉) ̎̈vTđIA悤ɃXN[
+BOOL BuffSearchNext(PCHAR Str, int Flags)
+{
+	POINT Start, End;
+
+	if (Selected) {
+		Start = SelectStart;
+		if ((Flags & BuffSearchBackward) == 0) {
+			Start.x++;
+		}
+	}
+	else if (Flags & BuffSearchBackward) {
+		Start.x = 0;
+		Start.y = WinOrgY + PageStart + WinHeight;
+	}
+	else {
+		Start.x = 0;
+		Start.y = WinOrgY + PageStart;
+	}
+
+	if (! BuffSearch(Str, Flags, &Start, &End)) {
+		return FALSE;
+	}
+
+	LockBuffer();
+	// ȑȎI
+	SelectEnd = SelectStart;
+	ChangeSelectRegion();
+	BoxSelect = FALSE;
+
+	if (Start.y < WinOrgY + PageStart || Start.y >= WinOrgY + PageStart + WinHeight) {
+		DispVScroll(SCROLL_POS, Start.y - WinHeight / 2);
+	}
+
+	SelectStart = Start;
+	SelectEnd = End;
+	SelectEndOld = Start;
+	Selected = TRUE;
+	ChangeSelectRegion();
+	UnlockBuffer();
+	return TRUE;
+}
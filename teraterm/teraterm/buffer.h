@@ -28,11 +28,30 @@
  */
 
 /* TERATERM.EXE, scroll buffer routines */
+#pragma once
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Render statistics (cells written by the parser vs. cells drawn) */
+typedef struct {
+	DWORD Frames;		/* number of BuffFlushDamage() calls */
+	DWORD CellsParsed;	/* totals */
+	DWORD CellsPainted;
+	DWORD TextRuns;		/* strings passed to DispStr() */
+	DWORD LastParsed;	/* cells of the last frame */
+	DWORD LastPainted;
+	DWORD LastTextRuns;
+} TRenderStats;
+typedef TRenderStats *PRenderStats;
+
+/* BuffRenderFrame() draws the damaged region at most once per interval (ms) */
+#define RenderFrameInterval 16
+
+/* BuffSetUnicode(): right half of a character drawn as two cells */
+#define UniContinued 0xffffff
+
 void InitBuffer();
 void LockBuffer();
 void UnlockBuffer();
@@ -61,11 +80,18 @@ void BuffChangeAttrStream(int XStart, int YStart, int XEnd, int YEnd, PCharAttr
 void BuffCBCopy(BOOL Table);
 void BuffPrint(BOOL ScrollRegion);
 void BuffDumpCurrentLine(BYTE TERM);
+void BuffSetUnicode(DWORD Code);
 void BuffPutChar(BYTE b, TCharAttr Attr, BOOL Insert);
+void BuffPutString(PCHAR s, int len, TCharAttr Attr);
 void BuffPutKanji(WORD w, TCharAttr Attr, BOOL Insert);
+void BuffPutKanjiString(LPWORD w, int count, TCharAttr Attr);
 void BuffUpdateRect(int XStart, int YStart, int XEnd, int YEnd);
 void UpdateStr();
 void UpdateStrUnicode(void);
+void BuffFlushDamage();
+void BuffRenderFrame(BOOL Idle);
+BOOL BuffRenderPending();
+void BuffGetRenderStats(PRenderStats Stats);
 void MoveCursor(int Xnew, int Ynew);
 void MoveRight();
 void BuffSetCaretWidth();
@@ -108,6 +134,12 @@ void BuffScrollRight(int count);
 int BuffGetCurrentLineData(char *buf, int bufsize);
 int BuffGetAnyLineData(int offset_y, char *buf, int bufsize);
 BOOL BuffCheckMouseOnURL(int Xw, int Yw);
+BOOL BuffSearch(PCHAR Str, int Flags, POINT *Start, POINT *End);
+BOOL BuffSearchNext(PCHAR Str, int Flags);
+
+#define BuffSearchRegex      1
+#define BuffSearchIgnoreCase 2
+#define BuffSearchBackward   4
 
 extern int StatusLine;
 extern int CursorTop, CursorBottom, CursorLeftM, CursorRightM;
@@ -41,6 +41,7 @@
 #include "ttcommon.h"
 #include "ttlib.h"
 
+#include "commlib.h"
 #include "clipboar.h"
 #include "tt_res.h"
 
@@ -54,9 +55,8 @@ static LPWSTR CBCopyWidePtr = NULL;
 static HGLOBAL CBMemHandle = NULL;
 static PCHAR CBMemPtr = NULL;
 static LONG CBMemPtr2 = 0;
-static BYTE CBByte;
-static BOOL CBRetrySend;
-static BOOL CBRetryEcho;
+static LONG CBMemLen = -1;	// CBDecode() ̃f[^ (-1: fR[h)
+static LONG CBEchoLen = 0;	// Mς݂ł܂GR[ĂȂoCg (CBMemPtr2 ̎O)
 static BOOL CBSendCR;
 static BOOL CBEchoOnly;
 static BOOL CBInsertDelay = FALSE;
@@ -89,6 +89,25 @@ PCHAR CBOpen(LONG MemSize)
 	return (CBCopyPtr);
 }
 
+// CBOpen() ̌ŌĂԂƁACF_UNICODETEXT p̗̈ԂB
+// Ă΂ȂꍇACF_UNICODETEXT  CBClose()  CF_TEXT ϊB
+//   Count: WCHAR ̌
+LPWSTR CBOpenW(LONG Count)
+{
+	if (CBCopyHandle==NULL || CBCopyWideHandle!=NULL) {
+		return (NULL);
+	}
+	CBCopyWideHandle = GlobalAlloc(GMEM_MOVEABLE, sizeof(WCHAR) * Count);
+	if (CBCopyWideHandle != NULL) {
+		CBCopyWidePtr = (LPWSTR)GlobalLock(CBCopyWideHandle);
+		if (CBCopyWidePtr == NULL) {
+			GlobalFree(CBCopyWideHandle);
+			CBCopyWideHandle = NULL;
+		}
+	}
+	return (CBCopyWidePtr);
+}
+
 void CBClose()
 {
 	BOOL Empty;
@@ -98,13 +117,19 @@ void CBClose()
 		return;
 	}
 
-	WideCharLength = MultiByteToWideChar(CP_ACP, 0, CBCopyPtr, -1, NULL, 0);
-	CBCopyWideHandle = GlobalAlloc(GMEM_MOVEABLE, sizeof(WCHAR) * WideCharLength);
 	if (CBCopyWideHandle) {
-		CBCopyWidePtr = (LPWSTR)GlobalLock(CBCopyWideHandle);
-		MultiByteToWideChar(CP_ACP, 0, CBCopyPtr, -1, CBCopyWidePtr, WideCharLength);
+		// CBOpenW() ŏݍς
 		GlobalUnlock(CBCopyWideHandle);
 	}
+	else {
+		WideCharLength = MultiByteToWideChar(CP_ACP, 0, CBCopyPtr, -1, NULL, 0);
+		CBCopyWideHandle = GlobalAlloc(GMEM_MOVEABLE, sizeof(WCHAR) * WideCharLength);
+		if (CBCopyWideHandle) {
+			CBCopyWidePtr = (LPWSTR)GlobalLock(CBCopyWideHandle);
+			MultiByteToWideChar(CP_ACP, 0, CBCopyPtr, -1, CBCopyWidePtr, WideCharLength);
+			GlobalUnlock(CBCopyWideHandle);
+		}
+	}
 
 	Empty = FALSE;
 	if (CBCopyPtr!=NULL) {
@@ -146,11 +171,11 @@ void CBStartSend(PCHAR DataPtr, int DataSize, BOOL EchoOnly)
 	CBMemHandle = NULL;
 	CBMemPtr = NULL;
 	CBMemPtr2 = 0;
+	CBMemLen = -1;
 
 	CBInsertDelay = FALSE;
 
-	CBRetrySend = FALSE;
-	CBRetryEcho = FALSE;
+	CBEchoLen = 0;
 	CBSendCR = FALSE;
 
 	if ((CBMemHandle = GlobalAlloc(GHND, DataSize+1)) != NULL) {
@@ -409,6 +434,7 @@ void CBStartPaste(HWND HWin, BOOL AddCR, BOOL Bracketed)
 	CBMemHandle = NULL;
 	CBMemPtr = NULL;
 	CBMemPtr2 = 0;
+	CBMemLen = -1;
 
 	if (ts.PasteDelayPerLine > 0) {
 		CBInsertDelay = TRUE;
@@ -417,8 +443,7 @@ void CBStartPaste(HWND HWin, BOOL AddCR, BOOL Bracketed)
 		CBInsertDelay = FALSE;
 	}
 
-	CBRetrySend = FALSE;
-	CBRetryEcho = FALSE;
+	CBEchoLen = 0;
 	CBSendCR = FALSE;
 
 	if (OpenClipboard(HWin)) {
@@ -546,6 +571,7 @@ void CBStartPasteB64(HWND HWin, PCHAR header, PCHAR footer)
 	CBMemHandle = NULL;
 	CBMemPtr = NULL;
 	CBMemPtr2 = 0;
+	CBMemLen = -1;
 
 	if (ts.PasteDelayPerLine > 0) {
 		CBInsertDelay = TRUE;
@@ -554,8 +580,7 @@ void CBStartPasteB64(HWND HWin, PCHAR header, PCHAR footer)
 		CBInsertDelay = FALSE;
 	}
 
-	CBRetrySend = FALSE;
-	CBRetryEcho = FALSE;
+	CBEchoLen = 0;
 	CBSendCR = FALSE;
 
 	if (IsClipboardFormatAvailable(CF_UNICODETEXT) && OpenClipboard(HWin)) {
@@ -639,10 +664,59 @@ void CBStartPasteB64(HWND HWin, PCHAR header, PCHAR footer)
 // ܂Af[^ null-terminate Ă邱ƂOƂĂ邽߁A㑱̃f[^
 // B
 // (2006.11.6 yutaka)
+// Decoding characters which are encoded by MACRO
+//   to support NUL character sending
+//
+//  [encoded character] --> [decoded character]
+//         01 01        -->     00
+//         01 02        -->     01
+//
+// Mn߂OɃf[^Ŝ̏ŃfR[hAfR[h̒Ԃ
+static LONG CBDecode(PCHAR p)
+{
+	LONG i, j;
+
+	for (i=0, j=0; p[i] != 0; i++, j++) {
+		if (p[i] == 0x01) { /* 0x01 from MACRO */
+			if (p[i+1] == 0) {
+				break;
+			}
+			i++;
+			p[j] = p[i] - 1; // character just after 0x01
+		}
+		else {
+			p[j] = p[i];
+		}
+	}
+	return j;
+}
+
+// ɑ镔 (CR ܂ŁA܂͍Ō܂) ̒Ԃ
+static LONG CBLineLength()
+{
+	PCHAR p, cr;
+	LONG n;
+
+	p = CBMemPtr + CBMemPtr2;
+	n = CBMemLen - CBMemPtr2;
+	cr = memchr(p, CR, n);
+	if (cr != NULL) {
+		n = cr - p + 1;
+	}
+	return n;
+}
+
+// Mς݂ł܂GR[ĂȂGR[BׂăGR[ł TRUE ԂB
+static BOOL CBEchoSent()
+{
+	CBEchoLen -= CommTextEcho(&cv, CBMemPtr + CBMemPtr2 - CBEchoLen, CBEchoLen);
+	return (CBEchoLen == 0);
+}
+
 void CBSend()
 {
 	int c;
-	BOOL EndFlag;
+	LONG n;
 	static DWORD lastcr;
 	DWORD now;
 
@@ -662,76 +736,61 @@ void CBSend()
 		}
 	}
 
-	if (CBRetrySend) {
-		CBRetryEcho = (ts.LocalEcho>0);
-		c = CommTextOut(&cv,(PCHAR)&CBByte,1);
-		CBRetrySend = (c==0);
-		if (CBRetrySend) {
-			return;
-		}
+	CBMemPtr = GlobalLock(CBMemHandle);
+	if (CBMemPtr==NULL) {
+		return;
 	}
-
-	if (CBRetryEcho) {
-		c = CommTextEcho(&cv,(PCHAR)&CBByte,1);
-		CBRetryEcho = (c==0);
-		if (CBRetryEcho) {
-			return;
-		}
+	if (CBMemLen < 0) {
+		CBMemLen = CBDecode(CBMemPtr);
 	}
 
-	CBMemPtr = GlobalLock(CBMemHandle);
-	if (CBMemPtr==NULL) {
+	if (CBEchoLen > 0 && ! CBEchoSent()) {
+		GlobalUnlock(CBMemHandle);
+		CBMemPtr=NULL;
 		return;
 	}
 
-	do {
-		if (CBSendCR && (CBMemPtr[CBMemPtr2]==0x0a)) {
+	// 1 s (CR ܂) ܂Ƃ߂đ
+	for (;;) {
+		if (CBSendCR && CBMemPtr2 < CBMemLen && (CBMemPtr[CBMemPtr2]==0x0a)) {
 			CBMemPtr2++;
+			CBSendCR = FALSE;
 			// added PasteDelayPerLine (2009.4.12 maya)
 			if (CBInsertDelay) {
 				lastcr = now;
-				CBSendCR = FALSE;
 				SetTimer(HVTWin, IdPasteDelayTimer, ts.PasteDelayPerLine, NULL);
 				break;
 			}
 		}
 
-		EndFlag = (CBMemPtr[CBMemPtr2]==0);
-		if (! EndFlag) {
-			CBByte = CBMemPtr[CBMemPtr2];
-			CBMemPtr2++;
-// Decoding characters which are encoded by MACRO
-//   to support NUL character sending
-//
-//  [encoded character] --> [decoded character]
-//         01 01        -->     00
-//         01 02        -->     01
-			if (CBByte==0x01) { /* 0x01 from MACRO */
-				CBByte = CBMemPtr[CBMemPtr2];
-				CBMemPtr2++;
-				CBByte = CBByte - 1; // character just after 0x01
-			}
-		}
-		else {
+		if (CBMemPtr2 >= CBMemLen) {
 			CBEndPaste();
 			return;
 		}
 
-		if (! EndFlag) {
-			c = CommTextOut(&cv,(PCHAR)&CBByte,1);
-			CBSendCR = (CBByte==0x0D);
-			CBRetrySend = (c==0);
-			if ((! CBRetrySend) &&
-			    (ts.LocalEcho>0)) {
-				c = CommTextEcho(&cv,(PCHAR)&CBByte,1);
-				CBRetryEcho = (c==0);
+		// Mobt@l܂A󂭂܂ (CommSend() Ă΂܂) ҂
+		if (CommSendStopped(&cv)) {
+			break;
+		}
+
+		n = CBLineLength();
+		c = CommTextOut(&cv, CBMemPtr + CBMemPtr2, n);
+		if (c <= 0) {
+			break;
+		}
+		CBMemPtr2 += c;
+		CBSendCR = (CBMemPtr[CBMemPtr2-1]==0x0D);
+
+		if (ts.LocalEcho>0) {
+			CBEchoLen = c;
+			if (! CBEchoSent()) {
+				break;
 			}
 		}
-		else {
-			c=0;
+		if (c < n) {
+			break;
 		}
 	}
-	while (c>0);
 
 	if (CBMemPtr!=NULL) {
 		GlobalUnlock(CBMemHandle);
@@ -745,45 +804,33 @@ void CBEcho()
 		return;
 	}
 
-	if (CBRetryEcho && CommTextEcho(&cv,(PCHAR)&CBByte,1) == 0) {
-		return;
-	}
-
 	if ((CBMemPtr = GlobalLock(CBMemHandle)) == NULL) {
 		return;
 	}
+	if (CBMemLen < 0) {
+		CBMemLen = CBDecode(CBMemPtr);
+	}
 
-	do {
-		if (CBSendCR && (CBMemPtr[CBMemPtr2]==0x0a)) {
-			CBMemPtr2++;
-		}
+	if (CBEchoLen == 0 || CBEchoSent()) {
+		for (;;) {
+			if (CBSendCR && CBMemPtr2 < CBMemLen && (CBMemPtr[CBMemPtr2]==0x0a)) {
+				CBMemPtr2++;
+				CBSendCR = FALSE;
+			}
 
-		if (CBMemPtr[CBMemPtr2] == 0) {
-			CBRetryEcho = FALSE;
-			CBEndPaste();
-			return;
-		}
+			if (CBMemPtr2 >= CBMemLen) {
+				CBEndPaste();
+				return;
+			}
 
-		CBByte = CBMemPtr[CBMemPtr2];
-		CBMemPtr2++;
-
-		// Decoding characters which are encoded by MACRO
-		//   to support NUL character sending
-		//
-		//  [encoded character] --> [decoded character]
-		//         01 01        -->     00
-		//         01 02        -->     01
-		if (CBByte==0x01) { /* 0x01 from MACRO */
-			CBByte = CBMemPtr[CBMemPtr2];
-			CBMemPtr2++;
-			CBByte = CBByte - 1; // character just after 0x01
+			CBEchoLen = CBLineLength();
+			CBMemPtr2 += CBEchoLen;
+			CBSendCR = (CBMemPtr[CBMemPtr2-1]==0x0D);
+			if (! CBEchoSent()) {
+				break;
+			}
 		}
-
-		CBSendCR = (CBByte==0x0D);
-
-	} while (CommTextEcho(&cv,(PCHAR)&CBByte,1) > 0);
-
-	CBRetryEcho = TRUE;
+	}
 
 	if (CBMemHandle != NULL) {
 		GlobalUnlock(CBMemHandle);
@@ -805,6 +852,8 @@ void CBEndPaste()
 	CBMemHandle = NULL;
 	CBMemPtr = NULL;
 	CBMemPtr2 = 0;
+	CBMemLen = -1;
+	CBEchoLen = 0;
 	CBEchoOnly = FALSE;
 	CBInsertDelay = FALSE;
 }
@@ -35,6 +35,7 @@ extern "C" {
 
 /* prototypes */
 PCHAR CBOpen(LONG MemSize);
+LPWSTR CBOpenW(LONG Count);
 void CBClose();
 void CBStartSend(PCHAR DataPtr, int DataSize, BOOL EchoOnly);
 void CBStartPaste(HWND HWin, BOOL AddCR, BOOL Bracketed);
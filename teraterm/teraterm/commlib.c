@@ -44,6 +44,7 @@
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <stdio.h> /* for _snprintf() */
+#include <stdlib.h>
 #include <time.h>
 #include <locale.h>
 
@@ -128,6 +129,18 @@ void CommInit(PComVar cv)
 	cv->Open = FALSE;
 	cv->Ready = FALSE;
 
+// receive buffer
+	cv->InBuff = NULL;
+	cv->InBuffMax = 0;
+	cv->InBuffCount = 0;
+	cv->InPtr = 0;
+
+// send buffer
+	cv->OutBuff = NULL;
+	cv->OutBuffMax = 0;
+	cv->OutBuffCount = 0;
+	cv->OutPtr = 0;
+
 // log-buffer variables
 	cv->HLogBuf = 0;
 	cv->HBinBuf = 0;
@@ -155,6 +168,51 @@ void CommInit(PComVar cv)
 	cv->ConnectedTime = 0;
 }
 
+// MOobt@mۂB
+// TCY2ׂ̂ɐ؂グAmۂłȂꍇ͏TCYōĎsB
+static BOOL CommAllocInBuff(PTTSet ts, PComVar cv)
+{
+	int size;
+
+	size = RecvBuffSizeMin;
+	while (size < ts->RecvBuffSize && size < RecvBuffSizeMax) {
+		size <<= 1;
+	}
+
+	if (cv->InBuff != NULL && cv->InBuffMax == size) {
+		return TRUE;
+	}
+	free(cv->InBuff);
+	cv->InBuff = NULL;
+	cv->InBuffMax = 0;
+
+	while (size >= RecvBuffSizeMin) {
+		cv->InBuff = (LPBYTE)malloc(size);
+		if (cv->InBuff != NULL) {
+			cv->InBuffMax = size;
+			return TRUE;
+		}
+		size >>= 1;
+	}
+	return FALSE;
+}
+
+// MOobt@mۂB
+// ݂Ȃ ttpcmn  (CommRawOut() Ȃ) ōL̂ŁA
+// ttpcmn Ɠ GlobalAlloc() ŊmۂB
+static BOOL CommAllocOutBuff(PComVar cv)
+{
+	if (cv->OutBuff != NULL) {
+		return TRUE;
+	}
+	cv->OutBuff = (LPBYTE)GlobalAlloc(GMEM_FIXED, OutBuffSize);
+	if (cv->OutBuff == NULL) {
+		return FALSE;
+	}
+	cv->OutBuffMax = OutBuffSize;
+	return TRUE;
+}
+
 /* reset a serial port which is already open */
 void CommResetSerial(PTTSet ts, PComVar cv, BOOL ClearBuff)
 {
@@ -303,6 +361,9 @@ void CommOpen(HWND HW, PTTSet ts, PComVar cv)
 	}
 
 	/* initialize ComVar */
+	if (! CommAllocInBuff(ts, cv) || ! CommAllocOutBuff(cv)) {
+		return;
+	}
 	cv->InBuffCount = 0;
 	cv->InPtr = 0;
 	cv->OutBuffCount = 0;
@@ -862,6 +923,15 @@ void CommClose(PComVar cv)
 	cv->ComID = INVALID_HANDLE_VALUE;
 	cv->PortType = 0;
 
+	free(cv->InBuff);
+	cv->InBuff = NULL;
+	cv->InBuffMax = 0;
+	GlobalFree(cv->OutBuff);
+	cv->OutBuff = NULL;
+	cv->OutBuffMax = 0;
+	cv->OutBuffCount = 0;
+	cv->OutPtr = 0;
+
 	_free_locale(cv->locale);
 }
 
@@ -888,88 +958,91 @@ void CommReceive(PComVar cv)
 {
 	DWORD C;
 	DWORD DErr;
+	int Span;
 
 	if (! cv->Ready || ! cv->RRQ ||
-	    (cv->InBuffCount>=InBuffSize)) {
+	    (cv->InBuffCount>=cv->InBuffMax)) {
 		return;
 	}
 
-	/* Compact buffer */
-	if ((cv->InBuffCount>0) && (cv->InPtr>0)) {
-		memmove(cv->InBuff,&(cv->InBuff[cv->InPtr]),cv->InBuffCount);
+	/* MOobt@̋󂫗̈֒ړǂݍށB
+	   obt@̎͐擪ɖ߂āAȂׂÄgB */
+	if (cv->InBuffCount==0) {
 		cv->InPtr = 0;
 	}
 
-	if (cv->InBuffCount<InBuffSize) {
-		switch (cv->PortType) {
-			case IdTCPIP:
-				C = Precv(cv->s, &(cv->InBuff[cv->InBuffCount]),
-				          InBuffSize-cv->InBuffCount, 0);
+	switch (cv->PortType) {
+		case IdTCPIP:
+			// 󂫗̈悪܂ԂĂꍇ́AO𖄂߂㔼ɂǂݍ
+			do {
+				Span = InBuffWriteSpan(cv);
+				C = Precv(cv->s, &(cv->InBuff[InBuffWritePtr(cv)]), Span, 0);
 				if (C == SOCKET_ERROR) {
 					C = 0;
 					PWSAGetLastError();
 				}
 				cv->InBuffCount = cv->InBuffCount + C;
-				break;
-			case IdSerial:
-				do {
-					ClearCommError(cv->ComID,&DErr,NULL);
-					if (! PReadFile(cv->ComID,&(cv->InBuff[cv->InBuffCount]),
-					                InBuffSize-cv->InBuffCount,&C,&rol)) {
-						if (GetLastError() == ERROR_IO_PENDING) {
-							if (WaitForSingleObject(rol.hEvent, 1000) != WAIT_OBJECT_0) {
-								C = 0;
-							}
-							else {
-								GetOverlappedResult(cv->ComID,&rol,&C,FALSE);
-							}
+			} while ((C == (DWORD)Span) && (cv->InBuffCount<cv->InBuffMax));
+			break;
+		case IdSerial:
+			do {
+				ClearCommError(cv->ComID,&DErr,NULL);
+				Span = InBuffWriteSpan(cv);
+				if (! PReadFile(cv->ComID,&(cv->InBuff[InBuffWritePtr(cv)]),
+				                Span,&C,&rol)) {
+					if (GetLastError() == ERROR_IO_PENDING) {
+						if (WaitForSingleObject(rol.hEvent, 1000) != WAIT_OBJECT_0) {
+							C = 0;
 						}
 						else {
-							C = 0;
+							GetOverlappedResult(cv->ComID,&rol,&C,FALSE);
 						}
 					}
-					cv->InBuffCount = cv->InBuffCount + C;
-				} while ((C!=0) && (cv->InBuffCount<InBuffSize));
-				ClearCommError(cv->ComID,&DErr,NULL);
-				break;
-			case IdFile:
-				if (PReadFile(cv->ComID,&(cv->InBuff[cv->InBuffCount]),
-				              InBuffSize-cv->InBuffCount,&C,NULL)) {
-					if (C == 0) {
-						DErr = ERROR_HANDLE_EOF;
-					}
 					else {
-						cv->InBuffCount = cv->InBuffCount + C;
+						C = 0;
 					}
 				}
+				cv->InBuffCount = cv->InBuffCount + C;
+			} while ((C!=0) && (cv->InBuffCount<cv->InBuffMax));
+			ClearCommError(cv->ComID,&DErr,NULL);
+			break;
+		case IdFile:
+			if (PReadFile(cv->ComID,&(cv->InBuff[InBuffWritePtr(cv)]),
+			              InBuffWriteSpan(cv),&C,NULL)) {
+				if (C == 0) {
+					DErr = ERROR_HANDLE_EOF;
+				}
 				else {
-					DErr = GetLastError();
+					cv->InBuffCount = cv->InBuffCount + C;
 				}
-				break;
+			}
+			else {
+				DErr = GetLastError();
+			}
+			break;
 
-			case IdNamedPipe:
-				// L[̒ɍŒ1oCgȏ̃f[^Ă邱ƂmFłĂ邽߁A
-				// ReadFile() ̓ubN邱Ƃ͂Ȃ߁AꊇēǂށB
-				if (PReadFile(cv->ComID,&(cv->InBuff[cv->InBuffCount]),
-				              InBuffSize-cv->InBuffCount,&C,NULL)) {
-					if (C == 0) {
-						DErr = ERROR_HANDLE_EOF;
-					}
-					else {
-						cv->InBuffCount = cv->InBuffCount + C;
-					}
+		case IdNamedPipe:
+			// L[̒ɍŒ1oCgȏ̃f[^Ă邱ƂmFłĂ邽߁A
+			// ReadFile() ̓ubN邱Ƃ͂Ȃ߁AꊇēǂށB
+			if (PReadFile(cv->ComID,&(cv->InBuff[InBuffWritePtr(cv)]),
+			              InBuffWriteSpan(cv),&C,NULL)) {
+				if (C == 0) {
+					DErr = ERROR_HANDLE_EOF;
 				}
 				else {
-					DErr = GetLastError();
+					cv->InBuffCount = cv->InBuffCount + C;
 				}
+			}
+			else {
+				DErr = GetLastError();
+			}
 
-				// 1oCgȏǂ߂ACxgNAXbhĊJB
-				if (cv->InBuffCount > 0) {
-					cv->RRQ = FALSE;
-					SetEvent(ReadEnd);
-				}
-				break;
-		}
+			// 1oCgȏǂ߂ACxgNAXbhĊJB
+			if (cv->InBuffCount > 0) {
+				cv->RRQ = FALSE;
+				SetEvent(ReadEnd);
+			}
+			break;
 	}
 
 	if (cv->InBuffCount==0) {
@@ -1009,12 +1082,90 @@ void CommReceive(PComVar cv)
 	}
 }
 
+// Mobt@̃obNvbV[
+// M҂ OutBuffSize/2 ȏɂȂAt@CM\t (}N send ܂)
+// ͏݂߂BCommSend()  OutBuffSize/4 ܂Ō SendReady ĂōĊJB
+static void (*SendReady)(void) = NULL;
+static BOOL SendStopped = FALSE;
+
+void CommSetSendReady(void (*Func)(void))
+{
+	SendReady = Func;
+}
+
+// M݂߂ׂ TRUE Ԃ
+BOOL CommSendStopped(PComVar cv)
+{
+	if (cv->OutBuffCount >= OutBuffSize / 2) {
+		SendStopped = TRUE;
+	}
+	else if (cv->OutBuffCount <= OutBuffSize / 4) {
+		SendStopped = FALSE;
+	}
+	return SendStopped;
+}
+
+/* Write to comm driver/Winsock */
+static int CommWrite(PComVar cv, LPBYTE B, int C)
+{
+	COMSTAT Stat;
+	int D;
+	DWORD DErr;
+
+	switch (cv->PortType) {
+		case IdTCPIP:
+			D = Psend(cv->s, B, C, 0);
+			if ( D==SOCKET_ERROR ) { /* if error occurs */
+				PWSAGetLastError(); /* Clear error */
+				D = 0;
+			}
+			break;
+
+		case IdSerial:
+			if (! PWriteFile(cv->ComID,B,C,(LPDWORD)&D,&wol)) {
+				if (GetLastError() == ERROR_IO_PENDING) {
+					if (WaitForSingleObject(wol.hEvent,1000) != WAIT_OBJECT_0) {
+						D = C; /* Time out, ignore data */
+					}
+					else {
+						GetOverlappedResult(cv->ComID,&wol,(LPDWORD)&D,FALSE);
+					}
+				}
+				else { /* I/O error */
+					D = C; /* ignore error */
+				}
+			}
+			ClearCommError(cv->ComID,&DErr,&Stat);
+			break;
+
+		case IdFile:
+			if (! PWriteFile(cv->ComID, B, C, (LPDWORD)&D, NULL)) {
+				if (! GetLastError() == ERROR_IO_PENDING) {
+					D = C; /* ignore data */
+				}
+			}
+			break;
+
+		case IdNamedPipe:
+			if (! PWriteFile(cv->ComID, B, C, (LPDWORD)&D, NULL)) {
+				// ERROR_IO_PENDING ȊÕG[ApCvN[YĂ邩ȂA
+				// MłƂɂB
+				if (! (GetLastError() == ERROR_IO_PENDING)) {
+					D = C; /* ignore data */
+				}
+			}
+			break;
+	}
+
+	return D;
+}
+
 void CommSend(PComVar cv)
 {
 	int delay;
 	COMSTAT Stat;
 	BYTE LineEnd;
-	int C, D, Max;
+	int C, D, Max, n, w;
 	DWORD DErr;
 
 	if ((! cv->Open) || (! cv->Ready)) {
@@ -1070,11 +1221,11 @@ void CommSend(PComVar cv)
 			}
 			C = 1;
 			if ( cv->DelayPerChar==0 ) {
-				while ((C<Max) && (cv->OutBuff[cv->OutPtr+C-1]!=LineEnd)) {
+				while ((C<Max) && (cv->OutBuff[(cv->OutPtr+C-1) & OutBuffMask(cv)]!=LineEnd)) {
 					C++;
 				}
 			}
-			if ( cv->OutBuff[cv->OutPtr+C-1]==LineEnd ) {
+			if ( cv->OutBuff[(cv->OutPtr+C-1) & OutBuffMask(cv)]==LineEnd ) {
 				delay = cv->DelayPerLine;
 			}
 			else {
@@ -1088,63 +1239,33 @@ void CommSend(PComVar cv)
 	}
 
 	/* Write to comm driver/Winsock */
-	switch (cv->PortType) {
-		case IdTCPIP:
-			D = Psend(cv->s, &(cv->OutBuff[cv->OutPtr]), C, 0);
-			if ( D==SOCKET_ERROR ) { /* if error occurs */
-				PWSAGetLastError(); /* Clear error */
-				D = 0;
-			}
-			break;
-
-		case IdSerial:
-			if (! PWriteFile(cv->ComID,&(cv->OutBuff[cv->OutPtr]),C,(LPDWORD)&D,&wol)) {
-				if (GetLastError() == ERROR_IO_PENDING) {
-					if (WaitForSingleObject(wol.hEvent,1000) != WAIT_OBJECT_0) {
-						D = C; /* Time out, ignore data */
-					}
-					else {
-						GetOverlappedResult(cv->ComID,&wol,(LPDWORD)&D,FALSE);
-					}
-				}
-				else { /* I/O error */
-					D = C; /* ignore error */
-				}
-			}
-			ClearCommError(cv->ComID,&DErr,&Stat);
-			break;
-
-		case IdFile:
-			if (! PWriteFile(cv->ComID, &(cv->OutBuff[cv->OutPtr]), C, (LPDWORD)&D, NULL)) {
-				if (! GetLastError() == ERROR_IO_PENDING) {
-					D = C; /* ignore data */
-				}
-			}
-			break;
-
-		case IdNamedPipe:
-			if (! PWriteFile(cv->ComID, &(cv->OutBuff[cv->OutPtr]), C, (LPDWORD)&D, NULL)) {
-				// ERROR_IO_PENDING ȊÕG[ApCvN[YĂ邩ȂA
-				// MłƂɂB
-				if (! (GetLastError() == ERROR_IO_PENDING)) {
-					D = C; /* ignore data */
-				}
-			}
-			break;
-	}
-
-	cv->OutBuffCount = cv->OutBuffCount - D;
+	// Oobt@܂ԂĂ鎞́AO 2 ̗̈𑱂ď
+	D = 0;
+	do {
+		n = OutBuffReadSpan(cv);
+		if (n > C - D) {
+			n = C - D;
+		}
+		w = CommWrite(cv, &(cv->OutBuff[cv->OutPtr]), n);
+		cv->OutBuffCount -= w;
+		cv->OutPtr = (cv->OutPtr + w) & OutBuffMask(cv);
+		D += w;
+	} while (w == n && D < C);
 	if ( cv->OutBuffCount==0 ) {
 		cv->OutPtr = 0;
 	}
-	else {
-		cv->OutPtr = cv->OutPtr + D;
-	}
 
 	if ( (C==D) && (delay>0) ) {
 		cv->CanSend = FALSE;
 		SetTimer(cv->HWin, IdDelayTimer, delay, NULL);
 	}
+
+	if (SendStopped && cv->OutBuffCount <= OutBuffSize / 4) {
+		SendStopped = FALSE;
+		if (SendReady != NULL) {
+			SendReady();
+		}
+	}
 }
 
 void CommSendBreak(PComVar cv, int msec)
@@ -44,6 +44,8 @@ void CommClose(PComVar cv);
 void CommProcRRQ(PComVar cv);
 void CommReceive(PComVar cv);
 void CommSend(PComVar cv);
+void CommSetSendReady(void (*Func)(void));
+BOOL CommSendStopped(PComVar cv);
 void CommSendBreak(PComVar cv, int msec);
 void CommResetSerial(PTTSet ts, PComVar cv, BOOL ClearBuffer);
 void CommLock(PTTSet ts, PComVar cv, BOOL Lock);
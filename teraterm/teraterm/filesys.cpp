@@ -66,7 +66,7 @@ static BYTE LogLast = 0;
 BOOL FileLog = FALSE;
 BOOL BinLog = FALSE;
 BOOL DDELog = FALSE;
-static BOOL FileRetrySend, FileRetryEcho, FileCRSend, FileReadEOF, BinaryMode;
+static BOOL FileRetryEcho, FileCRSend, FileReadEOF, BinaryMode;
 static BYTE FileByte;
 
 #define FILE_SEND_BUF_SIZE  8192
@@ -1223,7 +1223,6 @@ void FileSendStart()
 	SendVar->FileSize = GetFSize(SendVar->FullName);
 
 	TalkStatus = IdTalkFile;
-	FileRetrySend = FALSE;
 	FileRetryEcho = FALSE;
 	FileCRSend = FALSE;
 	FileReadEOF = FALSE;
@@ -1319,57 +1318,76 @@ void FileSendBinayBoost()
 
 	BCOld = SendVar->ByteCount;
 
-	if (FileRetrySend)
-	{
-		c = CommRawOut(&cv, &(FileSendHandler.buf[FileSendHandler.pos]),
-			FileSendHandler.end - FileSendHandler.pos);
-		FileSendHandler.pos += c;
-		FileRetrySend = (FileSendHandler.end != FileSendHandler.pos);
-		if (FileRetrySend)
+	do {
+		// Mobt@l܂A󂢂 CommSend() Ă΂܂ő҂
+		if (CommSendStopped(&cv)) {
+			if (SendVar->ByteCount != BCOld)
+				SendDlg->RefreshNum();
 			return;
-	}
+		}
 
-	do {
 		if (FileSendHandler.pos == FileSendHandler.end) {
 			ReadFile((HANDLE)SendVar->FileHandle, &(FileSendHandler.buf[0]), sizeof(FileSendHandler.buf), &read_bytes, NULL);
-			fc = LOWORD(read_bytes);
 			FileSendHandler.pos = 0;
-			FileSendHandler.end = fc;
-		} else {
-			fc = FileSendHandler.end - FileSendHandler.end;
+			FileSendHandler.end = LOWORD(read_bytes);
 		}
+		fc = FileSendHandler.end - FileSendHandler.pos;
 
 		if (fc != 0)
 		{
-			c = CommRawOut(&cv, &(FileSendHandler.buf[FileSendHandler.pos]),
-				FileSendHandler.end - FileSendHandler.pos);
+			c = CommRawOut(&cv, &(FileSendHandler.buf[FileSendHandler.pos]), fc);
 			FileSendHandler.pos += c;
-			FileRetrySend = (FileSendHandler.end != FileSendHandler.pos);
 			SendVar->ByteCount = SendVar->ByteCount + c;
-			if (FileRetrySend)
+			if (FileSendHandler.pos != FileSendHandler.end)
 			{
-				if (SendVar->ByteCount != BCOld)
-					SendDlg->RefreshNum();
+				// 肫Ȃc͎ɌĂ΂ꂽɑ
+				SendDlg->RefreshNum();
 				return;
 			}
 		}
-		FileDlgRefresh = SendVar->ByteCount;
-		SendDlg->RefreshNum();
-		BCOld = SendVar->ByteCount;
-		if (fc != 0)
-			return;
 	} while (fc != 0);
 
+	SendDlg->RefreshNum();
 	FileTransEnd(OpSendFile);
 }
 }
 
+// Mt@C1oCgǂ (FileSendHandler.buf ɂ܂Ƃ߂ēǂݍ)
+static WORD FileRead1(BYTE *b)
+{
+	DWORD read_bytes;
+
+	if (FileSendHandler.pos == FileSendHandler.end) {
+		ReadFile((HANDLE)SendVar->FileHandle, &(FileSendHandler.buf[0]), sizeof(FileSendHandler.buf), &read_bytes, NULL);
+		FileSendHandler.pos = 0;
+		FileSendHandler.end = LOWORD(read_bytes);
+		if (FileSendHandler.end == 0) {
+			return 0;
+		}
+	}
+	*b = FileSendHandler.buf[FileSendHandler.pos++];
+	return 1;
+}
+
+// ǂݍݍς݂̂̕A䕶܂܂Ȃ (FSOut1()  CommTextOut() ɓn) ̒
+static int FileTextLength()
+{
+	int i;
+
+	for (i = FileSendHandler.pos; i < FileSendHandler.end; i++) {
+		if ((BYTE)FileSendHandler.buf[i] < 0x20) {
+			break;
+		}
+	}
+	return i - FileSendHandler.pos;
+}
+
 extern "C" {
 void FileSend()
 {
 	WORD c, fc;
 	LONG BCOld;
-	DWORD read_bytes;
+	int n;
 
 	if (cv.PortType == IdSerial && ts.FileSendHighSpeedMode &&
 	    BinaryMode && !FileBracketMode && !cv.TelFlag &&
@@ -1383,15 +1401,6 @@ void FileSend()
 
 	BCOld = SendVar->ByteCount;
 
-	if (FileRetrySend)
-	{
-		FileRetryEcho = (ts.LocalEcho>0);
-		c = FSOut1(FileByte);
-		FileRetrySend = (c==0);
-		if (FileRetrySend)
-			return;
-	}
-
 	if (FileRetryEcho)
 	{
 		c = FSEcho1(FileByte);
@@ -1401,6 +1410,31 @@ void FileSend()
 	}
 
 	do {
+		// Mobt@l܂A󂢂 CommSend() Ă΂܂ő҂B
+		// l܂ĂȂ OutBuffSize/2 ȏ󂢂Ă̂ŁA1 ݂͕̏KB
+		if (CommSendStopped(&cv)) {
+			if (SendVar->ByteCount != BCOld)
+				SendDlg->RefreshNum();
+			return;
+		}
+
+		// eLXǵA䕶܂܂Ȃ܂Ƃ߂ CommTextOut() ŕϊđ
+		if (! BinaryMode && (FileBracketMode != FS_BRACKET_START) && (ts.LocalEcho == 0)) {
+			n = FileTextLength();
+			if (n > 0) {
+				c = CommTextOut(&cv, &(FileSendHandler.buf[FileSendHandler.pos]), n);
+				FileSendHandler.pos += c;
+				SendVar->ByteCount = SendVar->ByteCount + c;
+				FileCRSend = FALSE;
+				if (c < n) {
+					SendDlg->RefreshNum();
+					return;
+				}
+				fc = c;
+				continue;
+			}
+		}
+
 		if (FileBracketMode == FS_BRACKET_START) {
 			FileByte = BracketStartStr[FileBracketPtr++];
 			fc = 1;
@@ -1412,13 +1446,11 @@ void FileSend()
 			}
 		}
 		else if (! FileReadEOF) {
-			ReadFile((HANDLE)SendVar->FileHandle, &FileByte, 1, &read_bytes, NULL);
-			fc = LOWORD(read_bytes);
+			fc = FileRead1(&FileByte);
 			SendVar->ByteCount = SendVar->ByteCount + fc;
 
 			if (FileCRSend && (fc==1) && (FileByte==0x0A)) {
-				ReadFile((HANDLE)SendVar->FileHandle, &FileByte, 1, &read_bytes, NULL);
-				fc = LOWORD(read_bytes);
+				fc = FileRead1(&FileByte);
 				SendVar->ByteCount = SendVar->ByteCount + fc;
 			}
 		}
@@ -1441,15 +1473,8 @@ void FileSend()
 
 		if (fc!=0)
 		{
-			c = FSOut1(FileByte);
+			FSOut1(FileByte);
 			FileCRSend = (ts.TransBin==0) && (FileByte==0x0D);
-			FileRetrySend = (c==0);
-			if (FileRetrySend)
-			{
-				if (SendVar->ByteCount != BCOld)
-					SendDlg->RefreshNum();
-				return;
-			}
 			if (ts.LocalEcho>0)
 			{
 				c = FSEcho1(FileByte);
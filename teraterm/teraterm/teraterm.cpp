@@ -90,10 +90,25 @@ CTeraApp theApp;
 
 
 
+// Talker (clipboard/DDE data, file)
+// Mobt@ɋ󂫂 OnIdle() A~܂͋󂢂 CommSend() Ă΂
+static void Talk()
+{
+	switch (TalkStatus) {
+	case IdTalkCB:
+		CBSend();
+		break; /* clip board */
+	case IdTalkFile:
+		FileSend();
+		break; /* file */
+	}
+}
+
 // CTeraApp initialization
 BOOL CTeraApp::InitInstance()
 {
 	hInst = m_hInstance;
+	CommSetSendReady(Talk);
 	m_pMainWnd = new CVTWindow();
 	pVTWin = m_pMainWnd;
 	return TRUE;
@@ -198,13 +213,8 @@ BOOL CTeraApp::OnIdle(LONG lCount)
 		}
 
 		/* Talker */
-		switch (TalkStatus) {
-		case IdTalkCB:
-			CBSend();
-			break; /* clip board */
-		case IdTalkFile:
-			FileSend();
-			break; /* file */
+		if (! CommSendStopped(&cv)) {
+			Talk();
 		}
 
 		/* Receiver */
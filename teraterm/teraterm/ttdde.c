@@ -47,6 +47,7 @@
 #include "commlib.h"
 
 #include "vtwin.h"
+#include "buffer.h"
 
 #define ServiceName "TERATERM"
 #define ItemName "DATA"
@@ -856,6 +857,43 @@ scp_rcv_error:
 		}
 		break;
 
+	case CmdSftpSend:
+	case CmdSftpRcv:
+		{
+		typedef int (CALLBACK *PSSH_start_sftp)(char *, char *);
+		static PSSH_start_sftp send_func = NULL, recv_func = NULL;
+		PSSH_start_sftp func;
+		char *name = (Command[0] == CmdSftpSend) ? "TTXSftpSendfile" : "TTXSftpReceivefile";
+		HMODULE h;
+		char msg[128];
+
+		func = (Command[0] == CmdSftpSend) ? send_func : recv_func;
+		if (func == NULL) {
+			if ( ((h = GetModuleHandle("ttxssh.dll")) == NULL) ) {
+				_snprintf_s(msg, sizeof(msg), _TRUNCATE, "GetModuleHandle(\"ttxssh.dll\")) %d", GetLastError());
+				goto sftp_error;
+			}
+			func = (PSSH_start_sftp)GetProcAddress(h, name);
+			if (func == NULL) {
+				_snprintf_s(msg, sizeof(msg), _TRUNCATE, "GetProcAddress(\"%s\")) %d", name, GetLastError());
+				goto sftp_error;
+			}
+			if (Command[0] == CmdSftpSend)
+				send_func = func;
+			else
+				recv_func = func;
+		}
+
+		func(ParamFileName, ParamSecondFileName);
+		break;
+
+sftp_error:
+		MessageBox(NULL, msg, (Command[0] == CmdSftpSend) ? "Tera Term: sftpsend command error" : "Tera Term: sftprecv command error",
+		           MB_OK | MB_ICONERROR);
+		return DDE_FNOTPROCESSED;
+		}
+		break;
+
 	case CmdSetBaud:  // add 'setbaud' (2008.2.13 steven patch)
 		{
 		int val;
@@ -962,6 +1000,37 @@ scp_rcv_error:
 		}
 		break;
 
+	case CmdSearchBuff: // 'searchbuff'
+		// ParamFileName: , ParamSecondFileName: "IvV Jns"
+		// s̔ԍ (1 ) Ɠe ParamFileName ɕԂ
+		{
+		POINT Start, End;
+		int Flags = 0, Line = 0;
+		char Text[MaxStrLen];
+
+		sscanf(ParamSecondFileName, "%d %d", &Flags, &Line);
+		// ł͎w肵s̍s (w肪΃obt@̖) T
+		if (Flags & BuffSearchBackward) {
+			Start.x = MAXLONG;
+			Start.y = (Line > 0) ? Line - 1 : MAXLONG;
+		}
+		else {
+			Start.x = 0;
+			Start.y = (Line > 0) ? Line - 1 : 0;
+		}
+		if (BuffSearch(ParamFileName, Flags, &Start, &End)) {
+			int len = BuffGetAnyLineData(Start.y, Text, sizeof(Text));
+			while (len > 0 && Text[len - 1] == ' ') {
+				Text[--len] = 0;
+			}
+			_snprintf_s(ParamFileName, sizeof(ParamFileName), _TRUNCATE, "%d %s", Start.y + 1, Text);
+		}
+		else {
+			strncpy_s(ParamFileName, sizeof(ParamFileName), "0 ", _TRUNCATE);
+		}
+		}
+		break;
+
 	case CmdSendBroadcast: // 'sendbroadcast'
 		SendBroadcastMessage(HVTWin, HVTWin, ParamFileName, strlen(ParamFileName));
 		break;
@@ -117,6 +117,14 @@ static TCharAttr DCAttr;
 static TCharAttr CurCharAttr;
 static BOOL DCReverse;
 static HFONT DCPrevFont;
+// VTDC ɎۂɑIĂtHgƐF
+static HFONT DCFont;
+static COLORREF DCTextColor, DCBkColor;
+
+// ܂`悵ĂȂ (ڂ̘A܂Ƃ߂ĕ`悷)
+static char StrBuff[TermWidthMax];
+static int StrCount = 0;
+static int StrX, StrY;
 
 TCharAttr DefCharAttr = {
   AttrDefault,
@@ -2535,16 +2543,21 @@ void DispInitDC()
     VTDC = GetDC(HVTWin);
     DCPrevFont = SelectObject(VTDC, VTFont[0]);
   }
-  else
+  else {
+    DispFlushStr();
     SelectObject(VTDC, VTFont[0]);
+  }
+  DCFont = VTFont[0];
 
 #ifdef ALPHABLEND_TYPE2
-  SetTextColor(VTDC, BGVTColor[0]);
-  SetBkColor(VTDC, BGVTColor[1]);
+  DCTextColor = BGVTColor[0];
+  DCBkColor = BGVTColor[1];
 #else
-  SetTextColor(VTDC, ts.VTColor[0]);
-  SetBkColor(VTDC, ts.VTColor[1]);
+  DCTextColor = ts.VTColor[0];
+  DCBkColor = ts.VTColor[1];
 #endif  // ALPHABLEND_TYPE2
+  SetTextColor(VTDC, DCTextColor);
+  SetBkColor(VTDC, DCBkColor);
 
   SetBkMode(VTDC,OPAQUE);
   DCAttr = DefCharAttr;
@@ -2560,6 +2573,7 @@ void DispInitDC()
 void DispReleaseDC()
 {
   if (VTDC==NULL) return;
+  DispFlushStr();
   SelectObject(VTDC, DCPrevFont);
   ReleaseDC(HVTWin,VTDC);
   VTDC = NULL;
@@ -2579,7 +2593,11 @@ void DispSetupDC(TCharAttr Attr, BOOL Reverse)
 //   Reverse: true if text is selected (reversed) by mouse
 {
   COLORREF TextColor, BackColor;
+  HFONT Font;
   int NoReverseColor = 2;
+#ifdef ALPHABLEND_TYPE2
+  BOOL ReverseText;
+#endif
 
   if (VTDC==NULL)  DispInitDC();
 
@@ -2589,7 +2607,7 @@ void DispSetupDC(TCharAttr Attr, BOOL Reverse)
   DCAttr = Attr;
   DCReverse = Reverse;
 
-  SelectObject(VTDC, VTFont[(Attr.Attr & AttrFontMask) | (isURLUnderlined(Attr)?AttrUnder:0)]);
+  Font = VTFont[(Attr.Attr & AttrFontMask) | (isURLUnderlined(Attr)?AttrUnder:0)];
 
   if ((ts.ColorFlag & CF_FULLCOLOR) == 0) {
 	if (isBlinkColored(Attr)) {
@@ -2738,34 +2756,59 @@ void DispSetupDC(TCharAttr Attr, BOOL Reverse)
   if (Reverse != ((Attr.Attr & AttrReverse) != 0))
   {
 #ifdef ALPHABLEND_TYPE2
-    BGReverseText = TRUE;
+    ReverseText = TRUE;
 #endif
     if ((Attr.Attr & AttrReverse) && !NoReverseColor) {
 #ifdef ALPHABLEND_TYPE2
-      SetTextColor(VTDC, BGVTReverseColor[0]);
-      SetBkColor(  VTDC, BGVTReverseColor[1]);
+      TextColor = BGVTReverseColor[0];
+      BackColor = BGVTReverseColor[1];
 #else
-      SetTextColor(VTDC, ts.VTReverseColor[0]);
-      SetBkColor(  VTDC, ts.VTReverseColor[1]);
+      TextColor = ts.VTReverseColor[0];
+      BackColor = ts.VTReverseColor[1];
 #endif
     }
     else {
-      SetTextColor(VTDC, BackColor);
-      SetBkColor(  VTDC, TextColor);
+      COLORREF Color = TextColor;
+      TextColor = BackColor;
+      BackColor = Color;
     }
   }
   else {
 #ifdef ALPHABLEND_TYPE2 // by AKASI
-    BGReverseText = FALSE;
+    ReverseText = FALSE;
+#endif
+  }
+
+  // ڂςȂ̕ωł DC G炸A܂Ƃ߂ĕ`悷
+  if (Font == DCFont && TextColor == DCTextColor && BackColor == DCBkColor
+#ifdef ALPHABLEND_TYPE2
+      && ReverseText == BGReverseText
 #endif
-    SetTextColor(VTDC,TextColor);
-    SetBkColor(  VTDC,BackColor);
+     ) {
+    return;
+  }
+  DispFlushStr();
+
+  if (Font != DCFont) {
+    SelectObject(VTDC, Font);
+    DCFont = Font;
+  }
+  if (TextColor != DCTextColor) {
+    SetTextColor(VTDC, TextColor);
+    DCTextColor = TextColor;
+  }
+  if (BackColor != DCBkColor) {
+    SetBkColor(VTDC, BackColor);
+    DCBkColor = BackColor;
   }
+#ifdef ALPHABLEND_TYPE2
+  BGReverseText = ReverseText;
+#endif
 }
 
 #if 1
 // ʂ͂̊֐gB(2004.11.4 yutaka)
-void DispStr(PCHAR Buff, int Count, int Y, int* X)
+static void DrawStr(PCHAR Buff, int Count, int Y, int* X)
 // Display a string
 //   Buff: points the string
 //   Y: vertical position in window cordinate
@@ -2854,7 +2897,7 @@ void DispStr(PCHAR Buff, int Count, int Y, int* X)
 }
 
 #else
-void DispStr(PCHAR Buff, int Count, int Y, int* X)
+static void DrawStr(PCHAR Buff, int Count, int Y, int* X)
 // Display a string
 //   Buff: points the string
 //   Y: vertical position in window cordinate
@@ -2924,6 +2967,48 @@ void DispStr(PCHAR Buff, int Count, int Y, int* X)
 }
 #endif
 
+void DispStr(PCHAR Buff, int Count, int Y, int* X)
+// Display a string
+//   the string is drawn together with the following strings
+//   by DispFlushStr() or the next DispSetupDC() that changes the DC.
+//   Buff: points the string
+//   Y: vertical position in window cordinate
+//  *X: horizontal position
+// Return:
+//  *X: horizontal position shifted by the width of the string
+{
+  if (StrCount > 0 &&
+      (Y != StrY || *X != StrX + StrCount*FontWidth || StrCount + Count > TermWidthMax))
+    DispFlushStr();
+
+  if (Count > TermWidthMax) {
+    DrawStr(Buff, Count, Y, X);
+    return;
+  }
+
+  if (StrCount == 0) {
+    StrX = *X;
+    StrY = Y;
+  }
+  memcpy(&StrBuff[StrCount], Buff, Count);
+  StrCount += Count;
+  *X = *X + Count*FontWidth;
+}
+
+void DispFlushStr()
+// Display the strings kept by DispStr()
+{
+  int X;
+
+  if (StrCount == 0 || VTDC == NULL) {
+    StrCount = 0;
+    return;
+  }
+  X = StrX;
+  DrawStr(StrBuff, StrCount, StrY, &X);
+  StrCount = 0;
+}
+
 
 void DispEraseCurToEnd(int YEnd)
 {
@@ -0,0 +1,264 @@
+#!perl -w
+#
+# Generates vtparse.map, the transition/action tables of the escape
+# sequence parser in vtterm.c.
+#
+#   perl vtparse.pl > vtparse.map
+#
+# Each received byte is mapped to a byte class (VTByteClass) and the class
+# selects the action of the current parse mode (EscActions, CSActions).
+# The final character of a CSI sequence without private or intermediate
+# characters is dispatched through CSFinals.
+# DBCSClass* are the byte classes given to CommReadDBCSRun() to read runs of
+# single byte and double byte characters of each kanji code.
+#
+# vtparse.map is checked in, so this is only needed after editing the
+# tables below.  The headless build (../headless/Makefile) regenerates it.
+
+use strict;
+
+my(@classes) = ();	# [name, first, last]
+my(%actions) = ();	# mode => { class => action }
+my(@modes) = ();
+my(%finals) = ();	# final char => [call, mnemonic]
+my(@dbcs) = ();		# kanji code names
+my(%dbcs) = ();		# kanji code => [256 bytes]
+my(%dbcsbit) = (Single => 1, Lead => 2, Trail => 4);	# DBCSSingle etc. in ttcommon.h
+
+while (<DATA>) {
+	s/#.*//;
+	my(@t) = split;
+	next if (!@t);
+	if ($t[0] eq 'class') {
+		push(@classes, [$t[1], hex($t[2]), hex($t[3])]);
+	}
+	elsif ($t[0] eq 'final') {
+		$finals{ord($t[1])} = [$t[2], $t[3]];
+	}
+	elsif ($t[0] eq 'dbcs') {
+		if (!exists($dbcs{$t[1]})) {
+			push(@dbcs, $t[1]);
+			$dbcs{$t[1]} = [(0) x 256];
+		}
+		foreach my $b (hex($t[3])..hex($t[4])) {
+			$dbcs{$t[1]}[$b] |= $dbcsbit{$t[2]};
+		}
+	}
+	else {
+		push(@modes, $t[0]) if (!exists($actions{$t[0]}));
+		$actions{$t[0]}{$t[1]} = $t[2];
+	}
+}
+
+my(@class) = ();
+foreach my $c (0..$#classes) {
+	foreach my $b ($classes[$c][1]..$classes[$c][2]) {
+		die "byte $b has two classes\n" if (defined($class[$b]));
+		$class[$b] = $c;
+	}
+}
+foreach my $b (0..255) {
+	die "byte $b has no class\n" if (!defined($class[$b]));
+}
+
+print <<'EOT';
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* generated by vtparse.pl, do not edit */
+
+EOT
+
+# byte classes
+foreach my $c (0..$#classes) {
+	printf("#define VTClass%-8s %d\n", $classes[$c][0], $c);
+}
+printf("#define VTClassCount    %d\n\n", scalar(@classes));
+
+print "static const BYTE VTByteClass[256] = {\n";
+foreach my $row (0..15) {
+	print "\t", join(", ", @class[$row*16..$row*16+15]), ",\n";
+}
+print "};\n\n";
+
+# actions of each parse mode
+my(%proto) = ();
+foreach my $m (@modes) {
+	foreach my $a (values(%{$actions{$m}})) {
+		$proto{$a} = 1;
+	}
+}
+foreach my $a (sort(keys(%proto))) {
+	print "void $a(BYTE b);\n";
+}
+print "\n";
+
+foreach my $m (@modes) {
+	print "static void (* const ${m}Actions[VTClassCount])(BYTE b) = {\n";
+	foreach my $c (@classes) {
+		my($a) = $actions{$m}{$$c[0]};
+		die "$m: no action for $$c[0]\n" if (!defined($a));
+		printf("\t%-20s /* %s */\n", "$a,", $$c[0]);
+	}
+	print "};\n\n";
+}
+
+# CSI final characters
+foreach my $f (sort { $a <=> $b } keys(%finals)) {
+	my($call) = $finals{$f}[0];
+	if ($call =~ /\(/) {
+		printf("static void CSFinal%02X() { %s; }\n", $f, $call);
+	}
+}
+print "\n";
+print "static void (* const CSFinals[0x7f - 0x40])() = {\n";
+foreach my $f (0x40..0x7e) {
+	my($func, $comment);
+	if (!defined($finals{$f})) {
+		$func = 'NULL';
+		$comment = chr($f);
+	}
+	else {
+		$func = $finals{$f}[0];
+		$func = sprintf("CSFinal%02X", $f) if ($func =~ /\(/);
+		$comment = chr($f) . ' ' . $finals{$f}[1];
+	}
+	printf("\t%-20s /* %s */\n", "$func,", $comment);
+}
+print "};\n";
+
+# DBCS byte classes
+foreach my $k (@dbcs) {
+	print "\nstatic const BYTE DBCSClass${k}[256] = {\n";
+	foreach my $row (0..15) {
+		print "\t", join(", ", @{$dbcs{$k}}[$row*16..$row*16+15]), ",\n";
+	}
+	print "};\n";
+}
+
+__DATA__
+# byte classes
+class C0	00 1F
+class Inter	20 2F	# intermediate characters
+class Digit	30 39
+class Colon	3A 3A	# sub parameter delimiter
+class Semi	3B 3B	# parameter delimiter
+class Priv	3C 3F	# private parameter characters
+class Final	40 7E
+class DEL	7F 7F
+class C1	80 9F
+class NBSP	A0 A0
+class GR	A1 FF
+
+# ModeESC: EscapeSequence()
+Esc C0		ParseControl
+Esc Inter	EscIntermediate
+Esc Digit	ParseEscape
+Esc Colon	ParseEscape
+Esc Semi	ParseEscape
+Esc Priv	ParseEscape
+Esc Final	ParseEscape
+Esc DEL		IgnoreChar
+Esc C1		ParseControl
+Esc NBSP	EscPrintChar
+Esc GR		EscPrintChar
+
+# ModeCSI: ControlSequence()
+CS C0		ParseControl
+CS Inter	CSIntermediate
+CS Digit	CSParamDigit
+CS Colon	CSSubParamDelim
+CS Semi		CSParamDelim
+CS Priv		CSPrivateChar
+CS Final	ParseCS
+CS DEL		CSIgnoreChar
+CS C1		ParseControl
+CS NBSP		CSIgnoreChar
+CS GR		CSPrintChar
+
+# CSI final characters (no private parameter, no intermediate character)
+# ISO/IEC 6429 / ECMA-48 Sequence
+final @	CSInsertCharacter	ICH
+final A	CSCursorUp(TRUE)	CUU
+final B	CSCursorDown(TRUE)	CUD
+final C	CSCursorRight(TRUE)	CUF
+final D	CSCursorLeft(TRUE)	CUB
+final E	CSCursorDown1		CNL
+final F	CSCursorUp1		CPL
+final G	CSMoveToColumnN		CHA
+final H	CSMoveToXY		CUP
+final I	CSForwardTab		CHT
+final J	CSScreenErase		ED
+final K	CSLineErase		EL
+final L	CSInsertLine		IL
+final M	CSDeleteNLines		DL
+final P	CSDeleteCharacter	DCH
+final S	CSScrollUp		SU
+final T	CSScrollDown		SD
+final X	CSEraseCharacter	ECH
+final Z	CSBackwardTab		CBT
+final `	CSMoveToColumnN		HPA
+final a	CSCursorRight(FALSE)	HPR
+final c	AnswerTerminalType	DA
+final d	CSMoveToLineN		VPA
+final e	CSCursorDown(FALSE)	VPR
+final f	CSMoveToXY		HVP
+final g	CSDeleteTabStop		TBC
+final h	CS_h_Mode		SM
+final i	CS_i_Mode		MC
+final j	CSCursorLeft(FALSE)	HPB
+final k	CSCursorUp(FALSE)	VPB
+final l	CS_l_Mode		RM
+final m	CSSetAttr		SGR
+final n	CS_n_Mode		DSR
+# Private Sequence
+final r	CSSetScrollRegion	DECSTBM
+final s	CS_s_Mode		DECSLRM/SCP
+final t	CSSunSequence		DECSLPP
+final u	RestoreCursor		RCP
+
+# DBCS byte classes: dbcs <kanji code> Single|Lead|Trail <first> <last>
+# Shift_JIS (and CP932 fallback)
+dbcs SJIS Single 20 7E
+dbcs SJIS Lead	81 9F
+dbcs SJIS Lead	E0 FC
+dbcs SJIS Trail	40 FC
+# EUC-JP (JIS X 0208 in G1)
+dbcs EUC Single	20 7E
+dbcs EUC Lead	A1 FE
+dbcs EUC Trail	A1 FE
+# JIS X 0208 invoked into GL (JIS, or ESC $ B in any kanji code)
+dbcs JIS Single	20 20
+dbcs JIS Lead	21 7E
+dbcs JIS Trail	21 7E
+# KS C 5601 / UHC
+dbcs KR Single	20 7E
+dbcs KR Lead	A1 FE
+dbcs KR Trail	41 5A
+dbcs KR Trail	61 7A
+dbcs KR Trail	81 FE
@@ -165,6 +165,10 @@ static BOOL ConvJIS;
 static WORD Kanji;
 static BOOL Fallbacked;
 
+/* UTF-8 decoder state (ParseFirstUTF8) */
+static int UTF8Count = 0;
+static int UTF8CanCombining = 0;
+
 // variables for status line mode
 static int StatusX=0;
 static BOOL StatusWrap=FALSE;
@@ -652,6 +656,76 @@ void PutChar(BYTE b)
 	}
 }
 
+// 󎚉\(0x20-0x7E)̘A PutChar() ƓʂɂȂ悤ɂ܂Ƃ߂ďo͂B
+// s̉E[(E}[W)܂ł1 BuffPutString() ŏ݁A܂Ԃ
+// ʒu̕ PutChar() ɔCB
+static void PutASCIIString(PCHAR s, int len)
+{
+	int LineEnd, n, i;
+
+	while (len > 0) {
+		if (CursorX > CursorRightM)
+			LineEnd = NumOfColumns - 1;
+		else
+			LineEnd = CursorRightM;
+
+		n = LineEnd - CursorX + 1;
+		if (Wrap || n <= 1) {
+			PutChar(*s);
+			s++;
+			len--;
+			continue;
+		}
+		if (n > len) {
+			n = len;
+		}
+
+		if (cv.HLogBuf!=0) {
+			for (i=0; i<n; i++) {
+				Log1Byte(s[i]);
+			}
+		}
+
+		if (Special) {
+			UpdateStr();
+			Special = FALSE;
+		}
+
+		BuffPutString(s, n, CharAttr);
+
+		if (CursorX == CursorRightM || CursorX >= NumOfColumns-1) {
+			UpdateStr();
+			Wrap = AutoWrapMode;
+		}
+		else {
+			MoveRight();
+		}
+
+		s += n;
+		len -= n;
+	}
+}
+
+// 󎚉\̘A PutASCIIString() ł܂Ƃ߂ďĂ悢ԂԂB
+// W̐؂ւ⊿/UTF-8 ̃fR[hrȂǁA1oCgƂ̏
+// Kvȏꍇ FALSE ԂB
+static BOOL CanPutASCIIString()
+{
+	if (PrinterMode || InsertMode || SSflag) {
+		return FALSE;
+	}
+	if (KanjiIn || EUCkanaIn || EUCsupIn) {
+		return FALSE;
+	}
+	if (Gn[Glr[0]] != IdASCII) {
+		return FALSE;
+	}
+	if (UTF8Count != 0 || UTF8CanCombining != 0) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
 void PutDecSp(BYTE b)
 {
 	TCharAttr CharAttrTmp;
@@ -1485,28 +1559,6 @@ void ParseEscape(BYTE b) /* b is the final char */
 	ParseMode = ModeFirst;
 }
 
-void EscapeSequence(BYTE b)
-{
-	if (b<=US)
-		ParseControl(b);
-	else if ((b>=0x20) && (b<=0x2F)) {
-		// TODO: ICount  IntCharMax ɒBAŌ IntChar û͑Ó?
-		if (ICount<IntCharMax)
-			ICount++;
-		IntChar[ICount] = b;
-	}
-	else if ((b>=0x30) && (b<=0x7E))
-		ParseEscape(b);
-	else if ((b>=0x80) && (b<=0x9F))
-		ParseControl(b);
-	else if (b>=0xA0) {
-		ParseMode=ModeFirst;
-		ParseFirst(b);
-	}
-
-	JustAfterESC = FALSE;
-}
-
 #define CheckParamVal(p,m) \
 	if ((p) == 0) { \
 		(p) = 1; \
@@ -3796,6 +3848,111 @@ void PrnParseCS(BYTE b) // printer mode
 	WriteToPrnFile(b,TRUE);
 }
 
+// 䕶ȊO 1 oCgƂ̏ (vtparse.map  EscActions/CSActions Ă΂)
+void IgnoreChar(BYTE b)
+{
+}
+
+void EscIntermediate(BYTE b)
+{
+	// TODO: ICount  IntCharMax ɒBAŌ IntChar û͑Ó?
+	if (ICount<IntCharMax)
+		ICount++;
+	IntChar[ICount] = b;
+}
+
+void EscPrintChar(BYTE b)
+{
+	ParseMode=ModeFirst;
+	ParseFirst(b);
+}
+
+void CSIntermediate(BYTE b)
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+	if (ICount<IntCharMax) ICount++;
+	IntChar[ICount] = b;
+}
+
+#define ParamIncr(p, b) \
+	do { \
+		unsigned int ptmp; \
+		if ((p) != (int)UINT_MAX) { \
+			ptmp = (unsigned int)(p); \
+			if (ptmp > UINT_MAX / 10 || ptmp * 10 > UINT_MAX - (b - 0x30)) { \
+				(p) = (int)UINT_MAX; \
+			} \
+			else { \
+				(p) = (int)(ptmp * 10 + b - 0x30); \
+			} \
+		} \
+	} while (0);
+
+void CSParamDigit(BYTE b) /* parameter value */
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+	if (NSParam[NParam] > 0) {
+		ParamIncr(SubParam[NParam][NSParam[NParam]], b);
+	}
+	else {
+		ParamIncr(Param[NParam], b);
+	}
+}
+
+void CSSubParamDelim(BYTE b) /* ':' Subparameter delimiter */
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+	if (NSParam[NParam] < NSParamMax) {
+		NSParam[NParam]++;
+		SubParam[NParam][NSParam[NParam]] = 0;
+	}
+}
+
+void CSParamDelim(BYTE b) /* ';' Parameter delimiter */
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+	if (NParam < NParamMax) {
+		NParam++;
+		Param[NParam] = 0;
+		NSParam[NParam] = 0;
+	}
+}
+
+void CSPrivateChar(BYTE b) /* private char */
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+	if (FirstPrm) Prv = b;
+}
+
+void CSIgnoreChar(BYTE b)
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+}
+
+void CSPrintChar(BYTE b)
+{
+	if (PrinterMode)
+		WriteToPrnFile(b,FALSE);
+	ParseMode=ModeFirst;
+	ParseFirst(b);
+}
+
+void CS_s_Mode()
+{
+	if (LRMarginMode)
+		CSSetLRScrollRegion();    // DECSLRM
+	else
+		SaveCursor();             // SCP (Save cursor (ANSI.SYS/SCO?))
+}
+
+#include "vtparse.map"
+
 void ParseCS(BYTE b) /* b is the final char */
 {
 	if (PrinterMode) { // printer mode
@@ -3807,66 +3964,8 @@ void ParseCS(BYTE b) /* b is the final char */
 	  case 0: /* no intermediate char */
 		switch (Prv) {
 		  case 0: /* no private parameter */
-			switch (b) {
-			// ISO/IEC 6429 / ECMA-48 Sequence
-			  case '@': CSInsertCharacter(); break;   // ICH
-			  case 'A': CSCursorUp(TRUE); break;      // CUU
-			  case 'B': CSCursorDown(TRUE); break;    // CUD
-			  case 'C': CSCursorRight(TRUE); break;   // CUF
-			  case 'D': CSCursorLeft(TRUE); break;    // CUB
-			  case 'E': CSCursorDown1(); break;       // CNL
-			  case 'F': CSCursorUp1(); break;         // CPL
-			  case 'G': CSMoveToColumnN(); break;     // CHA
-			  case 'H': CSMoveToXY(); break;          // CUP
-			  case 'I': CSForwardTab(); break;        // CHT
-			  case 'J': CSScreenErase(); break;       // ED
-			  case 'K': CSLineErase(); break;         // EL
-			  case 'L': CSInsertLine(); break;        // IL
-			  case 'M': CSDeleteNLines(); break;      // DL
-//			  case 'N': break;                        // EF   -- Not support
-//			  case 'O': break;                        // EA   -- Not support
-			  case 'P': CSDeleteCharacter(); break;   // DCH
-//			  case 'Q': break;                        // SEE  -- Not support
-//			  case 'R': break;                        // CPR  -- Report only, ignore.
-			  case 'S': CSScrollUp(); break;          // SU
-			  case 'T': CSScrollDown(); break;        // SD
-//			  case 'U': break;                        // NP   -- Not support
-//			  case 'V': break;                        // PP   -- Not support
-//			  case 'W': break;                        // CTC  -- Not support
-			  case 'X': CSEraseCharacter(); break;    // ECH
-//			  case 'Y': break;                        // CVT  -- Not support
-			  case 'Z': CSBackwardTab(); break;       // CBT
-//			  case '[': break;                        // SRS  -- Not support
-//			  case '\\': break;                       // PTX  -- Not support
-//			  case ']': break;                        // SDS  -- Not support
-//			  case '^': break;                        // SIMD -- Not support
-			  case '`': CSMoveToColumnN(); break;     // HPA
-			  case 'a': CSCursorRight(FALSE); break;  // HPR
-//			  case 'b': break;                        // REP  -- Not support
-			  case 'c': AnswerTerminalType(); break;  // DA
-			  case 'd': CSMoveToLineN(); break;       // VPA
-			  case 'e': CSCursorDown(FALSE); break;   // VPR
-			  case 'f': CSMoveToXY(); break;          // HVP
-			  case 'g': CSDeleteTabStop(); break;     // TBC
-			  case 'h': CS_h_Mode(); break;           // SM
-			  case 'i': CS_i_Mode(); break;           // MC
-			  case 'j': CSCursorLeft(FALSE); break;   // HPB
-			  case 'k': CSCursorUp(FALSE); break;     // VPB
-			  case 'l': CS_l_Mode(); break;           // RM
-			  case 'm': CSSetAttr(); break;           // SGR
-			  case 'n': CS_n_Mode(); break;           // DSR
-//			  case 'o': break;                        // DAQ  -- Not support
-
-			// Private Sequence
-			  case 'r': CSSetScrollRegion(); break;   // DECSTBM
-			  case 's':
-				if (LRMarginMode)
-					CSSetLRScrollRegion();    // DECSLRM
-				else
-					SaveCursor();             // SCP (Save cursor (ANSI.SYS/SCO?))
-				break;
-			  case 't': CSSunSequence(); break;       // DECSLPP / Window manipulation(dtterm?)
-			  case 'u': RestoreCursor(); break;       // RCP (Restore cursor (ANSI.SYS/SCO))
+			if (CSFinals[b - 0x40] != NULL) {
+				(*CSFinals[b - 0x40])();
 			}
 			break; /* end of case Prv=0 */
 		  case '<': CSLT(b); break;    /* private parameter = '<' */
@@ -3899,62 +3998,15 @@ void ParseCS(BYTE b) /* b is the final char */
 	ParseMode = ModeFirst;
 }
 
-void ControlSequence(BYTE b)
+void EscapeSequence(BYTE b)
 {
-	if ((b<=US) || (b>=0x80) && (b<=0x9F))
-		ParseControl(b); /* ctrl char */
-	else if ((b>=0x40) && (b<=0x7E))
-		ParseCS(b); /* terminate char */
-	else {
-		if (PrinterMode)
-			WriteToPrnFile(b,FALSE);
+	(*EscActions[VTByteClass[b]])(b);
+	JustAfterESC = FALSE;
+}
 
-		if ((b>=0x20) && (b<=0x2F)) { /* intermediate char */
-			if (ICount<IntCharMax) ICount++;
-			IntChar[ICount] = b;
-		}
-		else if ((b>=0x30) && (b<=0x39)) { /* parameter value */
-#define ParamIncr(p, b) \
-	do { \
-		unsigned int ptmp; \
-		if ((p) != (int)UINT_MAX) { \
-			ptmp = (unsigned int)(p); \
-			if (ptmp > UINT_MAX / 10 || ptmp * 10 > UINT_MAX - (b - 0x30)) { \
-				(p) = (int)UINT_MAX; \
-			} \
-			else { \
-				(p) = (int)(ptmp * 10 + b - 0x30); \
-			} \
-		} \
-	} while (0);
-			if (NSParam[NParam] > 0) {
-				ParamIncr(SubParam[NParam][NSParam[NParam]], b);
-			}
-			else {
-				ParamIncr(Param[NParam], b);
-			}
-		}
-		else if (b==0x3A) { /* ':' Subparameter delimiter */
-			if (NSParam[NParam] < NSParamMax) {
-				NSParam[NParam]++;
-				SubParam[NParam][NSParam[NParam]] = 0;
-			}
-		}
-		else if (b==0x3B) { /* ';' Parameter delimiter */
-			if (NParam < NParamMax) {
-				NParam++;
-				Param[NParam] = 0;
-				NSParam[NParam] = 0;
-			}
-		}
-		else if ((b>=0x3C) && (b<=0x3F)) { /* private char */
-			if (FirstPrm) Prv = b;
-		}
-		else if (b>0xA0) {
-			ParseMode=ModeFirst;
-			ParseFirst(b);
-		}
-	}
+void ControlSequence(BYTE b)
+{
+	(*CSActions[VTByteClass[b]])(b);
 	FirstPrm = FALSE;
 }
 
@@ -5384,13 +5436,31 @@ int GetIndexOfCombiningFirstCode(unsigned short code, combining_map_t *table, in
 }
 
 
-static void UnicodeToCP932(unsigned int code)
+// Unicode -> CP932 ̕ϊʂ̃LbV
+//   ϊɎg wctomb() ̓P[̐ݒ肪KvŒx߁A1ƂɌʂoĂB
+//   P[ DEC ꕶւ̊蓖Đݒ肪ς蒼B
+//   l 0 ϊA0x8140 ȏオ2oCgAȊO͈ȉ̂ƂB
+#define UniCacheChar    0x0100	// 1oCg (ʃoCg)
+#define UniCacheDecSp   0x0200	// DEC ꕶ (ʃoCg)
+#define UniCacheUnknown 0x0300	// ϊłȂ
+#define UniCacheKanji0  0x0400	// ϊ\1oCg̒l (ʃoCg)
+static WORD UniCache[0x10000];
+static BOOL UniCacheValid = FALSE;
+static char UniCacheLocale[sizeof(ts.Locale)];
+static WORD UniCacheDecSpMapping;
+
+static WORD ConvUnicodeToCP932(unsigned int code)
 {
 	int ret;
 	char mbchar[32];
 	unsigned char wchar[32];
 	unsigned short cset = 0;
 
+	if (code >= 0x10000) {
+		// CP932 ɂȂ
+		return UniCacheUnknown;
+	}
+
 	wchar[0] = code & 0xff;
 	wchar[1] = (code >> 8) & 0xff;
 
@@ -5398,38 +5468,81 @@ static void UnicodeToCP932(unsigned int code)
 		cset = ConvertUnicode(code, mapUnicodeSymbolToDecSp, MAPSIZE(mapUnicodeSymbolToDecSp));
 	}
 	if (((cset >> 8) & ts.UnicodeDecSpMapping) != 0) {
-		PutDecSp(cset & 0xff);
-	}
-	else {
-		// Unicode -> CP932
-		ret = wctomb(mbchar, ((wchar_t *)wchar)[0]);
-		switch (ret) {
-		  case -1:
-			if (_stricmp(ts.Locale, DEFAULT_LOCALE) == 0) {
-				// U+301CȂǂ͕ϊłȂBUnicode -> Shift_JIS֕ϊĂ݂B
-				cset = ConvertUnicode(code, mapUnicodeToSJIS, MAPSIZE(mapUnicodeToSJIS));
-				if (cset != 0) {
-					Kanji = cset & 0xff00;
-					PutKanji(cset & 0x00ff);
+		return UniCacheDecSp | (cset & 0xff);
+	}
+
+	// Unicode -> CP932
+	setlocale(LC_ALL, ts.Locale);
+	ret = wctomb(mbchar, ((wchar_t *)wchar)[0]);
+	switch (ret) {
+	  case -1:
+		if (_stricmp(ts.Locale, DEFAULT_LOCALE) == 0) {
+			// U+301CȂǂ͕ϊłȂBUnicode -> Shift_JIS֕ϊĂ݂B
+			cset = ConvertUnicode(code, mapUnicodeToSJIS, MAPSIZE(mapUnicodeToSJIS));
+			if (cset != 0) {
+				if ((cset & 0xff00) == 0) {
+					return UniCacheKanji0 | cset;
 				}
+				return cset;
 			}
+		}
+		return UniCacheUnknown;
+	  case 1:
+		return UniCacheChar | (BYTE)mbchar[0];
+	  default:
+		return ((BYTE)mbchar[0] << 8) | (BYTE)mbchar[1];
+	}
+}
 
-			if (cset == 0) {
-				PutChar('?');
-				if (ts.UnknownUnicodeCharaAsWide) {
-					PutChar('?');
-				}
-			}
-			break;
-		  case 1:
-			PutChar(mbchar[0]);
-			break;
-		  default:
-			Kanji = mbchar[0] << 8;
-			PutKanji(mbchar[1]);
-			break;
+static void UnicodeToCP932(unsigned int code)
+{
+	WORD w;
+
+	if (!UniCacheValid ||
+	    ts.UnicodeDecSpMapping != UniCacheDecSpMapping ||
+	    strcmp(ts.Locale, UniCacheLocale) != 0) {
+		memset(UniCache, 0, sizeof(UniCache));
+		strncpy_s(UniCacheLocale, sizeof(UniCacheLocale), ts.Locale, _TRUNCATE);
+		UniCacheDecSpMapping = ts.UnicodeDecSpMapping;
+		UniCacheValid = TRUE;
+	}
+
+	if (code < 0x10000) {
+		w = UniCache[code];
+		if (w == 0) {
+			w = UniCache[code] = ConvUnicodeToCP932(code);
 		}
 	}
+	else {
+		w = ConvUnicodeToCP932(code);
+	}
+
+	// ʂɂ CP932 ŏARs[pɌ̕ʒuZɎc
+	BuffSetUnicode(code);
+	switch (w & 0xff00) {
+	  case UniCacheChar:
+		PutChar(w & 0xff);
+		break;
+	  case UniCacheDecSp:
+		PutDecSp(w & 0xff);
+		break;
+	  case UniCacheUnknown:
+		PutChar('?');
+		if (ts.UnknownUnicodeCharaAsWide) {
+			BuffSetUnicode(UniContinued);
+			PutChar('?');
+		}
+		break;
+	  case UniCacheKanji0:
+		Kanji = 0;
+		PutKanji(w & 0xff);
+		break;
+	  default:
+		Kanji = w & 0xff00;
+		PutKanji(w & 0xff);
+		break;
+	}
+	BuffSetUnicode(0);
 }
 
 // UTF-8ŎMf[^
@@ -5437,43 +5550,38 @@ BOOL ParseFirstUTF8(BYTE b, int proc_combining)
 // returns TRUE if b is processed
 //  (actually allways returns TRUE)
 {
-	static BYTE buf[3];
-	static int count = 0;
-	static int can_combining = 0;
+	static BYTE buf[4];
 	static unsigned int first_code;
 	static int first_code_index;
 
 	unsigned int code;
 	unsigned short cset;
-	char *locptr;
-
-	locptr = setlocale(LC_ALL, ts.Locale);
 
 	if (ts.FallbackToCP932 && Fallbacked) {
 		return ParseFirstJP(b);
 	}
 
-	if ((b & 0x80) != 0x80 || ((b & 0xe0) == 0x80 && count == 0)) {
+	if ((b & 0x80) != 0x80 || ((b & 0xe0) == 0x80 && UTF8Count == 0)) {
 		// 1oCgڂ2oCgڂASCIȈꍇ́AׂASCIIo͂ƂB
 		// 1oCgڂC1䕶(0x80-0x9f)̏ꍇlB
-		if (count == 0 || count == 1) {
-			if (proc_combining == 1 && can_combining == 1) {
+		if (UTF8Count == 0 || UTF8Count == 1) {
+			if (proc_combining == 1 && UTF8CanCombining == 1) {
 				UnicodeToCP932(first_code);
-				can_combining = 0;
+				UTF8CanCombining = 0;
 			}
 
-			if (count == 1) {
+			if (UTF8Count == 1) {
 				ParseASCII(buf[0]);
 			}
 			ParseASCII(b);
 
-			count = 0;  // reset counter
+			UTF8Count = 0;  // reset counter
 			return TRUE;
 		}
 	}
 
-	buf[count++] = b;
-	if (count < 2) {
+	buf[UTF8Count++] = b;
+	if (UTF8Count < 2) {
 		return TRUE;
 	}
 
@@ -5481,9 +5589,9 @@ BOOL ParseFirstUTF8(BYTE b, int proc_combining)
 	if ((buf[0] & 0xe0) == 0xc0) {
 		if ((buf[1] & 0xc0) == 0x80) {
 
-			if (proc_combining == 1 && can_combining == 1) {
+			if (proc_combining == 1 && UTF8CanCombining == 1) {
 				UnicodeToCP932(first_code);
-				can_combining = 0;
+				UTF8CanCombining = 0;
 			}
 
 			code = ((buf[0] & 0x1f) << 6);
@@ -5495,15 +5603,44 @@ BOOL ParseFirstUTF8(BYTE b, int proc_combining)
 			ParseASCII(buf[0]);
 			ParseASCII(buf[1]);
 		}
-		count = 0;
+		UTF8Count = 0;
 		return TRUE;
 	}
 
-	if (count < 3) {
+	if (UTF8Count < 3) {
+		return TRUE;
+	}
+
+	if ((buf[0] & 0xf8) == 0xf0 &&
+		(buf[1] & 0xc0) == 0x80 &&
+		(buf[2] & 0xc0) == 0x80) { // 4oCgR[h̏ꍇ
+		if (UTF8Count < 4) {
+			return TRUE;
+		}
+
+		code = ((buf[0] & 0x07) << 18);
+		code |= ((buf[1] & 0x3f) << 12);
+		code |= ((buf[2] & 0x3f) << 6);
+		code |= ((buf[3] & 0x3f));
+
+		if ((buf[3] & 0xc0) == 0x80 && code <= 0x10ffff) {
+			if (proc_combining == 1 && UTF8CanCombining == 1) {
+				UnicodeToCP932(first_code);
+				UTF8CanCombining = 0;
+			}
+			UnicodeToCP932(code);
+		}
+		else {
+			ParseASCII(buf[0]);
+			ParseASCII(buf[1]);
+			ParseASCII(buf[2]);
+			ParseASCII(buf[3]);
+		}
+		UTF8Count = 0;
 		return TRUE;
 	}
 
-	if ((buf[0] & 0xe0) == 0xe0 &&
+	if ((buf[0] & 0xf0) == 0xe0 &&
 		(buf[1] & 0xc0) == 0x80 &&
 		(buf[2] & 0xc0) == 0x80) { // 3oCgR[h̏ꍇ
 
@@ -5517,17 +5654,17 @@ BOOL ParseFirstUTF8(BYTE b, int proc_combining)
 		code |= ((buf[2] & 0x3f));
 
 		if (proc_combining == 1) {
-			if (can_combining == 0) {
+			if (UTF8CanCombining == 0) {
 				if ((first_code_index = GetIndexOfCombiningFirstCode(
 						code, mapCombiningToPrecomposed, MAPSIZE(mapCombiningToPrecomposed)
 						)) != -1) {
-					can_combining = 1;
+					UTF8CanCombining = 1;
 					first_code = code;
-					count = 0;
+					UTF8Count = 0;
 					return (TRUE);
 				}
 			} else {
-				can_combining = 0;
+				UTF8CanCombining = 0;
 				cset = GetPrecomposedChar(first_code_index, first_code, code, mapCombiningToPrecomposed, MAPSIZE(mapCombiningToPrecomposed));
 				if (cset != 0) { // success
 					code = cset;
@@ -5541,15 +5678,15 @@ BOOL ParseFirstUTF8(BYTE b, int proc_combining)
 						// 1߂͂̂̕܂܏o͂
 						UnicodeToCP932(first_code);
 
-						can_combining = 1;
+						UTF8CanCombining = 1;
 						first_code = code;
-						count = 0;
+						UTF8Count = 0;
 						return (TRUE);
 					}
 
 					UnicodeToCP932(first_code);
 					UnicodeToCP932(code);
-					count = 0;
+					UTF8Count = 0;
 					return (TRUE);
 				}
 			}
@@ -5558,19 +5695,198 @@ BOOL ParseFirstUTF8(BYTE b, int proc_combining)
 		UnicodeToCP932(code);
 
 skip:
-		count = 0;
+		UTF8Count = 0;
 
 	} else {
 		ParseASCII(buf[0]);
 		ParseASCII(buf[1]);
 		ParseASCII(buf[2]);
-		count = 0;
+		UTF8Count = 0;
 
 	}
 
 	return TRUE;
 }
 
+// UTF-8 ̕ CommReadUTF8Run() ł܂Ƃ߂ĎoďĂ悢ԂԂB
+// ̏ CP932 ւ̃tH[obN ParseFirstUTF8() ɔCB
+static BOOL CanPutUTF8String()
+{
+	switch (ts.Language) {
+	  case IdUtf8:
+		if (ts.KanjiCode == IdUTF8m) {
+			return FALSE;
+		}
+		break;
+	  case IdJapanese:
+	  case IdKorean:
+		if (ts.KanjiCode != IdUTF8) {
+			return FALSE;
+		}
+		break;
+	  default:
+		return FALSE;
+	}
+	if (ts.FallbackToCP932 && Fallbacked) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// CommReadUTF8Run() Ŏo ParseFirstUTF8() ƓʂɂȂ悤ɏo͂B
+// ASCII ̘A PutASCIIString() ɂ܂Ƃ߂ēnB
+static void PutUTF8String(LPBYTE s, int len)
+{
+	int n;
+	unsigned int code;
+
+	while (len > 0) {
+		for (n = 0; n < len && s[n] < 0x80; n++)
+			;
+		if (n > 0) {
+			PutASCIIString((PCHAR)s, n);
+		}
+		else if (s[0] < 0xe0) {
+			code = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
+			UnicodeToCP932(code);
+			n = 2;
+		}
+		else {
+			code = ((s[0] & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+			UnicodeToCP932(code);
+			n = 3;
+		}
+		s += n;
+		len -= n;
+	}
+}
+
+// R[h(SJIS/EUC/JIS/KS5601)̎M CommReadDBCSRun() ł܂Ƃ߂
+// oƂ̃oCg(vtparse.map)ԂB
+// 1oCgƂ̏KvȏԂȂ NULL ԂB
+static const BYTE *DBCSRunClass()
+{
+	if (PrinterMode || InsertMode || SSflag) {
+		return NULL;
+	}
+	if (KanjiIn || EUCkanaIn || EUCsupIn) {
+		return NULL;
+	}
+
+	switch (ts.Language) {
+	  case IdJapanese:
+		if (ts.KanjiCode != IdSJIS && ts.KanjiCode != IdEUC && ts.KanjiCode != IdJIS) {
+			return NULL;
+		}
+		if (Gn[Glr[0]] == IdKanji) {
+			return DBCSClassJIS;
+		}
+		if (Gn[Glr[0]] != IdASCII) {
+			return NULL;
+		}
+		if (ts.KanjiCode == IdSJIS) {
+			return DBCSClassSJIS;
+		}
+		if (ts.KanjiCode == IdEUC) {
+			return DBCSClassEUC;
+		}
+		return NULL;
+	  case IdKorean:
+		if (ts.KanjiCode == IdSJIS && Gn[Glr[0]] == IdASCII) {
+			return DBCSClassKR;
+		}
+		return NULL;
+	}
+	return NULL;
+}
+
+// 2 oCg count  PutKanji() ƓʂɂȂ悤ɏo͂B
+// s̉E[(E}[W)܂ł1 BuffPutKanjiString() ŏ݁A܂Ԃ
+// ʒu̕ PutKanji() ɔCB
+//   Conv: JIS X 0208 ̕ SJIS ɕϊ
+static void PutKanjiString(LPBYTE s, int count, BOOL Conv)
+{
+	WORD buff[TermWidthMax / 2];
+	int LineEnd, n, i;
+
+	while (count > 0) {
+		if (CursorX > CursorRightM)
+			LineEnd = NumOfColumns - 1;
+		else
+			LineEnd = CursorRightM;
+
+		n = (LineEnd - CursorX + 1) / 2;
+		if (Wrap || n < 1) {
+			Kanji = s[0] << 8;
+			ConvJIS = Conv;
+			PutKanji(s[1]);
+			s += 2;
+			count--;
+			continue;
+		}
+		if (n > count) {
+			n = count;
+		}
+
+		for (i=0; i<n; i++) {
+			Kanji = (s[i*2] << 8) | s[i*2+1];
+			if (Conv) {
+				Kanji = JIS2SJIS((WORD)(Kanji & 0x7f7f));
+			}
+			buff[i] = Kanji;
+			if (cv.HLogBuf!=0) {
+				Log1Byte(HIBYTE(Kanji));
+				Log1Byte(LOBYTE(Kanji));
+			}
+		}
+
+		if (Special) {
+			UpdateStr();
+			Special = FALSE;
+		}
+
+		BuffPutKanjiString(buff, n, CharAttr);
+
+		if (CursorX < LineEnd - 1) {
+			MoveRight();
+			MoveRight();
+		}
+		else {
+			UpdateStr();
+			Wrap = AutoWrapMode;
+		}
+
+		s += n * 2;
+		count -= n;
+	}
+}
+
+// CommReadDBCSRun() Ŏo ParseFirstJP()/ParseFirstKR() ƓʂɂȂ悤ɏo͂B
+//   Class: DBCSRunClass() ̕ԂoCg
+static void PutDBCSString(LPBYTE s, int len, const BYTE *Class)
+{
+	int n;
+
+	while (len > 0) {
+		for (n = 0; n < len && (Class[s[n]] & DBCSSingle); n++)
+			;
+		if (n > 0) {
+			PutASCIIString((PCHAR)s, n);
+		}
+		else {
+			// soCg 1 oCgƏdȂȂ̂ŁA2 oCgׂ΂悢
+			for (n = 0; n < len && !(Class[s[n]] & DBCSSingle); n += 2)
+				;
+			if (Class == DBCSClassSJIS) {
+				Fallbacked = TRUE;
+			}
+			PutKanjiString(s, n / 2, Class == DBCSClassEUC || Class == DBCSClassJIS);
+		}
+		s += n;
+		len -= n;
+	}
+}
+
 
 BOOL ParseFirstRus(BYTE b)
 // returns if b is processed
@@ -5652,6 +5968,20 @@ void ParseFirst(BYTE b)
 		PutChar(b);
 }
 
+// ParseMode Ƃ 1 oCg̏
+static void (* const ParseModeActions[ModeIgnore+1])(BYTE b) = {
+	ParseFirst,	// ModeFirst
+	EscapeSequence,	// ModeESC
+	DeviceControl,	// ModeDCS
+	DCUserKey,	// ModeDCUserKey
+	IgnoreString,	// ModeSOS
+	ControlSequence,	// ModeCSI
+	XSequence,	// ModeXS
+	DLESeen,	// ModeDLE
+	CANSeen,	// ModeCAN
+	IgnoreString,	// ModeIgnore
+};
+
 int VTParse()
 {
 	BYTE b;
@@ -5659,7 +5989,19 @@ int VTParse()
 
 	c = CommRead1Byte(&cv,&b);
 
-	if (c==0) return 0;
+	if (c==0) {
+		// Mr؂ꂽA`҂Ă镶ׂĕ`悷
+		if (BuffRenderPending()) {
+			CaretOff();
+			DispInitDC();
+			LockBuffer();
+			BuffRenderFrame(TRUE);
+			UnlockBuffer();
+			DispReleaseDC();
+			CaretOn();
+		}
+		return 0;
+	}
 
 	CaretOff();
 	UpdateCaretPosition(FALSE);	// ANeBȕꍇ̂ݍĕ`悷
@@ -5675,50 +6017,51 @@ int VTParse()
 		if (DebugFlag!=DEBUG_FLAG_NONE)
 			PutDebugChar(b);
 		else {
-			switch (ParseMode) {
-			case ModeFirst:
-				ParseFirst(b);
-				break;
-			case ModeESC:
-				EscapeSequence(b);
-				break;
-			case ModeDCS:
-				DeviceControl(b);
-				break;
-			case ModeDCUserKey:
-				DCUserKey(b);
-				break;
-			case ModeSOS:
-				IgnoreString(b);
-				break;
-			case ModeCSI:
-				ControlSequence(b);
-				break;
-			case ModeXS:
-				XSequence(b);
-				break;
-			case ModeDLE:
-				DLESeen(b);
-				break;
-			case ModeCAN:
-				CANSeen(b);
-				break;
-			case ModeIgnore:
-				IgnoreString(b);
-				break;
-			default:
+			if (ParseMode > ModeIgnore) {
 				ParseMode = ModeFirst;
-				ParseFirst(b);
 			}
+			(*ParseModeActions[ParseMode])(b);
 		}
 
 		PrevCharacter = b;		// memorize previous character for AUTO CR/LF-receive mode
 
-		if (ChangeEmu==0)
+		if (ChangeEmu==0) {
+			// 󎚉\ꍇ́A1oCgł͂Ȃ܂Ƃ߂ďo͂
+			if ((ParseMode==ModeFirst) && (DebugFlag==DEBUG_FLAG_NONE)) {
+				LPBYTE run;
+				int len = 0;
+				const BYTE *Class;
+				if ((Class = DBCSRunClass()) != NULL) {
+					len = CommReadDBCSRun(&cv, &run, Class);
+					if (len > 0) {
+						PutDBCSString(run, len, Class);
+					}
+				}
+				else if (CanPutASCIIString()) {
+					if (CanPutUTF8String()) {
+						len = CommReadUTF8Run(&cv, &run);
+						if (len > 0) {
+							PutUTF8String(run, len);
+						}
+					}
+					else {
+						len = CommReadPrintableRun(&cv, &run);
+						if (len > 0) {
+							PutASCIIString((PCHAR)run, len);
+						}
+					}
+				}
+				if (len > 0) {
+					PrevCharacter = run[len-1];
+				}
+			}
 			c = CommRead1Byte(&cv,&b);
+		}
 	}
 
 	BuffUpdateScroll();
+	// M̕`̓t[Pʂɂ܂Ƃ߂
+	BuffRenderFrame(ChangeEmu > 0 || cv.ProtoFlag);
 
 	BuffSetCaretWidth();
 	UnlockBuffer();
@@ -103,6 +103,7 @@ static char THIS_FILE[] = __FILE__;
 
 static HFONT DlgBroadcastFont;
 static HFONT DlgCommentFont;
+static HFONT DlgFindBuffFont;
 static HFONT DlgSetupdirFont;
 
 static BOOL TCPLocalEchoUsed = FALSE;
@@ -223,6 +224,7 @@ BEGIN_MESSAGE_MAP(CVTWindow, CFrameWnd)
 	ON_COMMAND(ID_EDIT_CLEARBUFFER, OnEditClearBuffer)
 	ON_COMMAND(ID_EDIT_CANCELSELECT, OnEditCancelSelection)
 	ON_COMMAND(ID_EDIT_SELECTALL, OnEditSelectAllBuffer)
+	ON_COMMAND(ID_EDIT_FINDBUFF, OnEditFindBuffer)
 	ON_COMMAND(ID_EDIT_SELECTSCREEN, OnEditSelectScreenBuffer)
 	ON_COMMAND(ID_SETUP_ADDITIONALSETTINGS, OnExternalSetup)
 	ON_COMMAND(ID_SETUP_TERMINAL, OnSetupTerminal)
@@ -1334,6 +1336,9 @@ void CVTWindow::InitMenu(HMENU *Menu)
 	GetMenuString(EditMenu, ID_EDIT_SELECTALL, uimsg, sizeof(uimsg), MF_BYCOMMAND);
 	get_lang_msg("MENU_EDIT_SELECTALL", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
 	ModifyMenu(EditMenu, ID_EDIT_SELECTALL, MF_BYCOMMAND, ID_EDIT_SELECTALL, ts.UIMsg);
+	GetMenuString(EditMenu, ID_EDIT_FINDBUFF, uimsg, sizeof(uimsg), MF_BYCOMMAND);
+	get_lang_msg("MENU_EDIT_FINDBUFF", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+	ModifyMenu(EditMenu, ID_EDIT_FINDBUFF, MF_BYCOMMAND, ID_EDIT_FINDBUFF, ts.UIMsg);
 
 	GetMenuString(*Menu, ID_SETUP, uimsg, sizeof(uimsg), MF_BYPOSITION);
 	get_lang_msg("MENU_SETUP", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
@@ -4494,6 +4499,113 @@ void CVTWindow::OnEditSelectAllBuffer()
 	ChangeSelectRegion();
 }
 
+// XN[obt@̌
+//   ƃIvV͎ɊJƂ̂߂ɊoĂ
+static char FindBuffStr[256];
+static int FindBuffFlags = BuffSearchIgnoreCase;
+
+static LRESULT CALLBACK OnFindBuffDlgProc(HWND hDlgWnd, UINT msg, WPARAM wp, LPARAM lp)
+{
+	LOGFONT logfont;
+	HFONT font;
+	char uimsg[MAX_UIMSG];
+	int Flags;
+
+	switch (msg) {
+		case WM_INITDIALOG:
+			font = (HFONT)SendMessage(hDlgWnd, WM_GETFONT, 0, 0);
+			GetObject(font, sizeof(LOGFONT), &logfont);
+			if (get_lang_font("DLG_SYSTEM_FONT", hDlgWnd, &logfont, &DlgFindBuffFont, ts.UILanguageFile)) {
+				SendDlgItemMessage(hDlgWnd, IDC_FINDBUFF_EDIT, WM_SETFONT, (WPARAM)DlgFindBuffFont, MAKELPARAM(TRUE,0));
+				SendDlgItemMessage(hDlgWnd, IDC_FINDBUFF_REGEX, WM_SETFONT, (WPARAM)DlgFindBuffFont, MAKELPARAM(TRUE,0));
+				SendDlgItemMessage(hDlgWnd, IDC_FINDBUFF_CASE, WM_SETFONT, (WPARAM)DlgFindBuffFont, MAKELPARAM(TRUE,0));
+				SendDlgItemMessage(hDlgWnd, IDOK, WM_SETFONT, (WPARAM)DlgFindBuffFont, MAKELPARAM(TRUE,0));
+				SendDlgItemMessage(hDlgWnd, IDC_FINDBUFF_PREV, WM_SETFONT, (WPARAM)DlgFindBuffFont, MAKELPARAM(TRUE,0));
+				SendDlgItemMessage(hDlgWnd, IDCANCEL, WM_SETFONT, (WPARAM)DlgFindBuffFont, MAKELPARAM(TRUE,0));
+			}
+			else {
+				DlgFindBuffFont = NULL;
+			}
+
+			GetWindowText(hDlgWnd, uimsg, sizeof(uimsg));
+			get_lang_msg("DLG_FINDBUFF_TITLE", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+			SetWindowText(hDlgWnd, ts.UIMsg);
+			GetDlgItemText(hDlgWnd, IDC_FINDBUFF_REGEX, uimsg, sizeof(uimsg));
+			get_lang_msg("DLG_FINDBUFF_REGEX", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+			SetDlgItemText(hDlgWnd, IDC_FINDBUFF_REGEX, ts.UIMsg);
+			GetDlgItemText(hDlgWnd, IDC_FINDBUFF_CASE, uimsg, sizeof(uimsg));
+			get_lang_msg("DLG_FINDBUFF_CASE", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+			SetDlgItemText(hDlgWnd, IDC_FINDBUFF_CASE, ts.UIMsg);
+			GetDlgItemText(hDlgWnd, IDOK, uimsg, sizeof(uimsg));
+			get_lang_msg("DLG_FINDBUFF_NEXT", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+			SetDlgItemText(hDlgWnd, IDOK, ts.UIMsg);
+			GetDlgItemText(hDlgWnd, IDC_FINDBUFF_PREV, uimsg, sizeof(uimsg));
+			get_lang_msg("DLG_FINDBUFF_PREV", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+			SetDlgItemText(hDlgWnd, IDC_FINDBUFF_PREV, ts.UIMsg);
+			GetDlgItemText(hDlgWnd, IDCANCEL, uimsg, sizeof(uimsg));
+			get_lang_msg("BTN_CLOSE", ts.UIMsg, sizeof(ts.UIMsg), uimsg, ts.UILanguageFile);
+			SetDlgItemText(hDlgWnd, IDCANCEL, ts.UIMsg);
+
+			SetDlgItemText(hDlgWnd, IDC_FINDBUFF_EDIT, FindBuffStr);
+			SendDlgItemMessage(hDlgWnd, IDC_FINDBUFF_EDIT, EM_SETSEL, 0, -1);
+			CheckDlgButton(hDlgWnd, IDC_FINDBUFF_REGEX,
+			               (FindBuffFlags & BuffSearchRegex) ? BST_CHECKED : BST_UNCHECKED);
+			CheckDlgButton(hDlgWnd, IDC_FINDBUFF_CASE,
+			               (FindBuffFlags & BuffSearchIgnoreCase) ? BST_UNCHECKED : BST_CHECKED);
+			SetFocus(GetDlgItem(hDlgWnd, IDC_FINDBUFF_EDIT));
+
+			return FALSE;
+
+		case WM_COMMAND:
+			switch (LOWORD(wp)) {
+				case IDOK:
+				case IDC_FINDBUFF_PREV:
+					GetDlgItemText(hDlgWnd, IDC_FINDBUFF_EDIT, FindBuffStr, sizeof(FindBuffStr));
+					Flags = 0;
+					if (IsDlgButtonChecked(hDlgWnd, IDC_FINDBUFF_REGEX) == BST_CHECKED) {
+						Flags |= BuffSearchRegex;
+					}
+					if (IsDlgButtonChecked(hDlgWnd, IDC_FINDBUFF_CASE) != BST_CHECKED) {
+						Flags |= BuffSearchIgnoreCase;
+					}
+					FindBuffFlags = Flags;
+					if (LOWORD(wp) == IDC_FINDBUFF_PREV) {
+						Flags |= BuffSearchBackward;
+					}
+					if (FindBuffStr[0] != 0 && ! BuffSearchNext(FindBuffStr, Flags)) {
+						MessageBeep(0);
+					}
+					return TRUE;
+
+				case IDCANCEL:
+					if (DlgFindBuffFont != NULL) {
+						DeleteObject(DlgFindBuffFont);
+					}
+					EndDialog(hDlgWnd, IDCANCEL);
+					return TRUE;
+
+				default:
+					return FALSE;
+			}
+
+		case WM_CLOSE:
+			if (DlgFindBuffFont != NULL) {
+				DeleteObject(DlgFindBuffFont);
+			}
+			EndDialog(hDlgWnd, 0);
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+void CVTWindow::OnEditFindBuffer()
+{
+	DialogBox(hInst, MAKEINTRESOURCE(IDD_FINDBUFF_DIALOG),
+	          HVTWin, (DLGPROC)OnFindBuffDlgProc);
+}
+
 void CVTWindow::OnEditSelectScreenBuffer()
 {
 	// Select screen buffer
@@ -190,6 +190,7 @@ protected:
 	afx_msg void OnEditCancelSelection();
 	afx_msg void OnEditSelectScreenBuffer();
 	afx_msg void OnEditSelectAllBuffer();
+	afx_msg void OnEditFindBuffer();
 	afx_msg void OnSetupTerminal();
 	afx_msg void OnSetupWindow();
 	afx_msg void OnSetupFont();
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* TTCMN.DLL, length of character runs for CommRead*Run() */
+#include "teraterm.h"
+#include "tttypes.h"
+#include "ttcommon.h"
+#include <string.h>
+
+#include "charrun.h"
+
+// 4oCg(DWORD) n  / n 傫oCg܂܂邩𔻒肷 (n <= 0x80)
+#define DwordHasLess(x, n) (((x) - 0x01010101UL * (n)) & ~(x) & 0x80808080UL)
+#define DwordHasMore(x, n) ((((x) + 0x01010101UL * (127 - (n))) | (x)) & 0x80808080UL)
+
+// p 瑱󎚉\(0x20-0x7E)̒Ԃ
+int PrintableLength(const BYTE *p, int len)
+{
+	int i = 0;
+	DWORD w;
+
+	// 4oCg܂Ƃ߂ĒׁA͈͊ÕoCg܂ތꂪ1oCgׂ
+	while (i + 4 <= len) {
+		memcpy(&w, &p[i], sizeof(w));
+		if (DwordHasLess(w, 0x20) || DwordHasMore(w, 0x7e)) {
+			break;
+		}
+		i += 4;
+	}
+	while (i < len && p[i] >= 0x20 && p[i] <= 0x7e) {
+		i++;
+	}
+	return i;
+}
+
+#define IsUTF8Trail(b) (((b) & 0xc0) == 0x80)
+
+// p 瑱A󎚉\Ɗ UTF-8  2/3 oCg̒Ԃ
+//   璷 2 oCg\(C0/C1)A4 oCgȏ̕ABOM(EF BB BF)A
+//   rŐ؂Ă镶̎OŎ~܂
+int UTF8Length(const BYTE *p, int len)
+{
+	int i = 0;
+	BYTE b;
+
+	while (i < len) {
+		i += PrintableLength(&p[i], len - i);
+		if (i >= len) {
+			break;
+		}
+		b = p[i];
+		if (b >= 0xc2 && b <= 0xdf) {
+			if (i + 1 >= len || !IsUTF8Trail(p[i+1])) {
+				break;
+			}
+			i += 2;
+		}
+		else if (b >= 0xe0 && b <= 0xef) {
+			if (i + 2 >= len || !IsUTF8Trail(p[i+1]) || !IsUTF8Trail(p[i+2])) {
+				break;
+			}
+			if (b == 0xef && p[i+1] == 0xbb && p[i+2] == 0xbf) {
+				break;
+			}
+			i += 3;
+		}
+		else {
+			break;
+		}
+	}
+	return i;
+}
+
+// Class  DBCSSingle ̕ƁADBCSLead/DBCSTrail ̑gɂȂĂ 2 oCg̒Ԃ
+int DBCSLength(const BYTE *p, int len, const BYTE *Class)
+{
+	int i = 0;
+	BYTE c;
+
+	while (i < len) {
+		c = Class[p[i]];
+		if (c & DBCSSingle) {
+			i++;
+		}
+		else if ((c & DBCSLead) && i + 1 < len && (Class[p[i+1]] & DBCSTrail)) {
+			i += 2;
+		}
+		else {
+			break;
+		}
+	}
+	return i;
+}
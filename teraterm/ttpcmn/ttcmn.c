@@ -39,6 +39,7 @@
 #include "ttftypes.h"
 #include "ttlib.h"
 #include "language.h"
+#include "charrun.h"
 #include <stdio.h>
 #include <windows.h>
 #include <tchar.h>
@@ -1284,6 +1285,24 @@ void PASCAL BroadcastClosingMessage(HWND myhwnd)
 }
 
 
+// MOobt@̖Ƀf[^ǉ ([JGR[p)
+// Ăяoŋ󂫂邱ƂmFĂƁB
+static void InBuffAppend(PComVar cv, PCHAR d, int len)
+{
+	int w, n;
+
+	w = InBuffWritePtr(cv);
+	n = cv->InBuffMax - w;
+	if (n > len) {
+		n = len;
+	}
+	memcpy(&(cv->InBuff[w]), d, n);
+	if (n < len) {
+		memcpy(cv->InBuff, d + n, len - n);
+	}
+	cv->InBuffCount = cv->InBuffCount + len;
+}
+
 int PASCAL CommReadRawByte(PComVar cv, LPBYTE b)
 {
 	if ( ! cv->Ready ) {
@@ -1292,7 +1311,7 @@ int PASCAL CommReadRawByte(PComVar cv, LPBYTE b)
 
 	if ( cv->InBuffCount>0 ) {
 		*b = cv->InBuff[cv->InPtr];
-		cv->InPtr++;
+		cv->InPtr = (cv->InPtr + 1) & InBuffMask(cv);
 		cv->InBuffCount--;
 		if ( cv->InBuffCount==0 ) {
 			cv->InPtr = 0;
@@ -1307,16 +1326,11 @@ int PASCAL CommReadRawByte(PComVar cv, LPBYTE b)
 
 void PASCAL CommInsert1Byte(PComVar cv, BYTE b)
 {
-	if ( ! cv->Ready ) {
+	if ( ! cv->Ready || cv->InBuffCount >= cv->InBuffMax ) {
 		return;
 	}
 
-	if (cv->InPtr == 0) {
-		memmove(&(cv->InBuff[1]),&(cv->InBuff[0]),cv->InBuffCount);
-	}
-	else {
-		cv->InPtr--;
-	}
+	cv->InPtr = (cv->InPtr - 1) & InBuffMask(cv);
 	cv->InBuff[cv->InPtr] = b;
 	cv->InBuffCount++;
 
@@ -1348,6 +1362,40 @@ void Log1Bin(PComVar cv, BYTE b)
 	}
 }
 
+// Af[^܂Ƃ߂ăoCiOɋL^
+static void LogBinSpan(PComVar cv, LPBYTE p, int len)
+{
+	int n;
+
+	if (((cv->FilePause & OpLog)!=0) || cv->ProtoFlag) {
+		return;
+	}
+	if (cv->BinSkip > 0) {
+		n = (cv->BinSkip < len) ? cv->BinSkip : len;
+		cv->BinSkip -= n;
+		p += n;
+		len -= n;
+	}
+	while (len > 0) {
+		n = InBuffSize - cv->BinPtr;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(&(cv->BinBuf[cv->BinPtr]), p, n);
+		cv->BinPtr += n;
+		if (cv->BinPtr>=InBuffSize) {
+			cv->BinPtr = cv->BinPtr-InBuffSize;
+		}
+		cv->BCount += n;
+		p += n;
+		len -= n;
+	}
+	if (cv->BCount>=InBuffSize) {
+		cv->BCount = InBuffSize;
+		cv->BStart = cv->BinPtr;
+	}
+}
+
 int PASCAL CommRead1Byte(PComVar cv, LPBYTE b)
 {
 	int c;
@@ -1418,29 +1466,183 @@ int PASCAL CommRead1Byte(PComVar cv, LPBYTE b)
 	return c;
 }
 
+// Mobt@̐擪܂Ƃ߂ĎooCgԂ
+static int RunSpan(PComVar cv)
+{
+	int len, room;
+
+	if ( ! cv->Ready ) {
+		return 0;
+	}
+
+	if ( cv->TelMode || cv->IACFlag || cv->TelCRFlag ) {
+		return 0;
+	}
+
+	len = InBuffReadSpan(cv);
+	if (cv->HLogBuf!=NULL) {
+		room = InBuffSize - 10 - ((cv->LCount > cv->DCount) ? cv->LCount : cv->DCount);
+		if (len > room) {
+			len = room;
+		}
+	}
+	if (cv->HBinBuf!=NULL) {
+		room = InBuffSize - 10 - cv->BCount;
+		if (len > room) {
+			len = room;
+		}
+	}
+	if (len <= 0) {
+		return 0;
+	}
+	return len;
+}
+
+// Mobt@̐擪 len oCgo
+static int TakeRun(PComVar cv, LPBYTE *run, int len)
+{
+	if (len == 0) {
+		return 0;
+	}
+
+	*run = &(cv->InBuff[cv->InPtr]);
+	if (cv->HBinBuf!=0) {
+		LogBinSpan(cv, *run, len);
+	}
+
+	cv->InPtr = (cv->InPtr + len) & InBuffMask(cv);
+	cv->InBuffCount -= len;
+	if ( cv->InBuffCount==0 ) {
+		cv->InPtr = 0;
+	}
+	return len;
+}
+
+// Mobt@̐擪ALength Œ𒲂ׂ܂Ƃ߂Ďo
+static int ReadRun(PComVar cv, LPBYTE *run, int (*Length)(const BYTE *p, int len))
+{
+	int len;
+
+	len = RunSpan(cv);
+	if (len == 0) {
+		return 0;
+	}
+	return TakeRun(cv, run, Length(&(cv->InBuff[cv->InPtr]), len));
+}
+
+// Mobt@̐擪󎚉\(0x20-0x7E)̘A܂Ƃ߂ĎoB
+// 䕶ADELA8bitATelnet  IAC(0xFF)/CR ̎OŎ~܂̂ŁA
+// c͏]ǂ CommRead1Byte() 1oCg邱ƁB
+// Telnet ̃R}h⃍Oobt@ɗ]TȂꍇ͉oȂB
+//   run: o̐擪 (̎M܂ł̊ԂL)
+//   ߂l: ooCg
+int PASCAL CommReadPrintableRun(PComVar cv, LPBYTE *run)
+{
+	return ReadRun(cv, run, PrintableLength);
+}
+
+// CommReadPrintableRun() ƓlAUTF-8  2/3 oCg܂߂ĎoB
+// o͕̓rŐ؂ĂȂB
+int PASCAL CommReadUTF8Run(PComVar cv, LPBYTE *run)
+{
+	return ReadRun(cv, run, UTF8Length);
+}
+
+// CommReadPrintableRun() ƓlAR[h(SJIS/EUC/JIS/KS5601) 2 oCg܂߂ĎoB
+//   Class: oCgƂ DBCSSingle/DBCSLead/DBCSTrail ̑gݍ킹
+// o 2 oCg̓rŐ؂ĂȂB
+int PASCAL CommReadDBCSRun(PComVar cv, LPBYTE *run, const BYTE *Class)
+{
+	int len;
+
+	len = RunSpan(cv);
+	if (len == 0) {
+		return 0;
+	}
+	return TakeRun(cv, run, DBCSLength(&(cv->InBuff[cv->InPtr]), len, Class));
+}
+
+// MOobt@̋󂫂ԂB
+// Len oCg肫Ȃ OutBuffSizeMax ܂ 2 {LB
+// (teraterm.exe ƋLobt@Ȃ̂ŁAmۂƉ GlobalAlloc() ōs)
+static int OutBuffRoom(PComVar cv, int Len)
+{
+	int size, n;
+	LPBYTE p;
+
+	size = cv->OutBuffMax;
+	while (size - cv->OutBuffCount < Len && size < OutBuffSizeMax) {
+		size <<= 1;
+	}
+	if (size != cv->OutBuffMax) {
+		p = (LPBYTE)GlobalAlloc(GMEM_FIXED, size);
+		if (p != NULL) {
+			n = OutBuffReadSpan(cv);
+			memcpy(p, &(cv->OutBuff[cv->OutPtr]), n);
+			memcpy(&p[n], cv->OutBuff, cv->OutBuffCount - n);
+			GlobalFree(cv->OutBuff);
+			cv->OutBuff = p;
+			cv->OutBuffMax = size;
+			cv->OutPtr = 0;
+		}
+	}
+	return cv->OutBuffMax - cv->OutBuffCount;
+}
+
 int PASCAL CommRawOut(PComVar cv, PCHAR B, int C)
 {
-	int a;
+	int a, i, n;
 
 	if ( ! cv->Ready ) {
 		return C;
 	}
 
-	if (C > OutBuffSize - cv->OutBuffCount) {
-		a = OutBuffSize - cv->OutBuffCount;
-	}
-	else {
+	a = OutBuffRoom(cv, C);
+	if (a > C) {
 		a = C;
 	}
-	if ( cv->OutPtr > 0 ) {
-		memmove(&(cv->OutBuff[0]),&(cv->OutBuff[cv->OutPtr]),cv->OutBuffCount);
+	if ( cv->OutBuffCount == 0 ) {
 		cv->OutPtr = 0;
 	}
-	memcpy(&(cv->OutBuff[cv->OutBuffCount]),B,a);
-	cv->OutBuffCount = cv->OutBuffCount + a;
+	// ܂Ԃ 2 ɕď
+	for (i=0; i<a; i+=n) {
+		n = OutBuffWriteSpan(cv);
+		if (n > a - i) {
+			n = a - i;
+		}
+		memcpy(&(cv->OutBuff[OutBuffWritePtr(cv)]), &B[i], n);
+		cv->OutBuffCount += n;
+	}
 	return a;
 }
 
+// B n܂ATelnet ̃GXP[v╶̕ϊɂ̂܂
+// ߂镔̒Ԃ
+//   Text: CommTextOut()/CommTextEcho() p (CR ̕ϊAVA̕R[hϊ̎Oł~܂)
+static int PlainLength(PComVar cv, PCHAR B, int C, BOOL Text)
+{
+	int i;
+	BYTE d;
+
+	for (i=0; i<C; i++) {
+		d = (BYTE)B[i];
+		if (d == CR) {
+			if (Text || cv->TelFlag && ! cv->TelBinSend) {
+				break;
+			}
+		}
+		else if (d == 0xff) {
+			if (cv->TelFlag) {
+				break;
+			}
+		}
+		if (Text && d >= 128 && cv->Language == IdRussian) {
+			break;
+		}
+	}
+	return i;
+}
+
 int PASCAL CommBinaryOut(PComVar cv, PCHAR B, int C)
 {
 	int a, i, Len;
@@ -1453,6 +1655,14 @@ int PASCAL CommBinaryOut(PComVar cv, PCHAR B, int C)
 	i = 0;
 	a = 1;
 	while ((a>0) && (i<C)) {
+		// GXP[v̗vȂ͂܂Ƃ߂ď
+		Len = PlainLength(cv, &B[i], C-i, FALSE);
+		if (Len > 0) {
+			a = CommRawOut(cv, &B[i], Len);
+			i += a;
+			continue;
+		}
+
 		Len = 0;
 
 		d[Len] = B[i];
@@ -1465,7 +1675,7 @@ int PASCAL CommBinaryOut(PComVar cv, PCHAR B, int C)
 			d[Len++] = '\xff';
 		}
 
-		if ( OutBuffSize - cv->OutBuffCount - Len >= 0 ) {
+		if ( OutBuffRoom(cv, Len) >= Len ) {
 			CommRawOut(cv, d, Len);
 			a = 1;
 		}
@@ -1490,6 +1700,16 @@ int PASCAL CommBinaryBuffOut(PComVar cv, PCHAR B, int C)
 	i = 0;
 	a = 1;
 	while ((a>0) && (i<C)) {
+		if (! cv->TelLineMode) {
+			// GXP[v̗vȂ͂܂Ƃ߂ď
+			Len = PlainLength(cv, &B[i], C-i, FALSE);
+			if (Len > 0) {
+				a = CommRawOut(cv, &B[i], Len);
+				i += a;
+				continue;
+			}
+		}
+
 		Len = 0;
 
 		d[Len] = B[i];
@@ -1528,7 +1748,7 @@ int PASCAL CommBinaryBuffOut(PComVar cv, PCHAR B, int C)
 			cv->Flush = FALSE;
 		}
 		else {
-			if ( OutBuffSize - cv->OutBuffCount - Len >= 0 ) {
+			if ( OutBuffRoom(cv, Len) >= Len ) {
 				CommRawOut(cv, d, Len);
 				a = 1;
 			}
@@ -1563,6 +1783,145 @@ static int OutputTextUTF8(WORD K, char *TempStr, PComVar cv)
 	return TempLen;
 }
 
+// M镶̕ϊ\
+//   SendLeadByte: _isleadbyte_l() ̌
+//   SendUTF8: 2oCg UTF-8 ɂ ((oCg << 24) | UTF-8 ̒lA0 ͖ϊ)
+//     SJIS2UTF8() 1Ƃ setlocale() ĂԂ̂ŁAϊoĂB
+// P[ς蒼B
+static BYTE SendLeadByte[256];
+static DWORD SendUTF8[0x10000];
+static char SendTableLocale[sizeof(pm->ts.Locale)];
+static BOOL SendTableValid = FALSE;
+
+static void SendTableCheck(PComVar cv)
+{
+	int c;
+
+	if (SendTableValid && strcmp(cv->Locale, SendTableLocale) == 0) {
+		return;
+	}
+	for (c=0; c<256; c++) {
+		SendLeadByte[c] = _isleadbyte_l(c, cv->locale) ? 1 : 0;
+	}
+	memset(SendUTF8, 0, sizeof(SendUTF8));
+	strncpy_s(SendTableLocale, sizeof(SendTableLocale), cv->Locale, _TRUNCATE);
+	SendTableValid = TRUE;
+}
+
+static int SendUTF8Kanji(WORD K, PCHAR Out, PComVar cv)
+{
+	DWORD u;
+	int len;
+
+	u = SendUTF8[K];
+	if (u == 0) {
+		u = SJIS2UTF8(K, &len, cv->Locale);
+		u |= len << 24;
+		SendUTF8[K] = u;
+	}
+	len = u >> 24;
+	switch (len) {
+	  case 3:
+		*Out++ = (u >> 16) & 0xff;
+	  case 2:
+		*Out++ = (u >> 8) & 0xff;
+	  case 1:
+		*Out++ = u & 0xff;
+	}
+	return len;
+}
+
+// B n܂AASCII ̕\2oCg̕܂Ƃ߂ĕϊAMobt@֏ށB
+// 1 TextOutMBCS() ƓʂɂȂ悤AJIS ̃Vtg (cv->SendCode) i߂B
+// 䕶AJ^JiA2oCg̓rŏI镔Ȃǂ̎OŎ~܂AoCgԂB
+static int TextOutMBCSRun(PComVar cv, PCHAR B, int C)
+{
+	char Buff[512];
+	int i, len, room;
+	BYTE d;
+	WORD K;
+	BOOL UTF8, JIS, Japanese;
+
+	UTF8 = (cv->KanjiCodeSend == IdUTF8 || cv->Language == IdUtf8);
+	Japanese = (cv->Language == IdJapanese);
+	JIS = (Japanese && cv->KanjiCodeSend == IdJIS);
+
+	i = 0;
+	while (i < C) {
+		// 1͍ő6oCg (GXP[vV[PX + 2oCg) ɂȂ
+		room = OutBuffRoom(cv, sizeof(Buff));
+		if (room > (int)sizeof(Buff)) {
+			room = sizeof(Buff);
+		}
+		room -= 6;
+		len = 0;
+		while (i < C && len <= room) {
+			d = (BYTE)B[i];
+			if (d >= 0x20 && d < 0x7f) {
+				if (Japanese) {
+					if (JIS) {
+						if (cv->SendCode == IdKanji) {
+							Buff[len++] = 0x1B;
+							Buff[len++] = '(';
+							switch (cv->KanjiOut) {
+							  case IdKanjiOutJ:
+								Buff[len++] = 'J';
+								break;
+							  case IdKanjiOutH:
+								Buff[len++] = 'H';
+								break;
+							  default:
+								Buff[len++] = 'B';
+							}
+						}
+						else if (cv->SendCode == IdKatakana && cv->JIS7KatakanaSend == 1) {
+							Buff[len++] = SI;
+						}
+					}
+					cv->SendCode = IdASCII;
+				}
+				Buff[len++] = d;
+				i++;
+			}
+			else if (SendLeadByte[d] && i + 1 < C) {
+				K = (d << 8) + (BYTE)B[i+1];
+				if (UTF8) {
+					len += SendUTF8Kanji(K, &Buff[len], cv);
+				}
+				else {
+					if (JIS) {
+						if (cv->SendCode != IdKanji) {
+							Buff[len++] = 0x1B;
+							Buff[len++] = '$';
+							Buff[len++] = (cv->KanjiIn == IdKanjiInB) ? 'B' : '@';
+						}
+						K = SJIS2JIS(K);
+					}
+					else if (Japanese && cv->KanjiCodeSend == IdEUC) {
+						K = SJIS2EUC(K);
+					}
+					Buff[len++] = HIBYTE(K);
+					Buff[len++] = LOBYTE(K);
+				}
+				cv->SendCode = IdKanji;
+				i += 2;
+			}
+			else {
+				break;
+			}
+		}
+		if (len == 0) {
+			break;
+		}
+		CommRawOut(cv, Buff, len);
+		if (i < C && len <= room) {
+			// ϊłȂ̎OŎ~܂
+			break;
+		}
+	}
+	return i;
+}
+
 //
 // MBCSe튿R[h֕ϊďo͂B
 //
@@ -1575,9 +1934,20 @@ int TextOutMBCS(PComVar cv, PCHAR B, int C)
 	BYTE d;
 	BOOL Full, KanjiFlagNew;
 
+	SendTableCheck(cv);
+
 	Full = FALSE;
 	i = 0;
 	while (! Full && (i < C)) {
+		if (! cv->TelLineMode && ! cv->SendKanjiFlag) {
+			// ASCII 2oCg͂̕܂Ƃ߂ĕϊ
+			TempLen = TextOutMBCSRun(cv, &B[i], C-i);
+			if (TempLen > 0) {
+				i += TempLen;
+				continue;
+			}
+		}
+
 		TempLen = 0;
 		d = (BYTE)B[i];
 		SendCodeNew = cv->SendCode;
@@ -1765,7 +2135,7 @@ int TextOutMBCS(PComVar cv, PCHAR B, int C)
 				cv->SendKanjiFlag = KanjiFlagNew;
 			}
 			else {
-				Full = OutBuffSize-cv->OutBuffCount-TempLen < 0;
+				Full = OutBuffRoom(cv, TempLen) < TempLen;
 				if (! Full) {
 					i++;
 					cv->SendCode = SendCodeNew;
@@ -1802,6 +2172,17 @@ int PASCAL CommTextOut(PComVar cv, PCHAR B, int C)
 	Full = FALSE;
 	i = 0;
 	while (! Full && (i < C)) {
+		if (! cv->TelLineMode) {
+			// ϊ̗vȂ͂܂Ƃ߂ď
+			TempLen = PlainLength(cv, &B[i], C-i, TRUE);
+			if (TempLen > 0) {
+				OutLen = CommRawOut(cv, &B[i], TempLen);
+				i += OutLen;
+				Full = (OutLen < TempLen);
+				continue;
+			}
+		}
+
 		TempLen = 0;
 		d = (BYTE)B[i];
 
@@ -1872,7 +2253,7 @@ int PASCAL CommTextOut(PComVar cv, PCHAR B, int C)
 			cv->Flush = FALSE;
 		}
 		else {
-			Full = OutBuffSize - cv->OutBuffCount - TempLen < 0;
+			Full = OutBuffRoom(cv, TempLen) < TempLen;
 			if (! Full) {
 				i++;
 				CommRawOut(cv,TempStr,TempLen);
@@ -1891,11 +2272,6 @@ int PASCAL CommBinaryEcho(PComVar cv, PCHAR B, int C)
 	if ( ! cv->Ready )
 		return C;
 
-	if ( (cv->InPtr>0) && (cv->InBuffCount>0) ) {
-		memmove(cv->InBuff,&(cv->InBuff[cv->InPtr]),cv->InBuffCount);
-		cv->InPtr = 0;
-	}
-
 	i = 0;
 	a = 1;
 	while ((a>0) && (i<C)) {
@@ -1915,9 +2291,8 @@ int PASCAL CommBinaryEcho(PComVar cv, PCHAR B, int C)
 			Len++;
 		}
 
-		if ( InBuffSize-cv->InBuffCount-Len >=0 ) {
-			memcpy(&(cv->InBuff[cv->InBuffCount]),d,Len);
-			cv->InBuffCount = cv->InBuffCount + Len;
+		if ( cv->InBuffMax-cv->InBuffCount-Len >=0 ) {
+			InBuffAppend(cv, d, Len);
 			a = 1;
 		}
 		else
@@ -2087,13 +2462,12 @@ int PASCAL TextEchoMBCS(PComVar cv, PCHAR B, int C)
 			cv->EchoKanjiFlag = KanjiFlagNew;
 		}
 		else {
-			Full = InBuffSize-cv->InBuffCount-TempLen < 0;
+			Full = cv->InBuffMax-cv->InBuffCount-TempLen < 0;
 			if (! Full) {
 				i++;
 				cv->EchoCode = EchoCodeNew;
 				cv->EchoKanjiFlag = KanjiFlagNew;
-				memcpy(&(cv->InBuff[cv->InBuffCount]),TempStr,TempLen);
-				cv->InBuffCount = cv->InBuffCount + TempLen;
+				InBuffAppend(cv, TempStr, TempLen);
 			}
 		}
 
@@ -2113,11 +2487,6 @@ int PASCAL CommTextEcho(PComVar cv, PCHAR B, int C)
 		return C;
 	}
 
-	if ( (cv->InPtr>0) && (cv->InBuffCount>0) ) {
-		memmove(cv->InBuff,&(cv->InBuff[cv->InPtr]),cv->InBuffCount);
-		cv->InPtr = 0;
-	}
-
 	switch (cv->Language) {
 	  case IdUtf8:
 	  case IdJapanese:
@@ -2129,6 +2498,20 @@ int PASCAL CommTextEcho(PComVar cv, PCHAR B, int C)
 	Full = FALSE;
 	i = 0;
 	while (! Full && (i < C)) {
+		if (! cv->TelLineMode) {
+			// ϊ̗vȂ͂܂Ƃ߂ď
+			TempLen = PlainLength(cv, &B[i], C-i, TRUE);
+			if (TempLen > 0) {
+				if (TempLen > cv->InBuffMax - cv->InBuffCount) {
+					TempLen = cv->InBuffMax - cv->InBuffCount;
+					Full = TRUE;
+				}
+				InBuffAppend(cv, &B[i], TempLen);
+				i += TempLen;
+				continue;
+			}
+		}
+
 		TempLen = 0;
 		d = (BYTE)B[i];
 
@@ -2168,11 +2551,10 @@ int PASCAL CommTextEcho(PComVar cv, PCHAR B, int C)
 			}
 		}
 
-		Full = InBuffSize-cv->InBuffCount-TempLen < 0;
+		Full = cv->InBuffMax-cv->InBuffCount-TempLen < 0;
 		if (! Full) {
 			i++;
-			memcpy(&(cv->InBuff[cv->InBuffCount]),TempStr,TempLen);
-			cv->InBuffCount = cv->InBuffCount + TempLen;
+			InBuffAppend(cv, TempStr, TempLen);
 		}
 	} // end of while {}
 
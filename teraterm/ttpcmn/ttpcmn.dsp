@@ -86,6 +86,10 @@ LINK32=link.exe
 # PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;hpj;bat;for;f90"
 # Begin Source File
 
+SOURCE=..\..\source\ttcmn\charrun.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\source\ttcmn\language.c
 # End Source File
 # Begin Source File
@@ -102,6 +106,10 @@ SOURCE=..\..\source\common\ttlib.c
 # PROP Default_Filter "h;hpp;hxx;hm;inl;fi;fd"
 # Begin Source File
 
+SOURCE=..\..\source\ttcmn\charrun.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\source\ttcmn\language.h
 # End Source File
 # Begin Source File
@@ -5835,6 +5835,113 @@ WORD TTLScpRecv()
 	return SendCmnd(CmdScpRcv, 0);
 }
 
+// SYNOPSIS:
+//   sftpsend "c:\usr\sample.chm" "doc/sample.chm"
+//   sftpsend "c:\usr\doc" "backup/"
+WORD TTLSftpSend()
+{
+	TStrVal Str;
+	TStrVal Str2;
+	WORD Err;
+
+	Err = 0;
+	GetStrVal(Str,&Err);
+
+	if ((Err==0) &&
+	    ((strlen(Str)==0)))
+		Err = ErrSyntax;
+	if (Err!=0) return Err;
+
+	GetStrVal(Str2,&Err);
+	if (Err) {
+		Str2[0] = '\0';
+		Err = 0;
+	}
+
+	if (GetFirstChar() != 0)
+		Err = ErrSyntax;
+	if (Err!=0) return Err;
+
+	SetFile(Str);
+	SetSecondFile(Str2);
+	return SendCmnd(CmdSftpSend, 0);
+}
+
+// SYNOPSIS:
+//   sftprecv "foo.txt"
+//   sftprecv "src" "c:\work"
+WORD TTLSftpRecv()
+{
+	TStrVal Str;
+	TStrVal Str2;
+	WORD Err;
+
+	Err = 0;
+	GetStrVal(Str,&Err);
+
+	if ((Err==0) &&
+	    ((strlen(Str)==0)))
+		Err = ErrSyntax;
+	if (Err!=0) return Err;
+
+	GetStrVal(Str2,&Err);
+	if (Err) {
+		Str2[0] = '\0';
+		Err = 0;
+	}
+
+	if (GetFirstChar() != 0)
+		Err = ErrSyntax;
+	if (Err!=0) return Err;
+
+	SetFile(Str);
+	SetSecondFile(Str2);
+	return SendCmnd(CmdSftpRcv, 0);
+}
+
+// SYNOPSIS:
+//   searchbuff "error"
+//   searchbuff "^ERROR [0-9]+" 1 120
+// Tera Term ̃XN[obt@As̔ԍ (1 )  result ɁA
+// ̍s̓e inputstr Ɋi[BȂ result  0B
+WORD TTLSearchBuff()
+{
+	TStrVal Str, Str2;
+	WORD Err;
+	int Opt = 0, Line = 0;
+	char *p;
+
+	Err = 0;
+	GetStrVal(Str, &Err);
+	if ((Err == 0) && (strlen(Str) == 0))
+		Err = ErrSyntax;
+	if ((Err == 0) && CheckParameterGiven()) {
+		GetIntVal(&Opt, &Err);
+		if ((Err == 0) && CheckParameterGiven())
+			GetIntVal(&Line, &Err);
+	}
+	if ((Err == 0) && (GetFirstChar() != 0))
+		Err = ErrSyntax;
+	if ((Err == 0) && (!Linked))
+		Err = ErrLinkFirst;
+	if (Err != 0) return Err;
+
+	SetFile(Str);
+	_snprintf_s(Str2, sizeof(Str2), _TRUNCATE, "%d %d", Opt, Line);
+	SetSecondFile(Str2);
+
+	memset(Str2, 0, sizeof(Str2));
+	Err = GetTTParam(CmdSearchBuff, Str2, sizeof(Str2));
+	if (Err != 0) return Err;
+
+	// "sԍ s̓e" ԂĂ
+	SetResult(atoi(Str2));
+	p = strchr(Str2, ' ');
+	SetInputStr((p != NULL) ? p + 1 : "");
+
+	return Err;
+}
+
 int ExecCmnd()
 {
 	WORD WId, Err;
@@ -6188,6 +6295,12 @@ int ExecCmnd()
 			Err = TTLScpSend(); break;      // add 'scpsend' (2008.1.1 yutaka)
 		case RsvScpRecv:
 			Err = TTLScpRecv(); break;      // add 'scprecv' (2008.1.4 yutaka)
+		case RsvSearchBuff:
+			Err = TTLSearchBuff(); break;
+		case RsvSftpRecv:
+			Err = TTLSftpRecv(); break;
+		case RsvSftpSend:
+			Err = TTLSftpSend(); break;
 		case RsvSend:
 			Err = TTLSend(); break;
 		case RsvSendBreak:
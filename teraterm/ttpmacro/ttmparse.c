@@ -354,6 +354,7 @@ BOOL CheckReservedWord(PCHAR Str, LPWORD WordId)
 	case 's':
 		if (_stricmp(Str,"scprecv")==0) *WordId = RsvScpRecv;      // add 'scprecv' (2008.1.1 yutaka)
 		else if (_stricmp(Str,"scpsend")==0) *WordId = RsvScpSend;      // add 'scpsend' (2008.1.1 yutaka)
+		else if (_stricmp(Str,"searchbuff")==0) *WordId = RsvSearchBuff;
 		else if (_stricmp(Str,"send")==0) *WordId = RsvSend;
 		else if (_stricmp(Str,"sendbreak")==0) *WordId = RsvSendBreak;
 		else if (_stricmp(Str,"sendbroadcast")==0) *WordId = RsvSendBroadcast;
@@ -383,6 +384,8 @@ BOOL CheckReservedWord(PCHAR Str, LPWORD WordId)
 		else if (_stricmp(Str,"settitle")==0) *WordId = RsvSetTitle;
 		else if (_stricmp(Str,"show")==0) *WordId = RsvShow;
 		else if (_stricmp(Str,"showtt")==0) *WordId = RsvShowTT;
+		else if (_stricmp(Str,"sftprecv")==0) *WordId = RsvSftpRecv;
+		else if (_stricmp(Str,"sftpsend")==0) *WordId = RsvSftpSend;
 		else if (_stricmp(Str,"sprintf")==0) *WordId = RsvSprintf;  // add 'sprintf' (2007.5.1 yutaka)
 		else if (_stricmp(Str,"sprintf2")==0) *WordId = RsvSprintf2;  // add 'sprintf2' (2008.12.18 maya)
 		else if (_stricmp(Str,"statusbox")==0) *WordId = RsvStatusBox;
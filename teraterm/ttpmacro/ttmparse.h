@@ -275,6 +275,9 @@
 #define RsvGetModemStatus	213
 #define RsvDirnameBox   214
 #define RsvSetFlowCtrl   215
+#define RsvSearchBuff   216
+#define RsvSftpRecv     217
+#define RsvSftpSend     218
 
 #define RsvOperator     1000
 #define RsvBNot         1001
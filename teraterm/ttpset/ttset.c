@@ -2062,6 +2062,20 @@ void PASCAL ReadIniFile(PCHAR FName, PTTSet ts)
 	// Fallback to CP932 (Experimental)
 	ts->FallbackToCP932 = GetOnOff(Section, "FallbackToCP932", FName, FALSE);
 
+	// Receive buffer size
+	ts->RecvBuffSize = GetPrivateProfileInt(Section, "RecvBufferSize", RecvBuffSizeDefault, FName);
+	if (ts->RecvBuffSize < RecvBuffSizeMin)
+		ts->RecvBuffSize = RecvBuffSizeMin;
+	else if (ts->RecvBuffSize > RecvBuffSizeMax)
+		ts->RecvBuffSize = RecvBuffSizeMax;
+
+	// Compressed scroll buffer size (MB)
+	ts->CompressedBuffSize = GetPrivateProfileInt(Section, "CompressedBuffSize", 0, FName);
+	if (ts->CompressedBuffSize < 0)
+		ts->CompressedBuffSize = 0;
+	else if (ts->CompressedBuffSize > CompressedBuffSizeMax)
+		ts->CompressedBuffSize = CompressedBuffSizeMax;
+
 	// CygTerm Configuration File
 	ReadCygtermConfFile(ts);
 }
@@ -3403,6 +3417,12 @@ void PASCAL WriteIniFile(PCHAR FName, PTTSet ts)
 			ts->TerminalInputSpeed, ts->TerminalOutputSpeed);
 	}
 
+	// Receive buffer size
+	WriteInt(Section, "RecvBufferSize", FName, ts->RecvBuffSize);
+
+	// Compressed scroll buffer size (MB)
+	WriteInt(Section, "CompressedBuffSize", FName, ts->CompressedBuffSize);
+
 	// CygTerm Configuration File
 	WriteCygtermConfFile(ts);
 }
@@ -0,0 +1,51 @@
+#!/bin/sh
+
+trap "CSI r m H 2J; exit" 0 2
+
+ESC() {
+  while [ $# -gt 0 ]; do
+    printf "\033$1"
+    shift
+  done
+}
+
+CSI() {
+  while [ $# -gt 0 ]; do
+    ESC "[$1"
+    shift
+  done
+}
+
+count=${1:-20000}
+
+CSI H 2J
+echo "---- top fixed line ----"
+CSI 999H
+printf -- "---- bottom fixed line ----"
+
+# scroll region (DECSTBM) inside the screen
+CSI "2;$(($(stty size | cut -d' ' -f1) - 1))r" 2H
+
+i=0
+while [ $i -lt $count ]; do
+  echo "scroll region line $i"
+  i=$((i + 1))
+done
+
+# insert / delete lines (IL / DL) inside the region
+i=0
+while [ $i -lt $count ]; do
+  CSI 3H L 5H M
+  i=$((i + 1))
+done
+printf "IL/DL $count times"
+
+# reverse index at the top of the region
+CSI 2H
+i=0
+while [ $i -lt $count ]; do
+  ESC M
+  i=$((i + 1))
+done
+
+sleep 2
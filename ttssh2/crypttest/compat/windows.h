@@ -0,0 +1,9 @@
+/*
+ * Stand-in for <windows.h> when the ttxssh crypto sources are built by
+ * crypttest on a POSIX host. Only what those sources use is defined here.
+ */
+#pragma once
+
+#include <string.h>
+
+#define SecureZeroMemory(p, n) memset((p), 0, (n))
@@ -0,0 +1,467 @@
+/*
+ * (C) 2026 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * crypttest - checks the ttxssh crypto code that has no other test
+ *
+ *   crypttest [-n count] [-s seed]
+ *
+ * fe25519   runs count random chains of field operations through
+ *           ed25519_fe25519.c and the byte-limb reference code in
+ *           ed25519_fe25519_ref.c and compares every result
+ * ed25519   RFC 8032 section 7.1 TEST 1-3: key generation, signing,
+ *           verification and the rejection of modified signatures
+ * x25519    RFC 7748 sections 5.2 and 6.1
+ * chachapoly
+ *           chachapoly_selftest() of cipher-chachapoly.c, the known answer
+ *           tests that /ssh-cipherbench runs in ttxssh
+ *
+ * Prints one line per test and exits with 1 if any of them fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ed25519_crypto_api.h"
+#include "ed25519_fe25519.h"
+#include "ed25519_fe25519_ref.h"
+
+static unsigned long long rnd_state = 88172645463325252ULL;
+
+static unsigned char rnd_byte(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+	return (unsigned char)rnd_state;
+}
+
+static void hex2bin(unsigned char *out, const char *hex, size_t len)
+{
+	size_t i;
+	unsigned int b;
+
+	for (i = 0; i < len; i++) {
+		sscanf(hex + i * 2, "%2x", &b);
+		out[i] = (unsigned char)b;
+	}
+}
+
+static void print_hex(const char *name, const unsigned char *p, size_t len)
+{
+	size_t i;
+
+	printf("  %s ", name);
+	for (i = 0; i < len; i++) {
+		printf("%02x", p[i]);
+	}
+	printf("\n");
+}
+
+/*
+ * ed25519_crypto_api.h maps randombytes() to arc4random_buf(). Key
+ * generation takes its seed from here, so the RFC 8032 seeds can be fed
+ * in through next_seed.
+ */
+static const unsigned char *next_seed;
+
+void arc4random_buf(void *buf, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		((unsigned char *)buf)[i] = next_seed != NULL ? next_seed[i] : rnd_byte();
+	}
+}
+
+/*
+ * fe25519
+ */
+
+/* random field element; one in two is an edge case near 0 or p = 2^255-19 */
+static void fe_random(unsigned char x[32])
+{
+	int i;
+
+	for (i = 0; i < 32; i++) {
+		x[i] = rnd_byte();
+	}
+	switch (rnd_byte() % 10) {
+	case 0:
+		memset(x, 0, 32);
+		break;
+	case 1:
+		memset(x, 0, 32);
+		x[0] = 1;
+		break;
+	case 2:
+		memset(x, 0xff, 32);
+		break;
+	case 3:
+	case 4:
+		/* p - 2 .. p + 2 */
+		memset(x, 0xff, 32);
+		x[0] = 0xeb + rnd_byte() % 5;
+		x[31] = 0x7f;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * fe25519_ref_pack() may return a value in [p, 2^256) after some
+ * operations. Reduce it the same way as the new code so the two can be
+ * compared byte for byte.
+ */
+static void ref_pack(unsigned char r[32], const fe25519_ref *x)
+{
+	fe25519 t;
+	int i, c;
+
+	fe25519_ref_pack(r, x);
+	if (r[31] & 0x80) {
+		/* 2^255 = 19 (mod p) */
+		r[31] &= 0x7f;
+		c = 19;
+		for (i = 0; i < 32 && c; i++) {
+			c += r[i];
+			r[i] = c & 0xff;
+			c >>= 8;
+		}
+	}
+	fe25519_unpack(&t, r);
+	fe25519_pack(r, &t);
+}
+
+static const char *fe_op_names[] = {
+	"add", "sub", "mul", "square", "neg", "cmov", "invert", "pow2523",
+};
+
+static int test_fe25519(int count)
+{
+	int n, i, op;
+	int fail = 0;
+	unsigned char a[32], b[32], x[32], y[32], z[32];
+	static const unsigned char zero[32];
+	fe25519 A, B, C;
+	fe25519_ref RA, RB, RC;
+
+	for (n = 0; n < count && fail == 0; n++) {
+		fe_random(a);
+		fe_random(b);
+		fe25519_unpack(&A, a);
+		fe25519_unpack(&B, b);
+		fe25519_ref_unpack(&RA, a);
+		fe25519_ref_unpack(&RB, b);
+
+		/* chain the results, so unreduced limbs are fed back in */
+		for (i = 0; i < 20; i++) {
+			op = rnd_byte() % 8;
+			/* invert and pow2523 are slow; run them on one step in 8 */
+			if (op >= 6 && (rnd_byte() & 7) != 0) {
+				op = 2;
+			}
+			switch (op) {
+			case 0:
+				fe25519_add(&C, &A, &B);
+				fe25519_ref_add(&RC, &RA, &RB);
+				break;
+			case 1:
+				fe25519_sub(&C, &A, &B);
+				fe25519_ref_sub(&RC, &RA, &RB);
+				break;
+			case 2:
+				fe25519_mul(&C, &A, &B);
+				fe25519_ref_mul(&RC, &RA, &RB);
+				break;
+			case 3:
+				fe25519_square(&C, &A);
+				fe25519_ref_square(&RC, &RA);
+				break;
+			case 4:
+				fe25519_neg(&C, &A);
+				fe25519_ref_neg(&RC, &RA);
+				break;
+			case 5: {
+				unsigned char bit = rnd_byte() & 1;
+				C = A;
+				RC = RA;
+				fe25519_cmov(&C, &B, bit);
+				fe25519_ref_cmov(&RC, &RB, bit);
+				break;
+			}
+			case 6:
+				fe25519_invert(&C, &A);
+				fe25519_ref_invert(&RC, &RA);
+				break;
+			case 7:
+				fe25519_pow2523(&C, &A);
+				fe25519_ref_pow2523(&RC, &RA);
+				break;
+			}
+
+			fe25519_pack(x, &C);
+			ref_pack(y, &RC);
+			ref_pack(z, &RA);
+			if (memcmp(x, y, 32) != 0 ||
+			    fe25519_iszero(&C) != (memcmp(y, zero, 32) == 0) ||
+			    fe25519_getparity(&C) != (y[0] & 1) ||
+			    fe25519_iseq_vartime(&C, &A) != (memcmp(y, z, 32) == 0)) {
+				printf("  chain %d step %d: %s differs\n", n, i, fe_op_names[op]);
+				print_hex("a  ", a, 32);
+				print_hex("b  ", b, 32);
+				print_hex("new", x, 32);
+				print_hex("ref", y, 32);
+				fail++;
+				break;
+			}
+
+			if (rnd_byte() & 1) {
+				B = A;
+				RB = RA;
+			}
+			A = C;
+			RA = RC;
+		}
+	}
+
+	printf("fe25519: %d chains: %s\n", n, fail ? "FAILED" : "ok");
+	return fail;
+}
+
+/*
+ * Ed25519, RFC 8032 section 7.1
+ */
+
+static const struct {
+	const char *seed;
+	const char *pk;
+	const char *msg;
+	const char *sig;
+} ed25519_vectors[] = {
+	{	/* TEST 1 */
+		"9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60",
+		"d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a",
+		"",
+		"e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e06522490155"
+		"5fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b",
+	},
+	{	/* TEST 2 */
+		"4ccd089b28ff96da9db6c346ec114e0f5b8a319f35aba624da8cf6ed4fb8a6fb",
+		"3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c",
+		"72",
+		"92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da"
+		"085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00",
+	},
+	{	/* TEST 3 */
+		"c5aa8df43f9f837bedb7442f31dcb7b166d38535076f094b85ce3a2e0b4458f7",
+		"fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025",
+		"af82",
+		"6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac"
+		"18ff9b538d16f290ae67f760984dc6594a7c15e9716ed28dc027beceea1ec40a",
+	},
+};
+
+static int test_ed25519(void)
+{
+	int i, bit;
+	int fail = 0;
+	unsigned char seed[32], pk[32], sk[64], want_pk[32], want_sig[64];
+	unsigned char msg[16], sm[64 + 16], m[64 + 16];
+	unsigned long long smlen, mlen, msglen;
+
+	for (i = 0; i < (int)(sizeof(ed25519_vectors) / sizeof(ed25519_vectors[0])); i++) {
+		hex2bin(seed, ed25519_vectors[i].seed, 32);
+		hex2bin(want_pk, ed25519_vectors[i].pk, 32);
+		hex2bin(want_sig, ed25519_vectors[i].sig, 64);
+		msglen = strlen(ed25519_vectors[i].msg) / 2;
+		hex2bin(msg, ed25519_vectors[i].msg, (size_t)msglen);
+
+		next_seed = seed;
+		crypto_sign_ed25519_keypair(pk, sk);
+		next_seed = NULL;
+		if (memcmp(pk, want_pk, 32) != 0) {
+			printf("  TEST %d: public key differs\n", i + 1);
+			print_hex("got", pk, 32);
+			fail++;
+			continue;
+		}
+
+		crypto_sign_ed25519(sm, &smlen, msg, msglen, sk);
+		if (smlen != 64 + msglen || memcmp(sm, want_sig, 64) != 0) {
+			printf("  TEST %d: signature differs\n", i + 1);
+			print_hex("got", sm, 64);
+			fail++;
+			continue;
+		}
+
+		if (crypto_sign_ed25519_open(m, &mlen, sm, smlen, pk) != 0 ||
+		    mlen != msglen || memcmp(m, msg, (size_t)msglen) != 0) {
+			printf("  TEST %d: signature not verified\n", i + 1);
+			fail++;
+			continue;
+		}
+
+		/* every single bit flip of the signature must be rejected */
+		for (bit = 0; bit < 64 * 8; bit++) {
+			sm[bit / 8] ^= 1 << (bit % 8);
+			if (crypto_sign_ed25519_open(m, &mlen, sm, smlen, pk) == 0) {
+				printf("  TEST %d: modified signature (bit %d) accepted\n", i + 1, bit);
+				fail++;
+			}
+			sm[bit / 8] ^= 1 << (bit % 8);
+		}
+	}
+
+	printf("ed25519: %d vectors: %s\n", i, fail ? "FAILED" : "ok");
+	return fail;
+}
+
+/*
+ * X25519, RFC 7748
+ */
+
+static int x25519_check(const char *name, const char *scalar, const char *u, const char *want)
+{
+	unsigned char n[32], p[32], q[32], w[32];
+
+	hex2bin(n, scalar, 32);
+	hex2bin(p, u, 32);
+	hex2bin(w, want, 32);
+	crypto_scalarmult_curve25519(q, n, p);
+	if (memcmp(q, w, 32) != 0) {
+		printf("  %s differs\n", name);
+		print_hex("got", q, 32);
+		return 1;
+	}
+	return 0;
+}
+
+static int test_x25519(void)
+{
+	static const char base[] =
+		"0900000000000000000000000000000000000000000000000000000000000000";
+	static const char alice[] =
+		"77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a";
+	static const char alice_pub[] =
+		"8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a";
+	static const char bob[] =
+		"5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb";
+	static const char bob_pub[] =
+		"de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f";
+	static const char shared[] =
+		"4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742";
+	unsigned char k[32], u[32], r[32], w1[32], w1000[32];
+	int i;
+	int fail = 0;
+
+	/* 5.2, the two single scalar multiplications */
+	fail += x25519_check("5.2 vector 1",
+		"a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4",
+		"e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c",
+		"c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552");
+	fail += x25519_check("5.2 vector 2",
+		"4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d",
+		"e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493",
+		"95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957");
+
+	/* 6.1, Diffie-Hellman */
+	fail += x25519_check("6.1 alice public", alice, base, alice_pub);
+	fail += x25519_check("6.1 bob public", bob, base, bob_pub);
+	fail += x25519_check("6.1 alice shared", alice, bob_pub, shared);
+	fail += x25519_check("6.1 bob shared", bob, alice_pub, shared);
+
+	/* 5.2, iterated: k = X25519(k, u), u = old k */
+	hex2bin(w1, "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079", 32);
+	hex2bin(w1000, "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51", 32);
+	hex2bin(k, base, 32);
+	hex2bin(u, base, 32);
+	for (i = 1; i <= 1000; i++) {
+		crypto_scalarmult_curve25519(r, k, u);
+		memcpy(u, k, 32);
+		memcpy(k, r, 32);
+		if ((i == 1 && memcmp(k, w1, 32) != 0) ||
+		    (i == 1000 && memcmp(k, w1000, 32) != 0)) {
+			printf("  5.2 iterated, %d iterations differs\n", i);
+			print_hex("got", k, 32);
+			fail++;
+			break;
+		}
+	}
+
+	printf("x25519: %s\n", fail ? "FAILED" : "ok");
+	return fail;
+}
+
+/*
+ * chacha20-poly1305
+ *
+ * cipher-chachapoly.h is not included: it pulls in <sys/types.h>, whose
+ * 64-bit types clash with the ones ed25519_crypto_api.h defines.
+ */
+int chachapoly_selftest(void);
+
+static int test_chachapoly(void)
+{
+	int fail = chachapoly_selftest() != 0;
+
+	printf("chachapoly: %s\n", fail ? "FAILED" : "ok");
+	return fail;
+}
+
+int main(int argc, char *argv[])
+{
+	int count = 20000;
+	int fail = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			rnd_state = strtoull(argv[++i], NULL, 0);
+			if (rnd_state == 0) {
+				rnd_state = 1;
+			}
+		}
+		else {
+			fprintf(stderr, "usage: %s [-n count] [-s seed]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	fail += test_fe25519(count);
+	fail += test_ed25519();
+	fail += test_x25519();
+	fail += test_chachapoly();
+
+	return fail ? 1 : 0;
+}
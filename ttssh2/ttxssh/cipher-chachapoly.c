@@ -0,0 +1,261 @@
+/* Imported via OpenSSH-7.6p1, TeraTerm Project */
+
+/*
+ * Copyright (c) 2013 Damien Miller <djm@mindrot.org>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* $OpenBSD: cipher-chachapoly.c,v 1.8 2016/08/03 05:41:57 djm Exp $ */
+
+/*
+ * chacha20-poly1305@openssh.com (PROTOCOL.chacha20poly1305 of OpenSSH)
+ *
+ * The 64 byte key is split into K_2 (main_ctx, first 32 bytes) for the
+ * payload and the Poly1305 key, and K_1 (header_ctx) for the packet length.
+ * The sequence number is the nonce, so there is no IV.
+ * Return values are 0 on success and -1 on error.
+ */
+
+#include <sys/types.h>
+#include <string.h>
+#include <windows.h>
+
+#include "cipher-chachapoly.h"
+
+#define POKE_U32(p, v) \
+	do { \
+		((u_char *)(p))[0] = (u_char)((v) >> 24); \
+		((u_char *)(p))[1] = (u_char)((v) >> 16); \
+		((u_char *)(p))[2] = (u_char)((v) >> 8); \
+		((u_char *)(p))[3] = (u_char)(v); \
+	} while (0)
+
+#define PEEK_U32(p) \
+	(((u_int)((const u_char *)(p))[0] << 24) | \
+	 ((u_int)((const u_char *)(p))[1] << 16) | \
+	 ((u_int)((const u_char *)(p))[2] << 8) | \
+	  (u_int)((const u_char *)(p))[3])
+
+/* 64 bit big endian sequence number; the upper half is always 0 */
+#define POKE_SEQNR(p, v) \
+	do { \
+		POKE_U32((p), 0); \
+		POKE_U32((u_char *)(p) + 4, (v)); \
+	} while (0)
+
+static int
+timingsafe_bcmp(const void *b1, const void *b2, size_t n)
+{
+	const u_char *p1 = b1, *p2 = b2;
+	int ret = 0;
+
+	for (; n > 0; n--)
+		ret |= *p1++ ^ *p2++;
+	return (ret != 0);
+}
+
+int
+chachapoly_init(struct chachapoly_ctx *ctx,
+    const u_char *key, u_int keylen)
+{
+	if (keylen != (32 + 32)) /* 2 x 256 bit keys */
+		return -1;
+	chacha_keysetup(&ctx->main_ctx, key, 256);
+	chacha_keysetup(&ctx->header_ctx, key + 32, 256);
+	return 0;
+}
+
+/*
+ * chachapoly_crypt() operates as following:
+ * En/decrypt with header key 'aadlen' bytes from 'src', storing result
+ * to 'dest'. The ciphertext here is treated as additional authenticated
+ * data for MAC calculation.
+ * En/decrypt 'len' bytes at offset 'aadlen' from 'src' to 'dest'. Use
+ * POLY1305_TAGLEN bytes at offset 'len'+'aadlen' as the authentication
+ * tag. This tag is written on encryption and verified on decryption.
+ */
+int
+chachapoly_crypt(struct chachapoly_ctx *ctx, u_int seqnr, u_char *dest,
+    const u_char *src, u_int len, u_int aadlen, u_int authlen, int do_encrypt)
+{
+	u_char seqbuf[8];
+	const u_char one[8] = { 1, 0, 0, 0, 0, 0, 0, 0 }; /* NB little-endian */
+	u_char expected_tag[POLY1305_TAGLEN], poly_key[POLY1305_KEYLEN];
+	int r = -1;
+
+	/*
+	 * Run ChaCha20 once to generate the Poly1305 key. The IV is the
+	 * packet sequence number.
+	 */
+	memset(poly_key, 0, sizeof(poly_key));
+	POKE_SEQNR(seqbuf, seqnr);
+	chacha_ivsetup(&ctx->main_ctx, seqbuf, NULL);
+	chacha_encrypt_bytes(&ctx->main_ctx,
+	    poly_key, poly_key, sizeof(poly_key));
+
+	/* If decrypting, check tag before anything else */
+	if (!do_encrypt) {
+		const u_char *tag = src + aadlen + len;
+
+		poly1305_auth(expected_tag, src, aadlen + len, poly_key);
+		if (timingsafe_bcmp(expected_tag, tag, POLY1305_TAGLEN) != 0) {
+			goto out;
+		}
+	}
+
+	/* Crypt additional data */
+	if (aadlen) {
+		chacha_ivsetup(&ctx->header_ctx, seqbuf, NULL);
+		chacha_encrypt_bytes(&ctx->header_ctx, src, dest, aadlen);
+	}
+
+	/* Set Chacha's block counter to 1 */
+	chacha_ivsetup(&ctx->main_ctx, seqbuf, one);
+	chacha_encrypt_bytes(&ctx->main_ctx, src + aadlen,
+	    dest + aadlen, len);
+
+	/* If encrypting, calculate and append tag */
+	if (do_encrypt) {
+		poly1305_auth(dest + aadlen + len, dest, aadlen + len,
+		    poly_key);
+	}
+	r = 0;
+ out:
+	SecureZeroMemory(expected_tag, sizeof(expected_tag));
+	SecureZeroMemory(seqbuf, sizeof(seqbuf));
+	SecureZeroMemory(poly_key, sizeof(poly_key));
+	return r;
+}
+
+/* Decrypt and extract the encrypted packet length */
+int
+chachapoly_get_length(struct chachapoly_ctx *ctx,
+    u_int *plenp, u_int seqnr, const u_char *cp, u_int len)
+{
+	u_char buf[4], seqbuf[8];
+
+	if (len < 4)
+		return -1;
+	POKE_SEQNR(seqbuf, seqnr);
+	chacha_ivsetup(&ctx->header_ctx, seqbuf, NULL);
+	chacha_encrypt_bytes(&ctx->header_ctx, cp, buf, 4);
+	*plenp = PEEK_U32(buf);
+	return 0;
+}
+
+/*
+ * Known answer tests, run by /ssh-cipherbench before it measures anything.
+ * ChaCha20 and Poly1305 use the vectors of RFC 8439 sections 2.4.2 and
+ * 2.5.2. The RFC 8439 nonce is 96 bits with a 32 bit counter, while
+ * chacha.c takes a 64 bit IV and a 64 bit counter, so the last 8 nonce
+ * bytes are the IV and the counter is 1. The packet vector was made with
+ * the OpenSSL 3.0 ChaCha20 and Poly1305 implementations: key 0x40..0x7f,
+ * sequence number 7 and an SSH2_MSG_SERVICE_REQUEST "ssh-userauth" packet.
+ * Returns 0 if all of them pass and -1 otherwise.
+ */
+static const char selftest_plain[] =
+	"Ladies and Gentlemen of the class of '99: If I could offer you "
+	"only one tip for the future, sunscreen would be it.";
+
+static const u_char selftest_chacha_cipher[114] = {
+	0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80, 0x41, 0xba, 0x07, 0x28,
+	0xdd, 0x0d, 0x69, 0x81, 0xe9, 0x7e, 0x7a, 0xec, 0x1d, 0x43, 0x60, 0xc2,
+	0x0a, 0x27, 0xaf, 0xcc, 0xfd, 0x9f, 0xae, 0x0b, 0xf9, 0x1b, 0x65, 0xc5,
+	0x52, 0x47, 0x33, 0xab, 0x8f, 0x59, 0x3d, 0xab, 0xcd, 0x62, 0xb3, 0x57,
+	0x16, 0x39, 0xd6, 0x24, 0xe6, 0x51, 0x52, 0xab, 0x8f, 0x53, 0x0c, 0x35,
+	0x9f, 0x08, 0x61, 0xd8, 0x07, 0xca, 0x0d, 0xbf, 0x50, 0x0d, 0x6a, 0x61,
+	0x56, 0xa3, 0x8e, 0x08, 0x8a, 0x22, 0xb6, 0x5e, 0x52, 0xbc, 0x51, 0x4d,
+	0x16, 0xcc, 0xf8, 0x06, 0x81, 0x8c, 0xe9, 0x1a, 0xb7, 0x79, 0x37, 0x36,
+	0x5a, 0xf9, 0x0b, 0xbf, 0x74, 0xa3, 0x5b, 0xe6, 0xb4, 0x0b, 0x8e, 0xed,
+	0xf2, 0x78, 0x5e, 0x42, 0x87, 0x4d
+};
+
+static const u_char selftest_poly_key[POLY1305_KEYLEN] = {
+	0x85, 0xd6, 0xbe, 0x78, 0x57, 0x55, 0x6d, 0x33, 0x7f, 0x44, 0x52, 0xfe,
+	0x42, 0xd5, 0x06, 0xa8, 0x01, 0x03, 0x80, 0x8a, 0xfb, 0x0d, 0xb2, 0xfd,
+	0x4a, 0xbf, 0xf6, 0xaf, 0x41, 0x49, 0xf5, 0x1b
+};
+
+static const u_char selftest_poly_tag[POLY1305_TAGLEN] = {
+	0xa8, 0x06, 0x1d, 0xc1, 0x30, 0x51, 0x36, 0xc6, 0xc2, 0x2b, 0x8b, 0xaf,
+	0x0c, 0x01, 0x27, 0xa9
+};
+
+static const u_char selftest_packet[32] = {
+	0x00, 0x00, 0x00, 0x1c, 0x0a, 0x05, 0x00, 0x00, 0x00, 0x0c, 0x73, 0x73,
+	0x68, 0x2d, 0x75, 0x73, 0x65, 0x72, 0x61, 0x75, 0x74, 0x68, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static const u_char selftest_packet_cipher[32 + POLY1305_TAGLEN] = {
+	0xf3, 0x8e, 0xb4, 0xf6, 0x55, 0x51, 0x7b, 0x33, 0xa1, 0x20, 0x4d, 0x62,
+	0xff, 0x33, 0x7f, 0x8f, 0xf7, 0xd0, 0xbb, 0x38, 0x53, 0x59, 0xa8, 0xc3,
+	0x44, 0x24, 0x05, 0xd2, 0x61, 0x13, 0x45, 0x3c, 0x2e, 0xea, 0x49, 0x06,
+	0x2a, 0x21, 0xd1, 0x80, 0xec, 0x88, 0xf7, 0xa1, 0x68, 0x34, 0x50, 0x98
+};
+
+int
+chachapoly_selftest(void)
+{
+	struct chacha_ctx cc;
+	struct chachapoly_ctx cpctx;
+	const u_char iv[8] = { 0, 0, 0, 0x4a, 0, 0, 0, 0 };
+	const u_char ctr[8] = { 1, 0, 0, 0, 0, 0, 0, 0 };
+	u_char key[64], buf[sizeof(selftest_packet_cipher)];
+	u_char out[sizeof(selftest_chacha_cipher)];
+	u_char tag[POLY1305_TAGLEN];
+	u_int i, plen;
+	int r = -1;
+
+	/* RFC 8439 2.4.2 */
+	for (i = 0; i < 32; i++)
+		key[i] = (u_char)i;
+	chacha_keysetup(&cc, key, 256);
+	chacha_ivsetup(&cc, iv, ctr);
+	chacha_encrypt_bytes(&cc, (const u_char *)selftest_plain, out,
+	    sizeof(out));
+	if (memcmp(out, selftest_chacha_cipher, sizeof(out)) != 0)
+		goto out;
+
+	/* RFC 8439 2.5.2 */
+	poly1305_auth(tag, (const u_char *)"Cryptographic Forum Research Group",
+	    34, selftest_poly_key);
+	if (memcmp(tag, selftest_poly_tag, sizeof(tag)) != 0)
+		goto out;
+
+	/* one packet: encrypt, read the length, decrypt, reject a bad tag */
+	for (i = 0; i < sizeof(key); i++)
+		key[i] = (u_char)(0x40 + i);
+	if (chachapoly_init(&cpctx, key, sizeof(key)) != 0 ||
+	    chachapoly_crypt(&cpctx, 7, buf, selftest_packet,
+	    sizeof(selftest_packet) - 4, 4, POLY1305_TAGLEN, 1) != 0 ||
+	    memcmp(buf, selftest_packet_cipher, sizeof(buf)) != 0)
+		goto out;
+	if (chachapoly_get_length(&cpctx, &plen, 7, buf, sizeof(buf)) != 0 ||
+	    plen != sizeof(selftest_packet) - 4)
+		goto out;
+	if (chachapoly_crypt(&cpctx, 7, out, buf,
+	    sizeof(selftest_packet) - 4, 4, POLY1305_TAGLEN, 0) != 0 ||
+	    memcmp(out, selftest_packet, sizeof(selftest_packet)) != 0)
+		goto out;
+	buf[10] ^= 1;
+	if (chachapoly_crypt(&cpctx, 7, out, buf,
+	    sizeof(selftest_packet) - 4, 4, POLY1305_TAGLEN, 0) == 0)
+		goto out;
+	r = 0;
+ out:
+	SecureZeroMemory(&cc, sizeof(cc));
+	SecureZeroMemory(&cpctx, sizeof(cpctx));
+	return r;
+}
@@ -25,21 +25,13 @@
 #include "config.h"
 
 #include <openssl/evp.h>
-#include <openssl/aes.h>
 #include <openssl/des.h>
 #include <openssl/blowfish.h>
 #include <openssl/cast.h>
 #include <openssl/camellia.h>
 
-extern const EVP_CIPHER *evp_aes_128_ctr(void);
 extern const EVP_CIPHER *evp_camellia_128_ctr(void);
 
-struct ssh_aes_ctr_ctx
-{
-	AES_KEY		aes_ctx;
-	unsigned char	aes_counter[AES_BLOCK_SIZE];
-};
-
 #define DES_BLOCK_SIZE sizeof(DES_cblock)
 struct ssh_des3_ctr_ctx
 {
@@ -76,103 +68,87 @@ ssh_ctr_inc(unsigned char *ctr, unsigned int len)
 }
 
 //============================================================================
-// AES
+// keystream
 //============================================================================
-static int
-ssh_aes_ctr(EVP_CIPHER_CTX *ctx, unsigned char *dest, const unsigned char *src, unsigned int len)
-{
-	struct ssh_aes_ctr_ctx *c;
-	unsigned int n = 0;
-	unsigned char buf[AES_BLOCK_SIZE];
-
-	if (len == 0)
-		return (1);
-	if ((c = EVP_CIPHER_CTX_get_app_data(ctx)) == NULL)
-		return (0);
+/*
+ * The counter blocks for up to CTR_KEYSTREAM_BLOCKS cipher blocks are
+ * written at once, encrypted in place and XORed with the data a word at a
+ * time.  As before, every call starts on a fresh counter block; SSH always
+ * passes a multiple of the block size.
+ * (aes*-ctr use EVP_aes_*_ctr() of OpenSSL, see ssh2_ciphers in ssh.h)
+ */
+#define CTR_KEYSTREAM_BLOCKS	16
+#define CTR_MAX_BLOCK_SIZE	16
 
-	while ((len--) > 0) {
-		if (n == 0) {
-			AES_encrypt(c->aes_counter, buf, &c->aes_ctx);
-			ssh_ctr_inc(c->aes_counter, AES_BLOCK_SIZE);
-		}
-		*(dest++) = *(src++) ^ buf[n];
-		n = (n + 1) % AES_BLOCK_SIZE;
-	}
-	return (1);
-}
+typedef void (*ctr_block_encrypt)(void *c, unsigned char *block);
 
-static int
-ssh_aes_ctr_init(EVP_CIPHER_CTX *ctx, const unsigned char *key, const unsigned char *iv, int enc)
+static void
+ssh_ctr_xor(unsigned char *dest, const unsigned char *src, const unsigned char *ks, unsigned int len)
 {
-	struct ssh_aes_ctr_ctx *c;
+	unsigned int i = 0;
 
-	if ((c = EVP_CIPHER_CTX_get_app_data(ctx)) == NULL) {
-		c = malloc(sizeof(*c));
-		EVP_CIPHER_CTX_set_app_data(ctx, c);
+	if ((((size_t)dest | (size_t)src) & (sizeof(size_t) - 1)) == 0) {
+		for (; i + sizeof(size_t) <= len; i += sizeof(size_t))
+			*(size_t *)(dest + i) = *(const size_t *)(src + i) ^ *(const size_t *)(ks + i);
 	}
-	if (key != NULL)
-		AES_set_encrypt_key(key, EVP_CIPHER_CTX_key_length(ctx) * 8, &c->aes_ctx);
-	if (iv != NULL)
-		memcpy(c->aes_counter, iv, AES_BLOCK_SIZE);
-	return (1);
+	for (; i < len; i++)
+		dest[i] = src[i] ^ ks[i];
 }
 
-static int
-ssh_aes_ctr_cleanup(EVP_CIPHER_CTX *ctx)
+static void
+ssh_ctr_crypt(void *c, ctr_block_encrypt encrypt, unsigned char *counter, unsigned int bsize,
+              unsigned char *dest, const unsigned char *src, unsigned int len)
 {
-	struct ssh_aes_ctr_ctx *c;
-
-	if((c = EVP_CIPHER_CTX_get_app_data(ctx)) != NULL) {
-		SecureZeroMemory(c, sizeof(*c));
-		free(c);
-		EVP_CIPHER_CTX_set_app_data(ctx, NULL);
+	union {
+		unsigned char	b[CTR_KEYSTREAM_BLOCKS * CTR_MAX_BLOCK_SIZE];
+		size_t		align;
+	} ks;
+	unsigned int blocks, n, i;
+
+	while (len > 0) {
+		blocks = (len + bsize - 1) / bsize;
+		if (blocks > CTR_KEYSTREAM_BLOCKS)
+			blocks = CTR_KEYSTREAM_BLOCKS;
+		for (i = 0; i < blocks; i++) {
+			memcpy(ks.b + i * bsize, counter, bsize);
+			ssh_ctr_inc(counter, bsize);
+		}
+		for (i = 0; i < blocks; i++)
+			encrypt(c, ks.b + i * bsize);
+
+		n = blocks * bsize;
+		if (n > len)
+			n = len;
+		ssh_ctr_xor(dest, src, ks.b, n);
+		dest += n;
+		src += n;
+		len -= n;
 	}
-	return (1);
-}
-
-const EVP_CIPHER *
-evp_aes_128_ctr(void)
-{
-	static EVP_CIPHER aes_ctr;
-
-	memset(&aes_ctr, 0, sizeof(EVP_CIPHER));
-	aes_ctr.nid = NID_undef;
-	aes_ctr.block_size = AES_BLOCK_SIZE;
-	aes_ctr.iv_len = AES_BLOCK_SIZE;
-	aes_ctr.key_len = 16;
-	aes_ctr.init = ssh_aes_ctr_init;
-	aes_ctr.cleanup = ssh_aes_ctr_cleanup;
-	aes_ctr.do_cipher = ssh_aes_ctr;
-#ifndef SSH_OLD_EVP
-	aes_ctr.flags = EVP_CIPH_CBC_MODE | EVP_CIPH_VARIABLE_LENGTH | EVP_CIPH_ALWAYS_CALL_INIT | EVP_CIPH_CUSTOM_IV;
-#endif
-	return (&aes_ctr);
+	SecureZeroMemory(&ks, sizeof(ks));
 }
 
 //============================================================================
 // Triple-DES
 //============================================================================
+static void
+ssh_des3_ctr_block(void *ctx, unsigned char *block)
+{
+	struct ssh_des3_ctr_ctx *c = ctx;
+
+	DES_encrypt3((DES_LONG *)block, &c->des3_ctx[0], &c->des3_ctx[1], &c->des3_ctx[2]);
+}
+
 static int
 ssh_des3_ctr(EVP_CIPHER_CTX *ctx, unsigned char *dest, const unsigned char *src, unsigned int len)
 {
 	struct ssh_des3_ctr_ctx *c;
-	unsigned int n = 0;
-	unsigned char buf[DES_BLOCK_SIZE];
 
 	if (len == 0)
 		return (1);
 	if ((c = EVP_CIPHER_CTX_get_app_data(ctx)) == NULL)
 		return (0);
 
-	while ((len--) > 0) {
-		if (n == 0) {
-			memcpy(buf, (unsigned char *)(c->des3_counter), DES_BLOCK_SIZE);
-			DES_encrypt3((DES_LONG *)buf, &c->des3_ctx[0], &c->des3_ctx[1], &c->des3_ctx[2]);
-			ssh_ctr_inc(c->des3_counter, DES_BLOCK_SIZE);
-		}
-		*(dest++) = *(src++) ^ buf[n];
-		n = (n + 1) % DES_BLOCK_SIZE;
-	}
+	ssh_ctr_crypt(c, ssh_des3_ctr_block, c->des3_counter, DES_BLOCK_SIZE, dest, src, len);
 	return (1);
 }
 
@@ -231,44 +207,38 @@ evp_des3_ctr(void)
 //============================================================================
 // Blowfish
 //============================================================================
+static void
+ssh_bf_ctr_block(void *ctx, unsigned char *block)
+{
+	struct ssh_blowfish_ctr_ctx *c = ctx;
+	BF_LONG tmp[2];
+
+	tmp[0] = ((BF_LONG)block[0] << 24) | ((BF_LONG)block[1] << 16) | ((BF_LONG)block[2] << 8) | block[3];
+	tmp[1] = ((BF_LONG)block[4] << 24) | ((BF_LONG)block[5] << 16) | ((BF_LONG)block[6] << 8) | block[7];
+
+	BF_encrypt(tmp, &c->blowfish_ctx);
+
+	block[0] = (unsigned char)(tmp[0] >> 24);
+	block[1] = (unsigned char)(tmp[0] >> 16);
+	block[2] = (unsigned char)(tmp[0] >> 8);
+	block[3] = (unsigned char)tmp[0];
+	block[4] = (unsigned char)(tmp[1] >> 24);
+	block[5] = (unsigned char)(tmp[1] >> 16);
+	block[6] = (unsigned char)(tmp[1] >> 8);
+	block[7] = (unsigned char)tmp[1];
+}
+
 static int
 ssh_bf_ctr(EVP_CIPHER_CTX *ctx, unsigned char *dest, const unsigned char *src, unsigned int len)
 {
 	struct ssh_blowfish_ctr_ctx *c;
-	unsigned int n = 0;
-	unsigned char buf[BF_BLOCK];
-	int i, j;
-	BF_LONG tmp[(BF_BLOCK + 3) / 4];
-	unsigned char *p;
 
 	if (len == 0)
 		return (1);
 	if ((c = EVP_CIPHER_CTX_get_app_data(ctx)) == NULL)
 		return (0);
 
-	while ((len--) > 0) {
-		if (n == 0) {
-			for (i = j = 0, p = c->blowfish_counter; i < BF_BLOCK; i += 4, j++) {
-				tmp[j]  = ((BF_LONG)*p++) << 24;
-				tmp[j] |= ((BF_LONG)*p++) << 16;
-				tmp[j] |= ((BF_LONG)*p++) << 8;
-				tmp[j] |= ((BF_LONG)*p++);
-			}
-
-			BF_encrypt(tmp, &c->blowfish_ctx);
-
-			for (i = j = 0, p = buf; i < BF_BLOCK; i += 4, j++) {
-				*p++ = (unsigned char)(tmp[j] >> 24);
-				*p++ = (unsigned char)(tmp[j] >> 16);
-				*p++ = (unsigned char)(tmp[j] >> 8);
-				*p++ = (unsigned char)tmp[j];
-			}
-
-			ssh_ctr_inc(c->blowfish_counter, BF_BLOCK);
-		}
-		*(dest++) = *(src++) ^ buf[n];
-		n = (n + 1) % BF_BLOCK;
-	}
+	ssh_ctr_crypt(c, ssh_bf_ctr_block, c->blowfish_counter, BF_BLOCK, dest, src, len);
 	return (1);
 }
 
@@ -325,44 +295,38 @@ evp_bf_ctr(void)
 //============================================================================
 // CAST-128
 //============================================================================
+static void
+ssh_cast5_ctr_block(void *ctx, unsigned char *block)
+{
+	struct ssh_cast5_ctr_ctx *c = ctx;
+	CAST_LONG tmp[2];
+
+	tmp[0] = ((CAST_LONG)block[0] << 24) | ((CAST_LONG)block[1] << 16) | ((CAST_LONG)block[2] << 8) | block[3];
+	tmp[1] = ((CAST_LONG)block[4] << 24) | ((CAST_LONG)block[5] << 16) | ((CAST_LONG)block[6] << 8) | block[7];
+
+	CAST_encrypt(tmp, &c->cast5_ctx);
+
+	block[0] = (unsigned char)(tmp[0] >> 24);
+	block[1] = (unsigned char)(tmp[0] >> 16);
+	block[2] = (unsigned char)(tmp[0] >> 8);
+	block[3] = (unsigned char)tmp[0];
+	block[4] = (unsigned char)(tmp[1] >> 24);
+	block[5] = (unsigned char)(tmp[1] >> 16);
+	block[6] = (unsigned char)(tmp[1] >> 8);
+	block[7] = (unsigned char)tmp[1];
+}
+
 static int
 ssh_cast5_ctr(EVP_CIPHER_CTX *ctx, unsigned char *dest, const unsigned char *src, unsigned int len)
 {
 	struct ssh_cast5_ctr_ctx *c;
-	unsigned int n = 0;
-	unsigned char buf[CAST_BLOCK];
-	int i, j;
-	CAST_LONG tmp[(CAST_BLOCK + 3) / 4];
-	unsigned char *p;
 
 	if (len == 0)
 		return (1);
 	if ((c = EVP_CIPHER_CTX_get_app_data(ctx)) == NULL)
 		return (0);
 
-	while ((len--) > 0) {
-		if (n == 0) {
-			for (i = j = 0, p = c->cast5_counter; i < CAST_BLOCK; i += 4, j++) {
-				tmp[j]  = ((CAST_LONG)*p++) << 24;
-				tmp[j] |= ((CAST_LONG)*p++) << 16;
-				tmp[j] |= ((CAST_LONG)*p++) << 8;
-				tmp[j] |= ((CAST_LONG)*p++);
-			}
-
-			CAST_encrypt(tmp, &c->cast5_ctx);
-
-			for (i = j = 0, p = buf; i < CAST_BLOCK; i += 4, j++) {
-				*p++ = (unsigned char)(tmp[j] >> 24);
-				*p++ = (unsigned char)(tmp[j] >> 16);
-				*p++ = (unsigned char)(tmp[j] >> 8);
-				*p++ = (unsigned char)tmp[j];
-			}
-
-			ssh_ctr_inc(c->cast5_counter, CAST_BLOCK);
-		}
-		*(dest++) = *(src++) ^ buf[n];
-		n = (n + 1) % CAST_BLOCK;
-	}
+	ssh_ctr_crypt(c, ssh_cast5_ctr_block, c->cast5_counter, CAST_BLOCK, dest, src, len);
 	return (1);
 }
 
@@ -419,26 +383,25 @@ evp_cast5_ctr(void)
 //============================================================================
 // Camellia
 //============================================================================
+static void
+ssh_camellia_ctr_block(void *ctx, unsigned char *block)
+{
+	struct ssh_camellia_ctr_ctx *c = ctx;
+
+	Camellia_encrypt(block, block, &c->camellia_ctx);
+}
+
 static int
 ssh_camellia_ctr(EVP_CIPHER_CTX *ctx, unsigned char *dest, const unsigned char *src, unsigned int len)
 {
 	struct ssh_camellia_ctr_ctx *c;
-	unsigned int n = 0;
-	unsigned char buf[CAMELLIA_BLOCK_SIZE];
 
 	if (len == 0)
 		return (1);
 	if ((c = EVP_CIPHER_CTX_get_app_data(ctx)) == NULL)
 		return (0);
 
-	while ((len--) > 0) {
-		if (n == 0) {
-			Camellia_encrypt(c->camellia_counter, buf, &c->camellia_ctx);
-			ssh_ctr_inc(c->camellia_counter, CAMELLIA_BLOCK_SIZE);
-		}
-		*(dest++) = *(src++) ^ buf[n];
-		n = (n + 1) % CAMELLIA_BLOCK_SIZE;
-	}
+	ssh_ctr_crypt(c, ssh_camellia_ctr_block, c->camellia_counter, CAMELLIA_BLOCK_SIZE, dest, src, len);
 	return (1);
 }
 
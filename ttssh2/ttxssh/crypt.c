@@ -41,6 +41,7 @@
 #include <openssl/dsa.h>
 #include "cipher.h"
 #include "ssh.h"
+#include "cipher-chachapoly.h"
 
 #define do_crc(buf, len) (~(uint32)crc32(0xFFFFFFFF, (buf), (len)))
 #define get_uint32(buf) get_uint32_MSBfirst((buf))
@@ -220,6 +221,14 @@ BOOL CRYPT_encrypt_aead(PTInstVar pvar, unsigned char *data, unsigned int bytes,
 		return FALSE;
 	}
 
+	if (pvar->cc[MODE_OUT] != NULL) {
+		// chacha20-poly1305 ̓pPbg(aadlen)ÍA tag t
+		if (chachapoly_crypt(pvar->cc[MODE_OUT], pvar->ssh_state.sender_sequence_number,
+		                     data, data, bytes, aadlen, authlen, 1) != 0)
+			goto err;
+		return TRUE;
+	}
+
 	if (bytes > encbufflen) {
 		if ((newbuff = realloc(encbuff, bytes)) == NULL)
 			goto err;
@@ -274,6 +283,16 @@ BOOL CRYPT_decrypt_aead(PTInstVar pvar, unsigned char *data, unsigned int bytes,
 		return FALSE;
 	}
 
+	if (pvar->cc[MODE_IN] != NULL) {
+		// tag ؂ĂpPbgƃyC[h𕜍
+		// tag ̕sv GCM Ɠl FALSE ԂɂāA
+		// G[̒ʒm͌Ăяo (prep_packet_ssh2) ɔC
+		if (chachapoly_crypt(pvar->cc[MODE_IN], pvar->ssh_state.receiver_sequence_number,
+		                     data, data, bytes, aadlen, authlen, 0) != 0)
+			return FALSE;
+		return TRUE;
+	}
+
 	if (bytes > encbufflen) {
 		if ((newbuff = realloc(encbuff, bytes)) == NULL)
 			goto err;
@@ -308,6 +327,21 @@ err:
 	return FALSE;
 }
 
+// MpPbg̐擪 4 oCgpPbg𓾂B
+// chacha20-poly1305 ł̓pPbgÍĂ̂ŁAŕĕԂB
+// (data ̂ MAC ̌؂ɎĝŏȂ)
+uint32 CRYPT_get_receiver_packet_length(PTInstVar pvar, unsigned char *data)
+{
+	u_int len;
+
+	if (pvar->cc[MODE_IN] != NULL) {
+		chachapoly_get_length(pvar->cc[MODE_IN], &len,
+		                      pvar->ssh_state.receiver_sequence_number, data, 4);
+		return len;
+	}
+	return get_uint32_MSBfirst(data);
+}
+
 static void no_encrypt(PTInstVar pvar, unsigned char *buf, int bytes)
 {
 }
@@ -584,6 +618,7 @@ BOOL CRYPT_set_supported_ciphers(PTInstVar pvar, int sender_ciphers,
 		            | (1 << SSH2_CIPHER_CAMELLIA256_CTR)
 		            | (1 << SSH2_CIPHER_AES128_GCM)
 		            | (1 << SSH2_CIPHER_AES256_GCM)
+		            | (1 << SSH2_CIPHER_CHACHAPOLY)
 		);
 	}
 
@@ -656,7 +691,7 @@ unsigned int CRYPT_get_receiver_MAC_size(PTInstVar pvar)
 BOOL CRYPT_verify_receiver_MAC(PTInstVar pvar, uint32 sequence_number,
 	char *data, int len, char *MAC)
 {
-	HMAC_CTX c;
+	HMAC_CTX *c;
 	unsigned char m[EVP_MAX_MD_SIZE];
 	unsigned char b[4];
 	struct Mac *mac;
@@ -678,12 +713,16 @@ BOOL CRYPT_verify_receiver_MAC(PTInstVar pvar, uint32 sequence_number,
 		goto error;
 	}
 
-	HMAC_Init(&c, mac->key, mac->key_len, mac->md);
+	// ݒς݂̏Ԃɖ߂ (CRYPT_set_MAC_key)
+	c = &pvar->hmac[MODE_IN];
+	if (!HMAC_Init_ex(c, NULL, 0, NULL, NULL)) {
+		logprintf(LOG_LEVEL_VERBOSE, "HMAC is not initialized(seq %lu len %d)", sequence_number, len);
+		goto error;
+	}
 	set_uint32_MSBfirst(b, sequence_number);
-	HMAC_Update(&c, b, sizeof(b));
-	HMAC_Update(&c, data, len);
-	HMAC_Final(&c, m, NULL);
-	HMAC_cleanup(&c);
+	HMAC_Update(c, b, sizeof(b));
+	HMAC_Update(c, data, len);
+	HMAC_Final(c, m, NULL);
 
 	if (memcmp(m, MAC, mac->mac_len)) {
 		logprintf(LOG_LEVEL_VERBOSE, "HMAC key is not matched(seq %lu len %d)", sequence_number, len);
@@ -698,6 +737,22 @@ error:
 	return FALSE;
 }
 
+//
+// SSH2p MAC ̐ݒ ()
+// ipad/opad ̃nbVԂ͂ňxApPbgƂɂ
+// HMAC_Init_ex(c, NULL, 0, NULL, NULL) Ōݒ蒼̏Ԃɖ߂ĎgB
+//
+void CRYPT_set_MAC_key(PTInstVar pvar, int mode)
+{
+	struct Mac *mac = &pvar->ssh2_keys[mode].mac;
+
+	HMAC_CTX_cleanup(&pvar->hmac[mode]);
+	HMAC_CTX_init(&pvar->hmac[mode]);
+	if (mac->key != NULL && mac->md != NULL) {
+		HMAC_Init_ex(&pvar->hmac[mode], mac->key, mac->key_len, mac->md, NULL);
+	}
+}
+
 unsigned int CRYPT_get_sender_MAC_size(PTInstVar pvar)
 {
 	struct Mac *mac;
@@ -717,7 +772,7 @@ unsigned int CRYPT_get_sender_MAC_size(PTInstVar pvar)
 BOOL CRYPT_build_sender_MAC(PTInstVar pvar, uint32 sequence_number,
                             char *data, int len, char *MAC)
 {
-	HMAC_CTX c;
+	HMAC_CTX *c;
 	static u_char m[EVP_MAX_MD_SIZE];
 	u_char b[4];
 	struct Mac *mac;
@@ -727,12 +782,13 @@ BOOL CRYPT_build_sender_MAC(PTInstVar pvar, uint32 sequence_number,
 		if (mac == NULL || mac->enabled == 0) 
 			return FALSE;
 
-		HMAC_Init(&c, mac->key, mac->key_len, mac->md);
+		c = &pvar->hmac[MODE_OUT];
+		if (!HMAC_Init_ex(c, NULL, 0, NULL, NULL))
+			return FALSE;
 		set_uint32_MSBfirst(b, sequence_number);
-		HMAC_Update(&c, b, sizeof(b));
-		HMAC_Update(&c, data, len);
-		HMAC_Final(&c, m, NULL);
-		HMAC_cleanup(&c);
+		HMAC_Update(c, b, sizeof(b));
+		HMAC_Update(c, data, len);
+		HMAC_Final(c, m, NULL);
 
 		// 20oCgRs[
 		memcpy(MAC, m, pvar->ssh2_keys[MODE_OUT].mac.mac_len);
@@ -1070,6 +1126,137 @@ void cipher_cleanup_SSH2(EVP_CIPHER_CTX *evp)
 	EVP_CIPHER_CTX_cleanup(evp);
 }
 
+//
+// chacha20-poly1305 ̏
+// EVP ͎g킸AƂ pvar->cc[] ɃReLXgB
+//
+static void chachapoly_cleanup_SSH2(PTInstVar pvar, int mode)
+{
+	if (pvar->cc[mode] != NULL) {
+		SecureZeroMemory(pvar->cc[mode], sizeof(struct chachapoly_ctx));
+		free(pvar->cc[mode]);
+		pvar->cc[mode] = NULL;
+	}
+}
+
+static void chachapoly_init_SSH2(PTInstVar pvar, int mode, const u_char *key, u_int keylen)
+{
+	char tmp[80];
+
+	chachapoly_cleanup_SSH2(pvar, mode);
+	pvar->cc[mode] = malloc(sizeof(struct chachapoly_ctx));
+	if (pvar->cc[mode] == NULL || chachapoly_init(pvar->cc[mode], key, keylen) != 0) {
+		UTIL_get_lang_msg("MSG_CIPHER_INIT_ERROR", pvar, "Cipher initialize error(%d)");
+		_snprintf_s(tmp, sizeof(tmp), _TRUNCATE, pvar->ts->UIMsg, 8);
+		notify_fatal_error(pvar, tmp, TRUE);
+	}
+}
+
+//
+// SSH2pÍASỸX[vbgv (/ssh-cipherbench)
+// ssh2_ciphers ̑SGg 32KB ̃pPbg 1 bԈÍA
+// ʂ TTSSH.LOG ɏo͂B
+// v̑OɁAOŎĂ chacha20-poly1305 m̒lŌB
+//
+#define CIPHER_BENCH_PACKET	32768
+#define CIPHER_BENCH_MSEC	1000
+#define CIPHER_BENCH_BUFSIZE	(4 + CIPHER_BENCH_PACKET + 16)	// pPbg + yC[h + tag
+
+void CRYPT_cipher_benchmark(PTInstVar pvar)
+{
+	SSH2Cipher *cipher;
+	EVP_CIPHER_CTX evp;
+	struct chachapoly_ctx cc;
+	unsigned char key[64], iv[32], lastiv[1];
+	unsigned char *src, *dst;
+	unsigned int authlen;
+	DWORD stime, elapsed;
+	unsigned long bytes;
+	int loglevel = pvar->settings.LogLevel;
+	BOOL ok, selftest;
+
+	src = malloc(CIPHER_BENCH_BUFSIZE);
+	dst = malloc(CIPHER_BENCH_BUFSIZE);
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		return;
+	}
+	memset(src, 0x5a, CIPHER_BENCH_BUFSIZE);
+	memset(key, 0x11, sizeof(key));
+	memset(iv, 0x22, sizeof(iv));
+
+	if (pvar->settings.LogLevel < LOG_LEVEL_NOTICE) {
+		pvar->settings.LogLevel = LOG_LEVEL_NOTICE;
+	}
+	logprintf(LOG_LEVEL_NOTICE, __FUNCTION__ ": %s, %d bytes/packet",
+	          SSLeay_version(SSLEAY_VERSION), CIPHER_BENCH_PACKET);
+
+	selftest = chachapoly_selftest() == 0;
+	logprintf(LOG_LEVEL_NOTICE, "chacha20-poly1305 known answer test: %s", selftest ? "ok" : "FAILED");
+
+	for (cipher = ssh2_ciphers; cipher->name != NULL; cipher++) {
+		authlen = get_cipher_auth_len(cipher);
+
+		if (cipher->id == SSH2_CIPHER_CHACHAPOLY) {
+			// EVP gȂ̂ CRYPT_encrypt_aead() Ɠ chachapoly_crypt() Ă
+			ok = selftest && chachapoly_init(&cc, key, get_cipher_key_len(cipher)) == 0;
+			bytes = 0;
+			stime = GetTickCount();
+			do {
+				ok = ok && chachapoly_crypt(&cc, bytes / CIPHER_BENCH_PACKET, dst, src,
+				                            CIPHER_BENCH_PACKET, 4, authlen, 1) == 0;
+				bytes += CIPHER_BENCH_PACKET;
+				elapsed = GetTickCount() - stime;
+			} while (ok && elapsed < CIPHER_BENCH_MSEC);
+			SecureZeroMemory(&cc, sizeof(cc));
+		}
+		else {
+			cipher_init_SSH2(&evp, key, get_cipher_key_len(cipher),
+			                 iv, get_cipher_iv_len(cipher),
+			                 CIPHER_ENCRYPT,
+			                 get_cipher_EVP_CIPHER(cipher),
+			                 get_cipher_discard_len(cipher),
+			                 authlen,
+			                 pvar);
+
+			ok = TRUE;
+			bytes = 0;
+			stime = GetTickCount();
+			do {
+				if (authlen > 0) {
+					// CRYPT_encrypt_aead() Ɠ菇 (AAD ̓pPbg 4 oCg)
+					ok = EVP_CIPHER_CTX_ctrl(&evp, EVP_CTRL_GCM_IV_GEN, 1, lastiv) &&
+					     EVP_Cipher(&evp, NULL, src, 4) >= 0 &&
+					     EVP_Cipher(&evp, dst, src + 4, CIPHER_BENCH_PACKET) >= 0 &&
+					     EVP_Cipher(&evp, NULL, NULL, 0) >= 0 &&
+					     EVP_CIPHER_CTX_ctrl(&evp, EVP_CTRL_GCM_GET_TAG, authlen, dst + CIPHER_BENCH_PACKET);
+				}
+				else {
+					ok = EVP_Cipher(&evp, dst, src, CIPHER_BENCH_PACKET) != 0;
+				}
+				bytes += CIPHER_BENCH_PACKET;
+				elapsed = GetTickCount() - stime;
+			} while (ok && elapsed < CIPHER_BENCH_MSEC);
+
+			cipher_cleanup_SSH2(&evp);
+		}
+
+		if (!ok) {
+			logprintf(LOG_LEVEL_NOTICE, "%-28s error", cipher->name);
+		}
+		else {
+			logprintf(LOG_LEVEL_NOTICE, "%-28s %8.1f MB/s", cipher->name,
+			          bytes / 1048576.0 * 1000 / (elapsed ? elapsed : 1));
+		}
+	}
+
+	pvar->settings.LogLevel = loglevel;
+	SecureZeroMemory(dst, CIPHER_BENCH_BUFSIZE);
+	free(src);
+	free(dst);
+}
+
 
 BOOL CRYPT_start_encryption(PTInstVar pvar, int sender_flag, int receiver_flag)
 {
@@ -1110,14 +1297,20 @@ BOOL CRYPT_start_encryption(PTInstVar pvar, int sender_flag, int receiver_flag)
 			cipher = pvar->ciphers[MODE_OUT];
 			if (cipher) {
 				enc = &pvar->ssh2_keys[MODE_OUT].enc;
-				cipher_init_SSH2(&pvar->evpcip[MODE_OUT],
-				                 enc->key, get_cipher_key_len(cipher),
-				                 enc->iv, get_cipher_iv_len(cipher),
-				                 CIPHER_ENCRYPT,
-				                 get_cipher_EVP_CIPHER(cipher),
-				                 get_cipher_discard_len(cipher),
-				                 get_cipher_auth_len(cipher),
-				                 pvar);
+				if (cipher->id == SSH2_CIPHER_CHACHAPOLY) {
+					chachapoly_init_SSH2(pvar, MODE_OUT, enc->key, get_cipher_key_len(cipher));
+				}
+				else {
+					chachapoly_cleanup_SSH2(pvar, MODE_OUT);
+					cipher_init_SSH2(&pvar->evpcip[MODE_OUT],
+					                 enc->key, get_cipher_key_len(cipher),
+					                 enc->iv, get_cipher_iv_len(cipher),
+					                 CIPHER_ENCRYPT,
+					                 get_cipher_EVP_CIPHER(cipher),
+					                 get_cipher_discard_len(cipher),
+					                 get_cipher_auth_len(cipher),
+					                 pvar);
+				}
 
 				pvar->crypt_state.encrypt = crypt_SSH2_encrypt;
 			}
@@ -1158,14 +1351,20 @@ BOOL CRYPT_start_encryption(PTInstVar pvar, int sender_flag, int receiver_flag)
 			cipher = pvar->ciphers[MODE_IN];
 			if (cipher) {
 				enc = &pvar->ssh2_keys[MODE_IN].enc;
-				cipher_init_SSH2(&pvar->evpcip[MODE_IN],
-				                 enc->key, get_cipher_key_len(cipher),
-				                 enc->iv, get_cipher_iv_len(cipher),
-				                 CIPHER_DECRYPT,
-				                 get_cipher_EVP_CIPHER(cipher),
-				                 get_cipher_discard_len(cipher),
-				                 get_cipher_auth_len(cipher),
-				                 pvar);
+				if (cipher->id == SSH2_CIPHER_CHACHAPOLY) {
+					chachapoly_init_SSH2(pvar, MODE_IN, enc->key, get_cipher_key_len(cipher));
+				}
+				else {
+					chachapoly_cleanup_SSH2(pvar, MODE_IN);
+					cipher_init_SSH2(&pvar->evpcip[MODE_IN],
+					                 enc->key, get_cipher_key_len(cipher),
+					                 enc->iv, get_cipher_iv_len(cipher),
+					                 CIPHER_DECRYPT,
+					                 get_cipher_EVP_CIPHER(cipher),
+					                 get_cipher_discard_len(cipher),
+					                 get_cipher_auth_len(cipher),
+					                 pvar);
+				}
 
 				pvar->crypt_state.decrypt = crypt_SSH2_decrypt;
 			}
@@ -1199,6 +1398,12 @@ void CRYPT_init(PTInstVar pvar)
 	pvar->crypt_state.detect_attack_statics.h = NULL;
 	pvar->crypt_state.detect_attack_statics.n =
 		HASH_MINSIZE / HASH_ENTRYSIZE;
+
+	HMAC_CTX_init(&pvar->hmac[MODE_IN]);
+	HMAC_CTX_init(&pvar->hmac[MODE_OUT]);
+
+	pvar->cc[MODE_IN] = NULL;
+	pvar->cc[MODE_OUT] = NULL;
 }
 
 static char *get_cipher_name(int cipher)
@@ -1260,6 +1465,8 @@ static char *get_cipher_name(int cipher)
 		return "aes128-gcm@openssh.com";
 	case SSH2_CIPHER_AES256_GCM:
 		return "aes256-gcm@openssh.com";
+	case SSH2_CIPHER_CHACHAPOLY:
+		return "chacha20-poly1305@openssh.com";
 
 	default:
 		return "Unknown";
@@ -1337,6 +1544,12 @@ void CRYPT_end(PTInstVar pvar)
 	       sizeof(pvar->crypt_state.client_cookie));
 	SecureZeroMemory(&pvar->crypt_state.enc, sizeof(pvar->crypt_state.enc));
 	SecureZeroMemory(&pvar->crypt_state.dec, sizeof(pvar->crypt_state.dec));
+
+	HMAC_CTX_cleanup(&pvar->hmac[MODE_IN]);
+	HMAC_CTX_cleanup(&pvar->hmac[MODE_OUT]);
+
+	chachapoly_cleanup_SSH2(pvar, MODE_IN);
+	chachapoly_cleanup_SSH2(pvar, MODE_OUT);
 }
 
 int CRYPT_passphrase_decrypt(int cipher, char *passphrase,
@@ -138,6 +138,7 @@ unsigned int CRYPT_get_sender_MAC_size(PTInstVar pvar);
 
 BOOL CRYPT_build_sender_MAC(PTInstVar pvar, uint32 sequence_number,
   char *data, int len, char *MAC);
+void CRYPT_set_MAC_key(PTInstVar pvar, int mode);
 
 BOOL CRYPT_set_supported_ciphers(PTInstVar pvar, int sender_ciphers, int receiver_ciphers);
 BOOL CRYPT_choose_ciphers(PTInstVar pvar);
@@ -152,8 +153,10 @@ unsigned int CRYPT_get_encryption_block_size(PTInstVar pvar);
 
 BOOL CRYPT_encrypt_aead(PTInstVar pvar, unsigned char *data, unsigned int len, unsigned int aadlen, unsigned int authlen);
 BOOL CRYPT_decrypt_aead(PTInstVar pvar, unsigned char *data, unsigned int len, unsigned int aadlen, unsigned int authlen);
+uint32 CRYPT_get_receiver_packet_length(PTInstVar pvar, unsigned char *data);
 
 BOOL CRYPT_detect_attack(PTInstVar pvar, unsigned char *buf, int bytes);
+void CRYPT_cipher_benchmark(PTInstVar pvar);
 int CRYPT_passphrase_decrypt(int cipher, char *passphrase, char *buf, int len);
 RSA *make_key(PTInstVar pvar,
                   int bits, unsigned char *exp,
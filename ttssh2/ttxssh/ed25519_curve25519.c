@@ -0,0 +1,113 @@
+/*
+ * (C) 2017 TeraTerm Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * X25519 (RFC 7748) on top of the fe25519 field arithmetic of ed25519.
+ * The Montgomery ladder always runs 255 steps and swaps with fe25519_cmov,
+ * so neither the branches nor the memory accesses depend on the scalar.
+ */
+
+#include <string.h>
+#include <windows.h>
+
+#include "ed25519_crypto_api.h"
+#include "ed25519_fe25519.h"
+
+static void fe25519_cswap(fe25519 *a, fe25519 *b, unsigned char swap)
+{
+	fe25519 t = *a;
+
+	fe25519_cmov(a, b, swap);
+	fe25519_cmov(b, &t, swap);
+}
+
+/* (486662 - 2) / 4 = 121665 */
+static const unsigned char a24_bytes[32] = {0x41, 0xdb, 0x01};
+
+int crypto_scalarmult_curve25519(unsigned char *q, const unsigned char *n,
+    const unsigned char *p)
+{
+	unsigned char e[32];
+	fe25519 x1, x2, z2, x3, z3;
+	fe25519 a, aa, b, bb, c, d, da, cb, t, a24;
+	unsigned char swap = 0, bit;
+	int pos;
+
+	/* clamp the scalar */
+	memcpy(e, n, sizeof(e));
+	e[0] &= 248;
+	e[31] &= 127;
+	e[31] |= 64;
+
+	/* fe25519_unpack() ignores the top bit of u */
+	fe25519_unpack(&x1, p);
+	fe25519_setone(&x2);
+	fe25519_setzero(&z2);
+	x3 = x1;
+	fe25519_setone(&z3);
+
+	fe25519_unpack(&a24, a24_bytes);
+
+	for (pos = 254; pos >= 0; pos--) {
+		bit = (e[pos >> 3] >> (pos & 7)) & 1;
+		swap ^= bit;
+		fe25519_cswap(&x2, &x3, swap);
+		fe25519_cswap(&z2, &z3, swap);
+		swap = bit;
+
+		fe25519_add(&a, &x2, &z2);
+		fe25519_square(&aa, &a);
+		fe25519_sub(&b, &x2, &z2);
+		fe25519_square(&bb, &b);
+		fe25519_add(&c, &x3, &z3);
+		fe25519_sub(&d, &x3, &z3);
+		fe25519_mul(&da, &d, &a);
+		fe25519_mul(&cb, &c, &b);
+
+		fe25519_add(&t, &da, &cb);
+		fe25519_square(&x3, &t);
+		fe25519_sub(&t, &da, &cb);
+		fe25519_square(&t, &t);
+		fe25519_mul(&z3, &x1, &t);
+
+		fe25519_mul(&x2, &aa, &bb);
+		fe25519_sub(&t, &aa, &bb);	/* E = AA - BB */
+		fe25519_mul(&z2, &a24, &t);
+		fe25519_add(&z2, &z2, &aa);
+		fe25519_mul(&z2, &z2, &t);
+	}
+	fe25519_cswap(&x2, &x3, swap);
+	fe25519_cswap(&z2, &z3, swap);
+
+	fe25519_invert(&z2, &z2);
+	fe25519_mul(&x2, &x2, &z2);
+	fe25519_pack(q, &x2);
+
+	SecureZeroMemory(e, sizeof(e));
+	return 0;
+}
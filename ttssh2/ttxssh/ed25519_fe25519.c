@@ -6,219 +6,276 @@
  * Copied from supercop-20130419/crypto_sign/ed25519/ref/fe25519.c
  */
 
+/*
+ * TeraTerm: field elements are 10 signed limbs of alternately 26 and 25 bits
+ * (radix 2^25.5, the representation of SUPERCOP ed25519/ref10) instead of
+ * the 32 limbs of 8 bits of the ref code.  A multiplication is 100 (square:
+ * 55) 32x32->64 bit products, which a 32-bit build does in one instruction.
+ * The interface is unchanged.  The ref code is kept in ed25519_fe25519_ref.c
+ * and ttssh2/crypttest checks this file against it.
+ *
+ * Every function leaves its result carried, i.e. |v[i]| <= 2^25 (even i)
+ * or 2^24 (odd i) plus a small amount, so any result can be fed into
+ * fe25519_mul() without overflowing the 64-bit sums.
+ */
+
 //#include "includes.h"
 
-#define WINDOWSIZE 1 /* Should be 1,2, or 4 */
-#define WINDOWMASK ((1<<WINDOWSIZE)-1)
+#include <string.h>
 
 #include "ed25519_fe25519.h"
 
 #pragma warning(disable : 4146)
 
-static crypto_uint32 equal(crypto_uint32 a,crypto_uint32 b) /* 16-bit inputs */
-{
-  crypto_uint32 x = a ^ b; /* 0: yes; 1..65535: no */
-  x -= 1; /* 4294967295: yes; 0..65534: no */
-  x >>= 31; /* 1: yes; 0: no */
-  return x;
-}
+#define M(a, b) ((crypto_int64)(a) * (b))
 
-static crypto_uint32 ge(crypto_uint32 a,crypto_uint32 b) /* 16-bit inputs */
-{
-  unsigned int x = a;
-  x -= (unsigned int) b; /* 0..65535: yes; 4294901761..4294967295: no */
-  x >>= 31; /* 0: yes; 1: no */
-  x ^= 1; /* 1: yes; 0: no */
-  return x;
-}
+static const int limb_bits[10] = { 26, 25, 26, 25, 26, 25, 26, 25, 26, 25 };
 
-static crypto_uint32 times19(crypto_uint32 a)
-{
-  return (a << 4) + (a << 1) + a;
-}
+/* propagate carries of 64-bit limbs; 2^255 = 19 */
+#define CARRY(i, bits) \
+	c = (h[i] + ((crypto_int64)1 << ((bits) - 1))) >> (bits); \
+	h[(i) + 1] += c; \
+	h[i] -= c << (bits)
 
-static crypto_uint32 times38(crypto_uint32 a)
+static void carry(fe25519 *r, crypto_int64 h[11])
 {
-  return (a << 5) + (a << 2) + (a << 1);
-}
+	crypto_int64 c;
+	int i;
 
-static void reduce_add_sub(fe25519 *r)
-{
-  crypto_uint32 t;
-  int i,rep;
-
-  for(rep=0;rep<4;rep++)
-  {
-    t = r->v[31] >> 7;
-    r->v[31] &= 127;
-    t = times19(t);
-    r->v[0] += t;
-    for(i=0;i<31;i++)
-    {
-      t = r->v[i] >> 8;
-      r->v[i+1] += t;
-      r->v[i] &= 255;
-    }
-  }
-}
+	CARRY(0, 26); CARRY(1, 25); CARRY(2, 26); CARRY(3, 25); CARRY(4, 26);
+	CARRY(5, 25); CARRY(6, 26); CARRY(7, 25); CARRY(8, 26); CARRY(9, 25);
+	h[0] += h[10] * 19;
+	CARRY(0, 26);
 
-static void reduce_mul(fe25519 *r)
-{
-  crypto_uint32 t;
-  int i,rep;
-
-  for(rep=0;rep<2;rep++)
-  {
-    t = r->v[31] >> 7;
-    r->v[31] &= 127;
-    t = times19(t);
-    r->v[0] += t;
-    for(i=0;i<31;i++)
-    {
-      t = r->v[i] >> 8;
-      r->v[i+1] += t;
-      r->v[i] &= 255;
-    }
-  }
+	for (i = 0; i < 10; i++) {
+		r->v[i] = (crypto_int32)h[i];
+	}
 }
 
 /* reduction modulo 2^255-19 */
-void fe25519_freeze(fe25519 *r) 
+void fe25519_freeze(fe25519 *r)
 {
-  int i;
-  crypto_uint32 m = equal(r->v[31],127);
-  for(i=30;i>0;i--)
-    m &= equal(r->v[i],255);
-  m &= ge(r->v[0],237);
-
-  // warning C4146: t̒lϐ́At^ɃLXgȂ΂Ȃ܂B
-  // FIXME: gccVC++ł͓삪قȂH
-  m = -m;
-
-  r->v[31] -= m&127;
-  for(i=30;i>0;i--)
-    r->v[i] -= m&255;
-  r->v[0] -= m&237;
+	unsigned char s[32];
+
+	fe25519_pack(s, r);
+	fe25519_unpack(r, s);
 }
 
 void fe25519_unpack(fe25519 *r, const unsigned char x[32])
 {
-  int i;
-  for(i=0;i<32;i++) r->v[i] = x[i];
-  r->v[31] &= 127;
+	crypto_uint64 acc = 0;
+	int bits = 0, i, j = 0;
+
+	for (i = 0; i < 10; i++) {
+		while (bits < limb_bits[i] && j < 32) {
+			acc |= (crypto_uint64)x[j++] << bits;
+			bits += 8;
+		}
+		/* the top bit of x[31] is dropped with the last limb */
+		r->v[i] = (crypto_int32)(acc & ((1 << limb_bits[i]) - 1));
+		acc >>= limb_bits[i];
+		bits -= limb_bits[i];
+	}
 }
 
 /* Assumes input x being reduced below 2^255 */
 void fe25519_pack(unsigned char r[32], const fe25519 *x)
 {
-  int i;
-  fe25519 y = *x;
-  fe25519_freeze(&y);
-  for(i=0;i<32;i++) 
-    r[i] = y.v[i];
+	crypto_int32 h[10];
+	crypto_int32 q, c;
+	crypto_uint64 acc = 0;
+	int bits = 0, i, j = 0;
+
+	for (i = 0; i < 10; i++) {
+		h[i] = x->v[i];
+	}
+
+	/* q = floor(x / p), which is 0 or 1 for a carried x */
+	q = (19 * h[9] + (1 << 24)) >> 25;
+	for (i = 0; i < 10; i++) {
+		q = (h[i] + q) >> limb_bits[i];
+	}
+
+	/* x - q * p = x + 19 * q - q * 2^255 */
+	h[0] += 19 * q;
+	for (i = 0; i < 9; i++) {
+		c = h[i] >> limb_bits[i];
+		h[i + 1] += c;
+		h[i] -= c << limb_bits[i];
+	}
+	h[9] &= (1 << 25) - 1;
+
+	for (i = 0; i < 10; i++) {
+		acc |= (crypto_uint64)h[i] << bits;
+		bits += limb_bits[i];
+		while (bits >= 8 || (i == 9 && bits > 0)) {
+			r[j++] = (unsigned char)acc;
+			acc >>= 8;
+			bits -= 8;
+		}
+	}
 }
 
 int fe25519_iszero(const fe25519 *x)
 {
-  int i;
-  int r;
-  fe25519 t = *x;
-  fe25519_freeze(&t);
-  r = equal(t.v[0],0);
-  for(i=1;i<32;i++) 
-    r &= equal(t.v[i],0);
-  return r;
+	unsigned char s[32];
+	unsigned char d = 0;
+	int i;
+
+	fe25519_pack(s, x);
+	for (i = 0; i < 32; i++) {
+		d |= s[i];
+	}
+	return (d - 1) >> 8 & 1;
 }
 
 int fe25519_iseq_vartime(const fe25519 *x, const fe25519 *y)
 {
-  int i;
-  fe25519 t1 = *x;
-  fe25519 t2 = *y;
-  fe25519_freeze(&t1);
-  fe25519_freeze(&t2);
-  for(i=0;i<32;i++)
-    if(t1.v[i] != t2.v[i]) return 0;
-  return 1;
+	unsigned char s1[32], s2[32];
+
+	fe25519_pack(s1, x);
+	fe25519_pack(s2, y);
+	return memcmp(s1, s2, 32) == 0;
 }
 
 void fe25519_cmov(fe25519 *r, const fe25519 *x, unsigned char b)
 {
-  int i;
-  crypto_uint32 mask = b;
-  // warning C4146: t̒lϐ́At^ɃLXgȂ΂Ȃ܂B
-  // FIXME: gccVC++ł͓삪قȂH
-  mask = -mask;
-  for(i=0;i<32;i++) r->v[i] ^= mask & (x->v[i] ^ r->v[i]);
+	int i;
+	crypto_int32 mask = -(crypto_int32)b;
+
+	for (i = 0; i < 10; i++) {
+		r->v[i] ^= mask & (x->v[i] ^ r->v[i]);
+	}
 }
 
 unsigned char fe25519_getparity(const fe25519 *x)
 {
-  fe25519 t = *x;
-  fe25519_freeze(&t);
-  return t.v[0] & 1;
+	unsigned char s[32];
+
+	fe25519_pack(s, x);
+	return s[0] & 1;
 }
 
 void fe25519_setone(fe25519 *r)
 {
-  int i;
-  r->v[0] = 1;
-  for(i=1;i<32;i++) r->v[i]=0;
+	int i;
+
+	r->v[0] = 1;
+	for (i = 1; i < 10; i++) {
+		r->v[i] = 0;
+	}
 }
 
 void fe25519_setzero(fe25519 *r)
 {
-  int i;
-  for(i=0;i<32;i++) r->v[i]=0;
+	int i;
+
+	for (i = 0; i < 10; i++) {
+		r->v[i] = 0;
+	}
 }
 
 void fe25519_neg(fe25519 *r, const fe25519 *x)
 {
-  fe25519 t;
-  int i;
-  for(i=0;i<32;i++) t.v[i]=x->v[i];
-  fe25519_setzero(r);
-  fe25519_sub(r, r, &t);
+	fe25519 t;
+
+	fe25519_setzero(&t);
+	fe25519_sub(r, &t, x);
 }
 
 void fe25519_add(fe25519 *r, const fe25519 *x, const fe25519 *y)
 {
-  int i;
-  for(i=0;i<32;i++) r->v[i] = x->v[i] + y->v[i];
-  reduce_add_sub(r);
+	crypto_int64 h[11];
+	int i;
+
+	for (i = 0; i < 10; i++) {
+		h[i] = (crypto_int64)x->v[i] + y->v[i];
+	}
+	h[10] = 0;
+	carry(r, h);
 }
 
 void fe25519_sub(fe25519 *r, const fe25519 *x, const fe25519 *y)
 {
-  int i;
-  crypto_uint32 t[32];
-  t[0] = x->v[0] + 0x1da;
-  t[31] = x->v[31] + 0xfe;
-  for(i=1;i<31;i++) t[i] = x->v[i] + 0x1fe;
-  for(i=0;i<32;i++) r->v[i] = t[i] - y->v[i];
-  reduce_add_sub(r);
+	crypto_int64 h[11];
+	int i;
+
+	for (i = 0; i < 10; i++) {
+		h[i] = (crypto_int64)x->v[i] - y->v[i];
+	}
+	h[10] = 0;
+	carry(r, h);
 }
 
 void fe25519_mul(fe25519 *r, const fe25519 *x, const fe25519 *y)
 {
-  int i,j;
-  crypto_uint32 t[63];
-  for(i=0;i<63;i++)t[i] = 0;
-
-  for(i=0;i<32;i++)
-    for(j=0;j<32;j++)
-      t[i+j] += x->v[i] * y->v[j];
-
-  for(i=32;i<63;i++)
-    r->v[i-32] = t[i-32] + times38(t[i]); 
-  r->v[31] = t[31]; /* result now in r[0]...r[31] */
-
-  reduce_mul(r);
+	crypto_int32 f0 = x->v[0], f1 = x->v[1], f2 = x->v[2], f3 = x->v[3], f4 = x->v[4];
+	crypto_int32 f5 = x->v[5], f6 = x->v[6], f7 = x->v[7], f8 = x->v[8], f9 = x->v[9];
+	crypto_int32 g0 = y->v[0], g1 = y->v[1], g2 = y->v[2], g3 = y->v[3], g4 = y->v[4];
+	crypto_int32 g5 = y->v[5], g6 = y->v[6], g7 = y->v[7], g8 = y->v[8], g9 = y->v[9];
+	/* limbs that wrap around 2^255 are multiplied by 19 */
+	crypto_int32 g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4, g5_19 = 19 * g5;
+	crypto_int32 g6_19 = 19 * g6, g7_19 = 19 * g7, g8_19 = 19 * g8, g9_19 = 19 * g9;
+	/* odd * odd limbs are 2^51 apart from the position of the product */
+	crypto_int32 f1_2 = 2 * f1, f3_2 = 2 * f3, f5_2 = 2 * f5, f7_2 = 2 * f7, f9_2 = 2 * f9;
+	crypto_int64 h0, h1, h2, h3, h4, h5, h6, h7, h8, h9;
+	crypto_int64 h[11];
+
+	h0 = M(f0, g0) + M(f1_2, g9_19) + M(f2, g8_19) + M(f3_2, g7_19) + M(f4, g6_19) +
+	     M(f5_2, g5_19) + M(f6, g4_19) + M(f7_2, g3_19) + M(f8, g2_19) + M(f9_2, g1_19);
+	h1 = M(f0, g1) + M(f1, g0) + M(f2, g9_19) + M(f3, g8_19) + M(f4, g7_19) + M(f5, g6_19) +
+	     M(f6, g5_19) + M(f7, g4_19) + M(f8, g3_19) + M(f9, g2_19);
+	h2 = M(f0, g2) + M(f1_2, g1) + M(f2, g0) + M(f3_2, g9_19) + M(f4, g8_19) + M(f5_2, g7_19) +
+	     M(f6, g6_19) + M(f7_2, g5_19) + M(f8, g4_19) + M(f9_2, g3_19);
+	h3 = M(f0, g3) + M(f1, g2) + M(f2, g1) + M(f3, g0) + M(f4, g9_19) + M(f5, g8_19) +
+	     M(f6, g7_19) + M(f7, g6_19) + M(f8, g5_19) + M(f9, g4_19);
+	h4 = M(f0, g4) + M(f1_2, g3) + M(f2, g2) + M(f3_2, g1) + M(f4, g0) + M(f5_2, g9_19) +
+	     M(f6, g8_19) + M(f7_2, g7_19) + M(f8, g6_19) + M(f9_2, g5_19);
+	h5 = M(f0, g5) + M(f1, g4) + M(f2, g3) + M(f3, g2) + M(f4, g1) + M(f5, g0) + M(f6, g9_19) +
+	     M(f7, g8_19) + M(f8, g7_19) + M(f9, g6_19);
+	h6 = M(f0, g6) + M(f1_2, g5) + M(f2, g4) + M(f3_2, g3) + M(f4, g2) + M(f5_2, g1) +
+	     M(f6, g0) + M(f7_2, g9_19) + M(f8, g8_19) + M(f9_2, g7_19);
+	h7 = M(f0, g7) + M(f1, g6) + M(f2, g5) + M(f3, g4) + M(f4, g3) + M(f5, g2) + M(f6, g1) +
+	     M(f7, g0) + M(f8, g9_19) + M(f9, g8_19);
+	h8 = M(f0, g8) + M(f1_2, g7) + M(f2, g6) + M(f3_2, g5) + M(f4, g4) + M(f5_2, g3) +
+	     M(f6, g2) + M(f7_2, g1) + M(f8, g0) + M(f9_2, g9_19);
+	h9 = M(f0, g9) + M(f1, g8) + M(f2, g7) + M(f3, g6) + M(f4, g5) + M(f5, g4) + M(f6, g3) +
+	     M(f7, g2) + M(f8, g1) + M(f9, g0);
+
+	h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+	h[5] = h5; h[6] = h6; h[7] = h7; h[8] = h8; h[9] = h9; h[10] = 0;
+	carry(r, h);
 }
 
 void fe25519_square(fe25519 *r, const fe25519 *x)
 {
-  fe25519_mul(r, x, x);
+	crypto_int32 f0 = x->v[0], f1 = x->v[1], f2 = x->v[2], f3 = x->v[3], f4 = x->v[4];
+	crypto_int32 f5 = x->v[5], f6 = x->v[6], f7 = x->v[7], f8 = x->v[8], f9 = x->v[9];
+	crypto_int32 f0_2 = 2 * f0, f1_2 = 2 * f1, f2_2 = 2 * f2, f3_2 = 2 * f3, f4_2 = 2 * f4;
+	crypto_int32 f5_2 = 2 * f5, f6_2 = 2 * f6, f7_2 = 2 * f7, f8_2 = 2 * f8, f9_2 = 2 * f9;
+	crypto_int32 f1_4 = 4 * f1, f3_4 = 4 * f3, f5_4 = 4 * f5, f7_4 = 4 * f7;
+	crypto_int32 f5_19 = 19 * f5, f6_19 = 19 * f6, f7_19 = 19 * f7, f8_19 = 19 * f8, f9_19 = 19 * f9;
+	crypto_int64 h0, h1, h2, h3, h4, h5, h6, h7, h8, h9;
+	crypto_int64 h[11];
+
+	h0 = M(f0, f0) + M(f1_4, f9_19) + M(f2_2, f8_19) + M(f3_4, f7_19) + M(f4_2, f6_19) +
+	     M(f5_2, f5_19);
+	h1 = M(f0_2, f1) + M(f2_2, f9_19) + M(f3_2, f8_19) + M(f4_2, f7_19) + M(f5_2, f6_19);
+	h2 = M(f0_2, f2) + M(f1_2, f1) + M(f3_4, f9_19) + M(f4_2, f8_19) + M(f5_4, f7_19) +
+	     M(f6, f6_19);
+	h3 = M(f0_2, f3) + M(f1_2, f2) + M(f4_2, f9_19) + M(f5_2, f8_19) + M(f6_2, f7_19);
+	h4 = M(f0_2, f4) + M(f1_4, f3) + M(f2, f2) + M(f5_4, f9_19) + M(f6_2, f8_19) +
+	     M(f7_2, f7_19);
+	h5 = M(f0_2, f5) + M(f1_2, f4) + M(f2_2, f3) + M(f6_2, f9_19) + M(f7_2, f8_19);
+	h6 = M(f0_2, f6) + M(f1_4, f5) + M(f2_2, f4) + M(f3_2, f3) + M(f7_4, f9_19) +
+	     M(f8, f8_19);
+	h7 = M(f0_2, f7) + M(f1_2, f6) + M(f2_2, f5) + M(f3_2, f4) + M(f8_2, f9_19);
+	h8 = M(f0_2, f8) + M(f1_4, f7) + M(f2_2, f6) + M(f3_4, f5) + M(f4, f4) + M(f9_2, f9_19);
+	h9 = M(f0_2, f9) + M(f1_2, f8) + M(f2_2, f7) + M(f3_2, f6) + M(f4_2, f5);
+
+	h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+	h[5] = h5; h[6] = h6; h[7] = h7; h[8] = h8; h[9] = h9; h[10] = 0;
+	carry(r, h);
 }
 
 void fe25519_invert(fe25519 *r, const fe25519 *x)
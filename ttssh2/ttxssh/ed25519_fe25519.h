@@ -29,9 +29,10 @@
 #define fe25519_invert       crypto_sign_ed25519_ref_fe25519_invert
 #define fe25519_pow2523      crypto_sign_ed25519_ref_fe25519_pow2523
 
+/* radix 2^25.5: v[i] holds 26 (even i) or 25 (odd i) bits, see fe25519.c */
 typedef struct 
 {
-  crypto_uint32 v[32]; 
+  crypto_int32 v[10]; 
 }
 fe25519;
 
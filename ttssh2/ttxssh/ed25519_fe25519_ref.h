@@ -0,0 +1,52 @@
+/* $OpenBSD: fe25519.h,v 1.3 2013/12/09 11:03:45 markus Exp $ */
+
+/*
+ * Public Domain, Authors: Daniel J. Bernstein, Niels Duif, Tanja Lange,
+ * Peter Schwabe, Bo-Yin Yang.
+ * Copied from supercop-20130419/crypto_sign/ed25519/ref/fe25519.h
+ */
+
+#ifndef FE25519_REF_H
+#define FE25519_REF_H
+
+#include "ed25519_crypto_api.h"
+
+typedef struct 
+{
+  crypto_uint32 v[32]; 
+}
+fe25519_ref;
+
+void fe25519_ref_freeze(fe25519_ref *r);
+
+void fe25519_ref_unpack(fe25519_ref *r, const unsigned char x[32]);
+
+void fe25519_ref_pack(unsigned char r[32], const fe25519_ref *x);
+
+int fe25519_ref_iszero(const fe25519_ref *x);
+
+int fe25519_ref_iseq_vartime(const fe25519_ref *x, const fe25519_ref *y);
+
+void fe25519_ref_cmov(fe25519_ref *r, const fe25519_ref *x, unsigned char b);
+
+void fe25519_ref_setone(fe25519_ref *r);
+
+void fe25519_ref_setzero(fe25519_ref *r);
+
+void fe25519_ref_neg(fe25519_ref *r, const fe25519_ref *x);
+
+unsigned char fe25519_ref_getparity(const fe25519_ref *x);
+
+void fe25519_ref_add(fe25519_ref *r, const fe25519_ref *x, const fe25519_ref *y);
+
+void fe25519_ref_sub(fe25519_ref *r, const fe25519_ref *x, const fe25519_ref *y);
+
+void fe25519_ref_mul(fe25519_ref *r, const fe25519_ref *x, const fe25519_ref *y);
+
+void fe25519_ref_square(fe25519_ref *r, const fe25519_ref *x);
+
+void fe25519_ref_invert(fe25519_ref *r, const fe25519_ref *x);
+
+void fe25519_ref_pow2523(fe25519_ref *r, const fe25519_ref *x);
+
+#endif
@@ -19,14 +19,11 @@
  */
 
 /* d */
-static const fe25519 ge25519_ecd = {{0xA3, 0x78, 0x59, 0x13, 0xCA, 0x4D, 0xEB, 0x75, 0xAB, 0xD8, 0x41, 0x41, 0x4D, 0x0A, 0x70, 0x00, 
-                      0x98, 0xE8, 0x79, 0x77, 0x79, 0x40, 0xC7, 0x8C, 0x73, 0xFE, 0x6F, 0x2B, 0xEE, 0x6C, 0x03, 0x52}};
+static const fe25519 ge25519_ecd = {{0x35978a3, 0x0d37284, 0x3156ebd, 0x06a0a0e, 0x001c029, 0x179e898, 0x3a03cbb, 0x1ce7198, 0x2e2b6ff, 0x1480db3}};
 /* 2*d */
-static const fe25519 ge25519_ec2d = {{0x59, 0xF1, 0xB2, 0x26, 0x94, 0x9B, 0xD6, 0xEB, 0x56, 0xB1, 0x83, 0x82, 0x9A, 0x14, 0xE0, 0x00, 
-                       0x30, 0xD1, 0xF3, 0xEE, 0xF2, 0x80, 0x8E, 0x19, 0xE7, 0xFC, 0xDF, 0x56, 0xDC, 0xD9, 0x06, 0x24}};
+static const fe25519 ge25519_ec2d = {{0x2b2f159, 0x1a6e509, 0x22add7a, 0x0d4141d, 0x0038052, 0x0f3d130, 0x3407977, 0x19ce331, 0x1c56dff, 0x0901b67}};
 /* sqrt(-1) */
-static const fe25519 ge25519_sqrtm1 = {{0xB0, 0xA0, 0x0E, 0x4A, 0x27, 0x1B, 0xEE, 0xC4, 0x78, 0xE4, 0x2F, 0xAD, 0x06, 0x18, 0x43, 0x2F, 
-                         0xA7, 0xD7, 0xFB, 0x3D, 0x99, 0x00, 0x4D, 0x2B, 0x0B, 0xDF, 0xC1, 0x4F, 0x80, 0x24, 0x83, 0x2B}};
+static const fe25519 ge25519_sqrtm1 = {{0x20ea0b0, 0x186c9d2, 0x08f189d, 0x035697f, 0x0bd0c60, 0x1fbd7a7, 0x2804c9e, 0x1e16569, 0x004fc1d, 0x0ae0c92}};
 
 #define ge25519_p3 ge25519
 
@@ -52,21 +49,67 @@ typedef struct
 } ge25519_aff;
 
 
-/* Packed coordinates of the base point */
-const ge25519 ge25519_base = {{{0x1A, 0xD5, 0x25, 0x8F, 0x60, 0x2D, 0x56, 0xC9, 0xB2, 0xA7, 0x25, 0x95, 0x60, 0xC7, 0x2C, 0x69, 
-                                0x5C, 0xDC, 0xD6, 0xFD, 0x31, 0xE2, 0xA4, 0xC0, 0xFE, 0x53, 0x6E, 0xCD, 0xD3, 0x36, 0x69, 0x21}},
-                              {{0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 
-                                0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66}},
-                              {{0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
-                              {{0xA3, 0xDD, 0xB7, 0xA5, 0xB3, 0x8A, 0xDE, 0x6D, 0xF5, 0x52, 0x51, 0x77, 0x80, 0x9F, 0xF0, 0x20, 
-                                0x7D, 0xE3, 0xAB, 0x64, 0x8E, 0x4E, 0xEA, 0x66, 0x65, 0x76, 0x8B, 0xD7, 0x0F, 0x5F, 0x87, 0x67}}};
+/* Coordinates of the base point */
+const ge25519 ge25519_base = {{{0x325d51a, 0x18b5823, 0x0f6592a, 0x104a92d, 0x1a4b31d, 0x1d6dc5c, 0x27118fe, 0x07fd814, 0x13cd6e5, 0x085a4db}},
+                              {{0x2666658, 0x1999999, 0x0cccccc, 0x1333333, 0x1999999, 0x0666666, 0x3333333, 0x0cccccc, 0x2666666, 0x1999999}},
+                              {{0x0000001, 0x0000000, 0x0000000, 0x0000000, 0x0000000, 0x0000000, 0x0000000, 0x0000000, 0x0000000, 0x0000000}},
+                              {{0x1b7dda3, 0x1a2ace9, 0x25eadbb, 0x003ba8a, 0x083c27e, 0x0abe37d, 0x1274732, 0x0ccacdd, 0x0fd78b7, 0x19e1d7c}}};
 
 /* Multiples of the base point in affine representation */
 static const ge25519_aff ge25519_base_multiples_affine[425] = {
 #include "ge25519_base.data"
 };
 
+/*
+ * TeraTerm: verification (ge25519_double_scalarmult_base_vartime) uses
+ * sliding windows of width 5 as SUPERCOP ed25519/ref10 does.  The odd
+ * multiples of the second point are stored as (Y+X, Y-X, Z, 2dT) and those
+ * of the base point as affine (y+x, y-x, 2dxy), so an addition costs 4 (3)
+ * multiplications.
+ */
+typedef struct
+{
+  fe25519 yplusx;
+  fe25519 yminusx;
+  fe25519 z;
+  fe25519 t2d;
+} ge25519_cached;
+
+typedef struct
+{
+  fe25519 yplusx;
+  fe25519 yminusx;
+  fe25519 xy2d;
+} ge25519_precomp;
+
+/* B, 3B, 5B, ..., 15B */
+static const ge25519_precomp ge25519_base_odd_multiples[8] = {
+  {{{0x18c3b85, 0x124f1bd, 0x1c325f7, 0x037dc60, 0x33e4cb7, 0x03d42c2, 0x1a44c32, 0x14ca4e1, 0x3a33d4b, 0x01f3e74}},
+   {{0x340913e, 0x00e4175, 0x3d673a2, 0x02e8a05, 0x3f4e67c, 0x08f8a09, 0x0c21a34, 0x04cf4b8, 0x1298f81, 0x113f4be}},
+   {{0x37aaa68, 0x0448161, 0x093d579, 0x11e6556, 0x09b67a0, 0x143598c, 0x1bee5ee, 0x0b50b43, 0x289f0c6, 0x1bc45ed}}},
+  {{{0x0ee9730, 0x16c2a13, 0x17155e4, 0x1874432, 0x0096a10, 0x1016732, 0x1a8014f, 0x11e9823, 0x1b9a80f, 0x1e85938}},
+   {{0x0fcd265, 0x047fa29, 0x34faacc, 0x1ef2e0d, 0x0ef4d4f, 0x14bd6bd, 0x0f98d10, 0x14c5026, 0x07555bd, 0x0aae456}},
+   {{0x1d0d889, 0x1a4cfc3, 0x34c4295, 0x110e1ae, 0x162508c, 0x0f2db4c, 0x072a2c6, 0x098da2e, 0x2f12b9b, 0x168a09a}}},
+  {{{0x0a5bb33, 0x0af1102, 0x1a05442, 0x01e3af7, 0x2354123, 0x0bfec44, 0x1f5862d, 0x0dd7ba3, 0x3146e20, 0x0a51733}},
+   {{0x047d6ba, 0x060b0e9, 0x136eff2, 0x08a5939, 0x3540053, 0x064a087, 0x2788e5c, 0x0be7c67, 0x33eb1b5, 0x05529f9}},
+   {{0x12a8285, 0x0f6fc60, 0x23f9797, 0x03e85ee, 0x09c3820, 0x1bda72d, 0x1b3858d, 0x0d35683, 0x296b3bb, 0x10eaaf9}}},
+  {{{0x04ea3bf, 0x0973425, 0x01a4d63, 0x1d59cee, 0x1d1c0d4, 0x0542e49, 0x1294114, 0x04fce36, 0x29283c9, 0x1186fa9}},
+   {{0x23221b1, 0x1cb26aa, 0x074f74d, 0x099ddd1, 0x1b28085, 0x0192c3a, 0x13b27c9, 0x0fc13bd, 0x1d2e531, 0x075bb75}},
+   {{0x1b8b3a2, 0x0db7200, 0x0935e30, 0x03829f5, 0x2cc0d7d, 0x077adf3, 0x220dd2c, 0x014ea53, 0x1c6a0f9, 0x1ea7eec}}},
+  {{{0x2a8632f, 0x199e2a9, 0x0d8b365, 0x17a8de2, 0x2994279, 0x086f5b5, 0x119e4e3, 0x1eb39d6, 0x338add7, 0x0d2e7b4}},
+   {{0x39d8064, 0x1885f80, 0x0337e6d, 0x1b7a902, 0x2628206, 0x15eb044, 0x1e30473, 0x191f2d9, 0x11fadc9, 0x1270169}},
+   {{0x045af1b, 0x13a2fe4, 0x245e0d6, 0x14538ce, 0x38bfe0f, 0x1d4cf16, 0x37e14c9, 0x160d55e, 0x021b008, 0x1cf05c8}}},
+  {{{0x2802ade, 0x1c02122, 0x1c4e5f7, 0x0781181, 0x39767fb, 0x1703406, 0x342388b, 0x1f5e227, 0x22546d8, 0x109d6ab}},
+   {{0x1864348, 0x1d6c092, 0x070262b, 0x14bb844, 0x0fb5acd, 0x08deb95, 0x03aaab5, 0x0eff474, 0x0029d5c, 0x062ad66}},
+   {{0x16089e9, 0x0cb317f, 0x0949b05, 0x1099417, 0x00c7ad2, 0x11a8622, 0x088ccda, 0x1290886, 0x22b53df, 0x0f71954}}},
+  {{{0x2007f6d, 0x03088a8, 0x3db77ee, 0x0d5ade6, 0x2fe12ce, 0x107ba07, 0x107097d, 0x0482a6f, 0x2ec346f, 0x08d3f5f}},
+   {{0x27fbf93, 0x1c04ecc, 0x1ed6a0d, 0x04cdbbb, 0x2bbf3af, 0x0ad5968, 0x1591955, 0x094f3a2, 0x2d17602, 0x0099e20}},
+   {{0x32ea378, 0x028465c, 0x28e2a6c, 0x18efc6e, 0x090df9a, 0x1a7e533, 0x39bfc48, 0x10c745d, 0x3daa097, 0x125ee9b}}},
+  {{{0x3cfeaa0, 0x1b300c4, 0x08da499, 0x068c4e1, 0x219230a, 0x1f2d4d0, 0x2defd60, 0x0e565b7, 0x17f12de, 0x18788a4}},
+   {{0x28ccf0b, 0x0f36191, 0x21ac081, 0x12154c8, 0x34e0a6e, 0x1b25192, 0x0180403, 0x1d7eea1, 0x0218d05, 0x10ed735}},
+   {{0x3d0b516, 0x09d8be6, 0x3ddcbb3, 0x071b9fe, 0x3ace2bd, 0x1d64270, 0x32d3ec9, 0x1084065, 0x210ae4d, 0x1447584}}}
+};
+
 static void p1p1_to_p2(ge25519_p2 *r, const ge25519_p1p1 *p)
 {
   fe25519_mul(&r->x, &p->x, &p->t);
@@ -142,6 +185,95 @@ static void dbl_p1p1(ge25519_p1p1 *r, const ge25519_p2 *p)
   fe25519_sub(&r->y, &d, &b);
 }
 
+static void p3_to_cached(ge25519_cached *r, const ge25519_p3 *p)
+{
+  fe25519_add(&r->yplusx, &p->y, &p->x);
+  fe25519_sub(&r->yminusx, &p->y, &p->x);
+  r->z = p->z;
+  fe25519_mul(&r->t2d, &p->t, &ge25519_ec2d);
+}
+
+/* r = p + q (neg = 0) or p - q (neg = 1) */
+static void add_cached_p1p1(ge25519_p1p1 *r, const ge25519_p3 *p, const ge25519_cached *q, int neg)
+{
+  fe25519 a, b, c, d;
+
+  fe25519_add(&a, &p->y, &p->x);
+  fe25519_sub(&b, &p->y, &p->x);
+  fe25519_mul(&a, &a, neg ? &q->yminusx : &q->yplusx);
+  fe25519_mul(&b, &b, neg ? &q->yplusx : &q->yminusx);
+  fe25519_mul(&c, &q->t2d, &p->t);
+  fe25519_mul(&d, &p->z, &q->z);
+  fe25519_add(&d, &d, &d);
+  fe25519_sub(&r->x, &a, &b);
+  fe25519_add(&r->y, &a, &b);
+  if (neg) {
+    fe25519_sub(&r->z, &d, &c);
+    fe25519_add(&r->t, &d, &c);
+  }
+  else {
+    fe25519_add(&r->z, &d, &c);
+    fe25519_sub(&r->t, &d, &c);
+  }
+}
+
+/* r = p + q (neg = 0) or p - q (neg = 1) */
+static void add_precomp_p1p1(ge25519_p1p1 *r, const ge25519_p3 *p, const ge25519_precomp *q, int neg)
+{
+  fe25519 a, b, c, d;
+
+  fe25519_add(&a, &p->y, &p->x);
+  fe25519_sub(&b, &p->y, &p->x);
+  fe25519_mul(&a, &a, neg ? &q->yminusx : &q->yplusx);
+  fe25519_mul(&b, &b, neg ? &q->yplusx : &q->yminusx);
+  fe25519_mul(&c, &q->xy2d, &p->t);
+  fe25519_add(&d, &p->z, &p->z);
+  fe25519_sub(&r->x, &a, &b);
+  fe25519_add(&r->y, &a, &b);
+  if (neg) {
+    fe25519_sub(&r->z, &d, &c);
+    fe25519_add(&r->t, &d, &c);
+  }
+  else {
+    fe25519_add(&r->z, &d, &c);
+    fe25519_sub(&r->t, &d, &c);
+  }
+}
+
+/* signed sliding window of width 5: r[i] is 0 or odd in -15..15 */
+static void slide(signed char r[256], const unsigned char a[32])
+{
+  int i, b, k;
+
+  for (i = 0; i < 256; i++)
+    r[i] = 1 & (a[i >> 3] >> (i & 7));
+
+  for (i = 0; i < 256; i++) {
+    if (!r[i])
+      continue;
+    for (b = 1; b <= 6 && i + b < 256; b++) {
+      if (!r[i + b])
+        continue;
+      if (r[i] + (r[i + b] << b) <= 15) {
+        r[i] += r[i + b] << b;
+        r[i + b] = 0;
+      }
+      else if (r[i] - (r[i + b] << b) >= -15) {
+        r[i] -= r[i + b] << b;
+        for (k = i + b; k < 256; k++) {
+          if (!r[k]) {
+            r[k] = 1;
+            break;
+          }
+          r[k] = 0;
+        }
+      }
+      else
+        break;
+    }
+  }
+}
+
 /* Constant-time version of: if(b) r = p */
 static void cmov_aff(ge25519_aff *r, const ge25519_aff *p, unsigned char b)
 {
@@ -303,6 +435,63 @@ void ge25519_double_scalarmult_vartime(ge25519_p3 *r, const ge25519_p3 *p1, cons
   }
 }
 
+/* computes [s1]p1 + [s2]B, B is the base point */
+void ge25519_double_scalarmult_base_vartime(ge25519_p3 *r, const ge25519_p3 *p1, const sc25519 *s1, const sc25519 *s2)
+{
+  unsigned char a[32], b[32];
+  signed char aslide[256], bslide[256];
+  ge25519_cached pre[8]; /* p1, 3p1, ..., 15p1 */
+  ge25519_p1p1 t;
+  ge25519_p3 u, p2;
+  int i;
+
+  sc25519_to32bytes(a, s1);
+  sc25519_to32bytes(b, s2);
+  slide(aslide, a);
+  slide(bslide, b);
+
+  p3_to_cached(&pre[0], p1);
+  dbl_p1p1(&t, (ge25519_p2 *)p1); p1p1_to_p3(&p2, &t);
+  for (i = 1; i < 8; i++) {
+    add_cached_p1p1(&t, &p2, &pre[i - 1], 0);
+    p1p1_to_p3(&u, &t);
+    p3_to_cached(&pre[i], &u);
+  }
+
+  setneutral(r);
+  for (i = 255; i >= 0; i--) {
+    if (aslide[i] || bslide[i])
+      break;
+  }
+
+  for (; i >= 0; i--) {
+    dbl_p1p1(&t, (ge25519_p2 *)r);
+
+    if (aslide[i] > 0) {
+      p1p1_to_p3(&u, &t);
+      add_cached_p1p1(&t, &u, &pre[aslide[i] / 2], 0);
+    }
+    else if (aslide[i] < 0) {
+      p1p1_to_p3(&u, &t);
+      add_cached_p1p1(&t, &u, &pre[-aslide[i] / 2], 1);
+    }
+
+    if (bslide[i] > 0) {
+      p1p1_to_p3(&u, &t);
+      add_precomp_p1p1(&t, &u, &ge25519_base_odd_multiples[bslide[i] / 2], 0);
+    }
+    else if (bslide[i] < 0) {
+      p1p1_to_p3(&u, &t);
+      add_precomp_p1p1(&t, &u, &ge25519_base_odd_multiples[-bslide[i] / 2], 1);
+    }
+
+    if (i != 0)
+      p1p1_to_p2((ge25519_p2 *)r, &t);
+    else
+      p1p1_to_p3(r, &t);
+  }
+}
+
 void ge25519_scalarmult_base(ge25519_p3 *r, const sc25519 *s)
 {
   signed char b[85];
@@ -38,6 +38,7 @@
 #define ge25519_pack                      crypto_sign_ed25519_ref_pack
 #define ge25519_isneutral_vartime         crypto_sign_ed25519_ref_isneutral_vartime
 #define ge25519_double_scalarmult_vartime crypto_sign_ed25519_ref_double_scalarmult_vartime
+#define ge25519_double_scalarmult_base_vartime crypto_sign_ed25519_ref_double_scalarmult_base_vartime
 #define ge25519_scalarmult_base           crypto_sign_ed25519_ref_scalarmult_base
 
 typedef struct
@@ -58,6 +59,8 @@ int ge25519_isneutral_vartime(const ge25519 *p);
 
 void ge25519_double_scalarmult_vartime(ge25519 *r, const ge25519 *p1, const sc25519 *s1, const ge25519 *p2, const sc25519 *s2);
 
+void ge25519_double_scalarmult_base_vartime(ge25519 *r, const ge25519 *p1, const sc25519 *s1, const sc25519 *s2);
+
 void ge25519_scalarmult_base(ge25519 *r, const sc25519 *s);
 
 #endif
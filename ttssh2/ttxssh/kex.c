@@ -28,6 +28,7 @@
 
 #include "ttxssh.h"
 #include "kex.h"
+#include "ed25519_crypto_api.h"
 
 extern SSHKeys current_keys[MODE_MAX];
 
@@ -438,6 +439,87 @@ unsigned char *kex_ecdh_hash(const EVP_MD *evp_md,
 }
 
 
+// curve25519-sha256 (RFC 8731)
+// 閧 key(32oCg) 𗐐ōAJ pub = X25519(key, 9) vZ
+void kexc25519_keygen(u_char key[CURVE25519_SIZE], u_char pub[CURVE25519_SIZE])
+{
+	static const u_char basepoint[CURVE25519_SIZE] = {9};
+
+	arc4random_buf(key, CURVE25519_SIZE);
+	crypto_scalarmult_curve25519(pub, key, basepoint);
+}
+
+// L閧 X25519(key, peer_pub)  shared_secret ɃZbgB
+// ʂ 0 (peer_pub ʐ̓_) ̏ꍇ̓G[(-1)ԂB
+int kexc25519_shared_key(const u_char key[CURVE25519_SIZE],
+                         const u_char pub[CURVE25519_SIZE],
+                         BIGNUM *shared_secret)
+{
+	u_char shared_key[CURVE25519_SIZE];
+	u_char zero = 0;
+	int i, ret = 0;
+
+	crypto_scalarmult_curve25519(shared_key, key, pub);
+	for (i = 0; i < CURVE25519_SIZE; i++) {
+		zero |= shared_key[i];
+	}
+	if (zero == 0) {
+		ret = -1;
+	}
+	// 32oCĝ܂ big endian ̐Ƃ mpint ň
+	else if (BN_bin2bn(shared_key, CURVE25519_SIZE, shared_secret) == NULL) {
+		ret = -1;
+	}
+	SecureZeroMemory(shared_key, sizeof(shared_key));
+	return ret;
+}
+
+unsigned char *kex_c25519_hash(const EVP_MD *evp_md,
+                               char *client_version_string,
+                               char *server_version_string,
+                               char *ckexinit, int ckexinitlen,
+                               char *skexinit, int skexinitlen,
+                               u_char *serverhostkeyblob, int sbloblen,
+                               const u_char client_dh_pub[CURVE25519_SIZE],
+                               const u_char server_dh_pub[CURVE25519_SIZE],
+                               BIGNUM *shared_secret,
+                               unsigned int *hashlen)
+{
+	buffer_t *b;
+	static unsigned char digest[EVP_MAX_MD_SIZE];
+	EVP_MD_CTX md;
+
+	b = buffer_init();
+	buffer_put_string(b, client_version_string, strlen(client_version_string));
+	buffer_put_string(b, server_version_string, strlen(server_version_string));
+
+	/* kexinit messages: fake header: len+SSH2_MSG_KEXINIT */
+	buffer_put_int(b, ckexinitlen+1);
+	buffer_put_char(b, SSH2_MSG_KEXINIT);
+	buffer_append(b, ckexinit, ckexinitlen);
+	buffer_put_int(b, skexinitlen+1);
+	buffer_put_char(b, SSH2_MSG_KEXINIT);
+	buffer_append(b, skexinit, skexinitlen);
+
+	buffer_put_string(b, serverhostkeyblob, sbloblen);
+
+	// Q_C, Q_S  ECDH ƈقȂ string Ƃ 32 oCĝ܂ܓ
+	buffer_put_string(b, (char *)client_dh_pub, CURVE25519_SIZE);
+	buffer_put_string(b, (char *)server_dh_pub, CURVE25519_SIZE);
+	buffer_put_bignum2(b, shared_secret);
+
+	EVP_DigestInit(&md, evp_md);
+	EVP_DigestUpdate(&md, buffer_ptr(b), buffer_len(b));
+	EVP_DigestFinal(&md, digest, NULL);
+
+	buffer_free(b);
+
+	*hashlen = EVP_MD_size(evp_md);
+
+	return digest;
+}
+
+
 int dh_pub_is_valid(DH *dh, BIGNUM *dh_pub)
 {
 	int i;
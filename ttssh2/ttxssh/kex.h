@@ -82,6 +82,22 @@ unsigned char *kex_ecdh_hash(const EVP_MD *evp_md,
                              BIGNUM *shared_secret,
                                unsigned int *hashlen);
 
+#define CURVE25519_SIZE 32
+void kexc25519_keygen(u_char key[CURVE25519_SIZE], u_char pub[CURVE25519_SIZE]);
+int kexc25519_shared_key(const u_char key[CURVE25519_SIZE],
+                         const u_char pub[CURVE25519_SIZE],
+                         BIGNUM *shared_secret);
+unsigned char *kex_c25519_hash(const EVP_MD *evp_md,
+                               char *client_version_string,
+                               char *server_version_string,
+                               char *ckexinit, int ckexinitlen,
+                               char *skexinit, int skexinitlen,
+                               u_char *serverhostkeyblob, int sbloblen,
+                               const u_char client_dh_pub[CURVE25519_SIZE],
+                               const u_char server_dh_pub[CURVE25519_SIZE],
+                               BIGNUM *shared_secret,
+                               unsigned int *hashlen);
+
 int dh_pub_is_valid(DH *dh, BIGNUM *dh_pub);
 void kex_derive_keys(PTInstVar pvar, int need, u_char *hash, BIGNUM *shared_secret,
                      char *session_id, int session_id_len);
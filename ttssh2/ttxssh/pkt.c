@@ -209,7 +209,13 @@ int PKT_recv(PTInstVar pvar, char *buf, int buflen)
 			}
 
 			// pPbg̐擪 uint32 (4oCg) ̃pPbg
-			pktsize = get_uint32_MSBfirst(data);
+			// (chacha20-poly1305 ł̓pPbgÍĂ̂ CRYPT ŕ)
+			if (SSHv2(pvar)) {
+				pktsize = CRYPT_get_receiver_packet_length(pvar, data);
+			}
+			else {
+				pktsize = get_uint32_MSBfirst(data);
+			}
 
 			if (SSHv1(pvar)) {
 				// SSH1 ł̓pPbg̒lɂ padding ̒܂܂ĂȂB
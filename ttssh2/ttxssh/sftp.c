@@ -51,6 +51,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/utime.h>
 #include <assert.h>
 
 
@@ -148,7 +149,8 @@ static void sftp_console_message(PTInstVar pvar, Channel_t *c, char *fmt, ...)
 	_vsnprintf_s(tmp, sizeof(tmp), _TRUNCATE, fmt, arg);
 	va_end(arg);
 
-	SendMessage(c->sftp.console_window, WM_USER_CONSOLE, 0, (LPARAM)tmp);
+	if (c->sftp.console_window != NULL)
+		SendMessage(c->sftp.console_window, WM_USER_CONSOLE, 0, (LPARAM)tmp);
 	logputs(LOG_LEVEL_VERBOSE, tmp);
 }
 
@@ -190,42 +192,22 @@ static void sftp_buffer_free(buffer_t *message)
 static void sftp_send_msg(PTInstVar pvar, Channel_t *c, buffer_t *msg)
 {
 	char *p;
-	int len;
+	unsigned int len, n;
 
 	len = buffer_len(msg);
 	p = buffer_ptr(msg);
 	// ŏɃbZ[WTCYi[B
 	set_uint32(p, len - 4);
 	// yC[h̑MB
-	SSH2_send_channel_data(pvar, c, p, len, 0);
-}
-
-// T[oMSFTPpPbgobt@Ɋi[B
-static void sftp_get_msg(PTInstVar pvar, Channel_t *c, unsigned char *data, unsigned int buflen, buffer_t **message)
-{
-	buffer_t *msg = *message;
-	int msg_len;
-
-	// obt@mۂAf[^ׂĕ荞ށBȍ~ buffer_t ^ʂđ삷B
-	// ق OpenSSH ̃R[hƂ̐eaǂȂ邽߁B
-	buffer_clear(msg);
-	buffer_append(msg, data, buflen);
-	buffer_rewind(msg);
-
-	msg_len = buffer_get_int(msg);
-	if (msg_len > SFTP_MAX_MSG_LENGTH) {
-		// TODO:
-		sftp_syslog(pvar, "Received message too long %u", msg_len);
-		goto error;
+	// WRITE v̓T[o̍őpPbgTCY𒴂̂ŁAđB
+	while (len > 0) {
+		n = len;
+		if (c->remote_maxpacket > 0 && n > c->remote_maxpacket)
+			n = c->remote_maxpacket;
+		SSH2_send_channel_data(pvar, c, p, n, 0);
+		p += n;
+		len -= n;
 	}
-	if (msg_len + 4 != buflen) {
-		// TODO:
-		sftp_syslog(pvar, "Buffer length %u is invalid", buflen);
-		goto error;
-	}
-
-error:
-	return;
 }
 
 static void sftp_send_string_request(PTInstVar pvar, Channel_t *c, unsigned int id, unsigned int code,
@@ -243,6 +225,24 @@ static void sftp_send_string_request(PTInstVar pvar, Channel_t *c, unsigned int
 }
 
 
+// READ/WRITE ṽTCYƁA҂ɑv̐ݒ肩瓾B
+static void sftp_get_transfer_params(PTInstVar pvar, unsigned int *buflen, unsigned int *num_requests)
+{
+	int len = pvar->settings.SftpBlockSize;
+	int num = pvar->settings.SftpMaxRequests;
+
+	if (len <= 0)
+		len = DEFAULT_COPY_BUFLEN;
+	len = max(len, SFTP_MIN_COPY_BUFLEN);
+	len = min(len, SFTP_MAX_COPY_BUFLEN);
+	if (num <= 0)
+		num = DEFAULT_NUM_REQUESTS;
+	num = min(num, SFTP_MAX_NUM_REQUESTS);
+
+	*buflen = len;
+	*num_requests = num;
+}
+
 // SFTPʐMJnÕlSVG[V
 // based on do_init()#sftp-client.c(OpenSSH 6.0)
 void sftp_do_init(PTInstVar pvar, Channel_t *c)
@@ -250,10 +250,9 @@ void sftp_do_init(PTInstVar pvar, Channel_t *c)
 	buffer_t *msg;
 
 	// SFTPǗ\̂̏
-	memset(&c->sftp, 0, sizeof(c->sftp));
+	// ]Wu (c->sftp.xfer) ̓`lJOɓo^Ă̂ŏȂB
 	c->sftp.state = SFTP_INIT;
-	c->sftp.transfer_buflen = DEFAULT_COPY_BUFLEN;
-	c->sftp.num_requests = DEFAULT_NUM_REQUESTS;
+	sftp_get_transfer_params(pvar, &c->sftp.transfer_buflen, &c->sftp.num_requests);
 	c->sftp.exts = 0;
 	c->sftp.limit_kbps = 0;
 
@@ -407,6 +406,953 @@ error:
 	return (filename);
 }
 
+/*
+ * t@C] (}NR}h sftpsend/sftprecv)
+ * based on do_download()/do_upload()/download_dir()/upload_dir()#sftp-client.c(OpenSSH 6.0)
+ *
+ * sftp_response() ɓ͂_@Ɏ̗v𑗂Cxg쓮œB
+ * READ/WRITE ͉҂ num_requests ܂őA request id 
+ * vƓ˂킹BREAD ͓̉͂ɁAvItZbg֏ށB
+ * fBNg͒gWuL[̖ɐςōċAIɓ]B
+ */
+
+#define SFTP_S_IFMT     0170000
+#define SFTP_S_IFDIR    0040000
+#define SFTP_S_IFREG    0100000
+
+typedef struct sftp_attrib {
+	unsigned int flags;
+	unsigned long long size;
+	unsigned int uid, gid;
+	unsigned int perm;
+	unsigned int atime, mtime;
+} sftp_attrib_t;
+
+typedef struct sftp_job {
+	enum scp_dir dir;
+	char local[MAX_PATH];
+	char remote[1024];
+	int resolve;               // ]悪fBNgȂt@C𑫂 (sftpsend ̓])
+	int has_attrib;            // [g̑ READDIR œĂ
+	sftp_attrib_t a;
+	struct sftp_job *next;
+} sftp_job_t;
+
+typedef struct sftp_request {
+	int used;
+	unsigned int id;
+	unsigned long long offset;
+	unsigned int len;
+} sftp_request_t;
+
+enum sftp_xfer_state {
+	SFTP_XFER_STAT, SFTP_XFER_MKDIR, SFTP_XFER_OPENDIR, SFTP_XFER_READDIR,
+	SFTP_XFER_CLOSEDIR, SFTP_XFER_OPEN, SFTP_XFER_DATA, SFTP_XFER_SETSTAT, SFTP_XFER_CLOSE,
+};
+
+typedef struct sftp_xfer {
+	enum sftp_xfer_state state;
+	sftp_job_t *head, *tail;      // WuL[B擪]̃WuB
+	unsigned int ctl_id;          // READ/WRITE ȊOŉ҂Ă request id
+	char *handle;
+	int handle_len;
+	FILE *fp;
+	unsigned long long offset;    // ɗvItZbg
+	unsigned long long done;      // ̃t@Cœ]ς݂̃oCg
+	sftp_request_t *req;          // ҂ READ/WRITE (num_requests )
+	unsigned int num_req;         // ҂ READ/WRITE ̐
+	unsigned int max_req;         // READ ̓v̏B0 Ȃ EOF ς݁B
+	int eof;                      // WRITE f[^ǂݏI
+	int failed;                   // ̃t@C̓]Ɏs
+	char *chunk;                  // WRITE f[^̓ǂݍݐ
+	DWORD start_tick;
+	DWORD file_tick;
+	unsigned long long total;
+	unsigned int files;
+	unsigned int errors;
+} sftp_xfer_t;
+
+static void sftp_decode_attrib(buffer_t *msg, sftp_attrib_t *a)
+{
+	unsigned int hi, lo, count, i;
+
+	memset(a, 0, sizeof(*a));
+	a->flags = buffer_get_int(msg);
+	if (a->flags & SSH2_FILEXFER_ATTR_SIZE) {
+		hi = buffer_get_int(msg);
+		lo = buffer_get_int(msg);
+		a->size = ((unsigned long long)hi << 32) | lo;
+	}
+	if (a->flags & SSH2_FILEXFER_ATTR_UIDGID) {
+		a->uid = buffer_get_int(msg);
+		a->gid = buffer_get_int(msg);
+	}
+	if (a->flags & SSH2_FILEXFER_ATTR_PERMISSIONS) {
+		a->perm = buffer_get_int(msg);
+	}
+	if (a->flags & SSH2_FILEXFER_ATTR_ACMODTIME) {
+		a->atime = buffer_get_int(msg);
+		a->mtime = buffer_get_int(msg);
+	}
+	if (a->flags & SSH2_FILEXFER_ATTR_EXTENDED) {
+		count = buffer_get_int(msg);
+		for (i = 0; i < count && buffer_remain_len(msg) > 0; i++) {
+			free(buffer_get_string_msg(msg, NULL));
+			free(buffer_get_string_msg(msg, NULL));
+		}
+	}
+}
+
+static void sftp_put_perm_attrib(buffer_t *msg, unsigned int perm)
+{
+	buffer_put_int(msg, SSH2_FILEXFER_ATTR_PERMISSIONS);
+	buffer_put_int(msg, perm);
+}
+
+static void sftp_put_int64(buffer_t *msg, unsigned long long v)
+{
+	buffer_put_int(msg, (unsigned int)(v >> 32));
+	buffer_put_int(msg, (unsigned int)v);
+}
+
+// pX̖̗vfԂB"dir/" ̂悤 '/' ŏIꍇ "dir/"  "dir" ԂB
+static void sftp_basename(const char *path, char *name, size_t namelen)
+{
+	const char *p, *end;
+
+	end = path + strlen(path);
+	while (end > path && (end[-1] == '/' || end[-1] == '\\'))
+		end--;
+	p = end;
+	while (p > path && p[-1] != '/' && p[-1] != '\\')
+		p--;
+	strncpy_s(name, namelen, p, end - p);
+}
+
+static void sftp_join_path(char *dst, size_t dstlen, const char *dir, const char *name, char sep)
+{
+	size_t len = strlen(dir);
+
+	if (len > 0 && dir[len - 1] != sep)
+		_snprintf_s(dst, dstlen, _TRUNCATE, "%s%c%s", dir, sep, name);
+	else
+		_snprintf_s(dst, dstlen, _TRUNCATE, "%s%s", dir, name);
+}
+
+static sftp_job_t *sftp_job_new(enum scp_dir dir, const char *local, const char *remote)
+{
+	sftp_job_t *job;
+
+	job = calloc(1, sizeof(sftp_job_t));
+	if (job == NULL)
+		return NULL;
+	job->dir = dir;
+	strncpy_s(job->local, sizeof(job->local), local, _TRUNCATE);
+	strncpy_s(job->remote, sizeof(job->remote), remote, _TRUNCATE);
+	return job;
+}
+
+static void sftp_job_push(sftp_xfer_t *x, sftp_job_t *job)
+{
+	if (x->tail == NULL) {
+		x->head = x->tail = job;
+	} else {
+		x->tail->next = job;
+		x->tail = job;
+	}
+}
+
+static void sftp_job_pop(sftp_xfer_t *x)
+{
+	sftp_job_t *job = x->head;
+
+	if (job == NULL)
+		return;
+	x->head = job->next;
+	if (x->head == NULL)
+		x->tail = NULL;
+	free(job);
+}
+
+static void sftp_xfer_free_handle(sftp_xfer_t *x)
+{
+	free(x->handle);
+	x->handle = NULL;
+	x->handle_len = 0;
+}
+
+static unsigned int sftp_send_handle_request(PTInstVar pvar, Channel_t *c, unsigned int code)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	unsigned int id = c->sftp.msg_id++;
+
+	sftp_send_string_request(pvar, c, id, code, x->handle, x->handle_len);
+	return id;
+}
+
+static unsigned int sftp_send_path_request(PTInstVar pvar, Channel_t *c, unsigned int code, char *path)
+{
+	unsigned int id = c->sftp.msg_id++;
+
+	sftp_send_string_request(pvar, c, id, code, path, strlen(path));
+	return id;
+}
+
+static unsigned int sftp_send_open(PTInstVar pvar, Channel_t *c, char *path, unsigned int mode, unsigned int perm)
+{
+	buffer_t *msg;
+	unsigned int id = c->sftp.msg_id++;
+
+	sftp_buffer_alloc(&msg);
+	buffer_put_char(msg, SSH2_FXP_OPEN);
+	buffer_put_int(msg, id);
+	buffer_put_string(msg, path, strlen(path));
+	buffer_put_int(msg, mode);
+	if (mode & SSH2_FXF_WRITE)
+		sftp_put_perm_attrib(msg, perm);
+	else
+		buffer_put_int(msg, 0);
+	sftp_send_msg(pvar, c, msg);
+	sftp_buffer_free(msg);
+	return id;
+}
+
+static unsigned int sftp_send_mkdir(PTInstVar pvar, Channel_t *c, char *path, unsigned int perm)
+{
+	buffer_t *msg;
+	unsigned int id = c->sftp.msg_id++;
+
+	sftp_buffer_alloc(&msg);
+	buffer_put_char(msg, SSH2_FXP_MKDIR);
+	buffer_put_int(msg, id);
+	buffer_put_string(msg, path, strlen(path));
+	sftp_put_perm_attrib(msg, perm);
+	sftp_send_msg(pvar, c, msg);
+	sftp_buffer_free(msg);
+	return id;
+}
+
+static unsigned int sftp_send_fsetstat_times(PTInstVar pvar, Channel_t *c, sftp_attrib_t *a)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	buffer_t *msg;
+	unsigned int id = c->sftp.msg_id++;
+
+	sftp_buffer_alloc(&msg);
+	buffer_put_char(msg, SSH2_FXP_FSETSTAT);
+	buffer_put_int(msg, id);
+	buffer_put_string(msg, x->handle, x->handle_len);
+	buffer_put_int(msg, SSH2_FILEXFER_ATTR_ACMODTIME);
+	buffer_put_int(msg, a->atime);
+	buffer_put_int(msg, a->mtime);
+	sftp_send_msg(pvar, c, msg);
+	sftp_buffer_free(msg);
+	return id;
+}
+
+static void sftp_send_read(PTInstVar pvar, Channel_t *c, sftp_request_t *r)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	buffer_t *msg;
+
+	r->id = c->sftp.msg_id++;
+	sftp_buffer_alloc(&msg);
+	buffer_put_char(msg, SSH2_FXP_READ);
+	buffer_put_int(msg, r->id);
+	buffer_put_string(msg, x->handle, x->handle_len);
+	sftp_put_int64(msg, r->offset);
+	buffer_put_int(msg, r->len);
+	sftp_send_msg(pvar, c, msg);
+	sftp_buffer_free(msg);
+}
+
+static void sftp_send_write(PTInstVar pvar, Channel_t *c, sftp_request_t *r, char *data)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	buffer_t *msg;
+
+	r->id = c->sftp.msg_id++;
+	sftp_buffer_alloc(&msg);
+	buffer_put_char(msg, SSH2_FXP_WRITE);
+	buffer_put_int(msg, r->id);
+	buffer_put_string(msg, x->handle, x->handle_len);
+	sftp_put_int64(msg, r->offset);
+	buffer_put_string(msg, data, r->len);
+	sftp_send_msg(pvar, c, msg);
+	sftp_buffer_free(msg);
+}
+
+static sftp_request_t *sftp_request_lookup(Channel_t *c, unsigned int id)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	unsigned int i;
+
+	for (i = 0; i < c->sftp.num_requests; i++) {
+		if (x->req[i].used && x->req[i].id == id)
+			return &x->req[i];
+	}
+	return NULL;
+}
+
+static sftp_request_t *sftp_request_alloc(Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	unsigned int i;
+
+	for (i = 0; i < c->sftp.num_requests; i++) {
+		if (!x->req[i].used) {
+			x->req[i].used = 1;
+			x->num_req++;
+			return &x->req[i];
+		}
+	}
+	return NULL;
+}
+
+static void sftp_request_free(Channel_t *c, sftp_request_t *r)
+{
+	r->used = 0;
+	c->sftp.xfer->num_req--;
+}
+
+static void sftp_xfer_error(PTInstVar pvar, Channel_t *c, char *fmt, ...)
+{
+	char tmp[1024];
+	va_list arg;
+
+	va_start(arg, fmt);
+	_vsnprintf_s(tmp, sizeof(tmp), _TRUNCATE, fmt, arg);
+	va_end(arg);
+
+	sftp_do_syslog(pvar, LOG_LEVEL_ERROR, "SFTP: %s", tmp);
+	c->sftp.xfer->errors++;
+}
+
+// ҂̗vcȂ悤AREAD/WRITE ܂őB
+static void sftp_xfer_fill(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head;
+	sftp_request_t *r;
+	size_t n;
+
+	if (x->failed)
+		return;
+
+	if (job->dir == FROMREMOTE) {
+		while (x->num_req < x->max_req) {
+			r = sftp_request_alloc(c);
+			if (r == NULL)
+				break;
+			r->offset = x->offset;
+			r->len = c->sftp.transfer_buflen;
+			x->offset += r->len;
+			sftp_send_read(pvar, c, r);
+		}
+	} else {
+		while (!x->eof && x->num_req < c->sftp.num_requests) {
+			n = fread(x->chunk, 1, c->sftp.transfer_buflen, x->fp);
+			if (n == 0) {
+				if (ferror(x->fp)) {
+					sftp_xfer_error(pvar, c, "read error on \"%s\"", job->local);
+					x->failed = 1;
+				}
+				x->eof = 1;
+				break;
+			}
+			r = sftp_request_alloc(c);
+			r->offset = x->offset;
+			r->len = (unsigned int)n;
+			x->offset += n;
+			sftp_send_write(pvar, c, r, x->chunk);
+		}
+	}
+}
+
+static void sftp_xfer_next(PTInstVar pvar, Channel_t *c);
+
+// t@C̃I[vɐBREAD/WRITE ̑Mn߂B
+static void sftp_xfer_start_data(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+
+	x->state = SFTP_XFER_DATA;
+	x->offset = 0;
+	x->done = 0;
+	x->num_req = 0;
+	x->max_req = 1;   // t@CŖʂ READ TȂ悤A1 瑝₵Ă
+	x->eof = 0;
+	x->file_tick = GetTickCount();
+	sftp_xfer_fill(pvar, c);
+}
+
+// READ/WRITE ׂčς񂾂nhB
+static void sftp_xfer_check_done(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head;
+
+	if (x->num_req > 0)
+		return;
+	if (job->dir == FROMREMOTE && x->max_req > 0 && !x->failed)
+		return;
+	if (job->dir == TOREMOTE && !x->eof && !x->failed)
+		return;
+
+	if (job->dir == TOREMOTE && !x->failed && (job->a.flags & SSH2_FILEXFER_ATTR_ACMODTIME)) {
+		// scpsend ƓXVۂ
+		x->ctl_id = sftp_send_fsetstat_times(pvar, c, &job->a);
+		x->state = SFTP_XFER_SETSTAT;
+		return;
+	}
+
+	x->ctl_id = sftp_send_handle_request(pvar, c, SSH2_FXP_CLOSE);
+	x->state = SFTP_XFER_CLOSE;
+}
+
+// Wu1IB
+static void sftp_xfer_job_done(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head;
+	DWORD ms;
+
+	if (x->fp != NULL) {
+		fclose(x->fp);
+		x->fp = NULL;
+
+		if (job->dir == FROMREMOTE) {
+			if (x->failed) {
+				// MɎst@C̎c[͍폜 (SCPƓ)
+				remove(job->local);
+			} else if (job->a.flags & SSH2_FILEXFER_ATTR_ACMODTIME) {
+				struct _utimbuf filetime;
+				filetime.actime = job->a.atime;
+				filetime.modtime = job->a.mtime;
+				_utime(job->local, &filetime);
+			}
+		}
+		if (!x->failed) {
+			ms = GetTickCount() - x->file_tick;
+			x->files++;
+			sftp_syslog(pvar, "SFTP: %s %s -> %s (%llu bytes, %lu ms)",
+				job->dir == FROMREMOTE ? "get" : "put",
+				job->dir == FROMREMOTE ? job->remote : job->local,
+				job->dir == FROMREMOTE ? job->local : job->remote,
+				x->done, ms);
+		}
+	}
+	sftp_xfer_free_handle(x);
+	x->failed = 0;
+	sftp_job_pop(x);
+	sftp_xfer_next(pvar, c);
+}
+
+// ׂẴWuIBʂOɎcA`lB
+static void sftp_xfer_finish(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	DWORD ms = GetTickCount() - x->start_tick;
+	char buf[256];
+
+	sftp_do_syslog(pvar, LOG_LEVEL_NOTICE, "SFTP: %u files, %llu bytes in %lu ms (%llu KB/s, %u x %u bytes requests)",
+		x->files, x->total, ms, ms > 0 ? x->total * 1000 / ms / 1024 : 0,
+		c->sftp.num_requests, c->sftp.transfer_buflen);
+
+	if (x->errors > 0) {
+		_snprintf_s(buf, sizeof(buf), _TRUNCATE,
+			"SFTP transfer failed for %u file(s). See TTSSH.LOG for details.", x->errors);
+		notify_nonfatal_error(pvar, buf);
+	}
+
+	c->sftp.state = SFTP_CLOSING;
+	ssh2_channel_send_close(pvar, c);
+}
+
+// M郊[g̃pX̎ނɉėv𑗂B炸ɍς񂾃Wu 0 ԂB
+static int sftp_xfer_begin_get(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head;
+	unsigned int type = job->a.perm & SFTP_S_IFMT;
+
+	if ((job->a.flags & SSH2_FILEXFER_ATTR_PERMISSIONS) && type == SFTP_S_IFDIR) {
+		if (!CreateDirectory(job->local, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+			sftp_xfer_error(pvar, c, "couldn't create local directory \"%s\" (%d)", job->local, GetLastError());
+			return 0;
+		}
+		x->ctl_id = sftp_send_path_request(pvar, c, SSH2_FXP_OPENDIR, job->remote);
+		x->state = SFTP_XFER_OPENDIR;
+		return 1;
+	}
+
+	if ((job->a.flags & SSH2_FILEXFER_ATTR_PERMISSIONS) && type != SFTP_S_IFREG) {
+		sftp_syslog(pvar, "SFTP: skipping non-regular file \"%s\"", job->remote);
+		return 0;
+	}
+
+	x->fp = fopen(job->local, "wb");
+	if (x->fp == NULL) {
+		sftp_xfer_error(pvar, c, "couldn't open local file \"%s\" for writing (%d)", job->local, GetLastError());
+		return 0;
+	}
+	x->ctl_id = sftp_send_open(pvar, c, job->remote, SSH2_FXF_READ, 0);
+	x->state = SFTP_XFER_OPEN;
+	return 1;
+}
+
+// M郍[J̃pX̎ނɉėv𑗂B炸ɍς񂾃Wu 0 ԂB
+static int sftp_xfer_begin_put(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head;
+	struct __stat64 st;
+	DWORD attr;
+
+	attr = GetFileAttributes(job->local);
+	if (attr == INVALID_FILE_ATTRIBUTES) {
+		sftp_xfer_error(pvar, c, "couldn't stat local file \"%s\" (%d)", job->local, GetLastError());
+		return 0;
+	}
+
+	if (attr & FILE_ATTRIBUTE_DIRECTORY) {
+		x->ctl_id = sftp_send_mkdir(pvar, c, job->remote, 0755);
+		x->state = SFTP_XFER_MKDIR;
+		return 1;
+	}
+
+	x->fp = fopen(job->local, "rb");
+	if (x->fp == NULL) {
+		sftp_xfer_error(pvar, c, "couldn't open local file \"%s\" for reading (%d)", job->local, GetLastError());
+		return 0;
+	}
+	if (_stat64(job->local, &st) == 0) {
+		job->a.flags = SSH2_FILEXFER_ATTR_ACMODTIME;
+		job->a.atime = (unsigned int)st.st_atime;
+		job->a.mtime = (unsigned int)st.st_mtime;
+	}
+	x->ctl_id = sftp_send_open(pvar, c, job->remote, SSH2_FXF_WRITE | SSH2_FXF_CREAT | SSH2_FXF_TRUNC, 0644);
+	x->state = SFTP_XFER_OPEN;
+	return 1;
+}
+
+// L[̐擪̃Wun߂B
+static void sftp_xfer_next(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job;
+	int sent;
+
+	for (;;) {
+		job = x->head;
+		if (job == NULL) {
+			sftp_xfer_finish(pvar, c);
+			return;
+		}
+
+		if ((job->dir == FROMREMOTE && !job->has_attrib) ||
+		    (job->dir == TOREMOTE && job->resolve)) {
+			x->ctl_id = sftp_send_path_request(pvar, c, SSH2_FXP_STAT, job->remote);
+			x->state = SFTP_XFER_STAT;
+			return;
+		}
+
+		if (job->dir == FROMREMOTE)
+			sent = sftp_xfer_begin_get(pvar, c);
+		else
+			sent = sftp_xfer_begin_put(pvar, c);
+		if (sent)
+			return;
+		sftp_job_pop(x);
+	}
+}
+
+// [J̃fBNg̒gL[ɐςށB
+static void sftp_xfer_queue_local_dir(PTInstVar pvar, Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head, *child;
+	WIN32_FIND_DATA fd;
+	HANDLE hFind;
+	char pattern[MAX_PATH], local[MAX_PATH], remote[1024];
+
+	sftp_join_path(pattern, sizeof(pattern), job->local, "*", '\\');
+	hFind = FindFirstFile(pattern, &fd);
+	if (hFind == INVALID_HANDLE_VALUE) {
+		sftp_xfer_error(pvar, c, "couldn't open local directory \"%s\" (%d)", job->local, GetLastError());
+		return;
+	}
+	do {
+		if (strcmp(fd.cFileName, ".") == 0 || strcmp(fd.cFileName, "..") == 0)
+			continue;
+		sftp_join_path(local, sizeof(local), job->local, fd.cFileName, '\\');
+		sftp_join_path(remote, sizeof(remote), job->remote, fd.cFileName, '/');
+		child = sftp_job_new(TOREMOTE, local, remote);
+		if (child != NULL)
+			sftp_job_push(x, child);
+	} while (FindNextFile(hFind, &fd));
+	FindClose(hFind);
+}
+
+// SSH2_FXP_NAME ̊eGgL[ɐςށB
+static void sftp_xfer_queue_remote_dir(PTInstVar pvar, Channel_t *c, buffer_t *msg)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head, *child;
+	unsigned int count, i;
+	char *filename, *longname;
+	char local[MAX_PATH], remote[1024];
+	sftp_attrib_t a;
+
+	count = buffer_get_int(msg);
+	for (i = 0; i < count; i++) {
+		filename = buffer_get_string_msg(msg, NULL);
+		longname = buffer_get_string_msg(msg, NULL);
+		if (filename == NULL || longname == NULL) {
+			free(filename);
+			free(longname);
+			break;
+		}
+		sftp_decode_attrib(msg, &a);
+
+		if (strcmp(filename, ".") == 0 || strcmp(filename, "..") == 0) {
+			// .  .. ͔΂
+		}
+		else if (filename[0] == '\0' || strpbrk(filename, "/\\:") != NULL) {
+			// T[o痈OŃ[J̃fBNg̊O֏܂Ȃ悤A
+			// pX؂hCuw܂ޖO͔΂ (OpenSSH  do_lsreaddir Ɠl)
+			sftp_do_syslog(pvar, LOG_LEVEL_WARNING, "SFTP: skipping suspect path \"%s\" in \"%s\"",
+			               filename, job->remote);
+		}
+		else {
+			sftp_join_path(local, sizeof(local), job->local, filename, '\\');
+			sftp_join_path(remote, sizeof(remote), job->remote, filename, '/');
+			child = sftp_job_new(FROMREMOTE, local, remote);
+			if (child != NULL) {
+				child->has_attrib = 1;
+				child->a = a;
+				sftp_job_push(x, child);
+			}
+		}
+		free(filename);
+		free(longname);
+	}
+}
+
+// ]̎MBprotocol error ̏ꍇ FALSE ԂB
+static BOOL sftp_xfer_response(PTInstVar pvar, Channel_t *c, buffer_t *msg)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+	sftp_job_t *job = x->head;
+	sftp_request_t *r;
+	unsigned int type, id, status, len;
+	char *p, name[MAX_PATH];
+
+	type = buffer_get_char(msg);
+	id = buffer_get_int(msg);
+
+	if (x->state == SFTP_XFER_DATA) {
+		r = sftp_request_lookup(c, id);
+		if (r == NULL) {
+			sftp_syslog(pvar, "SFTP: unexpected reply ID %u", id);
+			return FALSE;
+		}
+
+		if (job->dir == FROMREMOTE) {
+			if (type == SSH2_FXP_DATA) {
+				len = buffer_get_int(msg);
+				p = buffer_tail_ptr(msg);
+				if (len == 0 || len > r->len || len > (unsigned int)buffer_remain_len(msg)) {
+					sftp_syslog(pvar, "SFTP: invalid data length %u (asked for %u)", len, r->len);
+					return FALSE;
+				}
+				// ͗vɓ͂Ƃ͌Ȃ̂ŁAvItZbg֏
+				if (!x->failed &&
+				    (_fseeki64(x->fp, r->offset, SEEK_SET) != 0 || fwrite(p, 1, len, x->fp) != len)) {
+					sftp_xfer_error(pvar, c, "write error on \"%s\"", job->local);
+					x->failed = 1;
+				}
+				x->done += len;
+				x->total += len;
+
+				if (len < r->len && !x->failed) {
+					// ZBcxvB
+					r->offset += len;
+					r->len -= len;
+					sftp_send_read(pvar, c, r);
+				} else {
+					sftp_request_free(c, r);
+				}
+
+				if (x->max_req > 0) {
+					if ((job->a.flags & SSH2_FILEXFER_ATTR_SIZE) && x->offset > job->a.size) {
+						// t@C̏IzBEOF ̊mF1sB
+						x->max_req = 1;
+					} else if (x->max_req < c->sftp.num_requests) {
+						x->max_req++;
+					}
+				}
+			} else if (type == SSH2_FXP_STATUS) {
+				status = buffer_get_int(msg);
+				if (status != SSH2_FX_EOF && !x->failed) {
+					sftp_xfer_error(pvar, c, "couldn't read from \"%s\": %s", job->remote, fx2txt(status));
+					x->failed = 1;
+				}
+				x->max_req = 0;
+				sftp_request_free(c, r);
+			} else {
+				sftp_syslog(pvar, "SFTP: expected SSH2_FXP_DATA(%u) packet, got %u", SSH2_FXP_DATA, type);
+				return FALSE;
+			}
+		} else {
+			if (type != SSH2_FXP_STATUS) {
+				sftp_syslog(pvar, "SFTP: expected SSH2_FXP_STATUS(%u) packet, got %u", SSH2_FXP_STATUS, type);
+				return FALSE;
+			}
+			status = buffer_get_int(msg);
+			if (status != SSH2_FX_OK && !x->failed) {
+				sftp_xfer_error(pvar, c, "couldn't write to \"%s\": %s", job->remote, fx2txt(status));
+				x->failed = 1;
+			}
+			x->done += r->len;
+			x->total += r->len;
+			sftp_request_free(c, r);
+		}
+
+		sftp_xfer_fill(pvar, c);
+		sftp_xfer_check_done(pvar, c);
+		return TRUE;
+	}
+
+	if (id != x->ctl_id) {
+		sftp_syslog(pvar, "SFTP: ID mismatch (%u != %u)", id, x->ctl_id);
+		return FALSE;
+	}
+
+	switch (x->state) {
+	case SFTP_XFER_STAT:
+		if (type == SSH2_FXP_ATTRS) {
+			sftp_decode_attrib(msg, &job->a);
+			if (job->dir == FROMREMOTE) {
+				job->has_attrib = 1;
+			} else if ((job->a.flags & SSH2_FILEXFER_ATTR_PERMISSIONS) &&
+			           (job->a.perm & SFTP_S_IFMT) == SFTP_S_IFDIR) {
+				// ]悪fBNgȂẢ֓Oő
+				sftp_basename(job->local, name, sizeof(name));
+				p = _strdup(job->remote);
+				if (p != NULL) {
+					sftp_join_path(job->remote, sizeof(job->remote), p, name, '/');
+					free(p);
+				}
+			}
+		} else if (type == SSH2_FXP_STATUS) {
+			status = buffer_get_int(msg);
+			if (job->dir == FROMREMOTE) {
+				sftp_xfer_error(pvar, c, "couldn't stat remote file \"%s\": %s", job->remote, fx2txt(status));
+				sftp_job_pop(x);
+				sftp_xfer_next(pvar, c);
+				break;
+			}
+			// ]悪݂ȂȂA̖Oō
+		} else {
+			return FALSE;
+		}
+		job->resolve = 0;
+		sftp_xfer_next(pvar, c);
+		break;
+
+	case SFTP_XFER_MKDIR:
+		if (type != SSH2_FXP_STATUS)
+			return FALSE;
+		status = buffer_get_int(msg);
+		if (status != SSH2_FX_OK) {
+			// ɑ݂ꍇsԂ̂ŁÂ܂ܒg𑗂
+			sftp_syslog(pvar, "SFTP: mkdir \"%s\": %s", job->remote, fx2txt(status));
+		}
+		sftp_xfer_queue_local_dir(pvar, c);
+		sftp_job_pop(x);
+		sftp_xfer_next(pvar, c);
+		break;
+
+	case SFTP_XFER_OPEN:
+	case SFTP_XFER_OPENDIR:
+		if (type == SSH2_FXP_HANDLE) {
+			x->handle = buffer_get_string_msg(msg, &x->handle_len);
+			if (x->handle == NULL)
+				return FALSE;
+			if (x->state == SFTP_XFER_OPEN) {
+				sftp_xfer_start_data(pvar, c);
+				sftp_xfer_check_done(pvar, c);
+			} else {
+				x->ctl_id = sftp_send_handle_request(pvar, c, SSH2_FXP_READDIR);
+				x->state = SFTP_XFER_READDIR;
+			}
+		} else if (type == SSH2_FXP_STATUS) {
+			status = buffer_get_int(msg);
+			sftp_xfer_error(pvar, c, "couldn't open \"%s\": %s", job->remote, fx2txt(status));
+			x->failed = 1;
+			sftp_xfer_job_done(pvar, c);
+		} else {
+			return FALSE;
+		}
+		break;
+
+	case SFTP_XFER_READDIR:
+		if (type == SSH2_FXP_NAME) {
+			sftp_xfer_queue_remote_dir(pvar, c, msg);
+			x->ctl_id = sftp_send_handle_request(pvar, c, SSH2_FXP_READDIR);
+		} else if (type == SSH2_FXP_STATUS) {
+			status = buffer_get_int(msg);
+			if (status != SSH2_FX_EOF)
+				sftp_xfer_error(pvar, c, "couldn't read directory \"%s\": %s", job->remote, fx2txt(status));
+			x->ctl_id = sftp_send_handle_request(pvar, c, SSH2_FXP_CLOSE);
+			x->state = SFTP_XFER_CLOSEDIR;
+		} else {
+			return FALSE;
+		}
+		break;
+
+	case SFTP_XFER_SETSTAT:
+		if (type != SSH2_FXP_STATUS)
+			return FALSE;
+		status = buffer_get_int(msg);
+		if (status != SSH2_FX_OK) {
+			// ݒłȂT[ôŁA]͎sɂȂ
+			sftp_syslog(pvar, "SFTP: couldn't set times of \"%s\": %s", job->remote, fx2txt(status));
+		}
+		x->ctl_id = sftp_send_handle_request(pvar, c, SSH2_FXP_CLOSE);
+		x->state = SFTP_XFER_CLOSE;
+		break;
+
+	case SFTP_XFER_CLOSE:
+	case SFTP_XFER_CLOSEDIR:
+		if (type != SSH2_FXP_STATUS)
+			return FALSE;
+		status = buffer_get_int(msg);
+		if (status != SSH2_FX_OK && x->state == SFTP_XFER_CLOSE && !x->failed) {
+			sftp_xfer_error(pvar, c, "couldn't close \"%s\": %s", job->remote, fx2txt(status));
+			x->failed = 1;
+		}
+		sftp_xfer_job_done(pvar, c);
+		break;
+
+	default:
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// ]̂߂ local window ̑傫B҂ɑ READ ̕mۂB
+unsigned int sftp_get_window_size(PTInstVar pvar)
+{
+	unsigned int buflen, num_requests, window;
+
+	sftp_get_transfer_params(pvar, &buflen, &num_requests);
+	window = num_requests * (buflen + 1024);
+	if (window < CHAN_SES_WINDOW_DEFAULT)
+		window = CHAN_SES_WINDOW_DEFAULT;
+	return window;
+}
+
+// sftpsend/sftprecv ̓]Wuo^B`lJOɌĂԁB
+int sftp_add_transfer(PTInstVar pvar, Channel_t *c, char *sendfile, char *dstfile, enum scp_dir direction)
+{
+	sftp_xfer_t *x;
+	sftp_job_t *job = NULL;
+	char name[MAX_PATH], path[MAX_PATH], remote[1024], buf[MAX_PATH + 64];
+	unsigned int buflen, num_requests;
+	DWORD attr;
+
+	sftp_basename(sendfile, name, sizeof(name));
+	if (name[0] == '\0') {
+		_snprintf_s(buf, sizeof(buf), _TRUNCATE, "`%s' is not a valid file name.", sendfile);
+		notify_nonfatal_error(pvar, buf);
+		return FALSE;
+	}
+
+	if (direction == TOREMOTE) {
+		if (GetFileAttributes(sendfile) == INVALID_FILE_ATTRIBUTES) {
+			_snprintf_s(buf, sizeof(buf), _TRUNCATE, "`%s' does not exist.", sendfile);
+			notify_nonfatal_error(pvar, buf);
+			return FALSE;
+		}
+		if (dstfile == NULL || dstfile[0] == '\0') {
+			// z[fBNg֑
+			job = sftp_job_new(direction, sendfile, name);
+		} else if (dstfile[strlen(dstfile) - 1] == '/') {
+			sftp_join_path(remote, sizeof(remote), dstfile, name, '/');
+			job = sftp_job_new(direction, sendfile, remote);
+		} else {
+			job = sftp_job_new(direction, sendfile, dstfile);
+			if (job != NULL)
+				job->resolve = 1;
+		}
+	} else {
+		if (dstfile == NULL || dstfile[0] == '\0') {
+			sftp_join_path(path, sizeof(path), pvar->ts->FileDir, name, '\\');
+		} else {
+			attr = GetFileAttributes(dstfile);
+			if (attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY))
+				sftp_join_path(path, sizeof(path), dstfile, name, '\\');
+			else
+				strncpy_s(path, sizeof(path), dstfile, _TRUNCATE);
+		}
+		job = sftp_job_new(direction, path, sendfile);
+	}
+	if (job == NULL)
+		return FALSE;
+
+	sftp_get_transfer_params(pvar, &buflen, &num_requests);
+	x = calloc(1, sizeof(sftp_xfer_t));
+	if (x != NULL) {
+		x->req = calloc(num_requests, sizeof(sftp_request_t));
+		x->chunk = malloc(buflen);
+	}
+	if (x == NULL || x->req == NULL || x->chunk == NULL) {
+		if (x != NULL) {
+			free(x->req);
+			free(x->chunk);
+			free(x);
+		}
+		free(job);
+		return FALSE;
+	}
+	sftp_job_push(x, job);
+	c->sftp.xfer = x;
+
+	return TRUE;
+}
+
+// `l̉ɌĂ΂B
+void sftp_channel_free(Channel_t *c)
+{
+	sftp_xfer_t *x = c->sftp.xfer;
+
+	if (x != NULL) {
+		if (x->head != NULL) {
+			logprintf(LOG_LEVEL_ERROR, "SFTP: transfer of \"%s\" was interrupted.",
+				x->head->dir == FROMREMOTE ? x->head->remote : x->head->local);
+		}
+		if (x->fp != NULL) {
+			fclose(x->fp);
+			if (x->head != NULL && x->head->dir == FROMREMOTE)
+				remove(x->head->local);
+		}
+		while (x->head != NULL)
+			sftp_job_pop(x);
+		free(x->handle);
+		free(x->req);
+		free(x->chunk);
+		free(x);
+		c->sftp.xfer = NULL;
+	}
+	if (c->sftp.recvbuf != NULL) {
+		buffer_free(c->sftp.recvbuf);
+		c->sftp.recvbuf = NULL;
+	}
+}
+
 
 u_int
 sftp_proto_version(struct sftp *conn)
@@ -1133,25 +2079,26 @@ static LRESULT CALLBACK OnSftpConsoleDlgProc(HWND hDlgWnd, UINT msg, WPARAM wp,
 	return TRUE;
 }
 
-// SFTPM -Xe[g}V[-
-void sftp_response(PTInstVar pvar, Channel_t *c, unsigned char *data, unsigned int buflen)
+// 1SFTPbZ[WBmsg ͒(4byte)̒wĂB
+static BOOL sftp_dispatch(PTInstVar pvar, Channel_t *c, buffer_t *msg)
 {
-	buffer_t *msg;
 	HWND hDlgWnd;
 
-	/*
-	 * Allocate buffer
-	 */
-	sftp_buffer_alloc(&msg);
-	sftp_get_msg(pvar, c, data, buflen, &msg);
-
 	if (c->sftp.state == SFTP_INIT) {
+		sftp_do_init_recv(pvar, c, msg);
+
+		if (c->sftp.xfer != NULL) {
+			// sftpsend/sftprecv ̓]n߂
+			c->sftp.state = SFTP_XFER;
+			c->sftp.xfer->start_tick = GetTickCount();
+			sftp_xfer_next(pvar, c);
+			return TRUE;
+		}
+
 		// O[oϐɕۑB
 		g_pvar = pvar;
 		g_channel = c;
 
-		sftp_do_init_recv(pvar, c, msg);
-
 		// R\[NB
 		hDlgWnd = CreateDialog(hInst, MAKEINTRESOURCE(IDD_SFTP_DIALOG), 
 				pvar->cv->HWin, (DLGPROC)OnSftpConsoleDlgProc);	
@@ -1166,13 +2113,90 @@ void sftp_response(PTInstVar pvar, Channel_t *c, unsigned char *data, unsigned i
 	} else if (c->sftp.state == SFTP_CONNECTED) {
 		char *remote_path;
 		remote_path = sftp_do_realpath_recv(pvar, c, msg);
+		free(remote_path);
 
 		c->sftp.state = SFTP_REALPATH;
 
+	} else if (c->sftp.state == SFTP_XFER) {
+		return sftp_xfer_response(pvar, c, msg);
+
 	}
 
-	/*
-	 * Free buffer
-	 */
-	sftp_buffer_free(msg);
+	return TRUE;
+}
+
+// SFTPM -Xe[g}V[-
+//
+// SFTPbZ[Wƃ`l̃f[^̋؂͈vȂB1̃bZ[W
+// ̃f[^ɕē͂ƂA1̃f[^ɕ̃bZ[WĂ邱ƂB
+// ĂȂbZ[W c->sftp.recvbuf ɗ߂ĂB
+void sftp_response(PTInstVar pvar, Channel_t *c, unsigned char *data, unsigned int buflen)
+{
+	buffer_t *buf, view;
+	unsigned char *p;
+	unsigned int len, pos, msg_len, remain;
+
+	if (c->sftp.state == SFTP_CLOSING)
+		return;
+
+	if (c->sftp.recvbuf == NULL) {
+		c->sftp.recvbuf = buffer_init();
+		if (c->sftp.recvbuf == NULL)
+			return;
+	}
+	buf = c->sftp.recvbuf;
+
+	// ߂Ăf[^Ȃ΁AMf[^璼ڎo
+	if (buffer_len(buf) == 0) {
+		p = data;
+		len = buflen;
+	} else {
+		buffer_append(buf, (char *)data, buflen);
+		p = (unsigned char *)buffer_ptr(buf);
+		len = buffer_len(buf);
+	}
+
+	pos = 0;
+	while (len - pos >= 4) {
+		msg_len = get_uint32(p + pos);
+		if (msg_len > SFTP_MAX_MSG_LENGTH) {
+			sftp_syslog(pvar, "Received message too long %u", msg_len);
+			goto error;
+		}
+		if (len - pos - 4 < msg_len)
+			break;
+
+		// Mobt@̈ꕔ̂܂ buffer_t Ƃēǂ
+		view.buf = (char *)p + pos;
+		view.len = view.maxlen = msg_len + 4;
+		view.offset = 4;
+		if (!sftp_dispatch(pvar, c, &view))
+			goto error;
+		pos += 4 + msg_len;
+
+		if (c->sftp.state == SFTP_CLOSING)
+			return;
+	}
+
+	remain = len - pos;
+	if (p == data) {
+		buffer_clear(buf);
+		if (remain > 0)
+			buffer_append(buf, (char *)p + pos, remain);
+	} else {
+		memmove(buf->buf, buf->buf + pos, remain);
+		buf->len = buf->offset = remain;
+	}
+	return;
+
+error:
+	// vƉ̑ΉȂȂ̂ŁA]ł؂
+	if (c->sftp.xfer != NULL) {
+		char tmp[128];
+		_snprintf_s(tmp, sizeof(tmp), _TRUNCATE, "SFTP protocol error. The transfer was aborted.");
+		notify_nonfatal_error(pvar, tmp);
+	}
+	c->sftp.state = SFTP_CLOSING;
+	buffer_clear(buf);
+	ssh2_channel_send_close(pvar, c);
 }
@@ -107,7 +107,15 @@
 #define DEFAULT_COPY_BUFLEN 32768   /* Size of buffer for up/download */
 #define DEFAULT_NUM_REQUESTS    64  /* # concurrent outstanding requests */
 
+/* Limits of SftpBlockSize and SftpMaxRequests in TERATERM.INI */
+#define SFTP_MIN_COPY_BUFLEN    1024
+#define SFTP_MAX_COPY_BUFLEN    (SFTP_MAX_MSG_LENGTH - 1024)
+#define SFTP_MAX_NUM_REQUESTS   256
+
 void sftp_do_init(PTInstVar pvar, Channel_t *c);
 void sftp_response(PTInstVar pvar, Channel_t *c, unsigned char *data, unsigned int buflen);
+unsigned int sftp_get_window_size(PTInstVar pvar);
+int sftp_add_transfer(PTInstVar pvar, Channel_t *c, char *sendfile, char *dstfile, enum scp_dir direction);
+void sftp_channel_free(Channel_t *c);
 
 #endif
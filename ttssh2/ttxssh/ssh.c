@@ -106,6 +106,7 @@ static BOOL handle_SSH2_kexinit(PTInstVar pvar);
 static void SSH2_dh_kex_init(PTInstVar pvar);
 static void SSH2_dh_gex_kex_init(PTInstVar pvar);
 static void SSH2_ecdh_kex_init(PTInstVar pvar);
+static void SSH2_c25519_kex_init(PTInstVar pvar);
 static BOOL handle_SSH2_dh_common_reply(PTInstVar pvar);
 static BOOL handle_SSH2_dh_gex_reply(PTInstVar pvar);
 static BOOL handle_SSH2_newkeys(PTInstVar pvar);
@@ -120,6 +121,7 @@ static BOOL handle_SSH2_request_success(PTInstVar pvar);
 static BOOL handle_SSH2_request_failure(PTInstVar pvar);
 static BOOL handle_SSH2_channel_success(PTInstVar pvar);
 static BOOL handle_SSH2_channel_failure(PTInstVar pvar);
+static void ssh2_channel_winadj_reply(PTInstVar pvar, Channel_t *c);
 static BOOL handle_SSH2_channel_data(PTInstVar pvar);
 static BOOL handle_SSH2_channel_extended_data(PTInstVar pvar);
 static BOOL handle_SSH2_channel_eof(PTInstVar pvar);
@@ -127,6 +129,7 @@ static BOOL handle_SSH2_channel_close(PTInstVar pvar);
 static BOOL handle_SSH2_channel_open(PTInstVar pvar);
 static BOOL handle_SSH2_window_adjust(PTInstVar pvar);
 static BOOL handle_SSH2_channel_request(PTInstVar pvar);
+static void ssh2_scp_free_ring(Channel_t *c);
 void SSH2_dispatch_init(int stage);
 int SSH2_dispatch_enabled_check(unsigned char message);
 void SSH2_dispatch_add_message(unsigned char message);
@@ -206,6 +209,7 @@ static Channel_t *ssh2_channel_new(unsigned int window, unsigned int maxpack,
 	c->local_window = window;
 	c->local_window_max = window;
 	c->local_consumed = 0;
+	c->open_time = GetTickCount();
 	c->local_maxpacket = maxpack;
 	c->remote_window = 0;
 	c->remote_maxpacket = 0;
@@ -261,6 +265,10 @@ static void ssh2_channel_retry_send_bufchain(PTInstVar pvar, Channel_t *c)
 	bufchain_t *ch;
 	unsigned int size;
 
+	// ͑炸ɃXg֎cĂÅɑB
+	if (pvar->rekeying)
+		return;
+
 	while (c->bufchain) {
 		// 擪ɑ
 		ch = c->bufchain;
@@ -287,6 +295,15 @@ static void ssh2_channel_delete(Channel_t *c)
 {
 	bufchain_t *ch, *ptr;
 	enum scp_state prev_state;
+	DWORD elapsed;
+
+	if (c->recv_bytes > 0) {
+		elapsed = GetTickCount() - c->open_time;
+		logprintf(LOG_LEVEL_VERBOSE, "channel %d closed: received %llu bytes in %lu ms (%llu bytes/s), "
+		          "window %u, rtt %lu ms, %u window adjusts",
+		          c->self_id, c->recv_bytes, elapsed, elapsed > 0 ? c->recv_bytes * 1000 / elapsed : 0,
+		          c->local_window_max, c->rtt, c->adjust_count);
+	}
 
 	ch = c->bufchain;
 	while (ch) {
@@ -302,6 +319,21 @@ static void ssh2_channel_delete(Channel_t *c)
 		prev_state = c->scp.state;
 
 		c->scp.state = SCP_CLOSING;
+		if (c->scp.progress_window != NULL) {
+			DestroyWindow(c->scp.progress_window);
+			c->scp.progress_window = NULL;
+		}
+		// Xbht@CǂݏIĂ
+		if (c->scp.thread != (HANDLE)-1L) {
+			// 󂫂҂Ă鑗MXbhN
+			if (c->scp.ring_space != NULL)
+				SetEvent(c->scp.ring_space);
+			WaitForSingleObject(c->scp.thread, INFINITE);
+			CloseHandle(c->scp.thread);
+			c->scp.thread = (HANDLE)-1L;
+		}
+		ssh2_scp_free_ring(c);
+
 		if (c->scp.localfp != NULL) {
 			fclose(c->scp.localfp);
 			if (c->scp.dir == FROMREMOTE) {
@@ -318,21 +350,15 @@ static void ssh2_channel_delete(Channel_t *c)
 					remove(c->scp.localfilefull);
 			}
 		}
-		if (c->scp.progress_window != NULL) {
-			DestroyWindow(c->scp.progress_window);
-			c->scp.progress_window = NULL;
-		}
-		if (c->scp.thread != (HANDLE)-1L) {
-			WaitForSingleObject(c->scp.thread, INFINITE);
-			CloseHandle(c->scp.thread);
-			c->scp.thread = (HANDLE)-1L;
-		}
 
 		ssh2_scp_free_packetlist(c);
 	}
 	if (c->type == TYPE_AGENT) {
 		buffer_free(c->agent_msg);
 	}
+	if (c->type == TYPE_SFTP) {
+		sftp_channel_free(c);
+	}
 
 	memset(c, 0, sizeof(Channel_t));
 	c->used = 0;
@@ -3419,6 +3445,12 @@ void SSH2_send_channel_data(PTInstVar pvar, Channel_t *c, unsigned char *buf, un
 	unsigned int len;
 
 	// SSH2̏ꍇApPbĝĂB(2005.6.19 yutaka)
+	// SFTP͗vƉ̑ΉĂ܂߁AXgւȂł
+	// ̊ɑB
+	if (pvar->rekeying && c != NULL && c->type == TYPE_SFTP) {
+		ssh2_channel_add_bufchain(c, buf, buflen);
+		return;
+	}
 	if (pvar->rekeying) {
 		// TODO: zƂĂ̓pPbgjł͂ȂApPbgǂݎxɂƂ낾A
 		// ƂɂB
@@ -4129,15 +4161,14 @@ int SSH_start_scp_receive(PTInstVar pvar, char *filename)
 }
 
 
-int SSH_sftp_transaction(PTInstVar pvar)
+// SFTP`lJBsftpsend/sftprecv ̏ꍇ͓]Wuo^ĂJB
+static int ssh2_sftp_channel_open(PTInstVar pvar, char *sendfile, char *dstfile, enum scp_dir direction)
 {
 	buffer_t *msg;
 	char *s;
 	unsigned char *outmsg;
 	int len;
 	Channel_t *c = NULL;
-//	FILE *fp = NULL;
-//	struct __stat64 st;
 
 	// \PbgN[YĂꍇ͉ȂB
 	if (pvar->socket == INVALID_SOCKET)
@@ -4147,7 +4178,8 @@ int SSH_sftp_transaction(PTInstVar pvar)
 		goto error;
 
 	// `lݒ
-	c = ssh2_channel_new(CHAN_SES_WINDOW_DEFAULT, CHAN_SES_PACKET_DEFAULT, TYPE_SFTP, -1);
+	// vׂđ̉~܂炸ɓ͂悤Alocal window 傫ƂB
+	c = ssh2_channel_new(sftp_get_window_size(pvar), CHAN_SES_PACKET_DEFAULT, TYPE_SFTP, -1);
 	if (c == NULL) {
 		UTIL_get_lang_msg("MSG_SSH_NO_FREE_CHANNEL", pvar,
 		                  "Could not open new channel. TTSSH is already opening too many channels.");
@@ -4155,6 +4187,11 @@ int SSH_sftp_transaction(PTInstVar pvar)
 		goto error;
 	}
 
+	if (sendfile != NULL) {
+		if (!sftp_add_transfer(pvar, c, sendfile, dstfile, direction))
+			goto error;
+	}
+
 	// session open
 	msg = buffer_init();
 	if (msg == NULL) {
@@ -4182,6 +4219,16 @@ error:
 	return FALSE;
 }
 
+int SSH_sftp_transaction(PTInstVar pvar)
+{
+	return ssh2_sftp_channel_open(pvar, NULL, NULL, TOREMOTE);
+}
+
+int SSH_sftp_transfer(PTInstVar pvar, char *sendfile, char *dstfile, enum scp_dir direction)
+{
+	return ssh2_sftp_channel_open(pvar, sendfile, dstfile, direction);
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -4582,6 +4629,9 @@ void SSH2_update_cipher_myproposal(PTInstVar pvar)
 			case SSH2_CIPHER_AES256_GCM:
 				c_str = "aes256-gcm@openssh.com,";
 				break;
+			case SSH2_CIPHER_CHACHAPOLY:
+				c_str = "chacha20-poly1305@openssh.com,";
+				break;
 			default:
 				continue;
 		}
@@ -4733,6 +4783,9 @@ void SSH2_send_kexinit(PTInstVar pvar)
 		buffer_free(pvar->my_kex);
 	pvar->my_kex = msg;
 
+	// ɂԂ SSH2_MSG_NEWKEYS MɃOɏo
+	pvar->kex_start_tick = GetTickCount();
+
 	// bZ[W^Cv
 	//SSH2_packet_start(msg, SSH2_MSG_KEXINIT);
 
@@ -5298,6 +5351,10 @@ skip:
 		case KEX_ECDH_SHA2_521:
 			SSH2_ecdh_kex_init(pvar);
 			break;
+		case KEX_CURVE25519_SHA256:
+		case KEX_CURVE25519_SHA256_OLD:
+			SSH2_c25519_kex_init(pvar);
+			break;
 		default:
 			// TODO
 			break;
@@ -5678,6 +5735,42 @@ error:;
 }
 
 
+//
+// KEX_CURVE25519_SHA256 (RFC 8731)
+// bZ[W ECDH Ɠ SSH2_MSG_KEX_ECDH_INIT/REPLY gB
+//
+static void SSH2_c25519_kex_init(PTInstVar pvar)
+{
+	buffer_t *msg = NULL;
+	unsigned char *outmsg;
+	int len;
+
+	// J͌ŃnbVvZɎĝŎĂ
+	kexc25519_keygen(pvar->c25519_client_key, pvar->c25519_client_pubkey);
+
+	msg = buffer_init();
+	if (msg == NULL) {
+		// TODO: error check
+		logputs(LOG_LEVEL_ERROR, __FUNCTION__ ": buffer_init returns NULL.");
+		return;
+	}
+
+	buffer_put_string(msg, (char *)pvar->c25519_client_pubkey, CURVE25519_SIZE);
+
+	len = buffer_len(msg);
+	outmsg = begin_send_packet(pvar, SSH2_MSG_KEX_ECDH_INIT, len);
+	memcpy(outmsg, buffer_ptr(msg), len);
+	finish_send_packet(pvar);
+
+	SSH2_dispatch_init(2);
+	SSH2_dispatch_add_message(SSH2_MSG_KEX_ECDH_REPLY);
+
+	buffer_free(msg);
+
+	logputs(LOG_LEVEL_VERBOSE, "SSH2_MSG_KEX_ECDH_INIT was sent at SSH2_c25519_kex_init().");
+}
+
+
 static void ssh2_set_newkeys(PTInstVar pvar, int mode)
 {
 	// free already allocated buffer
@@ -5692,6 +5785,8 @@ static void ssh2_set_newkeys(PTInstVar pvar, int mode)
 	}
 
 	pvar->ssh2_keys[mode] = current_keys[mode];
+
+	CRYPT_set_MAC_key(pvar, mode);
 }
 
 static BOOL ssh2_kex_finish(PTInstVar pvar, char *hash, int hashlen, BIGNUM *share_key, Key *hostkey, char *signature, int siglen)
@@ -6236,6 +6331,145 @@ error:
 }
 
 
+//
+// curve25519-sha256 Key Exchange Reply(SSH2_MSG_KEX_ECDH_REPLY:31)
+//
+// KEX_ECDH_REPLY ̃yC[h璷t̕ 1 oB
+// *data  *len 𕶎̌܂Ői߁A̐擪ԂB
+// yC[h̎c𒴂Ă NULL ԂB
+static char *get_kex_reply_string(char **data, int *len, int *slen)
+{
+	char *p;
+	unsigned int n;
+
+	if (*len < 4)
+		return NULL;
+	n = get_uint32_MSBfirst(*data);
+	if (n > (unsigned int)(*len - 4))
+		return NULL;
+	p = *data + 4;
+	*data = p + n;
+	*len -= 4 + n;
+	*slen = n;
+	return p;
+}
+
+static BOOL handle_SSH2_c25519_kex_reply(PTInstVar pvar)
+{
+	char *data;
+	int len;
+	char *server_host_key_blob;
+	int bloblen, siglen, publen;
+	unsigned char *server_public;
+	char *signature;
+	BIGNUM *share_key = NULL;
+	char *hash;
+	char *emsg = NULL, emsg_tmp[1024];  // error message
+	int hashlen;
+	Key *hostkey = NULL;  // hostkey
+	BOOL result = FALSE;
+
+	logputs(LOG_LEVEL_VERBOSE, "SSH2_MSG_KEX_ECDH_REPLY was received.");
+
+	// bZ[W^Cv̌ɑyC[h̐擪
+	data = pvar->ssh_state.payload;
+	// yC[h̒; bZ[W^Cv 1 oCg炷
+	len = pvar->ssh_state.payloadlen - 1;
+
+	// for debug
+	push_memdump("KEX_ECDH_REPLY", "key exchange: receiving", data, len);
+
+	server_host_key_blob = get_kex_reply_string(&data, &len, &bloblen); // for hash
+	if (server_host_key_blob == NULL) {
+		emsg = __FUNCTION__ ": truncated server_host_key_blob";
+		goto error;
+	}
+
+	push_memdump("KEX_ECDH_REPLY", "server_host_key_blob", server_host_key_blob, bloblen);
+
+	hostkey = key_from_blob(server_host_key_blob, bloblen);
+	if (hostkey == NULL) {
+		emsg = __FUNCTION__ ": key_from_blob error";
+		goto error;
+	}
+
+	if (hostkey->type != pvar->hostkey_type) {  // zXgL[̎ʔr
+		_snprintf_s(emsg_tmp, sizeof(emsg_tmp), _TRUNCATE,
+		            "%s: type mismatch for decoded server_host_key_blob (kex:%s blob:%s)", __FUNCTION__,
+		            get_ssh_keytype_name(pvar->hostkey_type), get_ssh_keytype_name(hostkey->type));
+		emsg = emsg_tmp;
+		goto error;
+	}
+	HOSTS_check_host_key(pvar, pvar->ssh_state.hostname, pvar->ssh_state.tcpport, hostkey);
+	if (pvar->socket == INVALID_SOCKET) {
+		emsg = __FUNCTION__ ": Server disconnected";
+		goto error;
+	}
+
+	/* Q_S, server public key */
+	server_public = (unsigned char *)get_kex_reply_string(&data, &len, &publen);
+	if (server_public == NULL || publen != CURVE25519_SIZE) {
+		emsg = __FUNCTION__ ": invalid server public key length";
+		goto error;
+	}
+
+	signature = get_kex_reply_string(&data, &len, &siglen);
+	if (signature == NULL) {
+		emsg = __FUNCTION__ ": truncated signature";
+		goto error;
+	}
+
+	push_memdump("KEX_ECDH_REPLY", "signature", signature, siglen);
+
+	// ʌ̐
+	share_key = BN_new();
+	if (share_key == NULL) {
+		emsg = __FUNCTION__ ": Out of memory (1)";
+		goto error;
+	}
+	if (kexc25519_shared_key(pvar->c25519_client_key, server_public, share_key) != 0) {
+		emsg = __FUNCTION__ ": invalid server public key";
+		goto error;
+	}
+
+	// nbV̌vZ
+	/* calc and verify H */
+	hash = kex_c25519_hash(
+		get_kex_algorithm_EVP_MD(pvar->kex_type),
+		pvar->client_version_string,
+		pvar->server_version_string,
+		buffer_ptr(pvar->my_kex), buffer_len(pvar->my_kex),
+		buffer_ptr(pvar->peer_kex), buffer_len(pvar->peer_kex),
+		server_host_key_blob, bloblen,
+		pvar->c25519_client_pubkey,
+		server_public,
+		share_key,
+		&hashlen);
+
+	{
+		push_bignum_memdump("KEX_ECDH_REPLY c25519_kex_reply", "share_key", share_key);
+
+		push_memdump("KEX_ECDH_REPLY c25519_kex_reply", "hash", hash, hashlen);
+	}
+
+	// TTSSHo[Wɕ\L[rbg߂Ă
+	pvar->client_key_bits = 256;
+	pvar->server_key_bits = 256;
+
+	result = ssh2_kex_finish(pvar, hash, hashlen, share_key, hostkey, signature, siglen);
+
+error:
+	SecureZeroMemory(pvar->c25519_client_key, sizeof(pvar->c25519_client_key));
+	key_free(hostkey);
+	BN_clear_free(share_key);
+
+	if (emsg)
+		notify_fatal_error(pvar, emsg, TRUE);
+
+	return result;
+}
+
+
 // KEXɂăT[oԂĂ 31 ԃbZ[Wɑ΂nh
 static BOOL handle_SSH2_dh_common_reply(PTInstVar pvar)
 {
@@ -6256,6 +6490,10 @@ static BOOL handle_SSH2_dh_common_reply(PTInstVar pvar)
 		case KEX_ECDH_SHA2_521:
 			handle_SSH2_ecdh_kex_reply(pvar);
 			break;
+		case KEX_CURVE25519_SHA256:
+		case KEX_CURVE25519_SHA256_OLD:
+			handle_SSH2_c25519_kex_reply(pvar);
+			break;
 		default:
 			// TODO
 			break;
@@ -6301,11 +6539,15 @@ static BOOL handle_SSH2_newkeys(PTInstVar pvar)
 	                       | 1 << SSH2_CIPHER_CAMELLIA256_CTR
 	                       | 1 << SSH2_CIPHER_AES128_GCM
 	                       | 1 << SSH2_CIPHER_AES256_GCM
+	                       | 1 << SSH2_CIPHER_CHACHAPOLY
 	);
 	int type = (1 << SSH_AUTH_PASSWORD) | (1 << SSH_AUTH_RSA) |
 	           (1 << SSH_AUTH_TIS) | (1 << SSH_AUTH_PAGEANT);
+	int i;
 
 	logputs(LOG_LEVEL_VERBOSE, "SSH2_MSG_NEWKEYS was received(DH key generation is completed).");
+	logprintf(LOG_LEVEL_VERBOSE, "key exchange (%s) took %lu ms",
+	          get_kex_algorithm_name(pvar->kex_type), GetTickCount() - pvar->kex_start_tick);
 
 	// O̎̏I (2005.3.7 yutaka)
 	if (LogLevel(pvar, LOG_LEVEL_SSHDUMP)) {
@@ -6327,6 +6569,14 @@ static BOOL handle_SSH2_newkeys(PTInstVar pvar)
 			// TODO: error
 		}
 		do_SSH2_dispatch_setup_for_transfer(pvar);
+
+		// ɑȂ`l̃f[^𑗂B
+		for (i = 0 ; i < CHANNEL_MAX ; i++) {
+			if (channels[i].used && channels[i].bufchain)
+				ssh2_channel_retry_send_bufchain(pvar, &channels[i]);
+			if (channels[i].used)
+				ssh2_scp_send_ring(pvar, &channels[i]);
+		}
 		return TRUE;
 
 	} else {
@@ -7928,6 +8178,13 @@ static BOOL handle_SSH2_channel_success(PTInstVar pvar)
 		"SSH2_MSG_CHANNEL_SUCCESS was received(nego_status %d).",
 		pvar->session_nego_status);
 
+	// MEBhE RTT ̉
+	c = ssh2_channel_lookup(get_payload_uint32(pvar, 0));
+	if (c != NULL && c->winadj_pending) {
+		ssh2_channel_winadj_reply(pvar, c);
+		return TRUE;
+	}
+
 	if (pvar->session_nego_status == 1) {
 		// find channel by shell id(2005.2.27 yutaka)
 		c = ssh2_channel_lookup(pvar->shell_id);
@@ -7986,6 +8243,12 @@ static BOOL handle_SSH2_channel_failure(PTInstVar pvar)
 		return FALSE;
 	}
 
+	// MEBhE RTT ̉Bm̃NGXgȂ̂Œʏ FAILURE ԂB
+	if (c->winadj_pending) {
+		ssh2_channel_winadj_reply(pvar, c);
+		return TRUE;
+	}
+
 	if (pvar->shell_id == channel_id) {
 		if (c->type == TYPE_SUBSYSTEM_GEN) {
 			// TuVXe̋NɎŝŐ؂B
@@ -8012,42 +8275,97 @@ static BOOL handle_SSH2_channel_failure(PTInstVar pvar)
 
 
 
-// NCAgwindow sizeT[o֒m点
-static void do_SSH2_adjust_window_size(PTInstVar pvar, Channel_t *c)
+static void ssh2_channel_send_window_adjust(PTInstVar pvar, Channel_t *c, unsigned int adjust)
 {
-	// window size32KB֕ύXAlocal window̔ʂCB
-	// ɂSSH2̃X[vbgシB(2006.3.6 yutaka)
 	buffer_t *msg;
 	unsigned char *outmsg;
 	int len;
 
-	// [Jwindow sizeɂ܂]TȂAȂB
-	// added /2 (2006.3.6 yutaka)
-	if (c->local_window > c->local_window_max/2)
+	msg = buffer_init();
+	if (msg == NULL) {
+		// TODO: error check
+		logputs(LOG_LEVEL_ERROR, __FUNCTION__ ": buffer_init returns NULL.");
 		return;
+	}
+	buffer_put_int(msg, c->remote_id);
+	buffer_put_int(msg, adjust);
 
-	{
-		// pty open
-		msg = buffer_init();
-		if (msg == NULL) {
-			// TODO: error check
-			logputs(LOG_LEVEL_ERROR, __FUNCTION__ ": buffer_init returns NULL.");
-			return;
-		}
-		buffer_put_int(msg, c->remote_id);
-		buffer_put_int(msg, c->local_window_max - c->local_window);
+	len = buffer_len(msg);
+	outmsg = begin_send_packet(pvar, SSH2_MSG_CHANNEL_WINDOW_ADJUST, len);
+	memcpy(outmsg, buffer_ptr(msg), len);
+	finish_send_packet(pvar);
+	buffer_free(msg);
 
-		len = buffer_len(msg);
-		outmsg = begin_send_packet(pvar, SSH2_MSG_CHANNEL_WINDOW_ADJUST, len);
-		memcpy(outmsg, buffer_ptr(msg), len);
-		finish_send_packet(pvar);
-		buffer_free(msg);
+	logprintf(LOG_LEVEL_SSHDUMP, "SSH2_MSG_CHANNEL_WINDOW_ADJUST was sent. local:%d adjust:%u window_max:%u",
+	          c->self_id, adjust, c->local_window_max);
+	// NCAgwindow size𑝂₷
+	c->local_window += adjust;
+	c->adjust_count++;
+}
 
-		logputs(LOG_LEVEL_SSHDUMP, "SSH2_MSG_CHANNEL_WINDOW_ADJUST was sent at do_SSH2_adjust_window_size().");
-		// NCAgwindow size𑝂₷
-		c->local_window = c->local_window_max;
+// MEBhEL]n΁ARTT 𑪂邽߂̃NGXg𑗂B
+//  (OpenSSH ł SSH2_MSG_CHANNEL_FAILURE) Ԃ܂łɎMʂ
+// EBhEĂ邩𔻒fBPuTTY Ɠ@B
+static void ssh2_channel_send_winadj_probe(PTInstVar pvar, Channel_t *c)
+{
+	if (c->winadj_pending || pvar->rekeying)
+		return;
+	if (c->local_window_max >= (unsigned int)pvar->settings.ChannelWindowMax)
+		return;
+	// VF̃lSVG[V́Aǂ̃NGXĝ̂ʂłȂ
+	if (c->self_id == pvar->shell_id && c->type == TYPE_SHELL && pvar->session_nego_status != 4)
+		return;
+
+	if (!send_channel_request_gen(pvar, c, "winadj@putty.projects.tartarus.org", 1, NULL, NULL))
+		return;
+	c->winadj_pending = 1;
+	c->winadj_sent = GetTickCount();
+	c->winadj_bytes = c->recv_bytes;
+	c->winadj_window = c->local_window_max;
+}
+
+// RTT ̃NGXg̉󂯎
+static void ssh2_channel_winadj_reply(PTInstVar pvar, Channel_t *c)
+{
+	unsigned long long bytes = c->recv_bytes - c->winadj_bytes;
+	unsigned int limit = pvar->settings.ChannelWindowMax;
+	unsigned int newmax, grow;
+	DWORD rtt;
+
+	c->winadj_pending = 0;
+	rtt = GetTickCount() - c->winadj_sent;
+	c->rtt = rtt;
+
+	// 1 RTT ̊ԂɃEBhE̔ȏMȂAEBhEш}ĂB
+	// EBhE{ɂB
+	if (bytes >= c->winadj_window / 2 && c->local_window_max < limit) {
+		newmax = c->local_window_max * 2;
+		if (newmax > limit || newmax < c->local_window_max)
+			newmax = limit;
+		grow = newmax - c->local_window_max;
+		c->local_window_max = newmax;
+		ssh2_channel_send_window_adjust(pvar, c, grow);
 	}
 
+	logprintf(LOG_LEVEL_VERBOSE, "channel %d: rtt %lu ms, %llu bytes in rtt (%llu bytes/s), window %u",
+	          c->self_id, rtt, bytes, rtt > 0 ? bytes * 1000 / rtt : 0, c->local_window_max);
+}
+
+// NCAgwindow sizeT[o֒m点
+static void do_SSH2_adjust_window_size(PTInstVar pvar, Channel_t *c)
+{
+	// window size32KB֕ύXAlocal window̔ʂCB
+	// ɂSSH2̃X[vbgシB(2006.3.6 yutaka)
+	unsigned int consumed = c->local_window_max - c->local_window;
+
+	// ʂEBhE 1/4 ɖȂȂAȂB
+	// ܂ő҂ƁARTT 傫ƂɃT[ȏM~܂Ă܂B
+	if (consumed < c->local_window_max / 4)
+		return;
+
+	ssh2_channel_send_window_adjust(pvar, c, consumed);
+
+	ssh2_channel_send_winadj_probe(pvar, c);
 }
 
 
@@ -8089,6 +8407,13 @@ void ssh2_channel_send_close(PTInstVar pvar, Channel_t *c)
 #define WM_CHANNEL_CLOSE (WM_USER + 2)
 #define WM_GET_CLOSED_STATUS (WM_USER + 3)
 
+// SCPM̐i\XVԊu
+#define SCP_PROGRESS_TIMER      1
+#define SCP_PROGRESS_INTERVAL   250
+
+static void ssh2_scp_send_ring(PTInstVar pvar, Channel_t *c);
+static void ssh_scp_send_progress(HWND hWnd, Channel_t *c);
+
 typedef struct scp_dlg_parm {
 	Channel_t *c;
 	PTInstVar pvar;
@@ -8103,6 +8428,8 @@ static LRESULT CALLBACK ssh_scp_dlg_proc(HWND hWnd, UINT msg, WPARAM wp, LPARAM
 	switch (msg) {
 		case WM_INITDIALOG:
 			closed = 0;
+			// SCPM̏ꍇ̓`ln
+			SetWindowLong(hWnd, DWL_USER, lp);
 			return FALSE;
 
 		// SCPt@CM(remote-to-local)AgpB
@@ -8115,15 +8442,26 @@ static LRESULT CALLBACK ssh_scp_dlg_proc(HWND hWnd, UINT msg, WPARAM wp, LPARAM
 			return TRUE;
 			break;
 
+		// MXbht@Cǂݍ
 		case WM_SENDING_FILE:
 			{
-			scp_dlg_parm_t *parm = (scp_dlg_parm_t *)wp;
+			Channel_t *c = (Channel_t *)GetWindowLong(hWnd, DWL_USER);
 
-			SSH2_send_channel_data(parm->pvar, parm->c, parm->buf, parm->buflen, 0);
+			if (c != NULL)
+				ssh2_scp_send_ring(c->scp.pvar, c);
 			}
 			return TRUE;
 			break;
 
+		case WM_TIMER:
+			{
+			Channel_t *c = (Channel_t *)GetWindowLong(hWnd, DWL_USER);
+
+			if (c != NULL && wp == SCP_PROGRESS_TIMER)
+				ssh_scp_send_progress(hWnd, c);
+			}
+			return TRUE;
+
 		case WM_COMMAND:
 			switch (wp) {
 			}
@@ -8142,6 +8480,18 @@ static LRESULT CALLBACK ssh_scp_dlg_proc(HWND hWnd, UINT msg, WPARAM wp, LPARAM
 					//DestroyWindow(hWnd);
 					ShowWindow(hWnd, SW_HIDE);
 					closed = 1;
+					{
+					Channel_t *c = (Channel_t *)GetWindowLong(hWnd, DWL_USER);
+
+					// SCPM̏ꍇAMXbh̓t@CǂݏI (ring_eof) 
+					// IĂ܂ Cancel Ȃ̂ŁA (UIXbh) Ń`lA
+					// OɎcf[^͑炸Ɏ̂ĂB
+					if (c != NULL && !c->scp.eof_sent && c->scp.state != SCP_CLOSING) {
+						c->scp.state = SCP_CLOSING;
+						KillTimer(hWnd, SCP_PROGRESS_TIMER);
+						ssh2_channel_send_close(c->scp.pvar, c);
+					}
+					}
 					return TRUE;
 				default:
 					return FALSE;
@@ -8195,116 +8545,174 @@ void InitDlgProgress(HWND HDlg, int id_Progress, int *CurProgStat) {
 	return;
 }
 
-static unsigned __stdcall ssh_scp_thread(void *p)
+// SCPM̐i\BUIXbh̃^C}[Ă΂B
+static void ssh_scp_send_progress(HWND hWnd, Channel_t *c)
 {
-	Channel_t *c = (Channel_t *)p;
-	PTInstVar pvar = c->scp.pvar;
-	long long total_size = 0;
-	char *buf = NULL;
-	size_t buflen;
+	long long total_size = c->scp.filesendsize;
 	char s[80];
-	size_t ret;
-	HWND hWnd = c->scp.progress_window;
-	scp_dlg_parm_t parm;
-	int rate, ProgStat;
-	DWORD stime;
-	int elapsed, prev_elapsed;
-
-	buflen = min(c->remote_window, 8192*4); // max 32KB
-	buf = malloc(buflen);
+	int rate, elapsed;
 
-	//SendMessage(GetDlgItem(hWnd, IDC_FILENAME), WM_SETTEXT, 0, (LPARAM)c->scp.localfile);
-	SendMessage(GetDlgItem(hWnd, IDC_FILENAME), WM_SETTEXT, 0, (LPARAM)c->scp.localfilefull);
+	if (c->scp.filestat.st_size > 0)
+		rate = (int)(100 * total_size / c->scp.filestat.st_size);
+	else
+		rate = 100;
+	_snprintf_s(s, sizeof(s), _TRUNCATE, "%lld / %lld (%d%%)", total_size, c->scp.filestat.st_size, rate);
+	SendMessage(GetDlgItem(hWnd, IDC_PROGRESS), WM_SETTEXT, 0, (LPARAM)s);
+	if (c->scp.progstat != rate) {
+		c->scp.progstat = rate;
+		SendDlgItemMessage(hWnd, IDC_PROGBAR, PBM_SETPOS, (WPARAM)c->scp.progstat, 0);
+	}
+
+	elapsed = (GetTickCount() - c->scp.filesendstart) / 1000;
+	if (elapsed > c->scp.prev_elapsed) {
+		if (elapsed > 2) {
+			rate = (int)(total_size / elapsed);
+			if (rate < 1200) {
+				_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d (%d %s)", elapsed / 60, elapsed % 60, rate, "Bytes/s");
+			}
+			else if (rate < 1200000) {
+				_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d (%d.%02d %s)", elapsed / 60, elapsed % 60, rate / 1000, rate / 10 % 100, "KBytes/s");
+			}
+			else {
+				_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d (%d.%02d %s)", elapsed / 60, elapsed % 60, rate / (1000 * 1000), rate / 10000 % 100, "MBytes/s");
+			}
+		}
+		else {
+			_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d", elapsed / 60, elapsed % 60);
+		}
+		SendDlgItemMessage(hWnd, IDC_PROGTIME, WM_SETTEXT, 0, (LPARAM)s);
+		c->scp.prev_elapsed = elapsed;
+	}
+}
 
-	InitDlgProgress(hWnd, IDC_PROGBAR, &ProgStat);
+static BOOL ssh2_scp_alloc_ring(Channel_t *c)
+{
+	int i;
 
-	stime = GetTickCount();
-	prev_elapsed = 0;
+	c->scp.ring_space = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (c->scp.ring_space == NULL)
+		return FALSE;
+	for (i = 0 ; i < SCP_SEND_RING_NUM ; i++) {
+		c->scp.ring[i].buf = malloc(SCP_SEND_RING_SIZE);
+		if (c->scp.ring[i].buf == NULL)
+			return FALSE;
+		c->scp.ring[i].len = 0;
+		c->scp.ring[i].pos = 0;
+	}
+	c->scp.ring_head = 0;
+	c->scp.ring_tail = 0;
+	c->scp.ring_count = 0;
+	c->scp.ring_eof = 0;
+	c->scp.eof_sent = 0;
+	return TRUE;
+}
 
-	do {
-		int readlen, count=0;
+// MXbh̏IɌĂԂ
+static void ssh2_scp_free_ring(Channel_t *c)
+{
+	int i;
 
-		// Cancel{^ꂽEBhEB
-		if (is_canceled_window(hWnd))
-			goto cancel_abort;
+	for (i = 0 ; i < SCP_SEND_RING_NUM ; i++) {
+		free(c->scp.ring[i].buf);
+		c->scp.ring[i].buf = NULL;
+	}
+	if (c->scp.ring_space != NULL) {
+		CloseHandle(c->scp.ring_space);
+		c->scp.ring_space = NULL;
+	}
+}
 
-		// t@Cǂݍ񂾃f[^͂Ȃ炸T[o֑MB
-		readlen = max(4096, min(buflen, c->remote_window)); // min 4KB
-		ret = fread(buf, 1, readlen, c->scp.localfp);
-		if (ret == 0)
-			break;
+// MXbhǂݍ񂾃f[^Aremote window ̋󂫂̕B
+// SSH2_send_channel_data() ̓XbhZ[tł͂Ȃ̂ŁAUIXbhŌĂԂƁB
+// MXbh WM_SENDING_FILE ̂قAWINDOW_ADJUST ̎M
+// ̊ɌĂ΂B
+static void ssh2_scp_send_ring(PTInstVar pvar, Channel_t *c)
+{
+	scp_ring_t *r;
+	unsigned int len;
 
-		// remote_window 񕜂܂ő҂
-		do {
-			// socket or channelN[YꂽXbhI
-			if (pvar->socket == INVALID_SOCKET || c->scp.state == SCP_CLOSING || c->used == 0)
-				goto abort;
+	if (c->type != TYPE_SCP || c->scp.dir != TOREMOTE || c->scp.ring_space == NULL)
+		return;
+	if (c->scp.eof_sent || c->scp.state == SCP_CLOSING)
+		return;
+	// cԂƌ́AXgɐς܂ɑ҂
+	if (pvar->rekeying || c->bufchain != NULL)
+		return;
 
-			if (ret > c->remote_window) {
-				Sleep(100);
-			}
+	while (c->scp.ring_count > 0) {
+		r = &c->scp.ring[c->scp.ring_tail];
+		while (r->pos < r->len) {
+			len = min(r->len - r->pos, min(c->remote_window, c->remote_maxpacket));
+			if (len == 0)
+				return;  // WINDOW_ADJUST ҂
+			SSH2_send_channel_data(pvar, c, r->buf + r->pos, len, 0);
+			r->pos += len;
+			c->scp.filesendsize += len;
+		}
+		r->len = 0;
+		r->pos = 0;
+		c->scp.ring_tail = (c->scp.ring_tail + 1) % SCP_SEND_RING_NUM;
+		InterlockedDecrement(&c->scp.ring_count);
+		SetEvent(c->scp.ring_space);
+	}
+
+	// ring_eof Ă΁AXbh͍Ō̃obt@ςݏIĂ
+	if (c->scp.ring_eof && c->scp.ring_count == 0 && c->remote_window > 0) {
+		// eof
+		c->scp.eof_sent = 1;
+		c->scp.state = SCP_DATA;
+		SSH2_send_channel_data(pvar, c, "", 1, 0);
 
-			// 100񔲂Ȃ甲Ă܂
-			count++;
-			if (count > 100) {
-				break;
-			}
+		if (c->scp.progress_window != NULL) {
+			KillTimer(c->scp.progress_window, SCP_PROGRESS_TIMER);
+			ssh_scp_send_progress(c->scp.progress_window, c);
+			ShowWindow(c->scp.progress_window, SW_HIDE);
+		}
+	}
+}
 
-		} while (ret > c->remote_window);
+// t@CǂݍŃO֐ςށBM UIXbhsB
+static unsigned __stdcall ssh_scp_thread(void *p)
+{
+	Channel_t *c = (Channel_t *)p;
+	PTInstVar pvar = c->scp.pvar;
+	HWND hWnd = c->scp.progress_window;
+	scp_dlg_parm_t parm;
+	scp_ring_t *r;
+	size_t ret;
 
-		// sending data
-		parm.buf = buf;
-		parm.buflen = ret;
-		parm.c = c;
-		parm.pvar = pvar;
-		SendMessage(hWnd, WM_SENDING_FILE, (WPARAM)&parm, 0);
+	for (;;) {
+		// Cancel{^ꂽEBhEB
+		if (is_canceled_window(hWnd))
+			goto cancel_abort;
 
-		total_size += ret;
+		// socket or channelN[YꂽXbhI
+		if (pvar->socket == INVALID_SOCKET || c->scp.state == SCP_CLOSING || c->used == 0)
+			goto abort;
 
-		rate = (int)(100 * total_size / c->scp.filestat.st_size);
-		_snprintf_s(s, sizeof(s), _TRUNCATE, "%lld / %lld (%d%%)", total_size, c->scp.filestat.st_size, rate);
-		SendMessage(GetDlgItem(hWnd, IDC_PROGRESS), WM_SETTEXT, 0, (LPARAM)s);
-		if (ProgStat != rate) {
-			ProgStat = rate;
-			SendDlgItemMessage(hWnd, IDC_PROGBAR, PBM_SETPOS, (WPARAM)ProgStat, 0);
-		}
-
-		elapsed = (GetTickCount() - stime) / 1000;
-		if (elapsed > prev_elapsed) {
-			if (elapsed > 2) {
-				rate = (int)(total_size / elapsed);
-				if (rate < 1200) {
-					_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d (%d %s)", elapsed / 60, elapsed % 60, rate, "Bytes/s");
-				}
-				else if (rate < 1200000) {
-					_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d (%d.%02d %s)", elapsed / 60, elapsed % 60, rate / 1000, rate / 10 % 100, "KBytes/s");
-				}
-				else {
-					_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d (%d.%02d %s)", elapsed / 60, elapsed % 60, rate / (1000 * 1000), rate / 10000 % 100, "MBytes/s");
-				}
-			}
-			else {
-				_snprintf_s(s, sizeof(s), _TRUNCATE, "%d:%02d", elapsed / 60, elapsed % 60);
-			}
-			SendDlgItemMessage(hWnd, IDC_PROGTIME, WM_SETTEXT, 0, (LPARAM)s);
-			prev_elapsed = elapsed;
+		// OtȂAUIXbhÎ҂
+		if (c->scp.ring_count == SCP_SEND_RING_NUM) {
+			WaitForSingleObject(c->scp.ring_space, 1000);
+			continue;
 		}
 
-	} while (ret <= buflen);
-
-	// eof
-	c->scp.state = SCP_DATA;
-
-	buf[0] = '\0';
-	parm.buf = buf;
-	parm.buflen = 1;
-	parm.c = c;
-	parm.pvar = pvar;
-	SendMessage(hWnd, WM_SENDING_FILE, (WPARAM)&parm, 0);
-
-	ShowWindow(hWnd, SW_HIDE);
+		r = &c->scp.ring[c->scp.ring_head];
+		ret = fread(r->buf, 1, SCP_SEND_RING_SIZE, c->scp.localfp);
+		if (ret > 0) {
+			r->len = (unsigned int)ret;
+			r->pos = 0;
+			c->scp.ring_head = (c->scp.ring_head + 1) % SCP_SEND_RING_NUM;
+			InterlockedIncrement(&c->scp.ring_count);
+		}
+		if (ret < SCP_SEND_RING_SIZE) {
+			// eof (ǂݍ݃G[̏ꍇA܂łőł؂)
+			InterlockedExchange(&c->scp.ring_eof, 1);
+		}
+		PostMessage(hWnd, WM_SENDING_FILE, 0, 0);
 
-	free(buf);
+		if (c->scp.ring_eof)
+			break;
+	}
 
 	return 0;
 
@@ -8318,8 +8726,6 @@ cancel_abort:
 
 abort:
 
-	free(buf);
-
 	return 0;
 }
 
@@ -8351,10 +8757,22 @@ static void SSH2_scp_toremote(PTInstVar pvar, Channel_t *c, unsigned char *data,
 
 		c->scp.pvar = pvar;
 
-		hDlgWnd = CreateDialog(hInst, MAKEINTRESOURCE(IDD_SSHSCP_PROGRESS),
-				   pvar->cv->HWin, (DLGPROC)ssh_scp_dlg_proc);
+		if (!ssh2_scp_alloc_ring(c)) {
+			logputs(LOG_LEVEL_ERROR, __FUNCTION__ ": can't allocate the send buffer.");
+			ssh2_channel_send_close(pvar, c);
+			return;
+		}
+		c->scp.filesendsize = 0;
+		c->scp.filesendstart = GetTickCount();
+		c->scp.prev_elapsed = 0;
+
+		hDlgWnd = CreateDialogParam(hInst, MAKEINTRESOURCE(IDD_SSHSCP_PROGRESS),
+				   pvar->cv->HWin, (DLGPROC)ssh_scp_dlg_proc, (LPARAM)c);
 		if (hDlgWnd != NULL) {
 			c->scp.progress_window = hDlgWnd;
+			SendMessage(GetDlgItem(hDlgWnd, IDC_FILENAME), WM_SETTEXT, 0, (LPARAM)c->scp.localfilefull);
+			InitDlgProgress(hDlgWnd, IDC_PROGBAR, &c->scp.progstat);
+			SetTimer(hDlgWnd, SCP_PROGRESS_TIMER, SCP_PROGRESS_INTERVAL, NULL);
 			ShowWindow(hDlgWnd, SW_SHOW);
 		}
 
@@ -8791,6 +9209,7 @@ static BOOL handle_SSH2_channel_data(PTInstVar pvar)
 
 	// EBhETCY̒
 	c->local_window -= str_len;
+	c->recv_bytes += str_len;
 
 	do_SSH2_adjust_window_size(pvar, c);
 
@@ -8876,6 +9295,7 @@ static BOOL handle_SSH2_channel_extended_data(PTInstVar pvar)
 
 	// EBhETCY̒
 	c->local_window -= strlen;
+	c->recv_bytes += strlen;
 
 	do_SSH2_adjust_window_size(pvar, c);
 
@@ -9276,6 +9696,9 @@ static BOOL handle_SSH2_window_adjust(PTInstVar pvar)
 	// c
 	ssh2_channel_retry_send_bufchain(pvar, c);
 
+	// SCPM̑
+	ssh2_scp_send_ring(pvar, c);
+
 	return TRUE;
 }
 
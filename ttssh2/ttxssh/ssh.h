@@ -50,7 +50,6 @@ See LICENSE.TXT for the license.
 }
 
 // from OpenSSH
-extern const EVP_CIPHER *evp_aes_128_ctr(void);
 extern const EVP_CIPHER *evp_des3_ctr(void);
 extern const EVP_CIPHER *evp_bf_ctr(void);
 extern const EVP_CIPHER *evp_cast5_ctr(void);
@@ -96,7 +95,8 @@ typedef enum {
 	SSH2_CIPHER_CAMELLIA128_CBC, SSH2_CIPHER_CAMELLIA192_CBC, SSH2_CIPHER_CAMELLIA256_CBC,
 	SSH2_CIPHER_CAMELLIA128_CTR, SSH2_CIPHER_CAMELLIA192_CTR, SSH2_CIPHER_CAMELLIA256_CTR,
 	SSH2_CIPHER_AES128_GCM, SSH2_CIPHER_AES256_GCM,
-	SSH_CIPHER_MAX = SSH2_CIPHER_AES256_GCM,
+	SSH2_CIPHER_CHACHAPOLY,
+	SSH_CIPHER_MAX = SSH2_CIPHER_CHACHAPOLY,
 } SSHCipherId;
 
 typedef enum {
@@ -125,6 +125,9 @@ enum channel_type {
 // changed CHAN_SES_WINDOW_DEFAULT from 32KB to 128KB. (2007.10.29 maya)
 #define CHAN_SES_PACKET_DEFAULT (32*1024)
 #define CHAN_SES_WINDOW_DEFAULT (4*CHAN_SES_PACKET_DEFAULT)
+// MEBhE̎ōL (TERATERM.INI  ChannelWindowMax)
+#define CHAN_SES_WINDOW_LIMIT_DEFAULT (16*1024*1024)
+#define CHAN_SES_WINDOW_LIMIT_MAX     (256*1024*1024)
 #define CHAN_TCP_PACKET_DEFAULT (32*1024)
 #define CHAN_TCP_WINDOW_DEFAULT (4*CHAN_TCP_PACKET_DEFAULT)
 #if 0 // unused
@@ -393,9 +396,9 @@ static SSH2Cipher ssh2_ciphers[] = {
 	{SSH2_CIPHER_AES192_CBC,      "aes192-cbc",      16, 24,    0, 0, 0, EVP_aes_192_cbc},      // RFC4253
 	{SSH2_CIPHER_AES256_CBC,      "aes256-cbc",      16, 32,    0, 0, 0, EVP_aes_256_cbc},      // RFC4253
 	{SSH2_CIPHER_BLOWFISH_CBC,    "blowfish-cbc",     8, 16,    0, 0, 0, EVP_bf_cbc},           // RFC4253
-	{SSH2_CIPHER_AES128_CTR,      "aes128-ctr",      16, 16,    0, 0, 0, evp_aes_128_ctr},      // RFC4344
-	{SSH2_CIPHER_AES192_CTR,      "aes192-ctr",      16, 24,    0, 0, 0, evp_aes_128_ctr},      // RFC4344
-	{SSH2_CIPHER_AES256_CTR,      "aes256-ctr",      16, 32,    0, 0, 0, evp_aes_128_ctr},      // RFC4344
+	{SSH2_CIPHER_AES128_CTR,      "aes128-ctr",      16, 16,    0, 0, 0, EVP_aes_128_ctr},      // RFC4344
+	{SSH2_CIPHER_AES192_CTR,      "aes192-ctr",      16, 24,    0, 0, 0, EVP_aes_192_ctr},      // RFC4344
+	{SSH2_CIPHER_AES256_CTR,      "aes256-ctr",      16, 32,    0, 0, 0, EVP_aes_256_ctr},      // RFC4344
 	{SSH2_CIPHER_ARCFOUR,         "arcfour",          8, 16,    0, 0, 0, EVP_rc4},              // RFC4253
 	{SSH2_CIPHER_ARCFOUR128,      "arcfour128",       8, 16, 1536, 0, 0, EVP_rc4},              // RFC4345
 	{SSH2_CIPHER_ARCFOUR256,      "arcfour256",       8, 32, 1536, 0, 0, EVP_rc4},              // RFC4345
@@ -419,6 +422,7 @@ static SSH2Cipher ssh2_ciphers[] = {
 #endif // WITH_CAMELLIA_PRIVATE
 	{SSH2_CIPHER_AES128_GCM,      "aes128-gcm@openssh.com",      16, 16, 0, 12, 16, EVP_aes_128_gcm}, // not RFC5647, PROTOCOL of OpenSSH
 	{SSH2_CIPHER_AES256_GCM,      "aes256-gcm@openssh.com",      16, 32, 0, 12, 16, EVP_aes_256_gcm}, // not RFC5647, PROTOCOL of OpenSSH
+	{SSH2_CIPHER_CHACHAPOLY,      "chacha20-poly1305@openssh.com", 8, 64, 0,  0, 16, EVP_enc_null},    // PROTOCOL.chacha20poly1305 of OpenSSH
 	{SSH_CIPHER_NONE,             NULL,               0,  0,    0, 0, 0, NULL},
 };
 
@@ -435,6 +439,8 @@ typedef enum {
 	KEX_DH_GRP14_SHA256,
 	KEX_DH_GRP16_SHA512,
 	KEX_DH_GRP18_SHA512,
+	KEX_CURVE25519_SHA256,
+	KEX_CURVE25519_SHA256_OLD,
 	KEX_DH_UNKNOWN,
 	KEX_DH_MAX = KEX_DH_UNKNOWN,
 } kex_algorithm;
@@ -456,6 +462,8 @@ static ssh2_kex_algorithm_t ssh2_kex_algorithms[] = {
 	{KEX_DH_GRP14_SHA256, "diffie-hellman-group14-sha256",      EVP_sha256}, // RFC8268
 	{KEX_DH_GRP16_SHA512, "diffie-hellman-group16-sha512",      EVP_sha512}, // RFC8268
 	{KEX_DH_GRP18_SHA512, "diffie-hellman-group18-sha512",      EVP_sha512}, // RFC8268
+	{KEX_CURVE25519_SHA256, "curve25519-sha256",                EVP_sha256}, // RFC8731
+	{KEX_CURVE25519_SHA256_OLD, "curve25519-sha256@libssh.org", EVP_sha256}, // libssh
 	{KEX_DH_NONE      , NULL,                                   NULL},
 };
 
@@ -759,6 +767,7 @@ int SSH_start_scp(PTInstVar pvar, char *sendfile, char *dstfile);
 int SSH_start_scp_receive(PTInstVar pvar, char *filename);
 int SSH_scp_transaction(PTInstVar pvar, char *sendfile, char *dstfile, enum scp_dir direction);
 int SSH_sftp_transaction(PTInstVar pvar);
+int SSH_sftp_transfer(PTInstVar pvar, char *sendfile, char *dstfile, enum scp_dir direction);
 
 /* auxiliary SSH2 interfaces for pkt.c */
 unsigned int SSH_get_min_packet_size(PTInstVar pvar);
@@ -826,6 +835,16 @@ typedef struct PacketList {
 	struct PacketList *next;
 } PacketList_t;
 
+// SCPMŁAt@CǂރXbhƑMUIXbh̊ԂŎ󂯓nobt@
+#define SCP_SEND_RING_NUM   4
+#define SCP_SEND_RING_SIZE  (256 * 1024)
+
+typedef struct scp_ring {
+	char *buf;
+	unsigned int len;              // ǂݍ񂾃oCg
+	unsigned int pos;              // Mς݂̃oCg
+} scp_ring_t;
+
 typedef struct scp {
 	enum scp_dir dir;              // transfer direction
 	enum scp_state state;          // SCP state 
@@ -845,12 +864,26 @@ typedef struct scp {
 	DWORD fileatime;
 	PacketList_t *pktlist_head;
 	PacketList_t *pktlist_tail;
+	// for sending file
+	scp_ring_t ring[SCP_SEND_RING_NUM];
+	int ring_head;                 // ɓǂݍރobt@ (Xbh)
+	int ring_tail;                 // ɑMobt@ (UIXbh)
+	volatile LONG ring_count;      // ǂݍݍς݂ŖM̃obt@̐
+	volatile LONG ring_eof;        // t@CŌ܂œǂ
+	HANDLE ring_space;             // obt@󂢂ƂXbh֒m点
+	int eof_sent;
+	long long filesendsize;
+	DWORD filesendstart;
+	int progstat;
+	int prev_elapsed;
 } scp_t;
 
 enum sftp_state {
-	SFTP_INIT, SFTP_CONNECTED, SFTP_REALPATH, 
+	SFTP_INIT, SFTP_CONNECTED, SFTP_REALPATH, SFTP_XFER, SFTP_CLOSING,
 };
 
+struct sftp_xfer;
+
 typedef struct sftp {
 	enum sftp_state state;
 	HWND console_window;
@@ -866,6 +899,8 @@ typedef struct sftp {
 	unsigned long long limit_kbps;
 	//struct bwlimit bwlimit_in, bwlimit_out;
 	char path[1024];
+	buffer_t *recvbuf;             // MrSFTPbZ[W
+	struct sftp_xfer *xfer;        // t@C] (sftpsend/sftprecv)
 } sftp_t;
 
 typedef struct channel {
@@ -887,11 +922,22 @@ typedef struct channel {
 	sftp_t sftp;
 #define SSH_CHANNEL_STATE_CLOSE_SENT 0x00000001
 	unsigned int state;
+	// MEBhE̎
+	int winadj_pending;                // RTT ̃NGXgɑ΂鉞҂
+	DWORD winadj_sent;                 // NGXg𑗂
+	unsigned long long winadj_bytes;   // NGXg𑗂_ recv_bytes
+	unsigned int winadj_window;        // NGXg𑗂_ local_window_max
+	// v
+	unsigned long long recv_bytes;     // Mf[^̃oCg
+	DWORD open_time;                   // `l
+	DWORD rtt;                         // Ōɑ RTT (ms)
+	unsigned int adjust_count;         // WINDOW_ADJUST 𑗂
 } Channel_t;
 
 unsigned char *begin_send_packet(PTInstVar pvar, int type, int len);
 void finish_send_packet_special(PTInstVar pvar, int skip_compress);
 void SSH2_send_channel_data(PTInstVar pvar, Channel_t *c, unsigned char *buf, unsigned int buflen, int retry);
+void ssh2_channel_send_close(PTInstVar pvar, Channel_t *c);
 
 #define finish_send_packet(pvar) finish_send_packet_special((pvar), 0)
 #define get_payload_uint32(pvar, offset) get_uint32_MSBfirst((pvar)->ssh_state.payload + (offset))
@@ -281,6 +281,7 @@ static void normalize_cipher_order(char *buf)
 	   We *never* allow no encryption. */
 	static char default_strings[] = {
 		SSH2_CIPHER_AES256_GCM,
+		SSH2_CIPHER_CHACHAPOLY,
 		SSH2_CIPHER_CAMELLIA256_CTR,
 		SSH2_CIPHER_AES256_CTR,
 		SSH2_CIPHER_CAMELLIA256_CBC,
@@ -316,6 +317,8 @@ static void normalize_cipher_order(char *buf)
 static void normalize_kex_order(char *buf)
 {
 	static char default_strings[] = {
+		KEX_CURVE25519_SHA256,
+		KEX_CURVE25519_SHA256_OLD,
 		KEX_ECDH_SHA2_256,
 		KEX_ECDH_SHA2_384,
 		KEX_ECDH_SHA2_521,
@@ -544,6 +547,17 @@ static void read_ssh_options(PTInstVar pvar, PCHAR fileName)
 
 	settings->AuthBanner = GetPrivateProfileInt("TTSSH", "AuthBanner", 1, fileName);
 
+	// SFTP READ/WRITE ṽTCYƁA҂ɑv̐
+	settings->SftpBlockSize = GetPrivateProfileInt("TTSSH", "SftpBlockSize", DEFAULT_COPY_BUFLEN, fileName);
+	settings->SftpMaxRequests = GetPrivateProfileInt("TTSSH", "SftpMaxRequests", DEFAULT_NUM_REQUESTS, fileName);
+
+	// MEBhEōL (0 ȂLȂ)
+	settings->ChannelWindowMax = GetPrivateProfileInt("TTSSH", "ChannelWindowMax", CHAN_SES_WINDOW_LIMIT_DEFAULT, fileName);
+	if (settings->ChannelWindowMax < 0)
+		settings->ChannelWindowMax = CHAN_SES_WINDOW_LIMIT_DEFAULT;
+	else if (settings->ChannelWindowMax > CHAN_SES_WINDOW_LIMIT_MAX)
+		settings->ChannelWindowMax = CHAN_SES_WINDOW_LIMIT_MAX;
+
 	clear_local_settings(pvar);
 }
 
@@ -670,6 +684,15 @@ static void write_ssh_options(PTInstVar pvar, PCHAR fileName,
 
 	_itoa_s(settings->AuthBanner, buf, sizeof(buf), 10);
 	WritePrivateProfileString("TTSSH", "AuthBanner", buf, fileName);
+
+	_itoa_s(settings->SftpBlockSize, buf, sizeof(buf), 10);
+	WritePrivateProfileString("TTSSH", "SftpBlockSize", buf, fileName);
+
+	_itoa_s(settings->SftpMaxRequests, buf, sizeof(buf), 10);
+	WritePrivateProfileString("TTSSH", "SftpMaxRequests", buf, fileName);
+
+	_itoa_s(settings->ChannelWindowMax, buf, sizeof(buf), 10);
+	WritePrivateProfileString("TTSSH", "ChannelWindowMax", buf, fileName);
 }
 
 
@@ -1831,6 +1854,8 @@ static void PASCAL TTXParseParam(PCHAR param, PTTSet ts, PCHAR DDETopic) {
 					}
 				} else if (strcmp(option + 4, "-v") == 0) {
 					pvar->settings.LogLevel = LOG_LEVEL_VERBOSE;
+				} else if (_stricmp(option + 4, "-cipherbench") == 0) {
+					CRYPT_cipher_benchmark(pvar);
 				} else if (_stricmp(option + 4, "-autologin") == 0 ||
 				           _stricmp(option + 4, "-autologon") == 0) {
 					pvar->settings.TryDefaultAuth = TRUE;
@@ -2618,6 +2643,8 @@ static char *get_cipher_name(int cipher)
 		return "aes128-gcm@openssh.com(SSH2)";
 	case SSH2_CIPHER_AES256_GCM:
 		return "aes256-gcm@openssh.com(SSH2)";
+	case SSH2_CIPHER_CHACHAPOLY:
+		return "chacha20-poly1305@openssh.com(SSH2)";
 
 	default:
 		return NULL;
@@ -4058,6 +4085,17 @@ __declspec(dllexport) int CALLBACK TTXScpReceivefile(char *remotefile, char *loc
 	return SSH_scp_transaction(pvar, remotefile, localfile, FROMREMOTE);
 }
 
+// }NR}h"sftpsend"/"sftprecv"ĂяoBfBNg͍ċAIɓ]B
+__declspec(dllexport) int CALLBACK TTXSftpSendfile(char *filename, char *dstfile)
+{
+	return SSH_sftp_transfer(pvar, filename, dstfile, TOREMOTE);
+}
+
+__declspec(dllexport) int CALLBACK TTXSftpReceivefile(char *remotefile, char *localfile)
+{
+	return SSH_sftp_transfer(pvar, remotefile, localfile, FROMREMOTE);
+}
+
 
 // TTSSH̐ݒe(known hosts file)ԂB
 //
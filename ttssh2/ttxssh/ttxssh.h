@@ -79,6 +79,7 @@ typedef struct _TInstVar *PTInstVar;
 #include <openssl/dh.h>
 #include <openssl/ec.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include "buffer.h"
 
 /* tttypes.h Œ`Ă EM }N openssl/rsa.h (OpenSSL 0.9.8)̊֐vg^Cv錾
@@ -194,6 +195,11 @@ typedef struct _TS_SSH {
 	int GexMinimalGroupSize;
 
 	int AuthBanner;
+
+	int SftpBlockSize;
+	int SftpMaxRequests;
+
+	int ChannelWindowMax;
 } TS_SSH;
 
 typedef struct _TInstVar {
@@ -270,6 +276,8 @@ typedef struct _TInstVar {
 	int session_id_len;
 	SSHKeys ssh2_keys[MODE_MAX];
 	EVP_CIPHER_CTX evpcip[MODE_MAX];
+	struct chachapoly_ctx *cc[MODE_MAX];  // chacha20-poly1305 (EVP gȂ)
+	HMAC_CTX hmac[MODE_MAX];  // MAC ݒς݂̃ReLXg (CRYPT_set_MAC_key)
 	int userauth_success;
 	int shell_id;
 	/*int remote_id;*/
@@ -319,6 +327,9 @@ typedef struct _TInstVar {
 	BOOL nocheck_known_hosts;
 
 	EC_KEY *ecdh_client_key;
+	unsigned char c25519_client_key[32];     // curve25519-sha256 ̔閧
+	unsigned char c25519_client_pubkey[32];  //  J (Q_C)
+	DWORD kex_start_tick;  // SSH2_MSG_KEXINIT 𑗂
 
 	int dns_key_check;
 